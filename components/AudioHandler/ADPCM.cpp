@@ -0,0 +1,71 @@
+/*
+ * ADPCM.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include <xasin/audio/ADPCM.h>
+
+#include <algorithm>
+
+namespace Xasin {
+namespace Audio {
+namespace ADPCM {
+
+static const int8_t index_table[16] = {
+	-1, -1, -1, -1, 2, 4, 6, 8,
+	-1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+static const int16_t step_table[89] = {
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+	19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+	130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+	337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+	876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+	2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+	5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+size_t decode_packet(const uint8_t *data, size_t length, int16_t *out, size_t max_samples) {
+	if(length < XASAUDIO_ADPCM_PACKET_HEADER_SIZE)
+		return 0;
+
+	int32_t predictor = int16_t(data[0] | (data[1] << 8));
+	int32_t step_index = std::min<int32_t>(data[2], 88);
+
+	size_t sample_count = std::min<size_t>((length - XASAUDIO_ADPCM_PACKET_HEADER_SIZE) * 2, max_samples);
+	const uint8_t *nibbles = data + XASAUDIO_ADPCM_PACKET_HEADER_SIZE;
+
+	for(size_t i = 0; i < sample_count; i++) {
+		// Low nibble first
+		uint8_t code = (nibbles[i >> 1] >> ((i & 1) * 4)) & 0xF;
+		int32_t step = step_table[step_index];
+
+		int32_t diff = step >> 3;
+		if(code & 1)
+			diff += step >> 2;
+		if(code & 2)
+			diff += step >> 1;
+		if(code & 4)
+			diff += step;
+
+		if(code & 8)
+			predictor -= diff;
+		else
+			predictor += diff;
+
+		predictor = std::max<int32_t>(INT16_MIN, std::min<int32_t>(INT16_MAX, predictor));
+		step_index = std::max<int32_t>(0, std::min<int32_t>(88, step_index + index_table[code]));
+
+		out[i] = predictor;
+	}
+
+	return sample_count;
+}
+
+} /* namespace ADPCM */
+} /* namespace Audio */
+} /* namespace Xasin */
@@ -0,0 +1,261 @@
+/*
+ * AssetCache.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include <xasin/audio/AssetCache.h>
+
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include "sd_raw_access.h"
+
+namespace Xasin {
+namespace Audio {
+
+cached_asset_t::cached_asset_t(uint32_t size) : data(nullptr), size(size) {
+	// Prefer external RAM where there is any, internal RAM is precious.
+	data = static_cast<uint8_t*>(heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+	if(data == nullptr)
+		data = static_cast<uint8_t*>(heap_caps_malloc(size, MALLOC_CAP_8BIT));
+}
+cached_asset_t::~cached_asset_t() {
+	if(data != nullptr)
+		heap_caps_free(data);
+}
+
+SemaphoreHandle_t AssetCache::cache_mutex = nullptr;
+std::map<std::string, AssetCache::entry_t, std::less<>> AssetCache::entries;
+std::set<std::string, std::less<>> AssetCache::uncacheable;
+
+uint32_t AssetCache::use_counter = 0;
+asset_cache_stats_t AssetCache::stats = {};
+
+void AssetCache::init() {
+	if(cache_mutex != nullptr)
+		return;
+
+	cache_mutex = xSemaphoreCreateMutex();
+}
+
+bool AssetCache::reserve(uint32_t size, bool may_evict) {
+	while((stats.bytes_used + size) > CONFIG_XASAUDIO_ASSET_CACHE_SIZE) {
+		if(!may_evict)
+			return false;
+
+		auto oldest = entries.end();
+
+		for(auto i = entries.begin(); i != entries.end(); i++) {
+			// Entries still referenced by a playing source would not
+			// free any memory, so they are not worth evicting.
+			if(i->second.asset.use_count() > 1)
+				continue;
+			if(oldest == entries.end() || i->second.last_use < oldest->second.last_use)
+				oldest = i;
+		}
+
+		if(oldest == entries.end())
+			return false;
+
+		ESP_LOGD("XasAudio", "Evicting %s from asset cache", oldest->first.c_str());
+
+		stats.bytes_used -= oldest->second.asset->size;
+		stats.evictions++;
+		entries.erase(oldest);
+		stats.entries = entries.size();
+	}
+
+	stats.bytes_used += size;
+
+	return true;
+}
+
+AssetHandle AssetCache::find(const char *key) {
+	auto it = entries.find(key);
+	if(it == entries.end())
+		return nullptr;
+
+	it->second.last_use = ++use_counter;
+
+	return it->second.asset;
+}
+
+AssetHandle AssetCache::lookup(const char *key, bool count_stats, bool &is_uncacheable) {
+	xSemaphoreTake(cache_mutex, portMAX_DELAY);
+
+	AssetHandle out = find(key);
+	is_uncacheable = (out == nullptr) && (uncacheable.find(key) != uncacheable.end());
+
+	if(count_stats) {
+		if(out != nullptr)
+			stats.hits++;
+		else if(is_uncacheable)
+			stats.negative_hits++;
+		else
+			stats.misses++;
+	}
+
+	xSemaphoreGive(cache_mutex);
+
+	return out;
+}
+
+void AssetCache::mark_uncacheable(const char *key) {
+	xSemaphoreTake(cache_mutex, portMAX_DELAY);
+
+	if(uncacheable.size() >= UNCACHEABLE_MAX)
+		uncacheable.clear();
+	uncacheable.emplace(key);
+
+	xSemaphoreGive(cache_mutex);
+}
+
+AssetHandle AssetCache::load(const char *key, const char *file_path, uint32_t offset, uint32_t size,
+		bool may_evict) {
+	if(size == 0 || size > CONFIG_XASAUDIO_ASSET_CACHE_MAX_ENTRY) {
+		mark_uncacheable(key);
+		return nullptr;
+	}
+
+	xSemaphoreTake(cache_mutex, portMAX_DELAY);
+	bool reserved = reserve(size, may_evict);
+	xSemaphoreGive(cache_mutex);
+
+	if(!reserved)
+		return nullptr;
+
+	// The SD card is read outside of the cache lock, so that hits
+	// for other sounds are not held up by this load.
+	auto asset = std::make_shared<cached_asset_t>(size);
+
+	bool loaded = false;
+	if(asset->data != nullptr) {
+		FILE *file = sd_raw_fopen(file_path, "rb");
+		if(file != nullptr) {
+			if(offset == 0 || sd_raw_fseek(file, offset, SEEK_SET) == 0)
+				loaded = sd_raw_fread(asset->data, 1, size, file) == size;
+			sd_raw_fclose(file);
+		}
+	}
+
+	xSemaphoreTake(cache_mutex, portMAX_DELAY);
+
+	AssetHandle out = find(key);
+	if(!loaded || out != nullptr) {
+		// Either the read failed, or someone else loaded the same
+		// file in the meantime. Hand back the reserved space.
+		stats.bytes_used -= size;
+	}
+	else {
+		entries.emplace(key, entry_t{asset, ++use_counter});
+		stats.entries = entries.size();
+
+		out = asset;
+	}
+
+	xSemaphoreGive(cache_mutex);
+
+	if(!loaded)
+		ESP_LOGW("XasAudio", "Could not cache sound %s", key);
+
+	return out;
+}
+
+AssetHandle AssetCache::load_file(const char *file_path) {
+	long raw_size = sd_raw_get_file_size(file_path);
+	if(raw_size <= 0) {
+		mark_uncacheable(file_path);
+		return nullptr;
+	}
+
+	return load(file_path, file_path, 0, raw_size);
+}
+
+AssetHandle AssetCache::get(const char *file_path) {
+	if(cache_mutex == nullptr || file_path == nullptr)
+		return nullptr;
+
+	bool is_uncacheable;
+	AssetHandle out = lookup(file_path, true, is_uncacheable);
+	if(out != nullptr || is_uncacheable)
+		return out;
+
+	return load_file(file_path);
+}
+
+bool AssetCache::preload(const char *file_path) {
+	if(cache_mutex == nullptr || file_path == nullptr)
+		return false;
+
+	bool is_uncacheable;
+	if(lookup(file_path, false, is_uncacheable) != nullptr)
+		return true;
+	if(is_uncacheable)
+		return false;
+
+	return load_file(file_path) != nullptr;
+}
+
+AssetHandle AssetCache::get(const char *key, const char *file_path, uint32_t offset, uint32_t size) {
+	if(cache_mutex == nullptr || key == nullptr)
+		return nullptr;
+
+	bool is_uncacheable;
+	AssetHandle out = lookup(key, true, is_uncacheable);
+	if(out != nullptr || is_uncacheable)
+		return out;
+
+	return load(key, file_path, offset, size);
+}
+
+bool AssetCache::preload(const char *key, const char *file_path, uint32_t offset, uint32_t size,
+		bool may_evict) {
+	if(cache_mutex == nullptr || key == nullptr)
+		return false;
+
+	bool is_uncacheable;
+	if(lookup(key, false, is_uncacheable) != nullptr)
+		return true;
+	if(is_uncacheable)
+		return false;
+
+	return load(key, file_path, offset, size, may_evict) != nullptr;
+}
+
+bool AssetCache::contains(const char *key) {
+	if(cache_mutex == nullptr || key == nullptr)
+		return false;
+
+	xSemaphoreTake(cache_mutex, portMAX_DELAY);
+	bool out = entries.find(key) != entries.end();
+	xSemaphoreGive(cache_mutex);
+
+	return out;
+}
+
+void AssetCache::clear() {
+	if(cache_mutex == nullptr)
+		return;
+
+	xSemaphoreTake(cache_mutex, portMAX_DELAY);
+	entries.clear();
+	uncacheable.clear();
+	stats.entries = 0;
+	stats.bytes_used = 0;
+	xSemaphoreGive(cache_mutex);
+}
+
+asset_cache_stats_t AssetCache::get_stats() {
+	if(cache_mutex == nullptr)
+		return stats;
+
+	xSemaphoreTake(cache_mutex, portMAX_DELAY);
+	asset_cache_stats_t out = stats;
+	xSemaphoreGive(cache_mutex);
+
+	return out;
+}
+
+} /* namespace Audio */
+} /* namespace Xasin */
@@ -1,14 +1,16 @@
 #include "xasin/audio/AudioTX.h"
 #include "xasin/audio/Source.h"
+#include "xasin/audio/SDStream.h"
+#include "xasin/audio/AssetCache.h"
+#include "xasin/audio/I2SDACSink.h"
+#include "xasin/audio/MixKernel.h"
 
-#include <cstring>
 #include <cmath>
+#include <algorithm>
 
 #define LOG_LOCAL_LEVEL ESP_LOG_INFO
 #include "esp_log.h"
-#include "driver/dac.h" // Added for DAC functions
-#include "rom/ets_sys.h" // For ets_delay_us
-#include "esp_timer.h"   // For esp_timer_get_time
+#include "esp_timer.h"
 
 namespace Xasin {
 namespace Audio {
@@ -16,32 +18,37 @@ namespace Audio {
 void start_audio_task(void *arg) {
 	reinterpret_cast<TX *>(arg)->audio_dac_output_task(); // Starts the DAC output task
 }
+void start_reclaim_task(void *arg) {
+	reinterpret_cast<TX *>(arg)->reclaim_task_run();
+}
 
 TX::TX() { // Constructor
 
 	audio_task = nullptr;
 	processing_task = nullptr;
 
-	audio_config_mutex = xSemaphoreCreateMutex();
+	output_sink = nullptr;
+
+	reclaim_task = nullptr;
+	voice_list_head = nullptr;
+
+	voice_stats_count = {};
+	voice_stats_index = 0;
 
 	volume_estimate = 0;
 	clipping = false;
 
+	voices_stolen = 0;
+	voices_rejected = 0;
+
 	state = IDLE;
 
 	calculate_volume = false;
 	volume_mod = 255;
 }
 
-void TX::calculate_audio_rms() {
-	uint64_t rms_sum = 0;
-
-	// audio_buffer is now mono, iterate directly
-	for(int16_t sample : audio_buffer) {
-		rms_sum += int32_t(sample) * sample;
-	}
-
-	rms_sum /= audio_buffer.size(); // Size is now XASAUDIO_TX_FRAME_SAMPLE_NO
+void TX::calculate_audio_rms(uint64_t square_sum) {
+	uint64_t rms_sum = square_sum / audio_buffer.size();
 
 	float rms_value = (sqrt(float(rms_sum)) / INT16_MAX) * sqrt(2);
 	if(rms_value <= 0.0001)
@@ -58,99 +65,174 @@ void TX::boop_thread() {
 }
 
 void TX::remove_source(Source * source) {
-	xSemaphoreTake(audio_config_mutex, portMAX_DELAY);
+	if(!source->was_started || source->was_unlinked)
+		return;
 
 	ESP_LOGD("XasAudio", "Erasing source 0x%p", source);
 
-	for(auto i = audio_sources.begin(); i != audio_sources.end();) {
-		if(*i == source)
-			i = audio_sources.erase(i);
-		else
-			i++;
+	// Nobody else walks the voice list before init(), and on the
+	// processing task it is ours anyway, so there is nothing to wait for.
+	// Earlier commands go first, in case the source was just inserted.
+	if(audio_task == nullptr || xTaskGetCurrentTaskHandle() == processing_task) {
+		apply_source_commands();
+		unlink_source(source);
+		return;
 	}
 
-	ESP_LOGD("XasAudio", "New held count: %d", audio_sources.size());
+	// The processing task may be halfway through a frame using this
+	// source, so hand it the removal and wait until it lets go.
+	while(!source_commands.push({source, false})) {
+		boop_thread();
+		vTaskDelay(1);
+	}
 
-	xSemaphoreGive(audio_config_mutex);
+	while(!source->was_unlinked) {
+		boop_thread();
+		vTaskDelay(1);
+	}
 }
 
 void TX::insert_source(Source * source) {
-	xSemaphoreTake(audio_config_mutex, portMAX_DELAY);
-
 	ESP_LOGD("XasAudio", "Adding source 0x%p", source);
 
-	audio_sources.push_back(source);
+	while(!source_commands.push({source, true})) {
+		boop_thread();
+		vTaskDelay(1);
+	}
+
+	boop_thread();
+}
 
-	ESP_LOGD("XasAudio", "New held count: %d", audio_sources.size());
-	xSemaphoreGive(audio_config_mutex);
+void TX::apply_source_commands() {
+	source_command_t command;
 
-	xTaskNotify(audio_task, 0, eNoAction);
+	while(source_commands.pop(command)) {
+		if(command.insert)
+			link_source(command.source);
+		else
+			unlink_source(command.source);
+	}
 }
 
-// Removed add_interleaved_frame and add_lr_frame as they are stereo-specific
+void TX::link_source(Source * source) {
+	// Enforce the voice budget. If all voices are taken, the lowest
+	// priority voice (the oldest one among equals) makes room, as long
+	// as it does not outrank the new source. Otherwise the new source
+	// is inserted stopped, so that it is cleaned up like any other.
+	// Only voices with audio count, so that e.g. a silent TXStream
+	// does not hold one. Sources that are not deletable are never
+	// stopped here, as their owner could not start them again.
+	size_t active_voices = 0;
+	Source *victim = nullptr;
+
+	Source **tail = &voice_list_head;
+	for(; *tail != nullptr; tail = &(*tail)->next_voice) {
+		Source *voice = *tail;
+
+		if(!voice->is_active() || !voice->has_audio())
+			continue;
+
+		active_voices++;
+
+		if(!voice->can_be_deleted() || voice->priority > source->priority)
+			continue;
+		if(victim == nullptr || voice->priority < victim->priority)
+			victim = voice;
+	}
 
-// Add mono frame data to the buffer
-void TX::add_mono_frame(const int16_t *data, uint8_t volume) {
-	for(int i=0; i < XASAUDIO_TX_FRAME_SAMPLE_NO; i++) {
-		int32_t new_audio_value = audio_buffer[i];
-		// Apply volume modification
-		new_audio_value += (volume_mod * volume * int32_t(*data)) >> 16;
-
-		// Clipping
-		if(new_audio_value > INT16_MAX) {
-			clipping = true;
-			new_audio_value = INT16_MAX;
+	if(active_voices >= CONFIG_XASAUDIO_TX_MAX_VOICES && source->has_audio()) {
+		if(victim != nullptr) {
+			ESP_LOGD("XasAudio", "Stealing voice 0x%p", victim);
+			victim->was_stopped = true;
+			voices_stolen++;
 		}
-		else if(new_audio_value < INT16_MIN) {
-			clipping = true;
-			new_audio_value = INT16_MIN;
+		else if(source->can_be_deleted()) {
+			ESP_LOGD("XasAudio", "No voice free for 0x%p", source);
+			source->was_stopped = true;
+			voices_rejected++;
 		}
+	}
+
+	source->next_voice = nullptr;
+	*tail = source;
+}
 
-		audio_buffer[i] = int16_t(new_audio_value);
-		data++; // Move to the next sample in the input data
+void TX::unlink_source(Source * source) {
+	for(Source **i = &voice_list_head; *i != nullptr; i = &(*i)->next_voice) {
+		if(*i == source) {
+			*i = source->next_voice;
+			break;
+		}
 	}
+
+	source->next_voice = nullptr;
+	source->was_unlinked = true;
+}
+
+void TX::collect_sources() {
+	uint8_t stats_index = (voice_stats_index.load() + 1) & 1;
+	size_t stats_count = 0;
+
+	for(Source **i = &voice_list_head; *i != nullptr;) {
+		Source *source = *i;
+
+		// Finished sources are handed to the reclaim task for deletion.
+		// Should its queue be full, they are simply retried next frame.
+		if((source->was_stopped || source->is_finished()) && source->can_be_deleted()) {
+			if(reclaim_queue.push(source)) {
+				*i = source->next_voice;
+				source->next_voice = nullptr;
+				source->was_unlinked = true;
+
+				continue;
+			}
+		}
+		else if(source->is_active() && stats_count < CONFIG_XASAUDIO_TX_MAX_VOICES) {
+			voice_stats_t &entry = voice_stats[stats_index][stats_count++];
+
+			entry.source = source;
+			entry.priority = source->priority;
+			entry.last_frame_us = source->cpu_time_last_us;
+			entry.frames = source->frames_processed;
+			entry.average_frame_us = (source->frames_processed == 0) ? 0
+				: (source->cpu_time_total_us / source->frames_processed);
+		}
+
+		i = &source->next_voice;
+	}
+
+	voice_stats_count[stats_index] = stats_count;
+	voice_stats_index.store(stats_index);
+
+	if(reclaim_queue.size() != 0 && reclaim_task != nullptr)
+		xTaskNotify(reclaim_task, 0, eNoAction);
 }
 
-void TX::audio_dac_output_task() { // Task to continuously output audio samples to the DAC
+// Removed add_interleaved_frame and add_lr_frame as they are stereo-specific
+
+// Add mono frame data to the mix buffer
+void TX::add_mono_frame(const int16_t *data, uint8_t volume) {
+	Mix::accumulate(mix_buffer.data(), data, mix_buffer.size(), Mix::q15_gain(volume_mod, volume));
+}
+
+void TX::audio_dac_output_task() { // Task to continuously hand frames to the output sink
 	int audio_idle_count = 0;
-	const uint32_t sample_period_us = 1000000 / CONFIG_XASAUDIO_TX_SAMPLERATE;
-	int64_t frame_start_time, elapsed_time_us;
 
 	while(true) {
 		// As long as we haven't been idling for a while, continue playback.
+		// The sink blocks until a DMA buffer is free, which paces this loop
+		// to the sample rate without keeping the CPU busy.
 		if(audio_idle_count < 0) {
-			// Output samples from audio_buffer to DAC
-			for (size_t i = 0; i < XASAUDIO_TX_FRAME_SAMPLE_NO; ++i) {
-				frame_start_time = esp_timer_get_time();
-
-				// audio_buffer is now mono, directly use the sample
-				int16_t sample16 = audio_buffer[i];
-
-				// Convert 16-bit signed sample (-32768 to 32767) to 8-bit unsigned (0 to 255)
-				uint8_t dac_sample = (sample16 >> 8) + 128;
-				
-				// ESP_LOGV("XasAudioDAC", "Sample16: %d, DAC_Sample: %u", sample16, dac_sample); // Verbose logging for debugging
-
-				dac_output_voltage(DAC_CHANNEL_1, dac_sample); // Assuming DAC_CHANNEL_1, defined in init
-
-				elapsed_time_us = esp_timer_get_time() - frame_start_time;
-				if (elapsed_time_us < sample_period_us) {
-					ets_delay_us(sample_period_us - elapsed_time_us);
-				} else {
-					// ESP_LOGW("XasAudioDAC", "DAC output lagging: %lld us", elapsed_time_us - sample_period_us);
-				}
-			}
+			output_sink->write_frame(audio_buffer.data());
 		}
-		// The DAC output has been stopped, simply wait for new data, a new audio source or similar
+		// The output has been stopped, simply wait for new data, a new audio source or similar
 		else {
 			state = IDLE;
 			xTaskNotifyWait(0, 0, nullptr, portMAX_DELAY);
 		}
 
 		// First things first we need to call the large processing thread
-		// to see what needs to be done.
-		// For mono buffer, size is XASAUDIO_TX_FRAME_SAMPLE_NO * sizeof(int16_t)
-		memset(audio_buffer.data(), 0, audio_buffer.size() * sizeof(int16_t)); 
+		// to see what needs to be done. It fully rewrites audio_buffer.
 		state = PROCESSING;
 		xTaskNotify(processing_task, 0, eNoAction);
 		while(state == PROCESSING)
@@ -159,10 +241,10 @@ void TX::audio_dac_output_task() { // Task to continuously output audio samples
 
 		// An audio source reported it has some audio to play
 		if(state == RUNNING) {
-			// We had put the dac to sleep, unpause it.
+			// We had put the output to sleep, unpause it.
 			if(audio_idle_count == 0) {
 				ESP_LOGD("XasAudio", "Transitioning to running.");
-				// DAC is enabled in init, no specific "start" needed here for dac_output_voltage
+				output_sink->start();
 			}
 
 			// Reset the idle counter.
@@ -173,37 +255,65 @@ void TX::audio_dac_output_task() { // Task to continuously output audio samples
 		else if(audio_idle_count < 0) {
 			audio_idle_count++;
 
-			// We reached our four block idle time, stop the DAC output
+			// We reached our ten block idle time, stop the output
 			// This helps conserve energy and processing power
 			if(audio_idle_count == 0) {
 				ESP_LOGD("XasAudio", "Transitioning to idle.");
-				dac_output_voltage(DAC_CHANNEL_1, 128); // Output silence (mid-point for 8-bit DAC)
+				output_sink->stop();
 			}
 		}
 	}
 }
 
+void TX::reclaim_task_run() {
+	while(true) {
+		xTaskNotifyWait(0, 0, nullptr, portMAX_DELAY);
+
+		Source *source;
+		while(reclaim_queue.pop(source)) {
+			ESP_LOGD("XasAudio", "Starting delete of 0x%p", source);
+			delete source;
+		}
+	}
+}
+
 bool TX::largestack_process() {
 	if(state != PROCESSING)
 		return false;
 
 	ESP_LOGV("XasAudio", "Processing next batch.");
 
-	// We need to get the FreeRTOS Mutex to prevent concurrent modification
-	// of the audio sources list.
-	xSemaphoreTake(audio_config_mutex, portMAX_DELAY);
-	std::vector<Source *> sources_copy = audio_sources;
-	xSemaphoreGive(audio_config_mutex);
+	// Pick up sources that were started or destroyed since the last
+	// frame. From here on, only this task touches the voice list, so
+	// no lock and no copy of it is needed.
+	apply_source_commands();
+
+	mix_buffer.fill(0);
 
 	bool source_is_playing = false;
-	for(auto source : sources_copy) {
+	for(Source *source = voice_list_head; source != nullptr; source = source->next_voice) {
+		if(source->was_stopped)
+			continue;
+
+		int64_t process_start = esp_timer_get_time();
 		source_is_playing |= source->process_frame();
+
+		uint32_t process_time = esp_timer_get_time() - process_start;
+		source->cpu_time_last_us   = process_time;
+		source->cpu_time_total_us += process_time;
+		source->frames_processed++;
 	}
 
-	if(calculate_volume)
-		calculate_audio_rms();
-	else
+	// Clamp the mix down to 16 bit, and get the RMS in the same pass
+	if(calculate_volume) {
+		uint64_t square_sum = 0;
+		clipping |= Mix::saturate(mix_buffer.data(), audio_buffer.data(), audio_buffer.size(), &square_sum);
+		calculate_audio_rms(square_sum);
+	}
+	else {
+		clipping |= Mix::saturate(mix_buffer.data(), audio_buffer.data(), audio_buffer.size());
 		volume_estimate = 0;
+	}
 
 	if(source_is_playing)
 		state = RUNNING;
@@ -212,38 +322,58 @@ bool TX::largestack_process() {
 
 	xTaskNotify(audio_task, 0, eNoAction);
 
-	for (auto source : sources_copy)
-	{
-		// FIXME This really should be a std::shared_pointer, it's a perfect
-		// use case, I just need to muster the courage to use it :P
-		if (source->is_finished() && source->can_be_deleted())
-		{
-			ESP_LOGD("XasAudio", "Starting delete of 0x%p", source);
-			delete source;
-		}
-	}
+	collect_sources();
 
 	return true;
 }
 
-void TX::init(TaskHandle_t processing_task) { // Initializes DAC and audio processing task
-	// DAC initialization
-    ESP_LOGI("XasAudio", "Initializing DAC for audio output.");
-    dac_output_enable(DAC_CHANNEL_1); // Enable DAC output on channel 1 (GPIO25)
-    // dac_output_enable(DAC_CHANNEL_2); // Enable DAC output on channel 2 (GPIO26) if stereo DAC needed
-    
-    // Disable Cosine Wave (CW) generator.
-    // The CW generator can interfere with DAC output if not disabled.
-    dac_cw_generator_disable(); 
+void TX::init(TaskHandle_t processing_task, OutputSink *sink) { // Initializes the output and audio processing task
+	if(sink == nullptr)
+		sink = new I2SDACSink();
+
+	output_sink = sink;
+	output_sink->init();
 
 	this->processing_task = processing_task;
 
+	SDStream::start_prefetch_task();
+	AssetCache::init();
+
+	xTaskCreate(start_reclaim_task, "XasAudio GC", 3*1024, this, 1, &reclaim_task);
+
 	xTaskCreate(start_audio_task, "XasAudio DAC Output", 3*1024, this, 7, &audio_task);
 }
 
 float TX::get_volume_estimate() {
 	return volume_estimate;
 }
+bool TX::had_clipping() {
+	bool had_clipped = clipping;
+	clipping = false;
+
+	return had_clipped;
+}
+
+size_t TX::get_voice_count() {
+	return voice_stats_count[voice_stats_index.load()];
+}
+
+size_t TX::get_voice_stats(voice_stats_t *stats, size_t max_count) {
+	uint8_t stats_index = voice_stats_index.load();
+	size_t count = std::min(max_count, voice_stats_count[stats_index]);
+
+	for(size_t i = 0; i < count; i++)
+		stats[i] = voice_stats[stats_index][i];
+
+	return count;
+}
+
+uint32_t TX::get_stolen_voice_count() {
+	return voices_stolen;
+}
+uint32_t TX::get_rejected_voice_count() {
+	return voices_rejected;
+}
 
 }
 }
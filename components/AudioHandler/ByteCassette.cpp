@@ -10,37 +10,73 @@
 
 #define LOG_LOCAL_LEVEL ESP_LOG_INFO
 #include <esp_log.h>
-#include "sd_raw_access.h" // For SD card functions
 
 namespace Xasin {
 namespace Audio {
 
+// Bank sounds are cached under their ID, which is much cheaper
+// to compare than the full path would be.
+static void make_cache_key(char (&key)[8], sound_id_t sound_id) {
+	snprintf(key, sizeof(key), "#%u", sound_id);
+}
+
 ByteCassette::ByteCassette(TX &audio_handler,
-		const char *file_path, uint32_t samprate) // Modified constructor
+		const char *file_path, uint32_t samprate)
 	: Source(audio_handler),
-	  sound_file(nullptr), // Initialize sound_file to nullptr
-	  file_size(0),
-	  current_file_pos(0),
+	  asset(AssetCache::get(file_path)), asset_position(0),
+	  stream(nullptr),
+	  prev_sample(0), next_sample(0),
+	  sample_position_counter(0),
 	  per_sample_increase((samprate << 16)/CONFIG_XASAUDIO_TX_SAMPLERATE),
 	  data_samplerate(samprate) {
 
-	sound_file = sd_raw_fopen(file_path, "rb"); // Open file in read-binary mode
-	if (sound_file) {
-		file_size = sd_raw_get_file_size(file_path);
-		if (file_size <= 0) { // Check for valid file size
-			ESP_LOGE("ByteCassette", "Failed to get valid size for file: %s", file_path);
-			sd_raw_fclose(sound_file);
-			sound_file = nullptr;
-		}
-	} else {
-		ESP_LOGE("ByteCassette", "Failed to open sound file: %s", file_path);
-	}
-	sample_position_counter = 0;
+	if(asset == nullptr)
+		stream = new SDStream(file_path);
+
+	load_first_sample();
+
 	volume = 255;
 }
 
+ByteCassette::ByteCassette(TX &audio_handler, sound_id_t sound_id, const sound_bank_entry_t *entry)
+	: Source(audio_handler),
+	  asset(nullptr), asset_position(0),
+	  stream(nullptr),
+	  prev_sample(0), next_sample(0),
+	  sample_position_counter(0),
+	  per_sample_increase(entry ? (entry->sample_rate << 16)/CONFIG_XASAUDIO_TX_SAMPLERATE : 0),
+	  data_samplerate(entry ? entry->sample_rate : 0) {
+
+	volume = 255;
+
+	if(entry == nullptr) {
+		ESP_LOGE("XasAudio", "Sound %u is not in the sound bank!", sound_id);
+		return;
+	}
+	if(entry->format != SOUND_FORMAT_U8) {
+		ESP_LOGE("XasAudio", "Sound %u has unsupported format %u", sound_id, entry->format);
+		return;
+	}
+
+	char cache_key[8];
+	make_cache_key(cache_key, sound_id);
+
+	asset = AssetCache::get(cache_key, SoundBank::get_path(), entry->offset, entry->length);
+	if(asset == nullptr)
+		stream = new SDStream(SoundBank::get_path(), entry->offset, entry->length);
+
+	load_first_sample();
+
+	if(entry->volume != 0)
+		volume = entry->volume;
+}
+
+ByteCassette::ByteCassette(TX &handler, sound_id_t sound_id)
+	: ByteCassette(handler, sound_id, SoundBank::get(sound_id)) {
+}
+
 ByteCassette::ByteCassette(TX &handler, const bytecassette_data_t &cassette)
-	: ByteCassette(handler, cassette.file_path, // Use file_path
+	: ByteCassette(handler, cassette.file_path,
 			cassette.data_samplerate) {
 
 	if(cassette.volume != 0)
@@ -48,100 +84,153 @@ ByteCassette::ByteCassette(TX &handler, const bytecassette_data_t &cassette)
 }
 
 ByteCassette::~ByteCassette() {
-	if (sound_file) { // Close the file if it was opened
-		sd_raw_fclose(sound_file);
-		sound_file = nullptr;
+	detach();
+
+	delete stream;
+}
+
+void ByteCassette::load_first_sample() {
+	uint8_t first_byte = 0x80;
+	pop_byte(first_byte);
+
+	prev_sample = int16_t(first_byte) - 0x80;
+	next_sample = prev_sample;
+}
+
+bool ByteCassette::pop_byte(uint8_t &out) {
+	if(asset != nullptr) {
+		if(asset_position >= asset->size)
+			return false;
+
+		out = asset->data[asset_position++];
+		return true;
 	}
+
+	if(stream == nullptr)
+		return false;
+
+	return stream->pop(out);
+}
+
+bool ByteCassette::data_at_end() {
+	if(asset != nullptr)
+		return asset_position >= asset->size;
+
+	return stream == nullptr || stream->at_end();
 }
 
 bool ByteCassette::process_frame() {
-	if(!sound_file || current_file_pos >= file_size) // Check if file is open and not at EOF
+	if(is_finished())
 		return false;
 
 	std::array<int16_t, XASAUDIO_TX_FRAME_SAMPLE_NO> temp_buffer = {};
-	uint8_t prev_byte_val = 0;
-	uint8_t next_byte_val = 0;
-
-	// Read the first byte for prev_sample if not at the beginning
-	if (current_file_pos > 0) {
-		sd_raw_fseek(sound_file, current_file_pos -1, SEEK_SET);
-		sd_raw_fread(&prev_byte_val, 1, 1, sound_file);
-	} else {
-		// If at the beginning, read current byte for both prev and next initially
-		sd_raw_fseek(sound_file, current_file_pos, SEEK_SET);
-		sd_raw_fread(&prev_byte_val, 1, 1, sound_file);
-		next_byte_val = prev_byte_val; // Initialize next_byte_val
-	}
-
 
 	for(int i=0; i<XASAUDIO_TX_FRAME_SAMPLE_NO; i++) {
-		// Ensure we don't read past the end of the file for the next sample
-		if(current_file_pos + 1 >= file_size) {
-			// If current_file_pos is the last byte, use it as next_sample as well or handle as end of sound
-			if (current_file_pos < file_size) { // If there's still one byte to read
-			    sd_raw_fseek(sound_file, current_file_pos, SEEK_SET);
-				sd_raw_fread(&next_byte_val, 1, 1, sound_file);
-			} else { // No more bytes to read
-				current_file_pos = file_size; // Mark as finished
-				break;
-			}
-		} else {
-			// Read the next byte for next_sample
-			sd_raw_fseek(sound_file, current_file_pos + 1, SEEK_SET);
-			sd_raw_fread(&next_byte_val, 1, 1, sound_file);
-		}
-
+		uint16_t sample_fraction = (sample_position_counter & 0xFFFF);
 
-		int32_t prev_sample_val_proc = int32_t(prev_byte_val) - 0x80;
-		int32_t next_sample_val_proc = int32_t(next_byte_val) - 0x80;
+		temp_buffer[i] = (((0xFFFF - sample_fraction) * int32_t(prev_sample)) + (sample_fraction * int32_t(next_sample))) >> 8;
 
 		sample_position_counter += per_sample_increase;
-		uint16_t sample_fraction = (sample_position_counter & 0xFFFF);
 
-		temp_buffer[i] = (((0xFFFF - sample_fraction) * prev_sample_val_proc) + (sample_fraction * next_sample_val_proc)) >> 8;
-
-		// Advance file position based on how many full samples were consumed
-		long samples_consumed = sample_position_counter >> 16;
-		current_file_pos += samples_consumed;
-		sample_position_counter &= 0xFFFF; // Keep the fractional part
+		// Advance through the source data by however many whole samples
+		// were stepped over. On an underrun the last sample is held, which
+		// is far less audible than a gap.
+		for(; sample_position_counter >= (1<<16); sample_position_counter -= (1<<16)) {
+			uint8_t new_byte;
+			if(!pop_byte(new_byte))
+				break;
 
-		if (current_file_pos >= file_size) {
-			break; // End of file reached
+			prev_sample = next_sample;
+			next_sample = int16_t(new_byte) - 0x80;
 		}
 
-		// Update prev_byte_val for the next iteration
-		prev_byte_val = next_byte_val; // Current next becomes next iteration\'s previous
+		if(data_at_end())
+			break;
 	}
 
 	add_mono_frame_to_handler(temp_buffer.data(), volume);
 
-	return current_file_pos < file_size; // Continue if not at EOF
+	return !data_at_end();
 }
 
-void ByteCassette::play(TX &handler, const bytecassette_data_t &cassette) {
+void ByteCassette::play(TX &handler, const bytecassette_data_t &cassette, source_priority_t priority) {
 	auto temp = new ByteCassette(handler, cassette);
+	temp->priority = priority;
 	temp->start(true);
 
 	ESP_LOGD("Audio", "Newly created source is %p", temp);
 }
 
-void ByteCassette::play(TX &handler, const ByteCassetteCollection &cassettes) {
+void ByteCassette::play(TX &handler, sound_id_t sound_id, source_priority_t priority) {
+	auto temp = new ByteCassette(handler, sound_id);
+	temp->priority = priority;
+	temp->start(true);
+}
+
+void ByteCassette::play(TX &handler, const ByteCassetteCollection &cassettes, source_priority_t priority) {
 	if(cassettes.size() == 0)
 		return;
 
-	play(handler, cassettes.at(esp_random()%cassettes.size()));
+	play(handler, pick(cassettes), priority);
+}
+
+sound_id_t ByteCassette::pick(const ByteCassetteCollection &cassettes) {
+	size_t start = esp_random() % cassettes.size();
+
+	char cache_key[8];
+	for(size_t i = 0; i < cassettes.size(); i++) {
+		sound_id_t sound_id = cassettes[(start + i) % cassettes.size()];
+
+		make_cache_key(cache_key, sound_id);
+		if(AssetCache::contains(cache_key))
+			return sound_id;
+	}
+
+	return cassettes[start];
+}
+
+void ByteCassette::preload(const bytecassette_data_t &cassette) {
+	AssetCache::preload(cassette.file_path);
+}
+
+void ByteCassette::preload(sound_id_t sound_id, bool may_evict) {
+	auto entry = SoundBank::get(sound_id);
+	if(entry == nullptr || entry->format != SOUND_FORMAT_U8)
+		return;
+
+	char cache_key[8];
+	make_cache_key(cache_key, sound_id);
+
+	AssetCache::preload(cache_key, SoundBank::get_path(), entry->offset, entry->length, may_evict);
+}
+
+void ByteCassette::preload(const ByteCassetteCollection &cassettes) {
+	char cache_key[8];
+	size_t cached = 0;
+
+	for(auto sound_id : cassettes) {
+		preload(sound_id, cached < 2);
+
+		make_cache_key(cache_key, sound_id);
+		if(AssetCache::contains(cache_key))
+			cached++;
+	}
 }
 
 template<>
-Source * TX::play(const bytecassette_data_t &sample, bool auto_delete) {
+Source * TX::play(const bytecassette_data_t &sample, bool auto_delete, source_priority_t priority) {
 	auto new_sound = new ByteCassette(*this, sample);
+	new_sound->priority = priority;
 	new_sound->start(auto_delete);
 
 	return new_sound;
 }
 
 bool ByteCassette::is_finished() {
-	return !sound_file || current_file_pos >= file_size; // Check if file is open and not at EOF
+	if(asset == nullptr && (stream == nullptr || !stream->is_open()))
+		return true;
+
+	return data_at_end();
 }
 
 } /* namespace Audio */
@@ -0,0 +1,107 @@
+/*
+ * I2SDACSink.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include <xasin/audio/I2SDACSink.h>
+
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include <esp_log.h>
+
+namespace Xasin {
+namespace Audio {
+
+static_assert((XASAUDIO_TX_FRAME_SAMPLE_NO % 2) == 0, "The I2S DAC sink needs an even number of samples per frame!");
+
+I2SDACSink::I2SDACSink(i2s_dac_mode_t dac_mode) :
+	dac_mode(dac_mode), running(false),
+	dma_frame() {
+}
+
+void I2SDACSink::init() {
+	ESP_LOGI("XasAudio", "Initializing I2S DMA output to internal DAC.");
+
+	i2s_config_t i2s_cfg = {};
+	i2s_cfg.mode = i2s_mode_t(I2S_MODE_MASTER | I2S_MODE_TX | I2S_MODE_DAC_BUILT_IN);
+	i2s_cfg.sample_rate = CONFIG_XASAUDIO_TX_SAMPLERATE;
+	i2s_cfg.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+	if(dac_mode == I2S_DAC_CHANNEL_BOTH_EN)
+		i2s_cfg.channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT;
+	else if(dac_mode == I2S_DAC_CHANNEL_LEFT_EN)
+		i2s_cfg.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+	else
+		i2s_cfg.channel_format = I2S_CHANNEL_FMT_ONLY_RIGHT;
+	i2s_cfg.communication_format = I2S_COMM_FORMAT_STAND_MSB;
+	i2s_cfg.intr_alloc_flags = 0;
+	i2s_cfg.dma_buf_count = CONFIG_XASAUDIO_TX_DMA_COUNT;
+	i2s_cfg.dma_buf_len = XASAUDIO_TX_FRAME_SAMPLE_NO;
+	i2s_cfg.use_apll = false;
+	i2s_cfg.tx_desc_auto_clear = true;
+
+	// The built-in DAC is only reachable through I2S0.
+	esp_err_t ret = i2s_driver_install(I2S_NUM_0, &i2s_cfg, 0, nullptr);
+	if(ret != ESP_OK) {
+		ESP_LOGE("XasAudio", "I2S driver install failed: %s", esp_err_to_name(ret));
+		return;
+	}
+
+	i2s_set_pin(I2S_NUM_0, nullptr);
+	i2s_set_dac_mode(dac_mode);
+
+	i2s_zero_dma_buffer(I2S_NUM_0);
+	i2s_stop(I2S_NUM_0);
+}
+
+void I2SDACSink::write_frame(const int16_t *data) {
+	size_t frame_length = XASAUDIO_TX_FRAME_SAMPLE_NO;
+
+	// The DAC takes the upper byte of each sample as an unsigned value,
+	// so flip the sign bit to move from signed to offset binary.
+	if(dac_mode == I2S_DAC_CHANNEL_BOTH_EN) {
+		for(int i=0; i < XASAUDIO_TX_FRAME_SAMPLE_NO; i++) {
+			dma_frame[2*i]   = uint16_t(data[i]) ^ 0x8000;
+			dma_frame[2*i+1] = dma_frame[2*i];
+		}
+
+		frame_length *= 2;
+	}
+	else {
+		// In 16 bit mono mode the I2S FIFO emits the two halves of each
+		// 32 bit word in swapped order, hence the pairwise swap.
+		for(int i=0; i < XASAUDIO_TX_FRAME_SAMPLE_NO; i += 2) {
+			dma_frame[i]   = uint16_t(data[i+1]) ^ 0x8000;
+			dma_frame[i+1] = uint16_t(data[i])   ^ 0x8000;
+		}
+	}
+
+	size_t bytes_written = 0;
+	i2s_write(I2S_NUM_0, dma_frame.data(), frame_length * sizeof(uint16_t),
+		&bytes_written, portMAX_DELAY);
+}
+
+void I2SDACSink::start() {
+	if(running)
+		return;
+
+	running = true;
+	i2s_start(I2S_NUM_0);
+}
+
+void I2SDACSink::stop() {
+	if(!running)
+		return;
+
+	running = false;
+
+	// Push out mid-point silence before halting, rather than letting
+	// the DAC drop to zero (or hold the last sample), which would pop.
+	const std::array<int16_t, XASAUDIO_TX_FRAME_SAMPLE_NO> silence = {};
+	for(int i=0; i < CONFIG_XASAUDIO_TX_DMA_COUNT; i++)
+		write_frame(silence.data());
+
+	i2s_stop(I2S_NUM_0);
+}
+
+} /* namespace Audio */
+} /* namespace Xasin */
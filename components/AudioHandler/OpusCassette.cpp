@@ -8,8 +8,6 @@
 #include <xasin/audio/OpusCassette.h>
 #include <xasin/audio/AudioTX.h>
 
-#include <xasin/audio/ByteCassette.h>
-
 #include <array>
 
 #define LOG_LOCAL_LEVEL ESP_LOG_INFO
@@ -34,6 +32,8 @@ OpusCassette::OpusCassette(TX &handler, const opus_audio_bundle_t &data) :
 }
 
 OpusCassette::~OpusCassette() {
+	detach();
+
 	if(decoder != nullptr)
 		opus_decoder_destroy(decoder);
 }
@@ -64,7 +64,7 @@ bool OpusCassette::process_frame() {
 	opus_decode(decoder, data_ptr, audio_data.packetsize,
 		decode_buffer.data(), decode_buffer.size(), 0);
 
-	add_lr_frame(decode_buffer.data(), true, volume);
+	add_mono_frame_to_handler(decode_buffer.data(), volume);
 
 	packet_no++;
 	if(repeat && (packet_no >= audio_data.num_packets))
@@ -99,33 +99,28 @@ void OpusCassette::fade_out() {
 }
 
 template<>
-Source * TX::play(const opus_audio_bundle_t &data, bool auto_delete) {
-	// If this is the case, it is assumed this is a raw byte cassette,
-	// and will be played as such. This is meant for compatibility with
-	// raw formats.
+Source * TX::play(const opus_audio_bundle_t &data, bool auto_delete, source_priority_t priority) {
+	// Raw byte cassettes used to be embedded in flash like this.
+	// ByteCassette now only plays from the SD card, so such bundles
+	// have to be moved into a SoundBank instead.
 	if(data.packetsize <= 1) {
-		bytecassette_data_t byte_cassette = {
-			data.data,
-			data.data + data.num_packets,
-			44100,
-			data.volume
-		};
-
-		return this->play(byte_cassette, auto_delete);
+		ESP_LOGE("Audio::Opus", "Raw in-flash cassettes are no longer supported!");
+		return nullptr;
 	}
 
 	auto new_cassette = new OpusCassette(*this, data);
+	new_cassette->priority = priority;
 	new_cassette->start(auto_delete);
 
 	return new_cassette;
 }
 
 template<>
-Source * TX::play(const OpusCassetteCollection &collection, bool auto_delete) {
+Source * TX::play(const OpusCassetteCollection &collection, bool auto_delete, source_priority_t priority) {
 	if(collection.size() == 0)
 		return nullptr;
 
-	return play(collection.at(esp_random()%collection.size()), auto_delete);
+	return play(collection.at(esp_random()%collection.size()), auto_delete, priority);
 }
 
 }
@@ -0,0 +1,153 @@
+/*
+ * PacketCassette.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include <xasin/audio/PacketCassette.h>
+#include <xasin/audio/AudioTX.h>
+#include <xasin/audio/ADPCM.h>
+
+#include <string.h>
+#include <algorithm>
+#include <array>
+
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include <esp_log.h>
+#include <esp_timer.h>
+
+namespace Xasin {
+namespace Audio {
+
+static_assert(sizeof(packet_stream_header_t) == 16, "Packet stream header must be 16 bytes!");
+
+// Largest packet that is accepted, one frame worth of 16 bit samples.
+#define PACKET_MAX_SIZE (XASAUDIO_TX_FRAME_SAMPLE_NO * 2)
+
+packet_cassette_stats_t PacketCassette::stats = {};
+
+packet_cassette_stats_t PacketCassette::get_stats() {
+	return stats;
+}
+
+PacketCassette::PacketCassette(TX &handler, const packet_cassette_data_t &cassette) :
+	Source(handler),
+	stream(cassette.file_path, 2),
+	header(),
+	packet_no(0), pending_length(0),
+	valid(false),
+	volume(255) {
+
+	valid = read_header(cassette.file_path);
+
+	if(cassette.volume != 0)
+		volume = cassette.volume;
+}
+
+PacketCassette::~PacketCassette() {
+	detach();
+}
+
+bool PacketCassette::read_header(const char *file_path) {
+	if(!stream.is_open())
+		return false;
+
+	if(!stream.read(reinterpret_cast<uint8_t*>(&header), sizeof(header))
+		|| memcmp(header.magic, "XPKT", 4) != 0 || header.version != 1) {
+
+		ESP_LOGE("XasAudio", "Not a valid packet stream: %s", file_path);
+		return false;
+	}
+
+	if(header.codec != PACKET_CODEC_IMA_ADPCM) {
+		ESP_LOGE("XasAudio", "Packet stream %s uses unsupported codec %u", file_path, header.codec);
+		return false;
+	}
+
+	// Packets are decoded straight into a TX frame, without resampling.
+	if(header.sample_rate != CONFIG_XASAUDIO_TX_SAMPLERATE || header.frame_samples != XASAUDIO_TX_FRAME_SAMPLE_NO) {
+		ESP_LOGE("XasAudio", "Packet stream %s is %u Hz with %u samples per packet, expected %u Hz and %u",
+			file_path, header.sample_rate, header.frame_samples,
+			CONFIG_XASAUDIO_TX_SAMPLERATE, XASAUDIO_TX_FRAME_SAMPLE_NO);
+		return false;
+	}
+
+	return true;
+}
+
+bool PacketCassette::process_frame() {
+	if(is_finished())
+		return false;
+
+	// Both the length prefix and the packet itself are only consumed
+	// once they are completely buffered. On an underrun the frame is
+	// skipped, and the packet is picked up again next frame.
+	if(pending_length == 0) {
+		uint8_t prefix[2];
+		if(!stream.read(prefix, 2)) {
+			stats.underruns++;
+			return !stream.at_end();
+		}
+
+		pending_length = prefix[0] | (prefix[1] << 8);
+		if(pending_length == 0 || pending_length > PACKET_MAX_SIZE) {
+			ESP_LOGE("XasAudio", "Invalid packet length %u at packet %u", pending_length, packet_no);
+			valid = false;
+			return false;
+		}
+	}
+
+	std::array<uint8_t, PACKET_MAX_SIZE> packet;
+	if(!stream.read(packet.data(), pending_length)) {
+		stats.underruns++;
+		return !stream.at_end();
+	}
+
+	std::array<int16_t, XASAUDIO_TX_FRAME_SAMPLE_NO> decode_buffer = {};
+
+	int64_t decode_start = esp_timer_get_time();
+	ADPCM::decode_packet(packet.data(), pending_length, decode_buffer.data(), decode_buffer.size());
+	uint32_t decode_time = esp_timer_get_time() - decode_start;
+
+	stats.frames_decoded++;
+	stats.last_decode_us = decode_time;
+	stats.max_decode_us = std::max(stats.max_decode_us, decode_time);
+	stats.total_decode_us += decode_time;
+
+	add_mono_frame_to_handler(decode_buffer.data(), volume);
+
+	pending_length = 0;
+	packet_no++;
+
+	return true;
+}
+
+bool PacketCassette::is_finished() {
+	if(!valid)
+		return true;
+
+	return packet_no >= header.packet_count || stream.at_end();
+}
+
+TickType_t PacketCassette::remaining_runtime() {
+	if(is_finished())
+		return 0;
+
+	return (header.packet_count - packet_no) * CONFIG_XASAUDIO_TX_FRAMELENGTH / portTICK_PERIOD_MS;
+}
+
+template<>
+Source * TX::play(const packet_cassette_data_t &cassette, bool auto_delete, source_priority_t priority) {
+	auto new_cassette = new PacketCassette(*this, cassette);
+	new_cassette->priority = priority;
+	new_cassette->start(auto_delete);
+
+	return new_cassette;
+}
+
+Source *PacketCassette::play(TX &handler, const packet_cassette_data_t &cassette, source_priority_t priority) {
+	return handler.play(cassette, true, priority);
+}
+
+} /* namespace Audio */
+} /* namespace Xasin */
@@ -0,0 +1,231 @@
+/*
+ * SDStream.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include <xasin/audio/SDStream.h>
+
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include <esp_log.h>
+#include "sd_raw_access.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace Xasin {
+namespace Audio {
+
+TaskHandle_t SDStream::prefetch_task = nullptr;
+SemaphoreHandle_t SDStream::stream_list_mutex = nullptr;
+SDStream *SDStream::stream_list_head = nullptr;
+
+std::atomic<uint32_t> SDStream::stat_block_reads(0);
+std::atomic<uint32_t> SDStream::stat_bytes_read(0);
+std::atomic<uint32_t> SDStream::stat_underruns(0);
+
+void SDStream::prefetch_task_func(void *args) {
+	while(true) {
+		xTaskNotifyWait(0, 0, nullptr, portMAX_DELAY);
+
+		xSemaphoreTake(stream_list_mutex, portMAX_DELAY);
+		for(SDStream *stream = stream_list_head; stream != nullptr; stream = stream->next_stream)
+			stream->fill();
+		xSemaphoreGive(stream_list_mutex);
+	}
+}
+
+void SDStream::start_prefetch_task() {
+	if(prefetch_task != nullptr)
+		return;
+
+	stream_list_mutex = xSemaphoreCreateMutex();
+	xTaskCreate(prefetch_task_func, "XasAudio SD", 3*1024, nullptr, 4, &prefetch_task);
+}
+
+sd_stream_stats_t SDStream::get_stats() {
+	sd_stream_stats_t out = {};
+	out.block_reads = stat_block_reads.load();
+	out.bytes_read  = stat_bytes_read.load();
+	out.underruns   = stat_underruns.load();
+
+	return out;
+}
+
+SDStream::SDStream(const char *file_path, uint32_t prefill_blocks) :
+	next_stream(nullptr),
+	file(nullptr), file_size(0),
+	bytes_loaded(0), bytes_consumed(0),
+	buffer() {
+
+	file = sd_raw_fopen(file_path, "rb");
+	if(file == nullptr) {
+		ESP_LOGE("XasAudio", "Failed to open sound file: %s", file_path);
+		return;
+	}
+
+	long raw_size = sd_raw_get_file_size(file_path);
+	if(raw_size <= 0) {
+		ESP_LOGE("XasAudio", "Failed to get valid size for file: %s", file_path);
+		sd_raw_fclose(file);
+		file = nullptr;
+		return;
+	}
+	file_size.store(raw_size);
+
+	start(prefill_blocks);
+}
+
+SDStream::SDStream(const char *file_path, uint32_t offset, uint32_t length, uint32_t prefill_blocks) :
+	next_stream(nullptr),
+	file(nullptr), file_size(0),
+	bytes_loaded(0), bytes_consumed(0),
+	buffer() {
+
+	file = sd_raw_fopen(file_path, "rb");
+	if(file == nullptr) {
+		ESP_LOGE("XasAudio", "Failed to open sound file: %s", file_path);
+		return;
+	}
+
+	if(sd_raw_fseek(file, offset, SEEK_SET) != 0) {
+		ESP_LOGE("XasAudio", "Failed to seek to %u in %s", offset, file_path);
+		sd_raw_fclose(file);
+		file = nullptr;
+		return;
+	}
+	file_size.store(length);
+
+	start(prefill_blocks);
+}
+
+void SDStream::start(uint32_t prefill_blocks) {
+	// Load the start of the file synchronously so that playback can
+	// begin on the very next frame; the rest is left to the prefetcher.
+	fill(prefill_blocks);
+
+	if(stream_list_mutex == nullptr)
+		return;
+
+	xSemaphoreTake(stream_list_mutex, portMAX_DELAY);
+	next_stream = stream_list_head;
+	stream_list_head = this;
+	xSemaphoreGive(stream_list_mutex);
+
+	xTaskNotify(prefetch_task, 0, eNoAction);
+}
+
+SDStream::~SDStream() {
+	if(stream_list_mutex != nullptr) {
+		xSemaphoreTake(stream_list_mutex, portMAX_DELAY);
+		for(SDStream **i = &stream_list_head; *i != nullptr; i = &(*i)->next_stream) {
+			if(*i == this) {
+				*i = next_stream;
+				break;
+			}
+		}
+		xSemaphoreGive(stream_list_mutex);
+	}
+
+	if(file != nullptr)
+		sd_raw_fclose(file);
+}
+
+void SDStream::fill(uint32_t max_blocks) {
+	if(file == nullptr)
+		return;
+
+	for(; max_blocks != 0; max_blocks--) {
+		uint32_t loaded = bytes_loaded.load();
+		uint32_t size = file_size.load();
+
+		if(loaded >= size)
+			return;
+		if((buffer.size() - (loaded - bytes_consumed.load())) < XASAUDIO_SD_BLOCK_SIZE)
+			return;
+
+		// bytes_loaded only ever advances by whole blocks until the end
+		// of the file, so every block lands contiguously inside the ring
+		// buffer. A short read therefore has to end the file.
+		// The read is clamped so that streams out of a sound bank do
+		// not pick up the start of the following sound.
+		uint32_t to_read = std::min<uint32_t>(XASAUDIO_SD_BLOCK_SIZE, size - loaded);
+		size_t read = sd_raw_fread(buffer.data() + (loaded % buffer.size()), 1, to_read, file);
+
+		stat_block_reads.fetch_add(1);
+		stat_bytes_read.fetch_add(read);
+
+		if(read < to_read) {
+			ESP_LOGW("XasAudio", "SD stream truncated at %u of %u bytes", loaded + read, size);
+			file_size.store(loaded + read);
+		}
+
+		bytes_loaded.store(loaded + read);
+
+		if(read < to_read)
+			return;
+	}
+}
+
+bool SDStream::is_open() const {
+	return file != nullptr;
+}
+long SDStream::size() const {
+	return file_size.load();
+}
+
+uint32_t SDStream::available() const {
+	return bytes_loaded.load() - bytes_consumed.load();
+}
+bool SDStream::at_end() const {
+	return bytes_consumed.load() >= file_size.load();
+}
+
+bool SDStream::pop(uint8_t &out) {
+	uint32_t consumed = bytes_consumed.load();
+
+	if(consumed == bytes_loaded.load()) {
+		if(consumed < file_size.load())
+			stat_underruns.fetch_add(1);
+
+		return false;
+	}
+
+	out = buffer[consumed % buffer.size()];
+	consumed++;
+	bytes_consumed.store(consumed);
+
+	// A whole block was freed up, let the prefetcher top us up again.
+	if((consumed % XASAUDIO_SD_BLOCK_SIZE) == 0 && prefetch_task != nullptr)
+		xTaskNotify(prefetch_task, 0, eNoAction);
+
+	return true;
+}
+
+bool SDStream::read(uint8_t *out, uint32_t length) {
+	uint32_t consumed = bytes_consumed.load();
+
+	if((bytes_loaded.load() - consumed) < length) {
+		if(consumed < file_size.load())
+			stat_underruns.fetch_add(1);
+
+		return false;
+	}
+
+	// The data may wrap around the end of the ring buffer.
+	uint32_t start = consumed % buffer.size();
+	uint32_t first_part = std::min<uint32_t>(length, buffer.size() - start);
+
+	memcpy(out, buffer.data() + start, first_part);
+	memcpy(out + first_part, buffer.data(), length - first_part);
+
+	bytes_consumed.store(consumed + length);
+
+	if((consumed / XASAUDIO_SD_BLOCK_SIZE) != ((consumed + length) / XASAUDIO_SD_BLOCK_SIZE) && prefetch_task != nullptr)
+		xTaskNotify(prefetch_task, 0, eNoAction);
+
+	return true;
+}
+
+} /* namespace Audio */
+} /* namespace Xasin */
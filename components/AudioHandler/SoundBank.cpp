@@ -0,0 +1,79 @@
+/*
+ * SoundBank.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include <xasin/audio/SoundBank.h>
+
+#include <string.h>
+
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include <esp_log.h>
+#include "sd_raw_access.h"
+
+namespace Xasin {
+namespace Audio {
+
+static_assert(sizeof(sound_bank_entry_t) == 16, "Sound bank index entries must be 16 bytes!");
+static_assert(sizeof(sound_bank_header_t) == 16, "Sound bank header must be 16 bytes!");
+
+std::string SoundBank::bank_path;
+std::vector<sound_bank_entry_t> SoundBank::index;
+
+bool SoundBank::load(const char *file_path, uint32_t expected_id) {
+	FILE *file = sd_raw_fopen(file_path, "rb");
+	if(file == nullptr) {
+		ESP_LOGE("XasAudio", "Failed to open sound bank: %s", file_path);
+		return false;
+	}
+
+	sound_bank_header_t header = {};
+	if(sd_raw_fread(&header, sizeof(header), 1, file) != 1
+		|| memcmp(header.magic, "XSBK", 4) != 0 || header.version != 1) {
+
+		ESP_LOGE("XasAudio", "Not a valid sound bank: %s", file_path);
+		sd_raw_fclose(file);
+		return false;
+	}
+
+	std::vector<sound_bank_entry_t> new_index(header.sound_count);
+	size_t read = sd_raw_fread(new_index.data(), sizeof(sound_bank_entry_t), header.sound_count, file);
+	sd_raw_fclose(file);
+
+	if(read != header.sound_count) {
+		ESP_LOGE("XasAudio", "Sound bank index truncated: %s", file_path);
+		return false;
+	}
+
+	if(expected_id != 0 && header.bank_id != expected_id)
+		ESP_LOGW("XasAudio", "Sound bank %s is %08X, expected %08X. Sound IDs may be off!",
+			file_path, header.bank_id, expected_id);
+
+	bank_path = file_path;
+	index = std::move(new_index);
+
+	ESP_LOGI("XasAudio", "Loaded sound bank %s with %u sounds", file_path, header.sound_count);
+
+	return true;
+}
+
+bool SoundBank::is_loaded() {
+	return !index.empty();
+}
+const char *SoundBank::get_path() {
+	return bank_path.c_str();
+}
+uint16_t SoundBank::get_sound_count() {
+	return index.size();
+}
+
+const sound_bank_entry_t *SoundBank::get(sound_id_t sound_id) {
+	if(sound_id >= index.size())
+		return nullptr;
+
+	return &index[sound_id];
+}
+
+} /* namespace Audio */
+} /* namespace Xasin */
@@ -14,10 +14,20 @@ namespace Audio {
 Source::Source(TX &handler) : audio_handler(handler) {
 	was_started = false;
 	is_deletable = false;
+	was_stopped = false;
+
+	next_voice = nullptr;
+	was_unlinked = false;
+
+	cpu_time_last_us = 0;
+	cpu_time_total_us = 0;
+	frames_processed = 0;
+
+	priority = PRIORITY_SFX;
 }
 
 Source::~Source() {
-	audio_handler.remove_source(this);
+	detach();
 }
 
 bool Source::process_frame() {
@@ -28,6 +38,10 @@ void Source::boop_playback() {
 	audio_handler.boop_thread();
 }
 
+void Source::detach() {
+	audio_handler.remove_source(this);
+}
+
 // Add mono frame data to the audio_handler's buffer
 void Source::add_mono_frame_to_handler(const int16_t *data, uint8_t volume) {
 	audio_handler.add_mono_frame(data, volume);
@@ -44,6 +58,14 @@ bool Source::has_audio() {
 	return !is_finished();
 }
 
+bool Source::is_active() {
+	return !was_stopped && !is_finished();
+}
+void Source::stop() {
+	was_stopped = true;
+	boop_playback();
+}
+
 TickType_t Source::remaining_runtime() {
 	return 0;
 }
@@ -7,68 +7,189 @@
 
 #include "xasin/audio/TXStream.h"
 #include <cstring>
+#include <cstdlib>
+#include <algorithm>
 
 #define LOG_LOCAL_LEVEL ESP_LOG_INFO
 #include "esp_log.h"
+#include "esp_timer.h"
+
+#define STREAM_FRAME_US (CONFIG_XASAUDIO_TX_FRAMELENGTH * 1000)
+#define STREAM_MAX_DEPTH (CONFIG_XASAUDIO_TX_STREAM_BUFFER_LENGTH / CONFIG_XASAUDIO_TX_FRAMELENGTH)
+#define STREAM_PLC_FRAMES (CONFIG_XASAUDIO_TX_STREAM_PLC_LENGTH / CONFIG_XASAUDIO_TX_FRAMELENGTH)
 
 namespace Xasin {
 namespace Audio {
 
 TXStream::TXStream(TX &handler) : Source(handler),
-		packet_tail(0), packet_head(0), packet_count(0),
 		packet_buf(),
-		packet_low_watermark(0), packet_period_watermark(0),
-		decode_buffer_pos(UINT32_MAX), decode_buffer(), decode_playback_speed(1<<16) {
-
-	decoder = opus_decoder_create(CONFIG_XASAUDIO_TX_SAMPLERATE, 1, nullptr);
-	if(decoder <= 0)
-		ESP_LOGE("audio_tx", "Decoder could not be created!");
+		has_sequence(false), playing(false),
+		play_sequence(0), highest_sequence(0),
+		last_arrival_us(0), last_arrival_sequence(0),
+		jitter_q4(0),
+		stats(),
+		decode_buffer_pos(UINT32_MAX), decode_buffer(), decode_playback_speed(1<<16),
+		concealed_frames(STREAM_PLC_FRAMES),
+		volume(255) {
 
 	packet_semaphore = xSemaphoreCreateMutex();
+
+	stats.target_depth = CONFIG_XASAUDIO_TX_STREAM_MIN_DEPTH / CONFIG_XASAUDIO_TX_FRAMELENGTH;
 }
 
 TXStream::~TXStream() {
-	packet_count = 0;
-
-	opus_decoder_destroy(decoder);
+	detach();
 
 	xSemaphoreTake(packet_semaphore, portMAX_DELAY);
+	has_sequence = false;
+	playing = false;
 	xSemaphoreGive(packet_semaphore);
 
 	vSemaphoreDelete(packet_semaphore);
 }
 
+int16_t TXStream::buffer_depth() {
+	if(!has_sequence)
+		return 0;
+
+	// Counts missing packets as well, as they will be concealed.
+	return std::max<int16_t>(0, int16_t(highest_sequence - play_sequence) + 1);
+}
+
+void TXStream::update_jitter(uint16_t sequence, uint16_t batch_size) {
+	int64_t now = now_us();
+
+	if(last_arrival_us != 0) {
+		// Difference between the time the packets took to arrive, and the
+		// time they should have taken according to their sequence numbers.
+		int64_t arrival_delta = now - last_arrival_us;
+		int64_t send_delta = int64_t(int16_t(sequence - last_arrival_sequence)) * STREAM_FRAME_US;
+
+		uint32_t deviation = std::min<int64_t>(std::abs(arrival_delta - send_delta),
+				CONFIG_XASAUDIO_TX_STREAM_BUFFER_LENGTH * 1000);
+
+		// J += (|D| - J) / 16, with J kept as 16 * J to not lose precision
+		jitter_q4 += deviation - (jitter_q4 >> 4);
+	}
+
+	last_arrival_us = now;
+	last_arrival_sequence = sequence;
+
+	stats.jitter_us = jitter_q4 >> 4;
+
+	// Four times the jitter covers nearly all arrivals, on top of which
+	// at least one whole batch needs to fit in.
+	int32_t target = (CONFIG_XASAUDIO_TX_STREAM_MIN_DEPTH * 1000 + 4 * stats.jitter_us + STREAM_FRAME_US - 1) / STREAM_FRAME_US;
+	target = std::max<int32_t>(target, batch_size);
+	target = std::min<int32_t>(target, STREAM_MAX_DEPTH - batch_size);
+
+	stats.target_depth = std::max<int32_t>(1, target);
+}
+
+void TXStream::insert_packet(uint16_t sequence, const uint8_t * packet_ptr, uint16_t packet_size) {
+	int16_t offset = sequence - play_sequence;
+
+	// (Re)start the stream if this is the first packet, if the buffer
+	// ran dry and was not restarted yet, or if the sender jumped so
+	// far that none of the buffered packets are of any use anymore.
+	if(!has_sequence || (!playing && buffer_depth() == 0)
+		|| offset >= int16_t(packet_buf.size()) || offset <= -int16_t(packet_buf.size())) {
+
+		for(auto &slot : packet_buf)
+			slot.valid = false;
+
+		has_sequence = true;
+		play_sequence = sequence;
+		highest_sequence = sequence;
+	}
+	else if(offset < 0) {
+		stats.packets_late++;
+		return;
+	}
+
+	auto &slot = packet_buf[sequence & (packet_buf.size() - 1)];
+	if(slot.valid && slot.sequence == sequence)
+		return;
+
+	memcpy(slot.data.data(), packet_ptr, packet_size);
+	slot.length = packet_size;
+	slot.sequence = sequence;
+	slot.valid = true;
+
+	stats.packets_received++;
+
+	if(int16_t(sequence - highest_sequence) > 0)
+		highest_sequence = sequence;
+}
+
 bool TXStream::decode_next_packet() {
-	if(packet_count == 0)
-		return false;
+	stream_packet_t packet_copy;
+	bool have_packet = false;
 
 	xSemaphoreTake(packet_semaphore, portMAX_DELAY);
 
-	stream_opus_packet_t packet_copy = packet_buf[packet_tail];
-	packet_tail = (packet_tail + 1) % packet_buf.size();
-	packet_count--;
+	int16_t depth = buffer_depth();
 
-	if(packet_count < packet_low_watermark)
-		packet_low_watermark = packet_count;
-	if(packet_count < packet_period_watermark)
-		packet_period_watermark = packet_count;
+	if(!playing && has_sequence && depth >= stats.target_depth)
+		playing = true;
 
-	if((packet_tail >> 2) == 0) {
-		packet_low_watermark = packet_period_watermark;
-		packet_period_watermark = packet_buf.size();
-	}
+	if(playing) {
+		if(depth > 0) {
+			auto &slot = packet_buf[play_sequence & (packet_buf.size() - 1)];
+
+			if(slot.valid && slot.sequence == play_sequence) {
+				packet_copy = slot;
+				have_packet = true;
+			}
+			else
+				stats.packets_lost++;
+
+			slot.valid = false;
+			play_sequence++;
+		}
+		else {
+			// Out of packets, go back to buffering up to the target depth.
+			stats.underruns++;
+			playing = false;
+		}
 
-	int low_watermark_fill_percent = (packet_low_watermark << 8) / packet_buf.size();
-	ESP_LOGV("TXStream", "Audio low watermark fill percent %d", low_watermark_fill_percent);
+		// Play slightly faster while above the target depth, and slightly
+		// slower while below, by at most 2%. Not noticeable to the ear,
+		// but enough to drift back on target within a few seconds.
+		int32_t excess = buffer_depth() - stats.target_depth;
+		if(excess > 1)
+			decode_playback_speed = (1<<16) + std::min<int32_t>(excess * 328, 1311);
+		else if(excess < 0)
+			decode_playback_speed = (1<<16) + std::max<int32_t>(excess * 328, -1311);
+		else
+			decode_playback_speed = (1<<16);
+	}
 
-	decode_playback_speed = (1<<16) + (low_watermark_fill_percent - 51) * 12.85;
+	bool keep_playing = playing;
+	stats.depth = buffer_depth();
 
 	xSemaphoreGive(packet_semaphore);
 
-	auto retcode = opus_decode(decoder, packet_copy.data.data(), packet_copy.length,
-			decode_buffer.data(), decode_buffer.size(), 0);
+	if(have_packet) {
+		size_t decoded = ADPCM::decode_packet(packet_copy.data.data(), packet_copy.length,
+				decode_buffer.data(), decode_buffer.size());
+		std::fill(decode_buffer.begin() + decoded, decode_buffer.end(), 0);
 
-	if(retcode < 0)
+		concealed_frames = 0;
+	}
+	else if(concealed_frames < STREAM_PLC_FRAMES) {
+		// Repeat the last frame, fading it out a bit further each time.
+		// This is far less jarring than a sudden gap.
+		int32_t remaining = STREAM_PLC_FRAMES - concealed_frames;
+		for(auto &sample : decode_buffer)
+			sample = (int32_t(sample) * (remaining - 1)) / remaining;
+
+		concealed_frames++;
+		stats.frames_concealed++;
+	}
+	else if(keep_playing)
+		decode_buffer.fill(0);
+	else
 		return false;
 
 	decode_buffer_pos &= 0xFFFF;
@@ -77,11 +198,12 @@ bool TXStream::decode_next_packet() {
 }
 
 bool TXStream::process_frame() {
-	if((packet_count == 0) && (decode_buffer_pos >= XASAUDIO_TX_FRAME_SAMPLE_NO))
+	if(!has_audio() && (decode_buffer_pos >> 16) >= decode_buffer.size())
 		return false;
 
-	std::array<int16_t, XASAUDIO_TX_FRAME_SAMPLE_NO> frame_buffer;
+	std::array<int16_t, XASAUDIO_TX_FRAME_SAMPLE_NO> frame_buffer = {};
 
+	bool produced_audio = false;
 	for(int i = 0; i<frame_buffer.size(); i++) {
 		if((decode_buffer_pos >> 16) >= decode_buffer.size()) {
 			if(!decode_next_packet())
@@ -90,78 +212,78 @@ bool TXStream::process_frame() {
 
 		frame_buffer[i] = decode_buffer[decode_buffer_pos >> 16];
 		decode_buffer_pos += decode_playback_speed;
+
+		produced_audio = true;
 	}
 
-	add_lr_frame(frame_buffer.data());
+	if(produced_audio)
+		add_mono_frame_to_handler(frame_buffer.data(), volume);
 
-	return true;
+	return produced_audio;
 }
 
-void TXStream::feed_packet(const uint8_t * packet_ptr, uint16_t packet_size) {
-	if(packet_size >= XASAUDIO_TX_STREAM_MAX_PACKETSIZE)
+void TXStream::feed_packet(uint16_t sequence, const uint8_t * packet_ptr, uint16_t packet_size) {
+	feed_packets(sequence, packet_ptr, packet_size, 1);
+}
+
+void TXStream::feed_packets(uint16_t first_sequence, const uint8_t * data_ptr, uint16_t packet_size, uint8_t packet_no) {
+	ESP_LOGV("TXStream", "Attempting to feed %d packets with size %d", packet_no, packet_size);
+
+	if(packet_size > XASAUDIO_TX_STREAM_MAX_PACKETSIZE)
+		return;
+	if(packet_no == 0)
 		return;
 
 	xSemaphoreTake(packet_semaphore, portMAX_DELAY);
 
-	memcpy(packet_buf[packet_head].data.data(), packet_ptr, packet_size);
-	packet_buf[packet_head].length = packet_size;
+	update_jitter(first_sequence, packet_no);
 
-	packet_head = (1 + packet_head) % packet_buf.size();
+	for(uint8_t i = 0; i < packet_no; i++)
+		insert_packet(first_sequence + i, data_ptr + i * packet_size, packet_size);
 
-	if(packet_count == packet_buf.size())
-		packet_tail = (1 + packet_tail) % packet_buf.size();
-	else
-		packet_count++;
+	bool should_start = !playing && buffer_depth() >= stats.target_depth;
+
+	ESP_LOGV("TXStream", "Fed %d packets, depth now %d", packet_no, buffer_depth());
 
 	xSemaphoreGive(packet_semaphore);
 
-	if(packet_count > packet_buf.size() / 2)
+	if(should_start)
 		boop_playback();
 }
 
-void TXStream::feed_packets(const uint8_t * data_ptr, uint16_t packet_size, uint8_t packet_no) {
-	ESP_LOGV("TXStream", "Attempting to feed %d packets with size %d", packet_no, packet_size);
-
-	if(packet_size >= XASAUDIO_TX_STREAM_MAX_PACKETSIZE)
-		return;
-	if(packet_no == 0)
-		return;
-
-	xSemaphoreTake(packet_semaphore, portMAX_DELAY);
+bool TXStream::feed_message(const uint8_t * data_ptr, size_t length) {
+	if(length < 3)
+		return false;
 
-	if(packet_no > packet_buf.size()) {
-		data_ptr += packet_size * (packet_no - packet_buf.size());
-		packet_no = packet_buf.size();
-	}
+	uint16_t first_sequence = data_ptr[0] | (data_ptr[1] << 8);
+	uint8_t packet_no = data_ptr[2];
 
-	packet_count += packet_no;
-	if(packet_count > packet_buf.size()) {
-		packet_tail = (packet_tail + packet_count - packet_buf.size()) % packet_buf.size();
-		packet_count = packet_buf.size();
-	}
-
-	for(; packet_no != 0; packet_no--) {
-		memcpy(packet_buf[packet_head].data.data(), data_ptr, packet_size);
-		packet_buf[packet_head].length = packet_size;
+	if(packet_no == 0 || ((length - 3) % packet_no) != 0)
+		return false;
 
-		packet_head = (1 + packet_head) % packet_buf.size();
+	feed_packets(first_sequence, data_ptr + 3, (length - 3) / packet_no, packet_no);
 
-		data_ptr += packet_size;
-	}
+	return true;
+}
 
-	ESP_LOGV("TXStream", "Fed %d packets, total count now %d", packet_no, packet_count);
+int64_t TXStream::now_us() {
+	return esp_timer_get_time();
+}
 
+tx_stream_stats_t TXStream::get_stats() {
+	xSemaphoreTake(packet_semaphore, portMAX_DELAY);
+	tx_stream_stats_t out = stats;
 	xSemaphoreGive(packet_semaphore);
 
-	if(packet_count > packet_buf.size() / 2)
-		boop_playback();
+	return out;
 }
 
 bool TXStream::is_finished() {
 	return false;
 }
 bool TXStream::has_audio() {
-	return packet_count > 0;
+	return playing || concealed_frames < STREAM_PLC_FRAMES
+		|| (has_sequence && buffer_depth() >= stats.target_depth);
 }
 
 } /* namespace Audio */
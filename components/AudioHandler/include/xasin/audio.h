@@ -1,2 +1,3 @@
 #include <xasin/audio/AudioTX.h>
-#include <xasin/audio/ByteCassette.h>
\ No newline at end of file
+#include <xasin/audio/ByteCassette.h>
+#include <xasin/audio/PacketCassette.h>
\ No newline at end of file
@@ -0,0 +1,31 @@
+/*
+ * ADPCM.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_AUDIOHANDLER_ADPCM_H_
+#define ESP32_AUDIOHANDLER_ADPCM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Every packet starts with its own predictor state: s16 predictor,
+// u8 step index and a reserved byte, followed by one nibble per sample.
+#define XASAUDIO_ADPCM_PACKET_HEADER_SIZE 4
+#define XASAUDIO_ADPCM_PACKET_SIZE(samples) (XASAUDIO_ADPCM_PACKET_HEADER_SIZE + ((samples) + 1) / 2)
+
+namespace Xasin {
+namespace Audio {
+namespace ADPCM {
+
+// Decodes one self-contained IMA-ADPCM packet, as written by
+// tools/mkpacketstream.py, into at most max_samples samples.
+// Returns the number of samples written.
+size_t decode_packet(const uint8_t *data, size_t length, int16_t *out, size_t max_samples);
+
+} /* namespace ADPCM */
+} /* namespace Audio */
+} /* namespace Xasin */
+
+#endif /* ESP32_AUDIOHANDLER_ADPCM_H_ */
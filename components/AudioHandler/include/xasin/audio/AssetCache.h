@@ -0,0 +1,129 @@
+/*
+ * AssetCache.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_AUDIOHANDLER_ASSETCACHE_H_
+#define ESP32_AUDIOHANDLER_ASSETCACHE_H_
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+namespace Xasin {
+namespace Audio {
+
+// A sound file held completely in RAM, in exactly the format it
+// has on the SD card, so that playing it needs no SD access at all.
+struct cached_asset_t {
+	uint8_t *data;
+	uint32_t size;
+
+	cached_asset_t(uint32_t size);
+	~cached_asset_t();
+
+	cached_asset_t(const cached_asset_t&) = delete;
+};
+
+// Sources hold on to this while they play, which keeps the data
+// alive even if the cache decides to drop the entry meanwhile.
+typedef std::shared_ptr<const cached_asset_t> AssetHandle;
+
+struct asset_cache_stats_t {
+	uint32_t hits;
+	uint32_t misses;
+	// Lookups of sounds already known to be uncacheable, which go
+	// straight to streaming without touching the SD card.
+	uint32_t negative_hits;
+	uint32_t evictions;
+
+	uint32_t entries;
+	uint32_t bytes_used;
+};
+
+// Path-keyed cache of short sound files, loaded from SD in a single
+// read and kept in a pool of at most CONFIG_XASAUDIO_ASSET_CACHE_SIZE
+// bytes. Files above CONFIG_XASAUDIO_ASSET_CACHE_MAX_ENTRY bytes are
+// never cached and are left to be streamed instead.
+// Once the budget is reached, the least recently used entries that
+// are not currently playing are evicted to make space.
+// Sounds that are too large or missing are remembered as such, so that
+// playing them again does not cost another stat() or lock round trip.
+class AssetCache {
+private:
+	struct entry_t {
+		AssetHandle asset;
+		uint32_t last_use;
+	};
+
+	static SemaphoreHandle_t cache_mutex;
+
+	// std::less<> allows lookups with a plain const char *, so a cache
+	// hit does not need to allocate a std::string for the key.
+	static std::map<std::string, entry_t, std::less<>> entries;
+
+	// Keys that can not be cached, until the next clear(). Dropped as a
+	// whole once it grows past UNCACHEABLE_MAX keys, so that a long list
+	// of missing files can not grow it without bound.
+	static const size_t UNCACHEABLE_MAX = 32;
+	static std::set<std::string, std::less<>> uncacheable;
+
+	static uint32_t use_counter;
+	static asset_cache_stats_t stats;
+
+	// Evicts unused entries until size more bytes fit into the budget,
+	// then reserves them. Without may_evict, only reserves space that is
+	// still free. Must be called with cache_mutex held.
+	static bool reserve(uint32_t size, bool may_evict);
+
+	static AssetHandle find(const char *key);
+	// Looks up key while holding the lock, optionally counting the result.
+	// Sets is_uncacheable if key is known not to be worth loading.
+	static AssetHandle lookup(const char *key, bool count_stats, bool &is_uncacheable);
+	static void mark_uncacheable(const char *key);
+
+	static AssetHandle load(const char *key, const char *file_path, uint32_t offset, uint32_t size,
+			bool may_evict = true);
+	static AssetHandle load_file(const char *file_path);
+
+public:
+	static void init();
+
+	// Returns the cached file, loading it if it is not cached yet.
+	// Returns nullptr if the file is too large to be cached, could
+	// not be read, or the cache was not initialized.
+	static AssetHandle get(const char *file_path);
+	// Same as get(), but does not count towards the hit/miss stats.
+	// Meant to pull in sounds ahead of time, i.e. while a weapon
+	// is being equipped.
+	static bool preload(const char *file_path);
+
+	// Same as above, but for size bytes at offset inside of file_path,
+	// i.e. one sound out of a SoundBank, cached under the given key.
+	static AssetHandle get(const char *key, const char *file_path, uint32_t offset, uint32_t size);
+	// Without may_evict, the sound is only loaded into space that is still
+	// free, i.e. for the further variants of a sound collection.
+	static bool preload(const char *key, const char *file_path, uint32_t offset, uint32_t size,
+			bool may_evict = true);
+
+	// True if key is cached right now. Neither counts nor loads anything.
+	static bool contains(const char *key);
+
+	// Drops all entries, and forgets which sounds were uncacheable.
+	// Sources still playing keep their data until they are done.
+	static void clear();
+
+	static asset_cache_stats_t get_stats();
+};
+
+} /* namespace Audio */
+} /* namespace Xasin */
+
+#endif /* ESP32_AUDIOHANDLER_ASSETCACHE_H_ */
@@ -8,16 +8,32 @@
 #include <memory>
 
 #include <array>
-#include <vector>
+#include <atomic>
 
-#include "driver/dac.h"
+#include "xasin/audio/OutputSink.h"
+#include "xasin/audio/Source.h"
+#include "xasin/audio/LockFreeQueue.h"
 
 #define XASAUDIO_TX_FRAME_SAMPLE_NO ((CONFIG_XASAUDIO_TX_SAMPLERATE * CONFIG_XASAUDIO_TX_FRAMELENGTH)/1000)
 
 namespace Xasin {
 namespace Audio {
 
-class Source;
+// Processing cost of a single voice, as reported by TX::get_voice_stats()
+struct voice_stats_t {
+	const Source *source;
+	source_priority_t priority;
+	uint32_t last_frame_us;
+	uint32_t average_frame_us;
+	uint32_t frames;
+};
+
+// Request to link or unlink a source, sent from any task to the
+// processing task, which is the only one to touch the voice list.
+struct source_command_t {
+	Source *source;
+	bool insert;
+};
 
 class TX {
 public:
@@ -33,16 +49,49 @@ private:
 	TaskHandle_t processing_task; // Handle to a large-stack processing task,
 		// useful to decode audio frames or perform other intensive operations.
 
-	SemaphoreHandle_t audio_config_mutex;
+	OutputSink *output_sink; // Hardware (or file) the mixed frames are sent to.
+
+	TaskHandle_t reclaim_task; // Low-priority task deleting finished sources,
+		// so that destructors (closing files etc.) never run on the audio path.
+
+	// Source insertion/removal requests, applied at the start of each frame.
+	LockFreeQueue<source_command_t, CONFIG_XASAUDIO_TX_COMMAND_QUEUE_LENGTH> source_commands;
+	// Finished, deletable sources waiting to be deleted by the reclaim task.
+	LockFreeQueue<Source *, CONFIG_XASAUDIO_TX_COMMAND_QUEUE_LENGTH> reclaim_queue;
+
+	// Intrusive list of all linked sources, in order of insertion.
+	// Owned by the processing task, no other task may walk it.
+	Source *voice_list_head;
+
+	// Snapshot of the per-voice statistics, published by the processing
+	// task after each frame, double buffered for readers on other tasks.
+	std::array<std::array<voice_stats_t, CONFIG_XASAUDIO_TX_MAX_VOICES>, 2> voice_stats;
+	std::array<size_t, 2> voice_stats_count;
+	std::atomic<uint8_t> voice_stats_index;
 
 	float volume_estimate;
 
-	void calculate_audio_rms();
+	// Number of voices that were taken over by a higher priority
+	// source, and of sources that could not get a voice at all.
+	uint32_t voices_stolen;
+	uint32_t voices_rejected;
+
+	void calculate_audio_rms(uint64_t square_sum);
+
+	// Processing task side of the voice list handling.
+	void apply_source_commands();
+	void link_source(Source * source);
+	void unlink_source(Source * source);
+	void collect_sources();
 
 protected:
 friend Source;
 
 	void boop_thread();
+	// Blocks until the processing task no longer references the source.
+	// Before init(), and on the processing task itself, the source is
+	// unlinked right away. Must not be called from the DAC output task,
+	// or by a source for itself from within process_frame().
 	void remove_source(Source * source);
 	void insert_source(Source * source);
 
@@ -54,32 +103,49 @@ friend Source;
 	// The data here represents mono audio samples.
 	std::array<int16_t, XASAUDIO_TX_FRAME_SAMPLE_NO> audio_buffer; // Changed to mono
 
-	std::vector<Source*> audio_sources; // Ensure this line is present and not commented
+	// Sources are summed up in this 32 bit buffer without saturation.
+	// Once all sources have been processed, it is clamped down into
+	// audio_buffer in a single pass (see Mix::saturate()).
+	std::array<int32_t, XASAUDIO_TX_FRAME_SAMPLE_NO> mix_buffer;
 
 	bool clipping;
 
 	// These functions will always add exactly one frame (e.g., 20ms) of the given mono data
-	// buffer to the audio buffer. volume can be used to reduce the volume
+	// buffer to the mix buffer. volume can be used to reduce the volume
 	// of the given sample (independently of the global volume).
-	// This function handles potential saturation.
+	// Saturation is handled once per frame, after all sources were added.
 	void add_mono_frame(const int16_t *data, uint8_t volume = 255);
 
 public:
 	bool calculate_volume;
 	uint8_t volume_mod;
 
-	void audio_dac_output_task(); // Handles sending audio data to the DAC
+	void audio_dac_output_task(); // Handles sending audio data to the output sink
+	void reclaim_task_run();
 	bool largestack_process();
 
 	TX(); // Constructor
 	TX(const TX&) = delete;
 
-	void init(TaskHandle_t processing_task); // Initialize DAC and audio task
+	// Initialize the output and audio task. If no sink is given, the
+	// internal DAC channel 1 is driven via I2S DMA.
+	void init(TaskHandle_t processing_task, OutputSink *sink = nullptr);
 
 	float get_volume_estimate();
 	bool had_clipping();
 
-	template<class T> Source * play(const T &sample, bool auto_delete = true);
+	// Number of sources currently holding a voice. At most
+	// CONFIG_XASAUDIO_TX_MAX_VOICES deletable sources play at the same
+	// time, sources kept by their owner are never stopped for them.
+	size_t get_voice_count();
+	// Fills stats with the processing cost of up to max_count active
+	// voices, as of the last processed frame. Returns the number of
+	// entries written.
+	size_t get_voice_stats(voice_stats_t *stats, size_t max_count);
+	uint32_t get_stolen_voice_count();
+	uint32_t get_rejected_voice_count();
+
+	template<class T> Source * play(const T &sample, bool auto_delete = true, source_priority_t priority = PRIORITY_SFX);
 };
 
 }
@@ -9,9 +9,11 @@
 #define ESP32_AUDIOHANDLER_BITCASETTE_H_
 
 #include <xasin/audio/Source.h>
+#include <xasin/audio/SDStream.h>
+#include <xasin/audio/AssetCache.h>
+#include <xasin/audio/SoundBank.h>
 #include <stdint.h>
 #include <vector>
-#include <stdio.h> // Added for FILE*
 
 #define XASAUDIO_CASSETTE(path, samplerate, volume) ((const Xasin::Audio::bytecassette_data_t){path, samplerate, volume})
 
@@ -24,15 +26,30 @@ struct bytecassette_data_t {
 	uint8_t volume;
 };
 
-typedef std::vector<bytecassette_data_t> ByteCassetteCollection;
+// Set of interchangeable sounds out of the SoundBank, one of which
+// is picked at random on every play.
+typedef std::vector<sound_id_t> ByteCassetteCollection;
 
 class ByteCassette: public Source {
 private:
-	FILE* sound_file; // Changed from const uint8_t *current_sample
-	long file_size; // To store the size of the sound file
-	long current_file_pos; // To track the current read position in the file
+	// Short sounds are played straight out of the AssetCache.
+	AssetHandle asset;
+	uint32_t asset_position;
 
-	// const uint8_t * const sample_end; // No longer needed
+	// Longer ones fall back to a block-buffered reader, kept topped up
+	// by the SD prefetch task so that process_frame() only reads RAM.
+	SDStream *stream;
+
+	bool pop_byte(uint8_t &out);
+	bool data_at_end();
+
+	void load_first_sample();
+
+	ByteCassette(TX &handler, sound_id_t sound_id, const sound_bank_entry_t *entry);
+
+	// The two samples currently being interpolated between.
+	int16_t prev_sample;
+	int16_t next_sample;
 
 	uint32_t sample_position_counter;
 	const uint32_t per_sample_increase;
@@ -48,9 +65,24 @@ public:
 	ByteCassette(TX &handler, const char *file_path, // Changed from sample_ptr and sample_end
 			uint32_t intended_samplerate);
 	ByteCassette(TX &handler, const bytecassette_data_t &cassette);
-
-	static void play(TX &handler, const bytecassette_data_t &cassette);
-	static void play(TX &handler, const ByteCassetteCollection &cassette);
+	// Plays a sound out of the SoundBank, at the bank's sample rate and volume.
+	ByteCassette(TX &handler, sound_id_t sound_id);
+
+	static void play(TX &handler, const bytecassette_data_t &cassette, source_priority_t priority = PRIORITY_SFX);
+	static void play(TX &handler, sound_id_t sound_id, source_priority_t priority = PRIORITY_SFX);
+	static void play(TX &handler, const ByteCassetteCollection &cassette, source_priority_t priority = PRIORITY_SFX);
+
+	// Picks the sound of a collection to play, at random, but out of the
+	// variants that are cached if there are any. A collection rarely fits
+	// into the AssetCache as a whole, this keeps every play a cache hit.
+	static sound_id_t pick(const ByteCassetteCollection &cassette);
+
+	// Pulls the cassette's sound(s) into the AssetCache ahead of time.
+	static void preload(const bytecassette_data_t &cassette);
+	static void preload(sound_id_t sound_id, bool may_evict = true);
+	// Other sounds are evicted until two variants are cached, the
+	// rest only use up space that is still free.
+	static void preload(const ByteCassetteCollection &cassette);
 
 	~ByteCassette();
 
@@ -0,0 +1,52 @@
+/*
+ * I2SDACSink.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_AUDIOHANDLER_I2SDACSINK_H_
+#define ESP32_AUDIOHANDLER_I2SDACSINK_H_
+
+#include <xasin/audio/OutputSink.h>
+#include <xasin/audio/AudioTX.h>
+
+#include "driver/i2s.h"
+
+#include <array>
+
+namespace Xasin {
+namespace Audio {
+
+// Drives the ESP32's internal 8 bit DAC via I2S0 and DMA.
+// Frames are handed to the I2S driver's DMA ring of
+// CONFIG_XASAUDIO_TX_DMA_COUNT buffers, one frame each, so the
+// writing task sleeps until a buffer has been played out instead
+// of timing every single sample by hand.
+class I2SDACSink : public OutputSink {
+private:
+	const i2s_dac_mode_t dac_mode;
+	bool running;
+
+	// Samples converted to the unsigned format the DAC expects.
+	// Twice the frame size, as both DAC channels need their own
+	// copy of each sample when driven together.
+	std::array<uint16_t, 2 * XASAUDIO_TX_FRAME_SAMPLE_NO> dma_frame;
+
+public:
+	// I2S_DAC_CHANNEL_RIGHT_EN is DAC channel 1 (GPIO25),
+	// I2S_DAC_CHANNEL_LEFT_EN is DAC channel 2 (GPIO26),
+	// I2S_DAC_CHANNEL_BOTH_EN outputs the same mono mix on both.
+	I2SDACSink(i2s_dac_mode_t dac_mode = I2S_DAC_CHANNEL_RIGHT_EN);
+
+	void init();
+
+	void write_frame(const int16_t *data);
+
+	void start();
+	void stop();
+};
+
+} /* namespace Audio */
+} /* namespace Xasin */
+
+#endif /* ESP32_AUDIOHANDLER_I2SDACSINK_H_ */
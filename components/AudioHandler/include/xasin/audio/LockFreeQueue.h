@@ -0,0 +1,108 @@
+/*
+ * LockFreeQueue.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_AUDIOHANDLER_LOCKFREEQUEUE_H_
+#define ESP32_AUDIOHANDLER_LOCKFREEQUEUE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <array>
+#include <atomic>
+
+namespace Xasin {
+namespace Audio {
+
+// Bounded multi-producer, multi-consumer queue without any locks.
+// Each cell carries a sequence number telling producers and consumers
+// whether it is free or filled for the current lap around the ring,
+// so push() and pop() never block and never allocate. This makes it
+// usable from the audio path, where taking a mutex could stall a frame.
+// T should be a small, trivially copyable type.
+template<typename T, size_t capacity>
+class LockFreeQueue {
+private:
+	static_assert(capacity >= 2 && (capacity & (capacity - 1)) == 0,
+		"LockFreeQueue capacity must be a power of two!");
+
+	struct cell_t {
+		std::atomic<uint32_t> sequence;
+		T data;
+	};
+
+	std::array<cell_t, capacity> cells;
+
+	std::atomic<uint32_t> enqueue_pos;
+	std::atomic<uint32_t> dequeue_pos;
+
+public:
+	LockFreeQueue() : cells(), enqueue_pos(0), dequeue_pos(0) {
+		for(size_t i = 0; i < capacity; i++)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	LockFreeQueue(const LockFreeQueue&) = delete;
+
+	// Returns false if the queue is full.
+	bool push(const T &data) {
+		uint32_t pos = enqueue_pos.load(std::memory_order_relaxed);
+		cell_t *cell;
+
+		while(true) {
+			cell = &cells[pos & (capacity - 1)];
+			int32_t diff = int32_t(cell->sequence.load(std::memory_order_acquire) - pos);
+
+			if(diff == 0) {
+				if(enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if(diff < 0)
+				return false;
+			else
+				pos = enqueue_pos.load(std::memory_order_relaxed);
+		}
+
+		cell->data = data;
+		cell->sequence.store(pos + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// Returns false if the queue is empty.
+	bool pop(T &data) {
+		uint32_t pos = dequeue_pos.load(std::memory_order_relaxed);
+		cell_t *cell;
+
+		while(true) {
+			cell = &cells[pos & (capacity - 1)];
+			int32_t diff = int32_t(cell->sequence.load(std::memory_order_acquire) - (pos + 1));
+
+			if(diff == 0) {
+				if(dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if(diff < 0)
+				return false;
+			else
+				pos = dequeue_pos.load(std::memory_order_relaxed);
+		}
+
+		data = cell->data;
+		cell->sequence.store(pos + capacity, std::memory_order_release);
+
+		return true;
+	}
+
+	// Approximate fill level, only exact while no push/pop is in progress.
+	size_t size() const {
+		return enqueue_pos.load(std::memory_order_relaxed) - dequeue_pos.load(std::memory_order_relaxed);
+	}
+};
+
+} /* namespace Audio */
+} /* namespace Xasin */
+
+#endif /* ESP32_AUDIOHANDLER_LOCKFREEQUEUE_H_ */
@@ -0,0 +1,71 @@
+/*
+ * MixKernel.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_AUDIOHANDLER_MIXKERNEL_H_
+#define ESP32_AUDIOHANDLER_MIXKERNEL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Xasin {
+namespace Audio {
+namespace Mix {
+
+// Converts the combined 8 bit global and per-source volume into a
+// Q15 gain. Keeping the gain within 16 bits means every multiply in
+// accumulate() is a plain 16x16 bit one, which the ESP32 does in a
+// single MUL16S, and which host compilers vectorise readily.
+inline int16_t q15_gain(uint8_t volume_a, uint8_t volume_b) {
+	return int16_t((uint32_t(volume_a) * volume_b) >> 1);
+}
+
+// Adds one scaled input frame onto the 32 bit mix accumulator.
+// No saturation happens here: intermediate sums cannot overflow for
+// any sane number of voices, and clamping once in saturate() is both
+// cheaper and avoids order-dependent clipping between sources.
+inline void accumulate(int32_t * __restrict acc, const int16_t * __restrict in, size_t count, int16_t gain) {
+	for(size_t i = 0; i < count; i++)
+		acc[i] += (int32_t(in[i]) * gain) >> 15;
+}
+
+// Clamps the accumulator into 16 bit output samples and, if square_sum
+// is given, sums up the squares of the output in the same pass.
+// Returns true if any sample had to be clipped.
+template<bool with_rms>
+inline bool saturate_impl(const int32_t * __restrict acc, int16_t * __restrict out, size_t count, uint64_t *square_sum) {
+	int32_t clipped = 0;
+	uint64_t sum = 0;
+
+	for(size_t i = 0; i < count; i++) {
+		int32_t value = acc[i];
+		int32_t clamped = value < INT16_MIN ? INT16_MIN : value;
+		clamped = clamped > INT16_MAX ? INT16_MAX : clamped;
+
+		clipped |= value ^ clamped;
+		out[i] = int16_t(clamped);
+
+		if(with_rms)
+			sum += uint32_t(clamped * clamped);
+	}
+
+	if(with_rms)
+		*square_sum = sum;
+
+	return clipped != 0;
+}
+
+inline bool saturate(const int32_t *acc, int16_t *out, size_t count, uint64_t *square_sum = nullptr) {
+	if(square_sum == nullptr)
+		return saturate_impl<false>(acc, out, count, nullptr);
+
+	return saturate_impl<true>(acc, out, count, square_sum);
+}
+
+} /* namespace Mix */
+} /* namespace Audio */
+} /* namespace Xasin */
+
+#endif /* ESP32_AUDIOHANDLER_MIXKERNEL_H_ */
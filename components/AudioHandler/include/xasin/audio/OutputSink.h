@@ -0,0 +1,38 @@
+/*
+ * OutputSink.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_AUDIOHANDLER_OUTPUTSINK_H_
+#define ESP32_AUDIOHANDLER_OUTPUTSINK_H_
+
+#include <stdint.h>
+
+namespace Xasin {
+namespace Audio {
+
+// Destination for the mixed mono frames produced by the TX.
+// A sink is fed exactly one frame of XASAUDIO_TX_FRAME_SAMPLE_NO
+// signed 16 bit samples at a time, and is expected to pace the
+// caller: write_frame() should block (without spinning) until the
+// frame has been accepted by the output hardware.
+class OutputSink {
+public:
+	virtual ~OutputSink() {}
+
+	// Called once from TX::init(), before any frames are written.
+	virtual void init() = 0;
+
+	virtual void write_frame(const int16_t *data) = 0;
+
+	// Output is paused while the TX has nothing to play, and
+	// resumed before the next frame is written.
+	virtual void start() = 0;
+	virtual void stop() = 0;
+};
+
+} /* namespace Audio */
+} /* namespace Xasin */
+
+#endif /* ESP32_AUDIOHANDLER_OUTPUTSINK_H_ */
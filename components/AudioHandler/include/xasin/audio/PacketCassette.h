@@ -0,0 +1,95 @@
+/*
+ * PacketCassette.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_AUDIOHANDLER_PACKETCASSETTE_H_
+#define ESP32_AUDIOHANDLER_PACKETCASSETTE_H_
+
+#include <xasin/audio/Source.h>
+#include <xasin/audio/SDStream.h>
+
+#include <stdint.h>
+
+namespace Xasin {
+namespace Audio {
+
+enum packet_codec_t : uint8_t {
+	// IMA-ADPCM, 4 bit per sample. Every packet starts with its own
+	// predictor state, so a lost or late packet does not corrupt the next.
+	PACKET_CODEC_IMA_ADPCM = 0,
+	// Reserved for Opus packets, not decoded yet.
+	PACKET_CODEC_OPUS = 1,
+};
+
+// Header of a packet stream file, as written by tools/mkpacketstream.py.
+// It is followed by packet_count packets, each a little endian u16
+// length plus that many bytes of payload. Every packet decodes to
+// exactly one TX frame of frame_samples samples.
+struct packet_stream_header_t {
+	char magic[4];
+	uint8_t version;
+	uint8_t codec;
+	uint16_t frame_samples;
+	uint32_t sample_rate;
+	uint32_t packet_count;
+} __attribute__((packed));
+
+struct packet_cassette_data_t {
+	const char *file_path;
+	uint8_t volume;
+};
+
+// Totals over all packet cassettes, i.e. to check whether decoding
+// keeps up with playback.
+struct packet_cassette_stats_t {
+	uint32_t frames_decoded;
+	// Frames that had to be skipped as the SD card did not keep up.
+	uint32_t underruns;
+
+	uint32_t last_decode_us;
+	uint32_t max_decode_us;
+	uint64_t total_decode_us;
+};
+
+// Plays long, compressed tracks straight off the SD card.
+// The file is read ahead in blocks by the SDStream prefetch task, while
+// decoding happens one packet per frame in process_frame(), i.e. on the
+// TX's large-stack processing task.
+class PacketCassette : public Source {
+private:
+	static packet_cassette_stats_t stats;
+
+	SDStream stream;
+	packet_stream_header_t header;
+
+	uint32_t packet_no;
+	// Length of the next packet, once its prefix was read.
+	uint16_t pending_length;
+
+	bool valid;
+
+	bool read_header(const char *file_path);
+
+protected:
+	bool process_frame();
+
+public:
+	static packet_cassette_stats_t get_stats();
+
+	uint8_t volume;
+
+	PacketCassette(TX &handler, const packet_cassette_data_t &cassette);
+	~PacketCassette();
+
+	static Source *play(TX &handler, const packet_cassette_data_t &cassette, source_priority_t priority = PRIORITY_SFX);
+
+	bool is_finished();
+	TickType_t remaining_runtime();
+};
+
+} /* namespace Audio */
+} /* namespace Xasin */
+
+#endif /* ESP32_AUDIOHANDLER_PACKETCASSETTE_H_ */
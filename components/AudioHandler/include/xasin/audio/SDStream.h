@@ -0,0 +1,108 @@
+/*
+ * SDStream.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_AUDIOHANDLER_SDSTREAM_H_
+#define ESP32_AUDIOHANDLER_SDSTREAM_H_
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <array>
+#include <atomic>
+
+#define XASAUDIO_SD_BLOCK_SIZE  CONFIG_XASAUDIO_SD_BLOCK_SIZE
+#define XASAUDIO_SD_BUFFER_SIZE (CONFIG_XASAUDIO_SD_BLOCK_SIZE * CONFIG_XASAUDIO_SD_BLOCK_COUNT)
+
+namespace Xasin {
+namespace Audio {
+
+// Running totals over all streams, to check how much SD traffic
+// audio playback is causing. Every counted read is exactly one
+// sd_raw_fread() call and thus one s_sd_mutex acquisition.
+struct sd_stream_stats_t {
+	uint32_t block_reads;
+	uint32_t bytes_read;
+	uint32_t underruns;
+};
+
+// Sequential, read-ahead reader for a file on the SD card.
+// The file is read in whole blocks into a ring buffer by a shared,
+// low-priority prefetch task, so that the audio processing task only
+// ever touches RAM.
+// There is exactly one producer (the prefetch task, or the constructor
+// before the stream is registered) and one consumer (the owning Source),
+// so the ring buffer indices need no lock. The file size can shrink
+// on the producer side if the file turns out truncated, so it and the
+// shared statistics are atomics, too.
+class SDStream {
+private:
+	static TaskHandle_t prefetch_task;
+	static SemaphoreHandle_t stream_list_mutex;
+	static SDStream *stream_list_head;
+
+	static std::atomic<uint32_t> stat_block_reads;
+	static std::atomic<uint32_t> stat_bytes_read;
+	static std::atomic<uint32_t> stat_underruns;
+
+	static void prefetch_task_func(void *args);
+
+	SDStream *next_stream;
+
+	FILE *file;
+	std::atomic<uint32_t> file_size;
+
+	// Total number of bytes read from the file and consumed from
+	// the buffer respectively. Their difference is the fill level.
+	std::atomic<uint32_t> bytes_loaded;
+	std::atomic<uint32_t> bytes_consumed;
+
+	alignas(4) std::array<uint8_t, XASAUDIO_SD_BUFFER_SIZE> buffer;
+
+	// Prefills and registers the stream with the prefetch task.
+	void start(uint32_t prefill_blocks);
+
+	// Reads as many whole blocks as fit into the free buffer space,
+	// up to max_blocks. Must only be called from the producer side.
+	void fill(uint32_t max_blocks = UINT32_MAX);
+
+public:
+	// Starts the shared prefetch task. Until this is called, streams
+	// only hold the blocks they read in their constructor.
+	static void start_prefetch_task();
+	static sd_stream_stats_t get_stats();
+
+	SDStream(const char *file_path, uint32_t prefill_blocks = 1);
+	// Streams only length bytes starting at offset, i.e. a single
+	// sound out of a SoundBank. Costs one seek, but no stat().
+	SDStream(const char *file_path, uint32_t offset, uint32_t length, uint32_t prefill_blocks = 1);
+	~SDStream();
+
+	SDStream(const SDStream&) = delete;
+
+	bool is_open() const;
+	long size() const;
+
+	// Bytes currently buffered and ready to be read.
+	uint32_t available() const;
+	// True once every byte of the file has been consumed.
+	bool at_end() const;
+
+	// Fetches the next byte from the buffer. Returns false if no
+	// data is buffered, either due to end-of-file or an underrun.
+	bool pop(uint8_t &out);
+	// Fetches exactly length bytes at once. If fewer are buffered,
+	// nothing is consumed and false is returned.
+	bool read(uint8_t *out, uint32_t length);
+};
+
+} /* namespace Audio */
+} /* namespace Xasin */
+
+#endif /* ESP32_AUDIOHANDLER_SDSTREAM_H_ */
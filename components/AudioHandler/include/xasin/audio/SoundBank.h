@@ -0,0 +1,69 @@
+/*
+ * SoundBank.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_AUDIOHANDLER_SOUNDBANK_H_
+#define ESP32_AUDIOHANDLER_SOUNDBANK_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace Xasin {
+namespace Audio {
+
+typedef uint16_t sound_id_t;
+
+enum sound_format_t : uint8_t {
+	// Unsigned 8 bit mono PCM, as played by ByteCassette
+	SOUND_FORMAT_U8 = 0,
+};
+
+// One entry of the bank's index table, exactly as stored on the card.
+struct sound_bank_entry_t {
+	uint32_t offset;
+	uint32_t length;
+	uint32_t sample_rate;
+	uint8_t  volume;
+	uint8_t  format;
+	uint16_t reserved;
+} __attribute__((packed));
+
+struct sound_bank_header_t {
+	char magic[4];
+	uint16_t version;
+	uint16_t sound_count;
+	uint32_t bank_id;
+	uint32_t data_offset;
+} __attribute__((packed));
+
+// Single file holding all sounds, as written by tools/mksoundbank.py.
+// The index table is read into RAM once, after which any sound can be
+// located without touching the file system's directory tables: playing
+// it takes a single seek into the already known bank file.
+class SoundBank {
+private:
+	static std::string bank_path;
+	static std::vector<sound_bank_entry_t> index;
+
+public:
+	// Reads the bank's index. If expected_id is non-zero, a bank with a
+	// different ID (i.e. one built from other sounds than the firmware's
+	// sound ID header) is still loaded, but a warning is logged.
+	static bool load(const char *file_path, uint32_t expected_id = 0);
+
+	static bool is_loaded();
+	static const char *get_path();
+	static uint16_t get_sound_count();
+
+	// Returns nullptr if the ID is not in the bank.
+	static const sound_bank_entry_t *get(sound_id_t sound_id);
+};
+
+} /* namespace Audio */
+} /* namespace Xasin */
+
+#endif /* ESP32_AUDIOHANDLER_SOUNDBANK_H_ */
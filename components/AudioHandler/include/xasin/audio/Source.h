@@ -17,11 +17,36 @@ namespace Audio {
 
 class TX;
 
+// Used by the TX to decide which voice to drop once all voices
+// are in use. A new source may only take the place of a voice with
+// equal or lower priority.
+enum source_priority_t : uint8_t {
+	PRIORITY_AMBIENT = 0,	// Background loops, first to be dropped
+	PRIORITY_UI,			// Menu and notification sounds
+	PRIORITY_SFX,			// Game effects such as shots and hits
+};
+
 class Source {
 private:
 	bool was_started;
 	bool is_deletable;
 
+	// Set by the TX when this voice was stolen by a higher-priority
+	// source, or could not get a voice at all. A stopped source is
+	// no longer processed and treated as finished.
+	volatile bool was_stopped;
+
+	// Link in the TX's voice list, only touched by the processing task.
+	Source *next_voice;
+	// Set by the processing task once the source was taken out of the
+	// voice list again, after which it may safely be deleted.
+	volatile bool was_unlinked;
+
+	// Processing time spent in process_frame(), for profiling.
+	uint32_t cpu_time_last_us;
+	uint64_t cpu_time_total_us;
+	uint32_t frames_processed;
+
 protected:
 friend TX;
 
@@ -30,6 +55,12 @@ friend TX;
 	virtual bool process_frame();
 	void boop_playback();
 
+	// Takes this source out of the TX, waiting until the processing task
+	// no longer uses it. Derived classes call this first thing in their
+	// destructor, before their own members are torn down, as the base
+	// destructor only runs after those are gone.
+	void detach();
+
 	// This function will always add exactly one frame (e.g., 20ms) of the given mono data
 	// buffer to the audio_handler's internal buffer. volume can be used to reduce the volume
 	// of the given sample (independently of the global volume).
@@ -37,6 +68,8 @@ friend TX;
 	void add_mono_frame_to_handler(const int16_t *data, uint8_t volume = 255);
 
 public:
+	source_priority_t priority;
+
 	Source(TX &handler);
 	virtual ~Source();
 
@@ -45,6 +78,12 @@ public:
 	virtual bool is_finished();
 	virtual bool has_audio();
 
+	// True while this source still holds a voice in the TX,
+	// i.e. it is neither finished nor stopped.
+	bool is_active();
+	// Stops playback of this source, freeing its voice.
+	void stop();
+
 	virtual TickType_t remaining_runtime();
 
 	virtual void fade_out();
@@ -10,51 +10,107 @@
 
 #include "Source.h"
 #include "AudioTX.h"
+#include "ADPCM.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
-#include "opus.h"
 #include <array>
 
-#define XASAUDIO_TX_STREAM_MAX_PACKETSIZE (1 + (CONFIG_XASAUDIO_TX_FRAMELENGTH * CONFIG_XASAUDIO_TX_STREAM_MAX_BITRATE) / (8 * 1000))
+// Every packet is one TX frame of IMA-ADPCM, see ADPCM.h
+#define XASAUDIO_TX_STREAM_MAX_PACKETSIZE XASAUDIO_ADPCM_PACKET_SIZE(XASAUDIO_TX_FRAME_SAMPLE_NO)
 
 namespace Xasin {
 namespace Audio {
 
-struct stream_opus_packet_t {
+// Rounds up to the next power of two. Packets are stored by their sequence
+// number modulo the slot count, which only stays unique across the wrap
+// of the 16 bit sequence number if the count is a power of two.
+constexpr size_t tx_stream_slot_count(size_t n) {
+	return (n <= 1) ? 1 : 2 * tx_stream_slot_count((n + 1) / 2);
+}
+
+struct stream_packet_t {
+	uint16_t sequence;
 	uint16_t length;
+	bool valid;
 	std::array<uint8_t, XASAUDIO_TX_STREAM_MAX_PACKETSIZE> data;
 };
 
+struct tx_stream_stats_t {
+	uint32_t packets_received;
+	// Packets that arrived after their playback time had passed.
+	uint32_t packets_late;
+	// Packets that were never received, but later ones were.
+	uint32_t packets_lost;
+	uint32_t frames_concealed;
+	// Times the buffer ran completely dry during playback.
+	uint32_t underruns;
+
+	// Smoothed packet arrival jitter, as per RFC 3550.
+	uint32_t jitter_us;
+	uint16_t target_depth;
+	uint16_t depth;
+};
+
+// Plays live audio received over the network.
+// Packets are put into a jitter buffer by their sequence number, so that
+// reordered packets are played in order and missing ones are detected.
+// The buffer depth adapts to the measured arrival jitter. Playback only
+// starts once the target depth is reached, and is then sped up or
+// slowed down slightly to keep the depth on target.
+// Missing packets are concealed by fading out the last received frame.
 class TXStream : public Source {
 private:
-	OpusDecoder * decoder;
-
 	SemaphoreHandle_t packet_semaphore;
 
-	int packet_tail;
-	int packet_head;
-	int packet_count;
-	std::array<stream_opus_packet_t, 1 + (CONFIG_XASAUDIO_TX_STREAM_BUFFER_LENGTH / CONFIG_XASAUDIO_TX_FRAMELENGTH)> packet_buf;
+	std::array<stream_packet_t, tx_stream_slot_count(1 + CONFIG_XASAUDIO_TX_STREAM_BUFFER_LENGTH / CONFIG_XASAUDIO_TX_FRAMELENGTH)> packet_buf;
+
+	bool has_sequence;
+	bool playing;
+	uint16_t play_sequence;
+	uint16_t highest_sequence;
+
+	int64_t last_arrival_us;
+	uint16_t last_arrival_sequence;
+	// Jitter in microseconds, with 4 bits of fraction.
+	uint32_t jitter_q4;
 
-	int packet_low_watermark;
-	int packet_period_watermark;
+	tx_stream_stats_t stats;
 
 	uint32_t decode_buffer_pos;
 	std::array<int16_t, XASAUDIO_TX_FRAME_SAMPLE_NO> decode_buffer;
 	uint32_t decode_playback_speed;
 
+	uint8_t concealed_frames;
+
+	int16_t buffer_depth();
+	void update_jitter(uint16_t sequence, uint16_t batch_size);
+	void insert_packet(uint16_t sequence, const uint8_t *packet_ptr, uint16_t packet_size);
+
 	bool decode_next_packet();
 
+protected:
 	bool process_frame();
 
+	// Local time in µs that batches are stamped with on arrival, i.e.
+	// esp_timer_get_time. Simulations run the stream on their own clock.
+	virtual int64_t now_us();
+
 public:
+	uint8_t volume;
+
 	TXStream(TX &handler);
 	~TXStream();
 
-	void feed_packet(const uint8_t * packet_ptr, uint16_t packet_size);
-	void feed_packets(const uint8_t * data_ptr, uint16_t packet_size, uint8_t packet_count);
+	void feed_packet(uint16_t sequence, const uint8_t * packet_ptr, uint16_t packet_size);
+	void feed_packets(uint16_t first_sequence, const uint8_t * data_ptr, uint16_t packet_size, uint8_t packet_count);
+	// Feeds a batch as received from the network: a little endian u16
+	// sequence number of the first packet, a u8 packet count, followed
+	// by that many packets of equal size. Returns false if malformed.
+	bool feed_message(const uint8_t * data_ptr, size_t length);
+
+	tx_stream_stats_t get_stats();
 
 	bool is_finished();
 	bool has_audio();
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+#
+# mkpacketstream.py
+#
+#  Created on: 17 Oct 2026
+#
+# Encodes a WAV file into a packet stream for Xasin::Audio::PacketCassette,
+# meant for long tracks that are streamed off the SD card.
+#
+# The audio is mixed down to mono, resampled to the TX sample rate and
+# split into packets of one TX frame each. Every packet is IMA-ADPCM
+# encoded, at 4 bit per sample.
+#
+# Stream layout, all values little endian:
+#   header   magic "XPKT", u8 version, u8 codec, u16 samples per packet,
+#            u32 sample rate, u32 packet count
+#   packets  u16 payload length, followed by the payload:
+#            s16 predictor, u8 step index, u8 reserved,
+#            then one nibble per sample, low nibble first
+
+import argparse
+import struct
+import sys
+
+from mksoundbank import decode_wav_s16
+
+STREAM_MAGIC = b"XPKT"
+STREAM_VERSION = 1
+
+CODEC_IMA_ADPCM = 0
+
+HEADER = struct.Struct("<4sBBHII")
+
+INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8] * 2
+
+STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+]
+
+
+def clamp(value, low, high):
+    return max(low, min(high, value))
+
+
+def encode_packet(samples, state):
+    predictor, index = state
+    payload = bytearray(struct.pack("<hBB", predictor, index, 0))
+
+    codes = []
+    for sample in samples:
+        step = STEP_TABLE[index]
+        diff = sample - predictor
+
+        code = 0
+        if diff < 0:
+            code = 8
+            diff = -diff
+
+        # Mirrors the decoder exactly, so that encoder and decoder
+        # never drift apart.
+        delta = step >> 3
+        if diff >= step:
+            code |= 4
+            diff -= step
+            delta += step
+        if diff >= step >> 1:
+            code |= 2
+            diff -= step >> 1
+            delta += step >> 1
+        if diff >= step >> 2:
+            code |= 1
+            delta += step >> 2
+
+        predictor = clamp(predictor - delta if code & 8 else predictor + delta, -32768, 32767)
+        index = clamp(index + INDEX_TABLE[code], 0, 88)
+
+        codes.append(code)
+
+    if len(codes) % 2:
+        codes.append(0)
+    for i in range(0, len(codes), 2):
+        payload.append(codes[i] | (codes[i + 1] << 4))
+
+    return bytes(payload), (predictor, index)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Encode a WAV file into an ADPCM packet stream")
+    parser.add_argument("wav", help="WAV file to encode")
+    parser.add_argument("output", help="Packet stream file to write")
+    parser.add_argument("--rate", type=int, default=16000, help="TX sample rate, CONFIG_XASAUDIO_TX_SAMPLERATE")
+    parser.add_argument("--frame-ms", type=int, default=20, help="TX frame length, CONFIG_XASAUDIO_TX_FRAMELENGTH")
+    args = parser.parse_args()
+
+    frame_samples = args.rate * args.frame_ms // 1000
+    samples = decode_wav_s16(args.wav, args.rate)
+    if len(samples) == 0:
+        sys.exit("mkpacketstream: %s contains no audio" % args.wav)
+
+    packets = []
+    state = (0, 0)
+    for start in range(0, len(samples), frame_samples):
+        frame = list(samples[start:start + frame_samples])
+        frame += [0] * (frame_samples - len(frame))
+
+        payload, state = encode_packet(frame, state)
+        packets.append(payload)
+
+    with open(args.output, "wb") as f:
+        f.write(HEADER.pack(STREAM_MAGIC, STREAM_VERSION, CODEC_IMA_ADPCM,
+                            frame_samples, args.rate, len(packets)))
+        for payload in packets:
+            f.write(struct.pack("<H", len(payload)))
+            f.write(payload)
+
+    print("mkpacketstream: encoded %d packets (%.1f s) into %s" % (
+        len(packets), len(packets) * args.frame_ms / 1000, args.output))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+#
+# mksoundbank.py
+#
+#  Created on: 17 Oct 2026
+#
+# Packs a directory tree of WAV files into a single sound bank file for
+# Xasin::Audio::SoundBank, plus a C++ header assigning every sound an ID.
+#
+# Every WAV is mixed down to mono, resampled to the given rate and stored
+# as unsigned 8 bit PCM, the format ByteCassette plays directly.
+#
+# Bank layout, all values little endian:
+#   header   magic "XSBK", u16 version, u16 sound count,
+#            u32 bank ID, u32 offset of the first sample data
+#   index    one 16 byte entry per sound ID, in ID order:
+#            u32 data offset, u32 data length, u32 sample rate,
+#            u8 volume, u8 format, u16 reserved
+#   data     the samples of each sound, starting on a 512 byte boundary
+#
+# The bank ID is a CRC of the index, and is written to the header as well,
+# so the firmware can tell when the bank on the SD card is out of date.
+
+import argparse
+import array
+import os
+import re
+import struct
+import sys
+import wave
+import zlib
+
+BANK_MAGIC = b"XSBK"
+BANK_VERSION = 1
+
+SECTOR_SIZE = 512
+
+FORMAT_U8 = 0
+
+HEADER = struct.Struct("<4sHHII")
+INDEX_ENTRY = struct.Struct("<IIIBBH")
+
+
+def read_volumes(path):
+    volumes = {}
+    if path is None:
+        return volumes
+
+    with open(path) as f:
+        for line in f:
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+
+            name, volume = line.rsplit(None, 1)
+            volumes[name] = int(volume)
+
+    return volumes
+
+
+def decode_wav_s16(path, rate):
+    with wave.open(path, "rb") as w:
+        channels = w.getnchannels()
+        width = w.getsampwidth()
+        in_rate = w.getframerate()
+        raw = w.readframes(w.getnframes())
+
+    if width == 1:
+        # 8 bit WAV data is already unsigned, move it to signed 16 bit.
+        samples = array.array("h", ((b - 0x80) << 8 for b in raw))
+    elif width == 2:
+        samples = array.array("h")
+        samples.frombytes(raw)
+        if sys.byteorder == "big":
+            samples.byteswap()
+    else:
+        raise ValueError("%s: unsupported sample width of %d bytes" % (path, width))
+
+    in_frames = len(samples) // channels
+    out_frames = (in_frames * rate) // in_rate
+    step = in_rate / rate
+
+    out = array.array("h", bytes(2 * out_frames))
+    for i in range(out_frames):
+        # Averaging over all input frames that fall onto one output sample
+        # both mixes the channels down and acts as a simple anti-alias filter.
+        start = int(i * step)
+        end = max(start + 1, min(int((i + 1) * step), in_frames))
+
+        out[i] = sum(samples[start * channels:end * channels]) // ((end - start) * channels)
+
+    return out
+
+
+def decode_wav(path, rate):
+    return bytes((s >> 8) + 0x80 for s in decode_wav_s16(path, rate))
+
+
+def sound_name(stem):
+    name = re.sub(r"([a-z])([A-Z])", r"\1_\2", stem)
+    name = re.sub(r"[^A-Za-z0-9]+", "_", name).strip("_").upper()
+    if name[0].isdigit():
+        name = "_" + name
+
+    return name
+
+
+def collect_sounds(source_dir):
+    paths = []
+    for root, dirs, files in os.walk(source_dir):
+        dirs.sort()
+        for f in sorted(files):
+            if f.lower().endswith(".wav"):
+                paths.append(os.path.relpath(os.path.join(root, f), source_dir).replace(os.sep, "/"))
+
+    paths.sort()
+
+    # Plain file names make for the most readable IDs. Only fall back to
+    # the full path if two files in different directories share a name.
+    stems = [sound_name(os.path.splitext(os.path.basename(p))[0]) for p in paths]
+    names = []
+    for path, stem in zip(paths, stems):
+        if stems.count(stem) > 1:
+            names.append(sound_name(os.path.splitext(path)[0]))
+        else:
+            names.append(stem)
+
+    return list(zip(paths, names))
+
+
+def align(value):
+    return (value + SECTOR_SIZE - 1) // SECTOR_SIZE * SECTOR_SIZE
+
+
+def write_header(path, namespace, sounds, bank_id):
+    lines = [
+        "// Generated by mksoundbank.py, do not edit.",
+        "",
+        "#pragma once",
+        "",
+        "#include <xasin/audio/SoundBank.h>",
+        "",
+    ]
+    for ns in namespace.split("::"):
+        lines.append("namespace %s {" % ns)
+    lines += [
+        "",
+        "static const uint32_t BANK_ID = 0x%08X;" % bank_id,
+        "",
+        "enum : Xasin::Audio::sound_id_t {",
+    ]
+    for sound_id, (sound_path, name) in enumerate(sounds):
+        lines.append("\t%s = %d, // %s" % (name, sound_id, sound_path))
+    lines += [
+        "",
+        "\tSOUND_COUNT = %d" % len(sounds),
+        "};",
+        "",
+    ]
+    for ns in reversed(namespace.split("::")):
+        lines.append("} /* namespace %s */" % ns)
+    lines.append("")
+
+    content = "\n".join(lines)
+
+    # Only touch the header if it changed, so as not to trigger rebuilds.
+    if os.path.exists(path):
+        with open(path) as f:
+            if f.read() == content:
+                return
+
+    with open(path, "w") as f:
+        f.write(content)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pack WAV files into a sound bank")
+    parser.add_argument("source_dir", help="Directory tree of WAV files")
+    parser.add_argument("bank", help="Sound bank file to write")
+    parser.add_argument("--header", help="C++ header with the sound IDs to write")
+    parser.add_argument("--namespace", default="SFX", help="Namespace for the sound IDs")
+    parser.add_argument("--rate", type=int, default=16000, help="Sample rate of the bank")
+    parser.add_argument("--volumes", help="File listing '<path> <volume>' per line, default volume is 255")
+    args = parser.parse_args()
+
+    sounds = collect_sounds(args.source_dir)
+    if len(sounds) == 0 or len(sounds) > 0xFFFF:
+        sys.exit("mksoundbank: found %d sounds in %s" % (len(sounds), args.source_dir))
+
+    volumes = read_volumes(args.volumes)
+
+    data_offset = align(HEADER.size + INDEX_ENTRY.size * len(sounds))
+
+    index = bytearray()
+    data = bytearray()
+    for sound_path, name in sounds:
+        samples = decode_wav(os.path.join(args.source_dir, sound_path), args.rate)
+        volume = volumes.get(sound_path, 255)
+
+        index += INDEX_ENTRY.pack(data_offset + len(data), len(samples), args.rate, volume, FORMAT_U8, 0)
+
+        data += samples
+        data += bytes(align(len(data)) - len(data))
+
+    bank_id = zlib.crc32(index) & 0xFFFFFFFF
+
+    with open(args.bank, "wb") as f:
+        f.write(HEADER.pack(BANK_MAGIC, BANK_VERSION, len(sounds), bank_id, data_offset))
+        f.write(index)
+        f.write(bytes(data_offset - HEADER.size - len(index)))
+        f.write(data)
+
+    if args.header:
+        write_header(args.header, args.namespace, sounds, bank_id)
+
+    print("mksoundbank: packed %d sounds into %s, %d bytes" % (len(sounds), args.bank, data_offset + len(data)))
+
+
+if __name__ == "__main__":
+    main()
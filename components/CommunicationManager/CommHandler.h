@@ -2,6 +2,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <functional>
 #include <vector>
 #include <memory> // For std::unique_ptr or std::shared_ptr
@@ -9,13 +10,63 @@
 namespace Xasin {
 namespace Communication {
 
-// Structure for received messages
-struct CommReceivedData {
-    std::string topic; // For MQTT, or a logical topic/group in mesh
+// Non-owning view of a received payload
+struct CommPayload {
+    const uint8_t* ptr = nullptr;
+    size_t length = 0;
+
+    const uint8_t* data() const { return ptr; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+
+    const uint8_t* begin() const { return ptr; }
+    const uint8_t* end() const { return ptr + length; }
+    uint8_t operator[](size_t i) const { return ptr[i]; }
+};
+
+// Owning copy of a received message, see CommReceivedData::copy()
+struct CommReceivedMessage {
+    std::string topic;
+    std::string sub_topic;
     std::vector<uint8_t> payload;
-    std::string source_id; // MAC address or mesh node ID of the sender
+    std::string source_id;
+};
+
+// Structure for received messages.
+// None of these own their data, they point straight into the handler's
+// receive buffer and are only valid for the duration of the callback.
+// Consumers that need the message afterwards, i.e. to hand it to another
+// task, have to copy() it.
+struct CommReceivedData {
+    std::string_view topic; // Topic (filter) that was subscribed to
+    std::string_view sub_topic; // Part of the topic matched by a wildcard, i.e. "hit" for "event/#"
+    CommPayload payload;
+    std::string_view source_id; // MAC address or mesh node ID of the sender
+
+    CommReceivedMessage copy() const {
+        return { std::string(topic), std::string(sub_topic),
+                 std::vector<uint8_t>(payload.begin(), payload.end()), std::string(source_id) };
+    }
 };
 
+// Returns the n-th '/' separated segment of topic, ignoring a leading '/',
+// or an empty view if the topic has fewer segments.
+inline std::string_view topic_segment(std::string_view topic, size_t n) {
+    if (!topic.empty() && topic[0] == '/') {
+        topic.remove_prefix(1);
+    }
+
+    for (; n > 0; n--) {
+        size_t slash = topic.find('/');
+        if (slash == std::string_view::npos) {
+            return std::string_view();
+        }
+        topic.remove_prefix(slash + 1);
+    }
+
+    return topic.substr(0, topic.find('/'));
+}
+
 // Callback for received messages
 using comm_message_callback_t = std::function<void(const CommReceivedData& message)>;
 
@@ -11,8 +11,10 @@
 #include <sstream>         // For std::stringstream
 #include <iomanip>         // For std::setw, std::setfill
 #include <inttypes.h>      // For PRId32
+#include <algorithm>
 #include "esp_sntp.h"
 #include "esp_tls.h"       // For esp_tls_init_global_ca_store
+#include "esp_timer.h"     // For esp_timer_get_time
 
 // Required for mesh_netif.c helper functions
 extern "C" {
@@ -38,6 +40,10 @@ static void static_ip_event_handler_adapter(void *arg, esp_event_base_t event_ba
 
 // SNTP initialization function (moved outside class for clarity or if used globally)
 void initialize_sntp_task() { // Renamed to avoid conflict if there's a global initialize_sntp
+    if (sntp_enabled()) { // Still running from an earlier connection
+        return;
+    }
+
     ESP_LOGI("SNTP", "Initializing SNTP");
     esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
     esp_sntp_setservername(0, "pool.ntp.org"); // Default Kconfig is "pool.ntp.org"
@@ -93,7 +99,44 @@ EspMeshHandler::EspMeshHandler(bool is_root_node)
       mesh_connected_(false),
       ip_acquired_(false),
       m_mqtt_handler_(), // Default construct Xasin::MQTT::Handler
+      outbox_(),
+      mesh_transport_(),
+      mesh_bridge_(mesh_transport_,
+                   [this](const char *topic, const void *data, size_t length, bool retain, int qos) {
+                       return publish_mqtt(topic, data, length, retain, qos);
+                   },
+                   "/esp32/" CONFIG_PROJECT_NAME "/"),
+      mesh_telemetry_(&EspMeshHandler::read_mesh_link),
+      mesh_clock_(mesh_transport_, esp_timer_get_time),
+      mesh_mqtt_(mesh_transport_, mesh_mqtt_upstream(), "/esp32/" CONFIG_PROJECT_NAME "/", esp_timer_get_time),
+      mesh_mqtt_subscriptions_(),
       active_subscriptions_() { // Initialize active_subscriptions_ map
+    m_mqtt_handler_.on_connected = [this]() {
+        drain_outbox();
+        // Runs with the MQTT handler's lock held, so the nodes are told
+        // from the proxy's task instead.
+        if (mesh_mqtt_task_ != nullptr) {
+            xTaskNotifyGive(mesh_mqtt_task_);
+        }
+    };
+    mesh_mqtt_.on_connected = [this]() {
+        drain_outbox();
+    };
+    // Proxy frames arrive on mesh_netif's receive task, which is too
+    // small for TLS publishes and subscriber callbacks.
+    mesh_mqtt_.on_received = [this]() {
+        if (mesh_mqtt_task_ != nullptr) {
+            xTaskNotifyGive(mesh_mqtt_task_);
+        }
+    };
+    mesh_bridge_.on_pending = [this]() {
+        if (mesh_bridge_task_ != nullptr) {
+            xTaskNotifyGive(mesh_bridge_task_);
+        }
+    };
+
+    mesh_clock_.make_default();
+
     ESP_LOGI(MESH_TAG, "EspMeshHandler instance created. Initial is_root_ hint: %s", is_root_ ? "true" : "false");
 }
 
@@ -120,6 +163,24 @@ bool EspMeshHandler::start(void *config) {
     
     initialize_mesh_and_wifi();
 
+    if (mesh_bridge_task_ == nullptr) {
+        xTaskCreate(mesh_bridge_task, "MeshBridge", 3072, this, 5, &mesh_bridge_task_);
+    }
+#if CONFIG_COMM_MESH_TELEMETRY_INTERVAL > 0
+    if (mesh_telemetry_task_ == nullptr) {
+        xTaskCreate(mesh_telemetry_task, "MeshTelemetry", 3072, this, 1, &mesh_telemetry_task_);
+    }
+#endif
+    if (mesh_clock_task_ == nullptr) {
+        xTaskCreate(mesh_clock_task, "MeshClock", 3072, this, 4, &mesh_clock_task_);
+    }
+#if CONFIG_COMM_MESH_MQTT_PROXY
+    if (mesh_mqtt_task_ == nullptr) {
+        // Subscriber callbacks of nodes run on this task
+        xTaskCreate(mesh_mqtt_task, "MeshMqtt", 4096, this, 3, &mesh_mqtt_task_);
+    }
+#endif
+
     mesh_initialized_ = true;
     ESP_LOGI(MESH_TAG, "EspMeshHandler start sequence initiated. Waiting for network events.");
     return true;
@@ -140,6 +201,18 @@ void EspMeshHandler::stop() {
         }
     }
     active_subscriptions_.clear();
+    for (auto &subscription : mesh_mqtt_subscriptions_) {
+        delete subscription.second;
+    }
+    mesh_mqtt_subscriptions_.clear();
+    if (fast_rejoin_timer_) {
+        esp_timer_stop(fast_rejoin_timer_);
+        esp_timer_delete(fast_rejoin_timer_);
+        fast_rejoin_timer_ = nullptr;
+    }
+    fast_rejoin_pending_ = false;
+    root_ap_started_ = false;
+
     mesh_netifs_destroy(); 
     ESP_LOGI(MESH_TAG, "Mesh netifs destroyed.");
     
@@ -189,6 +262,29 @@ void EspMeshHandler::initialize_mesh_and_wifi() {
     }
     ESP_ERROR_CHECK(ret);
 
+    // Boot timings are kept either way, the topology is only used for
+    // fast rejoins.
+    warm_start_ = topology_cache_.load(mesh_config_hash(), topology_) && CONFIG_COMM_MESH_FAST_REJOIN_TIMEOUT > 0;
+    if (warm_start_) {
+        ESP_LOGI(MESH_TAG, "Warm start: last on channel %d as %s", topology_.channel,
+                 topology_.was_root ? "root" : "node");
+    } else {
+        ESP_LOGI(MESH_TAG, "Cold start: no cached topology, scanning.");
+    }
+
+#if CONFIG_COMM_MESH_FAST_REJOIN_TIMEOUT > 0
+    const esp_timer_create_args_t timer_args = {
+        .callback = &EspMeshHandler::fast_rejoin_timeout,
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "fast_rejoin",
+        .skip_unhandled_events = true,
+    };
+    if (fast_rejoin_timer_ == nullptr) {
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &fast_rejoin_timer_));
+    }
+#endif
+
     // 2. Initialize TCP/IP stack and default event loop
     ESP_LOGI(MESH_TAG, "Initializing LwIP and event loop.");
     ESP_ERROR_CHECK(esp_netif_init());
@@ -196,9 +292,9 @@ void EspMeshHandler::initialize_mesh_and_wifi() {
 
     // 3. Initialize Mesh-specific Netifs (MESH_AP_DEF, MESH_STA_DEF)
     // This MUST be called before esp_wifi_init() if using mesh_netif.c helpers for IP internal network.
-    // mesh_netifs_init(NULL) also creates the default STA netif ("WIFI_STA_DEF") internally.
+    // mesh_netifs_init() also creates the default STA netif ("WIFI_STA_DEF") internally.
     ESP_LOGI(MESH_TAG, "Initializing Mesh Netifs (for MESH_AP_DEF and default WIFI_STA_DEF).");
-    ESP_ERROR_CHECK(mesh_netifs_init(NULL)); 
+    ESP_ERROR_CHECK(mesh_netifs_init(&EspMeshTransport::raw_receive)); 
 
     // 4. Create default Wi-Fi STA netif (for external router connection if this node becomes root)
     // THIS IS NO LONGER NEEDED as mesh_netifs_init() already creates the default STA interface.
@@ -331,6 +427,12 @@ esp_err_t EspMeshHandler::apply_mesh_configuration() {
 
 
     mesh_cfg_to_set.channel = current_config_.mesh_channel; 
+    // The cached channel saves the scan across all of them. Should the
+    // mesh have moved, nodes fall back to a full scan after a few tries.
+    if (warm_start_ && mesh_cfg_to_set.channel == 0 && topology_.channel != 0) {
+        mesh_cfg_to_set.channel = topology_.channel;
+        mesh_cfg_to_set.allow_channel_switch = true;
+    }
     if (current_config_.mesh_password.length() >= sizeof(mesh_cfg_to_set.mesh_ap.password)) {
         ESP_LOGW(MESH_TAG, "Mesh password too long, will be truncated.");
     }
@@ -356,6 +458,14 @@ esp_err_t EspMeshHandler::apply_mesh_configuration() {
     strncpy((char *)mesh_cfg_to_set.router.password, current_config_.wifi_password.c_str(), sizeof(mesh_cfg_to_set.router.password) -1);
     mesh_cfg_to_set.router.password[sizeof(mesh_cfg_to_set.router.password) -1] = '\0';
 
+    // Looks for the last router first, but may still switch to another
+    // access point of the same SSID if it is gone.
+    static const uint8_t no_bssid[6] = {};
+    if (warm_start_ && topology_.was_root && memcmp(topology_.router_bssid, no_bssid, 6) != 0) {
+        memcpy(mesh_cfg_to_set.router.bssid, topology_.router_bssid, 6);
+        mesh_cfg_to_set.router.allow_router_switch = true;
+    }
+
 
     ESP_LOGI(MESH_TAG, "Setting mesh configuration: MESH_ID: %02x:%02x:%02x:%02x:%02x:%02x, Channel: %d, Router SSID: %s",
              mesh_cfg_to_set.mesh_id.addr[0], mesh_cfg_to_set.mesh_id.addr[1], mesh_cfg_to_set.mesh_id.addr[2],
@@ -397,16 +507,19 @@ void EspMeshHandler::mesh_event_handler(void *arg, esp_event_base_t event_base,
             ESP_LOGI(MESH_TAG, "Standalone root started (no router config). Starting mesh AP netif.");
             ESP_ERROR_CHECK(mesh_netif_start_root_ap(true, 0)); // dns_addr 0 for standalone
             ip_acquired_ = true; // Internal IP is set up by mesh_netif_start_root_ap
+            root_ap_started_ = true;
+            root_ap_dns_ = 0;
             ESP_LOGI(MESH_TAG, "Standalone Root IP setup. Starting MQTT client (if configured).");
-            if (!current_config_.mqtt_broker_uri.empty()) {
-                m_mqtt_handler_.start(current_config_.mqtt_broker_uri.c_str());
-            }
+            start_mqtt();
             initialize_sntp_task(); // Initialize SNTP for standalone root if needed
         } else if (this->is_root_ && !current_config_.wifi_ssid.empty()){
              ESP_LOGI(MESH_TAG, "MESH_EVENT_STARTED: Node is root, router configured. Waiting for IP_EVENT_STA_GOT_IP on WIFI_STA_DEF.");
              // Root status will be fully confirmed and MQTT started upon getting external IP.
         } else if (!this->is_root_) {
             ESP_LOGI(MESH_TAG, "MESH_EVENT_STARTED: Node is child. Waiting for MESH_EVENT_PARENT_CONNECTED.");
+            if (warm_start_ && !topology_.was_root) {
+                start_fast_rejoin();
+            }
         }
         break;
     }
@@ -414,6 +527,7 @@ void EspMeshHandler::mesh_event_handler(void *arg, esp_event_base_t event_base,
         ESP_LOGI(MESH_TAG, "MESH_EVENT_STOPPED");
         mesh_connected_ = false;
         ip_acquired_ = false;
+        root_ap_started_ = false;
         this->is_root_ = false; 
         ESP_LOGI(MESH_TAG, "MESH_EVENT_STOPPED: Node is_root set to false.");
         // Consider stopping MQTT if it was running
@@ -426,6 +540,16 @@ void EspMeshHandler::mesh_event_handler(void *arg, esp_event_base_t event_base,
                  MAC2STR(connected_event->connected.bssid), esp_mesh_get_layer());
         
         mesh_connected_ = true; 
+        mesh_telemetry_.note_parent_connected(connected_event->connected.bssid);
+
+        if (fast_rejoin_pending_.exchange(false)) {
+            esp_timer_stop(fast_rejoin_timer_);
+            // Lets the mesh heal by itself again from here on
+            esp_mesh_set_self_organized(true, false);
+            topology_cache_.record_fast_rejoin(true);
+            ESP_LOGI(MESH_TAG, "Fast rejoin to cached parent succeeded.");
+        }
+        remember_parent(*connected_event);
 
         // If this node is configured with an external router SSID,
         // then connecting to a "parent" means it has connected to that router
@@ -440,6 +564,7 @@ void EspMeshHandler::mesh_event_handler(void *arg, esp_event_base_t event_base,
             // This node is NOT configured with an external router, so any parent connection
             // means it's a child connecting to another mesh node.
             this->is_root_ = false;
+            root_ap_started_ = false; // Removed by mesh_netifs_start(false)
             ESP_LOGI(MESH_TAG, "MESH_EVENT_PARENT_CONNECTED: Node is CHILD (not configured for external router). Starting MESH_STA_DEF for IP acquisition from mesh root.");
             ESP_ERROR_CHECK(mesh_netifs_start(false)); // This configures netif_sta as MESH_STA_DEF
         }
@@ -450,7 +575,18 @@ void EspMeshHandler::mesh_event_handler(void *arg, esp_event_base_t event_base,
         ESP_LOGW(MESH_TAG, "MESH_EVENT_PARENT_DISCONNECTED from BSSID: " MACSTR ", Reason: %d",
                  MAC2STR(disconnected_event->bssid), disconnected_event->reason);
         mesh_connected_ = false; // No longer connected to that parent
+        mesh_telemetry_.note_parent_lost();
         ip_acquired_ = false;    // Lost IP that might have been obtained via that parent
+
+        // Times the reconnect, unless still waiting for the first publish
+        int32_t published = -1;
+        publish_wait_start_ms_.compare_exchange_strong(published, int32_t(esp_timer_get_time() / 1000));
+
+        // Most disconnects are short, i.e. the parent rebooting or moving
+        // out of reach for a moment, so it is asked for directly first.
+        if (!topology_.was_root) {
+            start_fast_rejoin();
+        }
         // is_root_ remains false, mesh will try to find a new parent or self-organize.
         // If it becomes root, MESH_EVENT_STARTED will be triggered again.
         // m_mqtt_handler_.stop(); 
@@ -459,6 +595,7 @@ void EspMeshHandler::mesh_event_handler(void *arg, esp_event_base_t event_base,
     case MESH_EVENT_LAYER_CHANGE: {
         mesh_event_layer_change_t *layer_change_event = (mesh_event_layer_change_t *)event_data;
         ESP_LOGI(MESH_TAG, "MESH_EVENT_LAYER_CHANGE: New layer: %d", layer_change_event->new_layer);
+        mesh_telemetry_.note_layer_change();
         break;
     }
     case MESH_EVENT_ROOT_ADDRESS: {
@@ -511,23 +648,30 @@ void EspMeshHandler::ip_event_handler(void *arg, esp_event_base_t event_base, in
                 ESP_LOGW(MESH_TAG, "Failed to get DNS info for root's external STA. Using 0.0.0.0 for children's DNS.");
             }
             
-            ESP_LOGI(MESH_TAG, "Root has external IP. Starting mesh AP netif (MESH_AP_DEF).");
-            ESP_ERROR_CHECK(mesh_netif_start_root_ap(true, dns_server_addr)); 
+            // Recreating it would cut off all children for a moment
+            if (!root_ap_started_ || dns_server_addr != root_ap_dns_) {
+                ESP_LOGI(MESH_TAG, "Root has external IP. Starting mesh AP netif (MESH_AP_DEF).");
+                ESP_ERROR_CHECK(mesh_netif_start_root_ap(true, dns_server_addr)); 
+                root_ap_started_ = true;
+                root_ap_dns_ = dns_server_addr;
+            } else {
+                ESP_LOGI(MESH_TAG, "Root has external IP again. Keeping mesh AP netif.");
+            }
 
             ESP_LOGI(MESH_TAG, "Root (external IP OK, mesh AP started). Starting MQTT client.");
-            if (!current_config_.mqtt_broker_uri.empty()) {
-                m_mqtt_handler_.start(current_config_.mqtt_broker_uri.c_str());
-            }
+            start_mqtt();
             initialize_sntp_task(); // Initialize SNTP once root has external connectivity
 
         } else if (strcmp(if_key, "MESH_STA_DEF") == 0 && !this->is_root_) { 
             ESP_LOGI(MESH_TAG, "IP_EVENT_STA_GOT_IP for CHILD on MESH_STA_DEF (internal mesh IP).");
             ip_acquired_ = true;     
 
+#if CONFIG_COMM_MESH_MQTT_PROXY
+            ESP_LOGI(MESH_TAG, "Node (child) got IP on mesh interface. Reaching MQTT through the root's proxy.");
+#else
             ESP_LOGI(MESH_TAG, "Node (child) got IP on mesh interface. Starting MQTT client (if configured).");
-            if (!current_config_.mqtt_broker_uri.empty()) {
-                 m_mqtt_handler_.start(current_config_.mqtt_broker_uri.c_str());
-            }
+            start_mqtt();
+#endif
             initialize_sntp_task(); // Initialize SNTP for child if it needs time
         } else {
             ESP_LOGW(MESH_TAG, "IP_EVENT_STA_GOT_IP on an unexpected interface/role combination. Key: '%s', Desc: '%s', is_root_: %s", 
@@ -573,24 +717,388 @@ bool EspMeshHandler::isConnected() const {
         return ip_acquired_; // Needs an IP to be considered connected within the mesh
     }
 
+#if CONFIG_COMM_MESH_MQTT_PROXY
+    // Children only have the root's broker connection
+    if (!is_root_) {
+        return mesh_mqtt_.is_connected();
+    }
+#endif
+
     // If MQTT is configured, it must also be connected
     bool mqtt_ok = (m_mqtt_handler_.is_disconnected() == 0);
     ESP_LOGD(MESH_TAG, "isConnected (With MQTT URI): IP acquired: %d, MQTT OK: %d", ip_acquired_, mqtt_ok);
     return ip_acquired_ && mqtt_ok;
 }
 
+// Sends everything queued while offline. Returns true once the queue is
+// empty, so that new messages can go out directly without overtaking it.
+bool EspMeshHandler::drain_outbox() {
+    outbox_.drain([this](const char *topic, const void *data, size_t length, bool retain, int qos) {
+        return send_mqtt(topic, data, length, retain, qos);
+    });
+
+    return outbox_.empty();
+}
+
+bool EspMeshHandler::send_mqtt(const char *topic, const void *data, size_t length, bool retain, int qos) {
+#if CONFIG_COMM_MESH_MQTT_PROXY
+    bool sent = is_root_ ? m_mqtt_handler_.publish_to(topic, data, length, retain, qos)
+                         : mesh_mqtt_.publish(topic, data, length, retain, qos);
+#else
+    bool sent = m_mqtt_handler_.publish_to(topic, data, length, retain, qos);
+#endif
+
+    if (sent) {
+        note_published();
+    }
+    return sent;
+}
+
+bool EspMeshHandler::publish_mqtt(const char *topic, const void *data, size_t length, bool retain, int qos) {
+    if (isConnected() && drain_outbox()
+        && send_mqtt(topic, data, length, retain, qos)) {
+        return true;
+    }
+
+    ESP_LOGD(MESH_TAG, "Queueing '%s', not fully connected. Mesh: %d, IP: %d, MQTT Connected: %s",
+             topic, mesh_connected_, ip_acquired_, (m_mqtt_handler_.is_disconnected() == 0) ? "yes" : "no");
+    bool queued = outbox_.push(topic, data, length, retain, qos);
+
+    // Queued behind a drain running on another task, which may have
+    // finished just before the push
+    if (queued && isConnected()) {
+        drain_outbox();
+    }
+    return queued;
+}
+
 bool EspMeshHandler::publish(const std::string& topic, const void* data, size_t length, bool retain, int qos) {
-    if (!isConnected()) {
-        ESP_LOGW(MESH_TAG, "Cannot publish to '%s', not fully connected. Mesh: %d, IP: %d, MQTT Connected: %s", 
-                 topic.c_str(), mesh_connected_, ip_acquired_, (m_mqtt_handler_.is_disconnected() == 0) ? "yes" : "no");
-        return false;
+#if CONFIG_COMM_MESH_BRIDGE
+    // The root is the one talking to the broker, so it only ever
+    // bridges game events of the other nodes.
+    if (!is_root_ && mesh_connected_ && mesh_bridge_.publish(topic, data, length, retain, qos)) {
+        return true;
+    }
+#endif
+
+    return publish_mqtt(topic.c_str(), data, length, retain, qos);
+}
+
+void EspMeshHandler::mesh_bridge_task(void *arg) {
+    EspMeshHandler *handler = static_cast<EspMeshHandler *>(arg);
+
+    while (true) {
+        // Woken up by the first message of a batch, which then
+        // gets one window for more messages to join it.
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_COMM_MESH_BATCH_WINDOW));
+
+        handler->mesh_bridge_.flush();
+    }
+}
+
+outbound_queue_stats_t EspMeshHandler::get_outbox_stats() {
+    return outbox_.get_stats();
+}
+
+mesh_bridge_stats_t EspMeshHandler::get_mesh_bridge_stats() {
+    return mesh_bridge_.get_stats();
+}
+
+void EspMeshHandler::read_mesh_link(mesh_link_reading_t &reading) {
+    reading.is_root = esp_mesh_is_root();
+    reading.layer = std::max(0, esp_mesh_get_layer());
+
+    mesh_addr_t parent;
+    if (esp_mesh_get_parent_bssid(&parent) == ESP_OK) {
+        memcpy(reading.parent_mac, parent.addr, 6);
+    }
+
+    wifi_ap_record_t ap_info;
+    if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+        reading.parent_rssi = ap_info.rssi;
+    }
+
+    reading.routing_table_size = esp_mesh_get_routing_table_size();
+
+    mesh_tx_pending_t tx_pending;
+    if (esp_mesh_get_tx_pending(&tx_pending) == ESP_OK) {
+        reading.tx_pending = tx_pending.to_parent + tx_pending.to_parent_p2p + tx_pending.to_child
+                           + tx_pending.to_child_p2p + tx_pending.mgmt + tx_pending.broadcast;
+    }
+
+    mesh_rx_pending_t rx_pending;
+    if (esp_mesh_get_rx_pending(&rx_pending) == ESP_OK) {
+        reading.rx_pending = rx_pending.toDS + rx_pending.toSelf;
+    }
+}
+
+void EspMeshHandler::mesh_telemetry_task(void *arg) {
+    EspMeshHandler *handler = static_cast<EspMeshHandler *>(arg);
+
+    // Queues are sampled more often than published, to catch their peaks
+    const TickType_t sample_interval = pdMS_TO_TICKS(std::min(1000, CONFIG_COMM_MESH_TELEMETRY_INTERVAL));
+    TickType_t last_publish = xTaskGetTickCount();
+
+    while (true) {
+        vTaskDelay(sample_interval);
+
+        if (!handler->mesh_connected_) {
+            continue;
+        }
+        handler->mesh_telemetry_.sample();
+
+        if ((xTaskGetTickCount() - last_publish) < pdMS_TO_TICKS(CONFIG_COMM_MESH_TELEMETRY_INTERVAL)) {
+            continue;
+        }
+        last_publish = xTaskGetTickCount();
+
+        // Stale telemetry is of no use, so it is never queued while offline
+        if (!handler->isConnected()) {
+            continue;
+        }
+
+        uint8_t buffer[MESH_TELEMETRY_SIZE];
+        size_t length = MeshTelemetry::encode(handler->mesh_telemetry_.get(true), buffer, sizeof(buffer));
+        handler->send_mqtt("telemetry/mesh", buffer, length, false, 0);
+    }
+}
+
+mesh_telemetry_t EspMeshHandler::get_mesh_telemetry() {
+    return mesh_telemetry_.get();
+}
+
+void EspMeshHandler::mesh_clock_task(void *arg) {
+    EspMeshHandler *handler = static_cast<EspMeshHandler *>(arg);
+
+    // Syncs quickly after joining, so that the first game events already
+    // carry a usable time, then settles to the configured interval.
+    uint8_t fast_syncs = 0;
+
+    while (true) {
+        TickType_t interval = pdMS_TO_TICKS(CONFIG_COMM_MESH_TIME_SYNC_INTERVAL);
+        if (fast_syncs < MESH_CLOCK_SAMPLES) {
+            interval = std::min<TickType_t>(interval, pdMS_TO_TICKS(250));
+        }
+        vTaskDelay(interval);
+
+        // Root changes are picked up here rather than in every event that
+        // might cause one. A new root restarts the filter by itself.
+        handler->mesh_clock_.set_root(handler->is_root_);
+        if (handler->is_root_ || !handler->mesh_connected_) {
+            fast_syncs = 0;
+            continue;
+        }
+
+        if (handler->mesh_clock_.request_sync() && fast_syncs < MESH_CLOCK_SAMPLES) {
+            fast_syncs++;
+        }
+    }
+}
+
+mesh_clock_stats_t EspMeshHandler::get_mesh_clock_stats() {
+    return mesh_clock_.get_stats();
+}
+
+MeshMqttProxy::upstream_t EspMeshHandler::mesh_mqtt_upstream() {
+    MeshMqttProxy::upstream_t upstream;
+
+    // The proxy serialises these, and never calls them with its own lock
+    // held, as the MQTT handler routes messages with its lock held.
+    upstream.subscribe = [this](const std::string &filter, int qos) {
+        Xasin::MQTT::Subscription *subscription = m_mqtt_handler_.subscribe_to(filter,
+            [this, filter](const Xasin::MQTT::MQTT_Packet &packet) {
+                mesh_mqtt_.route(filter, packet.full_topic, packet.topic, packet.data.data(), packet.data.size());
+            }, qos);
+
+        // A QoS upgrade replaces the subscription. The old one goes last,
+        // so that the broker subscription stays up in between.
+        Xasin::MQTT::Subscription *&slot = mesh_mqtt_subscriptions_[filter];
+        delete slot;
+        slot = subscription;
+    };
+    upstream.unsubscribe = [this](const std::string &filter) {
+        auto it = mesh_mqtt_subscriptions_.find(filter);
+        if (it != mesh_mqtt_subscriptions_.end()) {
+            delete it->second;
+            mesh_mqtt_subscriptions_.erase(it);
+        }
+    };
+    upstream.publish = [this](const char *topic, const void *data, size_t length, bool retain, int qos) {
+        return publish_mqtt(topic, data, length, retain, qos);
+    };
+
+    return upstream;
+}
+
+void EspMeshHandler::mesh_mqtt_task(void *arg) {
+    EspMeshHandler *handler = static_cast<EspMeshHandler *>(arg);
+
+    TickType_t last_keepalive = xTaskGetTickCount();
+
+    while (true) {
+        // Woken up early by received frames, and by the broker
+        // connection coming back
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+
+        // As with the clock, root changes are picked up here
+        handler->mesh_mqtt_.set_root(handler->is_root_);
+        handler->mesh_mqtt_.process_received();
+
+        bool keepalive_due = (xTaskGetTickCount() - last_keepalive) >= pdMS_TO_TICKS(CONFIG_COMM_MESH_MQTT_KEEPALIVE);
+
+        if (handler->is_root_) {
+            handler->mesh_mqtt_.set_broker_connected(handler->m_mqtt_handler_.is_disconnected() == 0);
+            if (keepalive_due) {
+                handler->mesh_mqtt_.expire();
+                last_keepalive = xTaskGetTickCount();
+            }
+        }
+        // Until the root answers, it is asked every second, so that nodes
+        // which just joined do not wait a whole interval for the broker.
+        else if (handler->mesh_connected_ && (keepalive_due || !handler->mesh_mqtt_.is_connected())) {
+            handler->mesh_mqtt_.keepalive();
+            last_keepalive = xTaskGetTickCount();
+        }
+    }
+}
+
+mesh_mqtt_proxy_stats_t EspMeshHandler::get_mesh_mqtt_stats() {
+    return mesh_mqtt_.get_stats();
+}
+
+uint32_t EspMeshHandler::mesh_config_hash() const {
+    return MeshTopologyCache::config_hash({
+        current_config_.mesh_id, current_config_.mesh_password, current_config_.wifi_ssid,
+        std::string_view(reinterpret_cast<const char *>(&current_config_.mesh_channel), 1) });
+}
+
+void EspMeshHandler::remember_parent(const mesh_event_connected_t &connected) {
+#if CONFIG_COMM_MESH_FAST_REJOIN_TIMEOUT > 0
+    topology_.config_hash = mesh_config_hash();
+    topology_.channel = connected.connected.channel;
+
+    // The root's parent is the router
+    topology_.was_root = connected.self_layer == MESH_ROOT_LAYER;
+    if (topology_.was_root) {
+        memcpy(topology_.router_bssid, connected.connected.bssid, 6);
+        // Rejoining as a node goes through a scan, not to the parent of
+        // some earlier boot
+        memset(topology_.parent_bssid, 0, sizeof(topology_.parent_bssid));
+        memset(topology_.parent_ssid, 0, sizeof(topology_.parent_ssid));
+        topology_.parent_ssid_length = 0;
+    } else {
+        size_t ssid_length = std::min<size_t>(connected.connected.ssid_len, sizeof(topology_.parent_ssid));
+
+        memcpy(topology_.parent_bssid, connected.connected.bssid, 6);
+        memset(topology_.parent_ssid, 0, sizeof(topology_.parent_ssid));
+        memcpy(topology_.parent_ssid, connected.connected.ssid, ssid_length);
+        topology_.parent_ssid_length = ssid_length;
+        topology_.layer = connected.self_layer;
+    }
+
+    topology_cache_.store(topology_);
+#endif
+}
+
+void EspMeshHandler::start_fast_rejoin() {
+    if (fast_rejoin_pending_ || fast_rejoin_timer_ == nullptr || topology_.parent_ssid_length == 0) {
+        return;
+    }
+
+    wifi_config_t parent = {};
+    memcpy(parent.sta.ssid, topology_.parent_ssid, topology_.parent_ssid_length);
+    memcpy(parent.sta.bssid, topology_.parent_bssid, 6);
+    parent.sta.bssid_set = true;
+    parent.sta.channel = topology_.channel;
+    strncpy((char *)parent.sta.password, current_config_.mesh_password.c_str(), sizeof(parent.sta.password) - 1);
+
+    mesh_addr_t mesh_id;
+    esp_mesh_get_id(&mesh_id);
+
+    // Self organisation would go for a scan of its own right away
+    esp_mesh_set_self_organized(false, false);
+    esp_err_t err = esp_mesh_set_parent(&parent, &mesh_id, MESH_NODE, topology_.layer);
+    if (err != ESP_OK) {
+        ESP_LOGW(MESH_TAG, "Fast rejoin not possible: %s", esp_err_to_name(err));
+        esp_mesh_set_self_organized(true, true);
+        return;
+    }
+
+    ESP_LOGI(MESH_TAG, "Fast rejoin to cached parent " MACSTR " on channel %d, layer %d",
+             MAC2STR(topology_.parent_bssid), topology_.channel, topology_.layer);
+    fast_rejoin_pending_ = true;
+    esp_timer_start_once(fast_rejoin_timer_, uint64_t(CONFIG_COMM_MESH_FAST_REJOIN_TIMEOUT) * 1000);
+}
+
+void EspMeshHandler::fast_rejoin_timeout(void *arg) {
+    EspMeshHandler *handler = static_cast<EspMeshHandler *>(arg);
+
+    // Lost the race against the parent connecting
+    if (!handler->fast_rejoin_pending_.exchange(false)) {
+        return;
+    }
+
+    ESP_LOGW(MESH_TAG, "Fast rejoin timed out, scanning for a parent.");
+    esp_mesh_set_self_organized(true, true);
+
+    handler->topology_cache_.record_fast_rejoin(false);
+    handler->topology_cache_.forget_parent();
+}
+
+// The client is only started once. Afterwards it reconnects by itself,
+// keeping its subscriptions, and is only hurried along here.
+void EspMeshHandler::start_mqtt() {
+    if (current_config_.mqtt_broker_uri.empty()) {
+        return;
+    }
+
+    if (m_mqtt_handler_.is_disconnected() == 255) {
+        m_mqtt_handler_.start(current_config_.mqtt_broker_uri.c_str());
+    } else {
+        m_mqtt_handler_.reconnect();
     }
-    m_mqtt_handler_.publish_to(topic, data, length, retain, qos);
-    return true;
+}
+
+void EspMeshHandler::note_published() {
+    int32_t wait_start = publish_wait_start_ms_.exchange(-1);
+    if (wait_start < 0) {
+        return;
+    }
+    uint32_t ms = int32_t(esp_timer_get_time() / 1000) - wait_start;
+
+    if (!first_publish_done_) {
+        first_publish_done_ = true;
+        topology_cache_.record_first_publish(ms, warm_start_);
+        ESP_LOGI(MESH_TAG, "First publish %u ms after boot (%s start)", unsigned(ms), warm_start_ ? "warm" : "cold");
+    } else {
+        topology_cache_.record_reconnect(ms);
+        ESP_LOGI(MESH_TAG, "First publish %u ms after losing the connection", unsigned(ms));
+    }
+
+    mesh_boot_stats_t stats = topology_cache_.get_boot_stats();
+
+    char buffer[192];
+    int length = snprintf(buffer, sizeof(buffer),
+                          "{\"boots\":%u,\"warmBoots\":%u,\"firstPublishMs\":%u,\"warm\":%s,"
+                          "\"reconnectMs\":%u,\"fastRejoins\":%u,\"fastRejoinsFailed\":%u}",
+                          unsigned(stats.boots), unsigned(stats.warm_boots), unsigned(stats.first_publish_ms[0]),
+                          (stats.warm_mask & 1) ? "true" : "false", unsigned(stats.last_reconnect_ms),
+                          unsigned(stats.fast_rejoins), unsigned(stats.fast_rejoins_failed));
+    send_mqtt("telemetry/boot", buffer, length, true, 0);
+}
+
+mesh_boot_stats_t EspMeshHandler::get_boot_stats() {
+    return topology_cache_.get_boot_stats();
 }
 
 bool EspMeshHandler::subscribe(const std::string &topic, comm_message_callback_t callback, int qos) {
     ESP_LOGI(MESH_TAG, "Subscribing to topic: %s", topic.c_str());
+#if CONFIG_COMM_MESH_MQTT_PROXY
+    // Kept by both, as this node may reach the broker either way. The
+    // MQTT handler subscribes once it is started, should it become root.
+    mesh_mqtt_.subscribe(topic, callback, qos);
+#else
     if (m_mqtt_handler_.is_disconnected() == 255) { // 255 means not started
         ESP_LOGE(MESH_TAG, "MQTT handler not started, cannot subscribe to topic: %s", topic.c_str());
         return false;
@@ -599,43 +1107,26 @@ bool EspMeshHandler::subscribe(const std::string &topic, comm_message_callback_t
         ESP_LOGW(MESH_TAG, "MQTT handler started but not connected, and no IP yet. Subscription to %s might fail or be delayed.", topic.c_str());
         // Proceed with subscription attempt, MQTT client should handle queuing if capable
     }
+#endif
 
 
     comm_message_callback_t captured_user_callback = std::move(callback);
     std::string topic_filter_for_lambda = topic;
 
     Xasin::MQTT::mqtt_callback xasin_callback =
-        [this, captured_user_callback, topic_filter_for_lambda](const Xasin::MQTT::MQTT_Packet& packet) {
+        [captured_user_callback, topic_filter_for_lambda](const Xasin::MQTT::MQTT_Packet& packet) {
+        // Only views are handed on, the user callback has to copy()
+        // the message if it needs it after returning.
         CommReceivedData received_data;
-        received_data.topic = topic_filter_for_lambda; 
-        received_data.payload = std::vector<uint8_t>(packet.data.begin(), packet.data.end());
-        
-        std::string source_id_str = "";
-        std::string full_topic_str = packet.topic; 
-        
-        size_t component_start_pos = 0;
-        if (!full_topic_str.empty() && full_topic_str[0] == '/') {
-            component_start_pos = 1; 
-        }
-
-        std::string path_to_parse = full_topic_str.substr(component_start_pos);
-        std::string segment;
-        std::vector<std::string> segments; 
-        std::istringstream segment_stream(path_to_parse); 
-
-        while(std::getline(segment_stream, segment, '/')) {
-            segments.push_back(segment);
-        }
-
-        if (segments.size() >= 3) { // Assuming /prefix/project/device_id/...
-            source_id_str = segments[2];
-        }
-
-        received_data.source_id = source_id_str;
-        
-        ESP_LOGD(MESH_TAG, "MQTT Pkt Recv. Full Topic: '%s', Filter: '%s', Parsed SrcID: '%s', Payload Sz: %zu. Relaying.", 
-                 full_topic_str.c_str(), topic_filter_for_lambda.c_str(), source_id_str.c_str(), packet.data.size());
-        captured_user_callback(received_data); 
+        received_data.topic = topic_filter_for_lambda;
+        received_data.sub_topic = packet.topic;
+        received_data.payload = { reinterpret_cast<const uint8_t*>(packet.data.data()), packet.data.size() };
+        received_data.source_id = topic_segment(packet.full_topic, 2); // Assuming /prefix/project/device_id/...
+
+        ESP_LOGD(MESH_TAG, "MQTT Pkt Recv. Full Topic: '%.*s', Filter: '%s', Parsed SrcID: '%.*s', Payload Sz: %zu. Relaying.",
+                 int(packet.full_topic.size()), packet.full_topic.data(), topic_filter_for_lambda.c_str(),
+                 int(received_data.source_id.size()), received_data.source_id.data(), packet.data.size());
+        captured_user_callback(received_data);
     };
 
     Xasin::MQTT::Subscription* sub = m_mqtt_handler_.subscribe_to(topic, xasin_callback, qos);
@@ -651,6 +1142,10 @@ bool EspMeshHandler::subscribe(const std::string &topic, comm_message_callback_t
 }
 
 bool EspMeshHandler::unsubscribe(const std::string &topic) {
+#if CONFIG_COMM_MESH_MQTT_PROXY
+    mesh_mqtt_.unsubscribe(topic);
+#endif
+
     auto it = active_subscriptions_.find(topic);
     if (it != active_subscriptions_.end()) {
         ESP_LOGI(MESH_TAG, "Unsubscribing from topic: %s", topic.c_str());
@@ -2,14 +2,23 @@
 #pragma once
 
 #include "CommHandler.h"
+#include "OutboundQueue.h"
+#include "EspMeshTransport.h"
+#include "MeshBridge.h"
+#include "MeshTelemetry.h"
+#include "MeshClock.h"
+#include "MeshMqttProxy.h"
+#include "MeshTopologyCache.h"
 #include "esp_mesh.h" // Main mesh header
 #include "xasin/mqtt/Handler.h" 
 #include "esp_event.h"      // For esp_event_base_t
+#include "esp_timer.h"
 
 #include <string>
 #include <vector>
 #include <functional>
 #include <map>
+#include <atomic>
 
 namespace Xasin {
 namespace Communication {
@@ -50,6 +59,19 @@ public:
     bool is_root() const { return is_root_; } // Example implementation
     bool isRootNode() const override; // Added override
 
+    // Depth, drop and age counters of the offline publish queue
+    outbound_queue_stats_t get_outbox_stats();
+    // Frame and record counters of the mesh transport
+    mesh_bridge_stats_t get_mesh_bridge_stats();
+    // Layer, parent and queue depths as of the last telemetry sample
+    mesh_telemetry_t get_mesh_telemetry();
+    // Offset, delay and drift against the root's clock
+    mesh_clock_stats_t get_mesh_clock_stats();
+    // Subscriptions and messages handled by the MQTT proxy, on either side
+    mesh_mqtt_proxy_stats_t get_mesh_mqtt_stats();
+    // Time to the first publish over the last boots, and rejoin counters
+    mesh_boot_stats_t get_boot_stats();
+
     // Changed from static void to void
     void mesh_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data);
     void ip_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data);
@@ -77,9 +99,69 @@ private:
     // --- Add this flag to prevent multiple mesh recovery tasks ---
     volatile bool mesh_recovery_task_running_ = false;
 
+    // Where this node was last time, to rejoin there without a scan
+    MeshTopologyCache topology_cache_;
+    mesh_topology_t topology_ = {};
+    bool warm_start_ = false;
+    uint32_t mesh_config_hash() const;
+    void remember_parent(const mesh_event_connected_t &connected);
+
+    // A directed rejoin to the cached parent, until the timer gives up
+    // on it and lets the mesh scan. Cleared by either the timer task or
+    // the event loop, whichever comes first.
+    std::atomic<bool> fast_rejoin_pending_{false};
+    esp_timer_handle_t fast_rejoin_timer_ = nullptr;
+    void start_fast_rejoin();
+    static void fast_rejoin_timeout(void *arg);
+
+    // The root keeps its mesh AP netif across losing the router, unless
+    // the DNS server it hands out changes
+    bool root_ap_started_ = false;
+    uint32_t root_ap_dns_ = 0;
+    void start_mqtt();
+
+    // Since boot, or since the connection was lost, in ms. -1 while the
+    // last publish went out.
+    std::atomic<int32_t> publish_wait_start_ms_{ 0 };
+    bool first_publish_done_ = false;
+    void note_published();
+
     // MQTT Handler instance
     Xasin::MQTT::Handler m_mqtt_handler_;
 
+    // Messages published while not connected, sent on reconnect
+    OutboundQueue outbox_;
+    bool drain_outbox();
+    // Publishes over MQTT, or queues the message while disconnected
+    bool publish_mqtt(const char *topic, const void *data, size_t length, bool retain, int qos);
+    // Hands a message to the broker client, or to the root's proxy
+    bool send_mqtt(const char *topic, const void *data, size_t length, bool retain, int qos);
+
+    // Game events sent over the mesh, bridged to MQTT by the root
+    EspMeshTransport mesh_transport_;
+    MeshBridge mesh_bridge_;
+    TaskHandle_t mesh_bridge_task_ = nullptr;
+    static void mesh_bridge_task(void *arg);
+
+    // Topology and link quality, published on telemetry/mesh
+    MeshTelemetry mesh_telemetry_;
+    TaskHandle_t mesh_telemetry_task_ = nullptr;
+    static void read_mesh_link(mesh_link_reading_t &reading);
+    static void mesh_telemetry_task(void *arg);
+
+    // Common timebase of all nodes, the root's clock, behind mesh_time_us()
+    MeshClock mesh_clock_;
+    TaskHandle_t mesh_clock_task_ = nullptr;
+    static void mesh_clock_task(void *arg);
+
+    // Broker access of the other nodes through this one while it is root,
+    // and of this one through the root otherwise
+    MeshMqttProxy mesh_mqtt_;
+    std::map<std::string, Xasin::MQTT::Subscription *> mesh_mqtt_subscriptions_;
+    TaskHandle_t mesh_mqtt_task_ = nullptr;
+    MeshMqttProxy::upstream_t mesh_mqtt_upstream();
+    static void mesh_mqtt_task(void *arg);
+
     // Event handler instances for unregistration
     esp_event_handler_instance_t mesh_event_instance_ = nullptr;
     esp_event_handler_instance_t ip_event_instance_ = nullptr;
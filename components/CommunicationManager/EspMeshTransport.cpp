@@ -0,0 +1,69 @@
+// EspMeshTransport.cpp
+#include "EspMeshTransport.h"
+
+#include "esp_log.h"
+
+#include <string.h>
+
+static const char *TRANSPORT_TAG = "EspMeshTransport";
+
+namespace Xasin {
+namespace Communication {
+
+EspMeshTransport *EspMeshTransport::instance = nullptr;
+
+EspMeshTransport::EspMeshTransport() {
+    assert(instance == nullptr);
+    instance = this;
+}
+
+EspMeshTransport::~EspMeshTransport() {
+    instance = nullptr;
+}
+
+void EspMeshTransport::raw_receive(mesh_addr_t *from, mesh_data_t *data) {
+    if (instance == nullptr) {
+        return;
+    }
+
+    instance->deliver(from->addr, data->data, data->size);
+}
+
+bool EspMeshTransport::send_to_root(const uint8_t *data, size_t length) {
+    mesh_data_t mesh_data = {};
+    mesh_data.data = const_cast<uint8_t *>(data);
+    mesh_data.size = length;
+    mesh_data.proto = MESH_PROTO_BIN;
+    mesh_data.tos = MESH_TOS_P2P;
+
+    // A NULL destination sends to the root
+    esp_err_t err = esp_mesh_send(NULL, &mesh_data, 0, NULL, 0);
+    if (err != ESP_OK) {
+        ESP_LOGD(TRANSPORT_TAG, "Sending %u bytes to root failed: %s", length, esp_err_to_name(err));
+        return false;
+    }
+
+    return true;
+}
+
+bool EspMeshTransport::send_to(const uint8_t *mac, const uint8_t *data, size_t length) {
+    mesh_addr_t to = {};
+    memcpy(to.addr, mac, sizeof(to.addr));
+
+    mesh_data_t mesh_data = {};
+    mesh_data.data = const_cast<uint8_t *>(data);
+    mesh_data.size = length;
+    mesh_data.proto = MESH_PROTO_BIN;
+    mesh_data.tos = MESH_TOS_P2P;
+
+    esp_err_t err = esp_mesh_send(&to, &mesh_data, MESH_DATA_P2P, NULL, 0);
+    if (err != ESP_OK) {
+        ESP_LOGD(TRANSPORT_TAG, "Sending %u bytes to " MACSTR " failed: %s", length, MAC2STR(mac), esp_err_to_name(err));
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Communication
+} // namespace Xasin
@@ -0,0 +1,30 @@
+// EspMeshTransport.h
+#pragma once
+
+#include "MeshTransport.h"
+
+#include "esp_mesh.h"
+
+namespace Xasin {
+namespace Communication {
+
+// Sends frames as MESH_PROTO_BIN packets through esp_mesh_send, and
+// receives them from the mesh_netif receive task.
+// There can only be one, as mesh_netif takes a plain function pointer.
+class EspMeshTransport : public MeshTransport {
+private:
+    static EspMeshTransport *instance;
+
+public:
+    EspMeshTransport();
+    ~EspMeshTransport();
+
+    // To be passed to mesh_netifs_init()
+    static void raw_receive(mesh_addr_t *from, mesh_data_t *data);
+
+    bool send_to_root(const uint8_t *data, size_t length) override;
+    bool send_to(const uint8_t *mac, const uint8_t *data, size_t length) override;
+};
+
+} // namespace Communication
+} // namespace Xasin
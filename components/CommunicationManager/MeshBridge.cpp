@@ -0,0 +1,223 @@
+// MeshBridge.cpp
+#include "MeshBridge.h"
+
+#include "esp_log.h"
+
+#include <stdio.h>
+#include <algorithm>
+
+static const char *BRIDGE_TAG = "MeshBridge";
+
+namespace Xasin {
+namespace Communication {
+
+MeshBridge::MeshBridge(MeshTransport &transport, publish_func_t mqtt_publish, const std::string &topic_prefix)
+    : transport(transport), mqtt_publish(mqtt_publish), topic_prefix(topic_prefix),
+      lock(), send_lock(),
+      node_buffers(),
+      node_batches{ MeshFrameBuilder(node_buffers[0].data(), node_buffers[0].size()),
+                    MeshFrameBuilder(node_buffers[1].data(), node_buffers[1].size()) },
+      active_node_batch(0),
+      root_buffers(),
+      root_batches{ MeshFrameBuilder(root_buffers[0].data(), root_buffers[0].size(), true),
+                    MeshFrameBuilder(root_buffers[1].data(), root_buffers[1].size(), true) },
+      active_root_batch(0), root_publishing(false),
+      stats(),
+      on_pending(nullptr) {
+
+    this->transport.set_handler(MESH_FRAME_MAGIC, [this](const uint8_t *from, const uint8_t *data, size_t length) {
+        receive_frame(from, data, length);
+    });
+}
+
+// Expects neither lock to be held, as the transport may block.
+void MeshBridge::send_node_batch() {
+    std::lock_guard<std::mutex> send_guard(send_lock);
+
+    MeshFrameBuilder *batch;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        batch = &node_batches[active_node_batch];
+        if (batch->empty()) {
+            return;
+        }
+
+        active_node_batch ^= 1;
+        stats.max_batch_records = std::max(stats.max_batch_records, batch->count());
+    }
+
+    bool sent = transport.send_to_root(batch->data(), batch->size());
+
+    uint32_t fallback = 0;
+    if (!sent) {
+        // Without a root these have to take the long way round, through
+        // the MQTT connection and its offline queue.
+        ESP_LOGD(BRIDGE_TAG, "Root unreachable, publishing %u records over MQTT", batch->count());
+
+        mesh_frame_parse(batch->data(), batch->size(), [&](const mesh_record_t &record) {
+            fallback++;
+            mqtt_publish(mesh_topic_name(record.topic_id), record.data, record.length, record.retain, record.qos);
+        });
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (sent) {
+        stats.frames_sent++;
+        stats.bytes_sent += batch->size();
+    }
+    stats.records_fallback += fallback;
+    batch->reset();
+}
+
+// Does not touch stats, so that it can run without holding lock.
+// Returns false for records of unknown topics.
+bool MeshBridge::bridge_record(const mesh_record_t &record) {
+    const char *topic_name = mesh_topic_name(record.topic_id);
+    if (topic_name == nullptr) {
+        return false;
+    }
+
+    const uint8_t *mac = record.source;
+
+    char topic[96];
+    snprintf(topic, sizeof(topic), "%s%02x:%02x:%02x:%02x:%02x:%02x/%s", topic_prefix.c_str(),
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], topic_name);
+
+    mqtt_publish(topic, record.data, record.length, record.retain, record.qos);
+    return true;
+}
+
+// Runs on the mesh receive task, so it only ever copies records into the
+// root's batch.
+void MeshBridge::receive_frame(const uint8_t *from, const uint8_t *data, size_t length) {
+    bool pending = false;
+
+    std::unique_lock<std::mutex> guard(lock);
+    stats.frames_received++;
+
+    bool valid = mesh_frame_parse(data, length, [&](const mesh_record_t &record) {
+        MeshFrameBuilder *batch = &root_batches[active_root_batch];
+        bool was_empty = batch->empty();
+
+        if (batch->append(from, record.topic_id, record.retain, record.qos, record.data, record.length)) {
+            pending |= was_empty;
+            return;
+        }
+
+        // Full before its window is up, so it is handed to flush() right
+        // away, if that is done with the other one.
+        MeshFrameBuilder &other = root_batches[active_root_batch ^ 1];
+        if (!root_publishing && other.empty()) {
+            active_root_batch ^= 1;
+            batch = &other;
+            pending = true;
+
+            if (batch->append(from, record.topic_id, record.retain, record.qos, record.data, record.length)) {
+                return;
+            }
+        }
+
+        stats.records_dropped++;
+    });
+
+    if (!valid) {
+        ESP_LOGW(BRIDGE_TAG, "Dropping malformed frame of %u bytes", length);
+        stats.frames_malformed++;
+    }
+
+    guard.unlock();
+
+    if (pending && on_pending) {
+        on_pending();
+    }
+}
+
+bool MeshBridge::publish(std::string_view topic, const void *data, size_t length, bool retain, int qos) {
+    uint8_t topic_id = mesh_topic_id(topic);
+    if (topic_id == MESH_TOPIC_NONE) {
+        return false;
+    }
+
+    bool started_batch;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            MeshFrameBuilder &batch = node_batches[active_node_batch];
+
+            if (batch.append(nullptr, topic_id, retain, qos, data, length)) {
+                stats.records_queued++;
+                started_batch = batch.count() == 1;
+                break;
+            }
+
+            // Too large for a frame at all
+            if (batch.empty()) {
+                return false;
+            }
+        }
+
+        send_node_batch();
+    }
+
+    if (started_batch && on_pending) {
+        on_pending();
+    }
+
+    return true;
+}
+
+// Publishes the batch flush() is not filling, after switching over to
+// it if it was empty. Returns false if there was nothing to publish.
+bool MeshBridge::publish_root_batch() {
+    std::unique_lock<std::mutex> guard(lock);
+
+    MeshFrameBuilder *batch = &root_batches[active_root_batch ^ 1];
+    if (batch->empty()) {
+        if (root_batches[active_root_batch].empty()) {
+            return false;
+        }
+
+        active_root_batch ^= 1;
+        batch = &root_batches[active_root_batch ^ 1];
+    }
+    root_publishing = true;
+    guard.unlock();
+
+    uint32_t bridged = 0;
+    uint32_t unknown = 0;
+
+    mesh_frame_parse(batch->data(), batch->size(), [&](const mesh_record_t &record) {
+        if (bridge_record(record)) {
+            bridged++;
+        } else {
+            unknown++;
+        }
+    });
+
+    guard.lock();
+    stats.records_bridged += bridged;
+    stats.records_unknown += unknown;
+    stats.max_batch_records = std::max(stats.max_batch_records, batch->count());
+    batch->reset();
+    root_publishing = false;
+
+    return true;
+}
+
+void MeshBridge::flush() {
+    send_node_batch();
+
+    // A batch the receive task switched away from, then the one it was
+    // filling
+    for (int i = 0; i < 2 && publish_root_batch(); i++) {
+    }
+}
+
+mesh_bridge_stats_t MeshBridge::get_stats() {
+    std::lock_guard<std::mutex> guard(lock);
+    return stats;
+}
+
+} // namespace Communication
+} // namespace Xasin
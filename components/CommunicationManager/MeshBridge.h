@@ -0,0 +1,108 @@
+// MeshBridge.h
+#pragma once
+
+#include "sdkconfig.h"
+
+#include "MeshFrame.h"
+#include "MeshTransport.h"
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <stdint.h>
+
+namespace Xasin {
+namespace Communication {
+
+struct mesh_bridge_stats_t {
+    // Node side
+    uint32_t records_queued;
+    uint32_t frames_sent;
+    uint32_t bytes_sent;
+    // Records handed back to MQTT because the root could not be reached
+    uint32_t records_fallback;
+
+    // Root side
+    uint32_t frames_received;
+    uint32_t frames_malformed;
+    uint32_t records_bridged;
+    // Records dropped as both of the root's batches were full
+    uint32_t records_dropped;
+    uint32_t records_unknown;
+
+    uint8_t max_batch_records;
+};
+
+// Carries latency critical topics (see MeshFrame.h) as binary frames over
+// the mesh, instead of going from the node through the root's NAPT to the
+// broker as MQTT over TLS.
+//
+// Nodes batch their records for up to CONFIG_COMM_MESH_BATCH_WINDOW, and
+// send them to the root as one frame. The root collects the records of all
+// its nodes, and publishes them to MQTT under each node's own topic in one
+// go, from the task calling flush(). The mesh receive task never waits on
+// the broker, nor does anything wait on the radio with lock held.
+//
+// Nothing in here touches the radio, so with a LoopbackMeshTransport the
+// whole path also runs on the host.
+class MeshBridge {
+public:
+    // topic is either relative to the own base topic, or a full topic
+    // starting with '/', just like for MQTT::Handler::publish_to.
+    using publish_func_t = std::function<bool (const char *topic, const void *data, size_t length, bool retain, int qos)>;
+
+private:
+    MeshTransport &transport;
+    const publish_func_t mqtt_publish;
+    const std::string topic_prefix;
+
+    std::mutex lock;
+    // Held while a node batch is on its way to the root, and taken before
+    // lock. Only one batch is ever in flight, so the other one is always
+    // empty and ready to take over.
+    std::mutex send_lock;
+
+    // Records keep going into one batch while the other one is sent
+    std::array<uint8_t, CONFIG_COMM_MESH_BATCH_SIZE> node_buffers[2];
+    MeshFrameBuilder node_batches[2];
+    uint8_t active_node_batch;
+
+    // Records keep arriving into one buffer while the other one is being
+    // published by flush(). If the active one fills up before, the
+    // receive task switches over itself, as long as the other is empty.
+    std::array<uint8_t, CONFIG_COMM_MESH_BRIDGE_BUFFER> root_buffers[2];
+    MeshFrameBuilder root_batches[2];
+    uint8_t active_root_batch;
+    bool root_publishing;
+
+    mesh_bridge_stats_t stats;
+
+    void send_node_batch();
+    bool publish_root_batch();
+    bool bridge_record(const mesh_record_t &record);
+    void receive_frame(const uint8_t *from, const uint8_t *data, size_t length);
+
+public:
+    // Called when a batch starts filling up. flush() should be called
+    // CONFIG_COMM_MESH_BATCH_WINDOW later, or right away if the root's
+    // batch filled up.
+    std::function<void ()> on_pending;
+
+    // Bridged records are published to topic_prefix + node MAC + '/' + topic
+    MeshBridge(MeshTransport &transport, publish_func_t mqtt_publish, const std::string &topic_prefix);
+
+    // Queues the message for the root. Returns false if the topic is not
+    // carried over the mesh, in which case it has to go out over MQTT.
+    bool publish(std::string_view topic, const void *data, size_t length, bool retain, int qos);
+
+    // Sends the node's batch to the root, and publishes the root's batch.
+    // Only to be called from one task.
+    void flush();
+
+    mesh_bridge_stats_t get_stats();
+};
+
+} // namespace Communication
+} // namespace Xasin
@@ -0,0 +1,323 @@
+// MeshClock.cpp
+#include "MeshClock.h"
+
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+namespace Xasin {
+namespace Communication {
+
+#define MESH_TIME_TYPE_REQUEST 1
+#define MESH_TIME_TYPE_REPLY 2
+
+// Exchanges taking longer than this say nothing useful about the offset
+#define MESH_CLOCK_MAX_DELAY 500000
+// How fast the error bound of a sample grows with its age, NTP's PHI
+#define MESH_CLOCK_AGING 15e-6
+// Error of even the fastest exchange, from asymmetry and timestamping
+#define MESH_CLOCK_MIN_BOUND 100
+// A fitted drift is only used once its standard error is below this. Until then, the offsets
+// are too noisy or too close together to say anything about it.
+#define MESH_CLOCK_DRIFT_ERROR 20e-6
+// Crystals are good to about 40ppm, anything beyond is a bad measurement
+#define MESH_CLOCK_MAX_DRIFT 200e-6
+
+static MeshClock *default_clock = nullptr;
+
+MeshClockFilter::MeshClockFilter() {
+    reset();
+}
+
+void MeshClockFilter::reset() {
+    sample_count = 0;
+    next_sample = 0;
+    history_count = 0;
+    next_history = 0;
+    last_picked = INT64_MIN;
+
+    fit_local = 0;
+    fit_offset = 0;
+    drift = 0;
+}
+
+bool MeshClockFilter::add_sample(int64_t t1, int64_t t2, int64_t t3, int64_t t4) {
+    int64_t delay = (t4 - t1) - (t3 - t2);
+    if (t4 < t1 || t3 < t2 || delay < 0 || delay > MESH_CLOCK_MAX_DELAY) {
+        return false;
+    }
+
+    samples[next_sample] = { t4, ((t2 - t1) + (t3 - t4)) / 2, delay };
+    next_sample = (next_sample + 1) % MESH_CLOCK_SAMPLES;
+    sample_count = std::min<uint8_t>(sample_count + 1, MESH_CLOCK_SAMPLES);
+
+    const sample_t *best = nullptr;
+    double best_bound = 0;
+    for (uint8_t i = 0; i < sample_count; i++) {
+        double bound = samples[i].delay / 2.0 + (t4 - samples[i].local) * MESH_CLOCK_AGING;
+        if (best == nullptr || bound < best_bound) {
+            best = &samples[i];
+            best_bound = bound;
+        }
+    }
+
+    // Every sample is used only once, an old best one has nothing new to say
+    if (best->local <= last_picked) {
+        return true;
+    }
+    last_picked = best->local;
+
+    history[next_history] = *best;
+    next_history = (next_history + 1) % MESH_CLOCK_HISTORY;
+    history_count = std::min<uint8_t>(history_count + 1, MESH_CLOCK_HISTORY);
+
+    fit();
+    return true;
+}
+
+void MeshClockFilter::fit() {
+    const sample_t &newest = history[(next_history + MESH_CLOCK_HISTORY - 1) % MESH_CLOCK_HISTORY];
+    fit_local = newest.local;
+
+    // The delay all exchanges share is mostly symmetric and cancels out,
+    // only what comes on top of it skews the offset.
+    int64_t min_delay = newest.delay;
+    for (uint8_t i = 0; i < history_count; i++) {
+        min_delay = std::min(min_delay, history[i].delay);
+    }
+
+    // Weighted by the inverse square of each sample's error, so that the
+    // few fast exchanges count for more than the many slow ones.
+    // Times are relative to the newest sample, to keep the sums small.
+    double weights[MESH_CLOCK_HISTORY];
+    double sum_w = 0, sum_t = 0, sum_o = 0;
+    for (uint8_t i = 0; i < history_count; i++) {
+        double bound = (history[i].delay - min_delay) / 2.0 + MESH_CLOCK_MIN_BOUND;
+        weights[i] = 1 / (bound * bound);
+
+        sum_w += weights[i];
+        sum_t += weights[i] * (history[i].local - newest.local);
+        sum_o += weights[i] * history[i].offset;
+    }
+    double mean_t = sum_t / sum_w;
+    double mean_o = sum_o / sum_w;
+
+    double sum_tt = 0, sum_to = 0;
+    for (uint8_t i = 0; i < history_count; i++) {
+        double t = (history[i].local - newest.local) - mean_t;
+        sum_tt += weights[i] * t * t;
+        sum_to += weights[i] * t * (history[i].offset - mean_o);
+    }
+
+    // The slope's variance is 1 / sum_tt. Until that is small enough,
+    // the newest pick is the best guess of the offset, as in plain NTP.
+    if (sum_tt * MESH_CLOCK_DRIFT_ERROR * MESH_CLOCK_DRIFT_ERROR < 1) {
+        drift = 0;
+        fit_offset = newest.offset;
+        return;
+    }
+
+    drift = std::max(-MESH_CLOCK_MAX_DRIFT, std::min(MESH_CLOCK_MAX_DRIFT, sum_to / sum_tt));
+    // Line through the mean, evaluated at the newest sample
+    fit_offset = mean_o - drift * mean_t;
+}
+
+bool MeshClockFilter::is_synced() const {
+    return history_count > 0;
+}
+
+int64_t MeshClockFilter::to_reference(int64_t local) const {
+    if (history_count == 0) {
+        return local;
+    }
+
+    return local + int64_t(fit_offset + drift * (local - fit_local));
+}
+
+int64_t MeshClockFilter::get_offset() const {
+    return fit_offset;
+}
+int64_t MeshClockFilter::get_delay() const {
+    if (history_count == 0) {
+        return 0;
+    }
+    return history[(next_history + MESH_CLOCK_HISTORY - 1) % MESH_CLOCK_HISTORY].delay;
+}
+float MeshClockFilter::get_drift_ppm() const {
+    return drift * 1e6;
+}
+
+static uint8_t *put_i64(uint8_t *out, int64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = uint64_t(value) >> (8 * i);
+    }
+    return out + 8;
+}
+static int64_t get_i64(const uint8_t *in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value |= uint64_t(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+static uint8_t *put_header(uint8_t *out, uint8_t type, uint8_t timebase) {
+    out[0] = MESH_TIME_MAGIC;
+    out[1] = MESH_TIME_VERSION;
+    out[2] = type;
+    out[3] = timebase;
+    return out + 4;
+}
+
+MeshClock::MeshClock(MeshTransport &transport, clock_func_t local_clock)
+    : transport(transport), local_clock(local_clock),
+      lock(), filter(), is_root(false), reference_mac(), timebase(0),
+      stats() {
+
+    this->transport.set_handler(MESH_TIME_MAGIC, [this](const uint8_t *from, const uint8_t *data, size_t length) {
+        receive(from, data, length);
+    });
+}
+
+void MeshClock::receive(const uint8_t *from, const uint8_t *data, size_t length) {
+    // Taken first thing, everything after adds to the measured delay
+    int64_t received_at = local_clock();
+
+    if (length < 4 || data[1] != MESH_TIME_VERSION) {
+        return;
+    }
+
+    if (data[2] == MESH_TIME_TYPE_REQUEST && length >= MESH_TIME_REQUEST_SIZE) {
+        uint8_t reply_timebase;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (!is_root) {
+                return;
+            }
+            stats.requests_answered++;
+            reply_timebase = timebase;
+        }
+
+        uint8_t reply[MESH_TIME_REPLY_SIZE];
+        uint8_t *out = put_header(reply, MESH_TIME_TYPE_REPLY, reply_timebase);
+        memcpy(out, data + 4, 8);
+        out = put_i64(out + 8, received_at);
+        put_i64(out, local_clock());
+
+        transport.send_to(from, reply, sizeof(reply));
+    }
+    else if (data[2] == MESH_TIME_TYPE_REPLY && length >= MESH_TIME_REPLY_SIZE) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (is_root) {
+            return;
+        }
+
+        stats.replies_received++;
+
+        // A new root has a clock of its own, as does one that restarted
+        if (data[3] == 0) {
+            return;
+        }
+        if (memcmp(from, reference_mac, sizeof(reference_mac)) != 0 || data[3] != timebase) {
+            memcpy(reference_mac, from, sizeof(reference_mac));
+            filter.reset();
+
+            if (timebase != 0) {
+                stats.timebase_changes++;
+            }
+            timebase = data[3];
+        }
+
+        if (!filter.add_sample(get_i64(data + 4), get_i64(data + 12), get_i64(data + 20), received_at)) {
+            stats.samples_rejected++;
+        }
+    }
+}
+
+void MeshClock::set_root(bool is_root) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (is_root == this->is_root) {
+        return;
+    }
+
+    this->is_root = is_root;
+    memset(reference_mac, 0, sizeof(reference_mac));
+    filter.reset();
+
+    // Only has to differ from the previous roots' IDs, which the low
+    // bits of the clock at the time of the switch nearly always do
+    timebase = is_root ? 1 + uint64_t(local_clock()) % 255 : 0;
+}
+
+bool MeshClock::request_sync() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (is_root) {
+            return false;
+        }
+        stats.requests_sent++;
+    }
+
+    uint8_t request[MESH_TIME_REQUEST_SIZE];
+    put_i64(put_header(request, MESH_TIME_TYPE_REQUEST, 0), local_clock());
+
+    return transport.send_to_root(request, sizeof(request));
+}
+
+bool MeshClock::is_synced() {
+    std::lock_guard<std::mutex> guard(lock);
+    return is_root || filter.is_synced();
+}
+
+int64_t MeshClock::now() {
+    return stamp().us;
+}
+
+mesh_time_t MeshClock::stamp() {
+    std::lock_guard<std::mutex> guard(lock);
+
+    int64_t local = local_clock();
+    if (is_root) {
+        return { local, timebase };
+    }
+
+    return { filter.to_reference(local), uint8_t(filter.is_synced() ? timebase : 0) };
+}
+
+mesh_clock_stats_t MeshClock::get_stats() {
+    std::lock_guard<std::mutex> guard(lock);
+
+    mesh_clock_stats_t out = stats;
+    out.synced = is_root || filter.is_synced();
+    out.timebase = out.synced ? timebase : 0;
+    out.offset_us = filter.get_offset();
+    out.delay_us = filter.get_delay();
+    out.drift_ppm = filter.get_drift_ppm();
+
+    return out;
+}
+
+void MeshClock::make_default() {
+    default_clock = this;
+}
+
+mesh_time_t mesh_time_stamp() {
+    if (default_clock != nullptr) {
+        return default_clock->stamp();
+    }
+
+    return { std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count(), 0 };
+}
+
+int64_t mesh_time_us() {
+    return mesh_time_stamp().us;
+}
+
+bool mesh_time_synced() {
+    return mesh_time_stamp().synced();
+}
+
+} // namespace Communication
+} // namespace Xasin
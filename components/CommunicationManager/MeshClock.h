@@ -0,0 +1,173 @@
+// MeshClock.h
+#pragma once
+
+#include "MeshTransport.h"
+
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+
+// Time sync frames, little endian. The root answers every request with
+// its own clock at reception and at sending.
+//
+//   u8 magic 'T', u8 version, u8 type, u8 timebase
+//   request  i64 t1: node time at sending
+//   reply    i64 t1, i64 t2: root time at reception, i64 t3: root time at sending
+//
+// The timebase is 0 in requests. In replies, it is the ID the root picked
+// when it became root, never 0, so that nodes and the server can tell the
+// clocks of successive roots apart.
+// Version 2 added the timebase.
+#define MESH_TIME_MAGIC 'T'
+#define MESH_TIME_VERSION 2
+
+#define MESH_TIME_REQUEST_SIZE 12
+#define MESH_TIME_REPLY_SIZE 28
+
+// Samples the filter picks the best of
+#define MESH_CLOCK_SAMPLES 8
+// Picked samples offset and drift are fitted over
+#define MESH_CLOCK_HISTORY 16
+
+namespace Xasin {
+namespace Communication {
+
+// NTP style offset and drift estimation from request/reply timestamps.
+//
+// Each exchange gives an offset, accurate to within half of its round trip
+// delay. Of the last MESH_CLOCK_SAMPLES exchanges, the one with the lowest
+// error bound is picked, as queueing in the mesh only ever adds delay. Like
+// in NTP, the bound of older samples grows with the drift they might have
+// missed. Offset and drift then come from a least squares fit over the
+// last MESH_CLOCK_HISTORY picked samples, which averages out what delay
+// noise remains.
+//
+// Pure arithmetic on the timestamps, so it can be fed simulated ones.
+class MeshClockFilter {
+private:
+    struct sample_t {
+        int64_t local;
+        int64_t offset;
+        int64_t delay;
+    };
+
+    sample_t samples[MESH_CLOCK_SAMPLES];
+    uint8_t sample_count;
+    uint8_t next_sample;
+
+    // Picked samples, each one only once
+    sample_t history[MESH_CLOCK_HISTORY];
+    uint8_t history_count;
+    uint8_t next_history;
+    int64_t last_picked;
+
+    // Fitted offset at fit_local, and the reference clock rate relative
+    // to the local clock, as rate - 1
+    int64_t fit_local;
+    double fit_offset;
+    double drift;
+
+    void fit();
+
+public:
+    MeshClockFilter();
+
+    // Forgets everything, i.e. when the reference clock changed
+    void reset();
+
+    // Timestamps of one exchange: t1, t4 local, t2, t3 of the reference.
+    // Returns false if the sample was rejected as implausible.
+    bool add_sample(int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+
+    bool is_synced() const;
+    // Returns local if not synced yet
+    int64_t to_reference(int64_t local) const;
+
+    int64_t get_offset() const;
+    int64_t get_delay() const;
+    float get_drift_ppm() const;
+};
+
+// A point in mesh time, and which clock it was taken on
+struct mesh_time_t {
+    int64_t us;
+    // The root timebase the node was synced to, 0 while it was not synced
+    // and us is only the local clock. Stamps with different timebases can
+    // not be compared, as a new root brings a clock of its own.
+    uint8_t timebase;
+
+    bool synced() const { return timebase != 0; }
+};
+
+struct mesh_clock_stats_t {
+    uint32_t requests_sent;
+    uint32_t replies_received;
+    uint32_t samples_rejected;
+    // Requests the root answered
+    uint32_t requests_answered;
+
+    bool synced;
+    uint8_t timebase;
+    // Times the node started over on a new root's clock
+    uint32_t timebase_changes;
+    int64_t offset_us;
+    uint32_t delay_us;
+    float drift_ppm;
+};
+
+// Keeps a common microsecond timebase across the mesh. The root's own clock
+// is the reference, the other nodes estimate their offset to it with
+// a MeshClockFilter, by calling request_sync() periodically.
+class MeshClock {
+public:
+    // Local monotonic time in µs, i.e. esp_timer_get_time
+    using clock_func_t = std::function<int64_t ()>;
+
+private:
+    MeshTransport &transport;
+    const clock_func_t local_clock;
+
+    std::mutex lock;
+    MeshClockFilter filter;
+    bool is_root;
+    // Replies from another root, or another timebase, start the filter over
+    uint8_t reference_mac[6];
+    uint8_t timebase;
+
+    mesh_clock_stats_t stats;
+
+    void receive(const uint8_t *from, const uint8_t *data, size_t length);
+
+public:
+    MeshClock(MeshTransport &transport, clock_func_t local_clock);
+
+    // The root answers requests, and is its own reference. It picks
+    // a new timebase ID every time it becomes root.
+    void set_root(bool is_root);
+
+    // Sends a request to the root, to be called periodically on nodes
+    bool request_sync();
+
+    bool is_synced();
+    // Mesh time in µs. Before the first sync, this is the local clock.
+    int64_t now();
+    // Mesh time, with the timebase it belongs to
+    mesh_time_t stamp();
+
+    mesh_clock_stats_t get_stats();
+
+    // Makes this the clock behind mesh_time_us()
+    void make_default();
+};
+
+// Current mesh time in µs, common to all nodes that are in sync.
+// Falls back to the local monotonic clock without a default MeshClock,
+// or while it is not synced, and jumps when a new root takes over.
+// Anything that is sent on should use mesh_time_stamp() instead.
+int64_t mesh_time_us();
+// Current mesh time and its timebase, 0 if it is only the local clock
+mesh_time_t mesh_time_stamp();
+bool mesh_time_synced();
+
+} // namespace Communication
+} // namespace Xasin
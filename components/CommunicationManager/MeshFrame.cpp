@@ -0,0 +1,131 @@
+// MeshFrame.cpp
+#include "MeshFrame.h"
+
+#include <string.h>
+
+namespace Xasin {
+namespace Communication {
+
+static const char *const mesh_topics[MESH_TOPIC_COUNT] = {
+    nullptr,
+    "event/ir_hit",
+    "event/ir_beacon",
+    "ping_signal",
+    "get/_ping",
+    "get/state",
+};
+
+uint8_t mesh_topic_id(std::string_view topic) {
+    for (uint8_t i = 1; i < MESH_TOPIC_COUNT; i++) {
+        if (topic == mesh_topics[i]) {
+            return i;
+        }
+    }
+
+    return MESH_TOPIC_NONE;
+}
+
+const char *mesh_topic_name(uint8_t id) {
+    if (id >= MESH_TOPIC_COUNT) {
+        return nullptr;
+    }
+
+    return mesh_topics[id];
+}
+
+MeshFrameBuilder::MeshFrameBuilder(uint8_t *buffer, size_t capacity, bool with_source)
+    : buffer(buffer), capacity(capacity), length(MESH_FRAME_HEADER_SIZE) {
+
+    buffer[0] = MESH_FRAME_MAGIC;
+    buffer[1] = MESH_FRAME_VERSION;
+    buffer[2] = with_source ? MESH_FRAME_FLAG_SOURCE : 0;
+    buffer[3] = 0;
+}
+
+void MeshFrameBuilder::reset() {
+    length = MESH_FRAME_HEADER_SIZE;
+    buffer[3] = 0;
+}
+
+bool MeshFrameBuilder::append(const uint8_t *source, uint8_t topic_id, bool retain, int qos, const void *data, size_t data_length) {
+    bool with_source = buffer[2] & MESH_FRAME_FLAG_SOURCE;
+    size_t record_size = (with_source ? MESH_FRAME_SOURCE_SIZE : 0) + MESH_FRAME_RECORD_HEADER_SIZE + data_length;
+
+    if (buffer[3] == UINT8_MAX || data_length > UINT16_MAX || length + record_size > capacity) {
+        return false;
+    }
+
+    uint8_t *out = buffer + length;
+    if (with_source) {
+        memcpy(out, source, MESH_FRAME_SOURCE_SIZE);
+        out += MESH_FRAME_SOURCE_SIZE;
+    }
+
+    out[0] = topic_id;
+    out[1] = (retain ? 1 : 0) | ((qos & 0x03) << 1);
+    out[2] = data_length & 0xFF;
+    out[3] = data_length >> 8;
+    memcpy(out + MESH_FRAME_RECORD_HEADER_SIZE, data, data_length);
+
+    length += record_size;
+    buffer[3]++;
+
+    return true;
+}
+
+// Walks all records, only calling cb if it is set. Returns false as soon
+// as a record runs past the end of the frame.
+static bool walk_records(const uint8_t *frame, size_t length, const std::function<void (const mesh_record_t &record)> *cb) {
+    bool with_source = frame[2] & MESH_FRAME_FLAG_SOURCE;
+    size_t pos = MESH_FRAME_HEADER_SIZE;
+
+    for (uint8_t i = 0; i < frame[3]; i++) {
+        mesh_record_t record = {};
+
+        if (with_source) {
+            if (pos + MESH_FRAME_SOURCE_SIZE > length) {
+                return false;
+            }
+            record.source = frame + pos;
+            pos += MESH_FRAME_SOURCE_SIZE;
+        }
+
+        if (pos + MESH_FRAME_RECORD_HEADER_SIZE > length) {
+            return false;
+        }
+
+        record.topic_id = frame[pos];
+        record.retain = frame[pos + 1] & 1;
+        record.qos = (frame[pos + 1] >> 1) & 0x03;
+        record.length = frame[pos + 2] | (frame[pos + 3] << 8);
+        pos += MESH_FRAME_RECORD_HEADER_SIZE;
+
+        if (pos + record.length > length) {
+            return false;
+        }
+        record.data = frame + pos;
+        pos += record.length;
+
+        if (cb != nullptr) {
+            (*cb)(record);
+        }
+    }
+
+    return pos == length;
+}
+
+bool mesh_frame_parse(const uint8_t *frame, size_t length, const std::function<void (const mesh_record_t &record)> &cb) {
+    if (length < MESH_FRAME_HEADER_SIZE || frame[0] != MESH_FRAME_MAGIC || frame[1] != MESH_FRAME_VERSION) {
+        return false;
+    }
+
+    if (!walk_records(frame, length, nullptr)) {
+        return false;
+    }
+
+    walk_records(frame, length, &cb);
+    return true;
+}
+
+} // namespace Communication
+} // namespace Xasin
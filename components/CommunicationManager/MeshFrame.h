@@ -0,0 +1,83 @@
+// MeshFrame.h
+#pragma once
+
+#include <functional>
+#include <string_view>
+#include <stdint.h>
+#include <stddef.h>
+
+// Binary frames carried directly over ESP-MESH, see MeshBridge.h.
+// All values are little endian.
+//
+//   header   u8 magic 'X', u8 version, u8 flags, u8 record count
+//   records  [6 byte source MAC, only with MESH_FRAME_FLAG_SOURCE]
+//            u8 topic ID, u8 flags (bit 0 retain, bits 1-2 QoS),
+//            u16 payload length, followed by the payload
+#define MESH_FRAME_MAGIC 'X'
+#define MESH_FRAME_VERSION 1
+
+#define MESH_FRAME_HEADER_SIZE 4
+#define MESH_FRAME_RECORD_HEADER_SIZE 4
+#define MESH_FRAME_SOURCE_SIZE 6
+
+// Every record carries the MAC of the node that sent it
+#define MESH_FRAME_FLAG_SOURCE 0x01
+
+namespace Xasin {
+namespace Communication {
+
+// Topics that are carried over the mesh instead of MQTT. These are the
+// latency critical game events, everything else still goes over IP.
+// IDs are part of the wire format, only ever append to this list.
+enum mesh_topic_id_t : uint8_t {
+    MESH_TOPIC_NONE = 0,
+    MESH_TOPIC_IR_HIT,
+    MESH_TOPIC_IR_BEACON,
+    MESH_TOPIC_PING_SIGNAL,
+    MESH_TOPIC_PING_REPLY,
+    MESH_TOPIC_PLAYER_STATE,
+    MESH_TOPIC_COUNT
+};
+
+// Returns MESH_TOPIC_NONE for topics that are not carried over the mesh
+uint8_t mesh_topic_id(std::string_view topic);
+// Returns nullptr for unknown IDs
+const char *mesh_topic_name(uint8_t id);
+
+struct mesh_record_t {
+    const uint8_t *source; // nullptr if the frame carries no source MACs
+    uint8_t topic_id;
+    bool retain;
+    uint8_t qos;
+    const uint8_t *data;
+    uint16_t length;
+};
+
+// Packs records into a frame in a caller provided buffer, without allocating.
+class MeshFrameBuilder {
+private:
+    uint8_t *buffer;
+    size_t capacity;
+    size_t length;
+
+public:
+    MeshFrameBuilder(uint8_t *buffer, size_t capacity, bool with_source = false);
+
+    void reset();
+
+    // Returns false, leaving the frame untouched, if the record does not fit.
+    // source is only used for frames built with_source.
+    bool append(const uint8_t *source, uint8_t topic_id, bool retain, int qos, const void *data, size_t data_length);
+
+    const uint8_t *data() const { return buffer; }
+    size_t size() const { return length; }
+    uint8_t count() const { return buffer[3]; }
+    bool empty() const { return count() == 0; }
+};
+
+// Checks the whole frame first, and only if it is valid calls cb for each
+// record in order. The record data points into frame.
+bool mesh_frame_parse(const uint8_t *frame, size_t length, const std::function<void (const mesh_record_t &record)> &cb);
+
+} // namespace Communication
+} // namespace Xasin
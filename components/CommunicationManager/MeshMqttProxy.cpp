@@ -0,0 +1,622 @@
+// MeshMqttProxy.cpp
+#include "MeshMqttProxy.h"
+
+#include "esp_log.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+static const char *PROXY_TAG = "MeshMqttProxy";
+
+namespace Xasin {
+namespace Communication {
+
+#define MESH_MQTT_SUBSCRIBE 1
+#define MESH_MQTT_UNSUBSCRIBE 2
+#define MESH_MQTT_PUBLISH 3
+#define MESH_MQTT_KEEPALIVE 4
+#define MESH_MQTT_MESSAGE 5
+#define MESH_MQTT_STATUS 6
+
+// Longest topic or filter as the broker sees it, including the terminating zero
+#define MESH_MQTT_TOPIC_LENGTH 128
+
+// Nodes and the root give up on each other after this many missed keepalives
+#define MESH_MQTT_KEEPALIVE_MISSES 3
+
+static const int64_t keepalive_timeout = int64_t(CONFIG_COMM_MESH_MQTT_KEEPALIVE) * 1000 * MESH_MQTT_KEEPALIVE_MISSES;
+
+MeshMqttProxy::MeshMqttProxy(MeshTransport &transport, const upstream_t &upstream,
+                             const std::string &topic_prefix, clock_func_t clock)
+    : transport(transport), upstream(upstream), topic_prefix(topic_prefix), clock(clock),
+      lock(), upstream_lock(), rx_lock(), rx_queue(),
+      is_root(false), broker_connected(false),
+      node_subscriptions(), next_id(1), needs_resync(true), root_connected(false), last_status(0),
+      children(), filters(),
+      frame(), stats(),
+      on_received(nullptr), on_connected(nullptr) {
+
+    this->transport.set_handler(MESH_MQTT_MAGIC, [this](const uint8_t *from, const uint8_t *data, size_t length) {
+        queue_frame(from, data, length);
+    });
+}
+
+void MeshMqttProxy::queue_frame(const uint8_t *from, const uint8_t *data, size_t length) {
+    {
+        std::lock_guard<std::mutex> guard(rx_lock);
+
+        // The only stats field not guarded by lock
+        if (rx_queue.size() >= MESH_MQTT_RX_QUEUE) {
+            stats.frames_dropped++;
+            return;
+        }
+
+        rx_queue.emplace_back();
+        received_frame_t &received = rx_queue.back();
+        memcpy(received.from, from, sizeof(received.from));
+        received.data.assign(data, data + length);
+    }
+
+    if (on_received) {
+        on_received();
+    }
+}
+
+size_t MeshMqttProxy::process_received() {
+    size_t count = 0;
+
+    while (true) {
+        received_frame_t received;
+        {
+            std::lock_guard<std::mutex> guard(rx_lock);
+            if (rx_queue.empty()) {
+                return count;
+            }
+            received = std::move(rx_queue.front());
+            rx_queue.pop_front();
+        }
+
+        receive(received.from, received.data.data(), received.data.size());
+        count++;
+    }
+}
+
+// Expects lock to be held, and the frame to be sent before it is released.
+uint8_t *MeshMqttProxy::start_frame(uint8_t type, uint8_t argument) {
+    frame[0] = MESH_MQTT_MAGIC;
+    frame[1] = MESH_MQTT_VERSION;
+    frame[2] = type;
+    frame[3] = argument;
+
+    return frame + MESH_MQTT_HEADER_SIZE;
+}
+
+// Expects lock to be held.
+bool MeshMqttProxy::send_subscribe(const node_subscription_t &subscription) {
+    size_t length = MESH_MQTT_HEADER_SIZE + 1 + subscription.topic.size();
+    if (length > sizeof(frame)) {
+        return false;
+    }
+
+    uint8_t *out = start_frame(MESH_MQTT_SUBSCRIBE, subscription.id);
+    out[0] = subscription.qos;
+    memcpy(out + 1, subscription.topic.data(), subscription.topic.size());
+
+    return transport.send_to_root(frame, length);
+}
+
+MeshMqttProxy::child_t *MeshMqttProxy::find_child(const uint8_t *mac) {
+    for (auto &child : children) {
+        if (memcmp(child.mac, mac, sizeof(child.mac)) == 0) {
+            return &child;
+        }
+    }
+
+    return nullptr;
+}
+
+// Writes the topic as the broker sees it into buffer. Returns its length,
+// or 0 if it does not fit.
+size_t MeshMqttProxy::full_topic(const child_t &child, std::string_view topic, char *buffer, size_t size) {
+    int printed;
+
+    if (!topic.empty() && topic[0] == '/') {
+        printed = snprintf(buffer, size, "%.*s", int(topic.size()), topic.data());
+    } else {
+        const uint8_t *mac = child.mac;
+        printed = snprintf(buffer, size, "%s%02x:%02x:%02x:%02x:%02x:%02x/%.*s", topic_prefix.c_str(),
+                           mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], int(topic.size()), topic.data());
+    }
+
+    if (topic.empty() || printed < 0 || size_t(printed) >= size) {
+        return 0;
+    }
+    return printed;
+}
+
+// Expects lock to be held. A subscription ID already in use is replaced.
+void MeshMqttProxy::add_subscriber(child_t &child, uint8_t id, const std::string &filter, int qos,
+                                   std::vector<upstream_change_t> &changes) {
+    auto it = filters.find(filter);
+
+    // Sent again on a resync, which must not bounce the broker subscription
+    if (it != filters.end()) {
+        for (auto &subscriber : it->second.subscribers) {
+            if (subscriber.child == &child && subscriber.id == id) {
+                subscriber.qos = qos;
+                if (qos > it->second.qos) {
+                    it->second.qos = qos;
+                    changes.push_back({ filter, qos });
+                }
+                return;
+            }
+        }
+    }
+
+    remove_subscriber(child, id, changes);
+
+    it = filters.find(filter);
+    if (it == filters.end()) {
+        it = filters.emplace(filter, filter_t{ qos, {} }).first;
+        changes.push_back({ filter, qos });
+    }
+    else if (qos > it->second.qos) {
+        it->second.qos = qos;
+        changes.push_back({ filter, qos });
+    }
+
+    it->second.subscribers.push_back({ &child, id, qos });
+}
+
+// Expects lock to be held.
+void MeshMqttProxy::remove_subscriber(child_t &child, uint8_t id, std::vector<upstream_change_t> &changes) {
+    for (auto it = filters.begin(); it != filters.end(); it++) {
+        auto &subscribers = it->second.subscribers;
+
+        auto subscriber = std::find_if(subscribers.begin(), subscribers.end(), [&](const subscriber_t &s) {
+            return s.child == &child && s.id == id;
+        });
+        if (subscriber == subscribers.end()) {
+            continue;
+        }
+
+        subscribers.erase(subscriber);
+        if (subscribers.empty()) {
+            changes.push_back({ it->first, -1 });
+            filters.erase(it);
+        }
+
+        // IDs are unique per node
+        return;
+    }
+}
+
+// Expects lock to be held.
+void MeshMqttProxy::remove_child(std::list<child_t>::iterator child, std::vector<upstream_change_t> &changes) {
+    for (auto it = filters.begin(); it != filters.end();) {
+        auto &subscribers = it->second.subscribers;
+        subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(), [&](const subscriber_t &s) {
+            return s.child == &*child;
+        }), subscribers.end());
+
+        if (subscribers.empty()) {
+            changes.push_back({ it->first, -1 });
+            it = filters.erase(it);
+        } else {
+            it++;
+        }
+    }
+
+    children.erase(child);
+}
+
+// Expects lock to be held.
+void MeshMqttProxy::send_status(const uint8_t *mac, uint8_t flags) {
+    start_frame(MESH_MQTT_STATUS, flags | (broker_connected ? MESH_MQTT_STATUS_CONNECTED : 0));
+    transport.send_to(mac, frame, MESH_MQTT_HEADER_SIZE);
+}
+
+// Expects upstream_lock to be held, and lock not to be.
+void MeshMqttProxy::apply(const std::vector<upstream_change_t> &changes) {
+    for (auto &change : changes) {
+        if (change.qos < 0) {
+            if (upstream.unsubscribe) {
+                upstream.unsubscribe(change.filter);
+            }
+        } else if (upstream.subscribe) {
+            upstream.subscribe(change.filter, change.qos);
+        }
+    }
+}
+
+void MeshMqttProxy::receive(const uint8_t *from, const uint8_t *data, size_t length) {
+    // Answers go out only once all locks are released, so that no send
+    // ever waits on the broker or a subscriber callback.
+    int status = -1;
+    bool resync = false;
+    bool became_connected = false;
+
+    {
+        std::lock_guard<std::mutex> upstream_guard(upstream_lock);
+        std::vector<upstream_change_t> changes;
+
+        {
+            std::lock_guard<std::recursive_mutex> guard(lock);
+
+            if (length < MESH_MQTT_HEADER_SIZE || data[1] != MESH_MQTT_VERSION) {
+                stats.frames_malformed++;
+                return;
+            }
+
+            if (is_root) {
+                status = receive_on_root(from, data, length, changes);
+            } else {
+                bool was_connected = is_connected();
+                resync = receive_on_node(data, length);
+                became_connected = !was_connected && is_connected();
+            }
+        }
+
+        apply(changes);
+    }
+
+    if (status >= 0) {
+        std::lock_guard<std::recursive_mutex> guard(lock);
+        send_status(from, status);
+    }
+    if (resync) {
+        keepalive();
+    }
+    if (became_connected && on_connected) {
+        on_connected();
+    }
+}
+
+// Expects lock to be held. Returns true if the root asked for all
+// subscriptions again.
+bool MeshMqttProxy::receive_on_node(const uint8_t *data, size_t length) {
+    switch (data[2]) {
+    case MESH_MQTT_STATUS:
+        root_connected = data[3] & MESH_MQTT_STATUS_CONNECTED;
+        last_status = clock();
+
+        if (data[3] & MESH_MQTT_STATUS_RESYNC) {
+            needs_resync = true;
+            return true;
+        }
+        break;
+
+    case MESH_MQTT_MESSAGE: {
+        if (length < MESH_MQTT_HEADER_SIZE + 2) {
+            stats.frames_malformed++;
+            return false;
+        }
+
+        size_t topic_length = data[4];
+        size_t rest_length = data[5];
+        size_t payload_start = MESH_MQTT_HEADER_SIZE + 2 + topic_length;
+        if (rest_length > topic_length || payload_start > length) {
+            stats.frames_malformed++;
+            return false;
+        }
+
+        auto subscription = std::find_if(node_subscriptions.begin(), node_subscriptions.end(),
+                                         [&](const node_subscription_t &s) { return s.id == data[3]; });
+        // Left over from an unsubscribe the root did not get yet
+        if (subscription == node_subscriptions.end()) {
+            return false;
+        }
+
+        std::string_view topic(reinterpret_cast<const char *>(data) + MESH_MQTT_HEADER_SIZE + 2, topic_length);
+
+        CommReceivedData received;
+        received.topic = subscription->topic;
+        received.sub_topic = topic.substr(topic_length - rest_length);
+        received.payload = { data + payload_start, length - payload_start };
+        received.source_id = topic_segment(topic, 2);
+
+        stats.messages_received++;
+        subscription->callback(received);
+        break;
+    }
+
+    default:
+        stats.frames_malformed++;
+        break;
+    }
+
+    return false;
+}
+
+// Expects lock to be held. Returns the STATUS flags to answer with,
+// or -1 for no answer.
+int MeshMqttProxy::receive_on_root(const uint8_t *from, const uint8_t *data, size_t length,
+                                   std::vector<upstream_change_t> &changes) {
+    child_t *child = find_child(from);
+    bool known = child != nullptr;
+    if (!known) {
+        children.push_back({});
+        child = &children.back();
+        memcpy(child->mac, from, sizeof(child->mac));
+    }
+    child->last_seen = clock();
+
+    switch (data[2]) {
+    case MESH_MQTT_SUBSCRIBE: {
+        char filter[MESH_MQTT_TOPIC_LENGTH];
+        size_t filter_length = 0;
+        if (length > MESH_MQTT_HEADER_SIZE + 1) {
+            std::string_view topic(reinterpret_cast<const char *>(data) + MESH_MQTT_HEADER_SIZE + 1,
+                                   length - MESH_MQTT_HEADER_SIZE - 1);
+            filter_length = full_topic(*child, topic, filter, sizeof(filter));
+        }
+        if (filter_length == 0) {
+            stats.frames_malformed++;
+            return -1;
+        }
+
+        add_subscriber(*child, data[3], std::string(filter, filter_length), data[4] & 3, changes);
+        // A node sending subscriptions is already resyncing
+        return -1;
+    }
+
+    case MESH_MQTT_UNSUBSCRIBE:
+        remove_subscriber(*child, data[3], changes);
+        break;
+
+    case MESH_MQTT_PUBLISH: {
+        size_t topic_length = (length > MESH_MQTT_HEADER_SIZE) ? data[4] : 0;
+        size_t payload_start = MESH_MQTT_HEADER_SIZE + 1 + topic_length;
+
+        char topic[MESH_MQTT_TOPIC_LENGTH];
+        size_t full_length = 0;
+        if (payload_start <= length) {
+            full_length = full_topic(*child, std::string_view(reinterpret_cast<const char *>(data) + MESH_MQTT_HEADER_SIZE + 1,
+                                                              topic_length), topic, sizeof(topic));
+        }
+        if (full_length == 0) {
+            stats.frames_malformed++;
+            return -1;
+        }
+
+        // Without a broker connection, the root's offline queue takes it
+        if (upstream.publish) {
+            upstream.publish(topic, data + payload_start, length - payload_start, data[3] & 1, (data[3] >> 1) & 3);
+        }
+        stats.publishes_forwarded++;
+        break;
+    }
+
+    case MESH_MQTT_KEEPALIVE:
+        return known ? 0 : MESH_MQTT_STATUS_RESYNC;
+
+    default:
+        stats.frames_malformed++;
+        return -1;
+    }
+
+    return known ? -1 : MESH_MQTT_STATUS_RESYNC;
+}
+
+void MeshMqttProxy::set_root(bool is_root) {
+    std::lock_guard<std::mutex> upstream_guard(upstream_lock);
+    std::vector<upstream_change_t> changes;
+
+    {
+        std::lock_guard<std::recursive_mutex> guard(lock);
+
+        if (is_root == this->is_root) {
+            return;
+        }
+        this->is_root = is_root;
+
+        if (is_root) {
+            root_connected = false;
+        } else {
+            while (!children.empty()) {
+                remove_child(children.begin(), changes);
+            }
+            needs_resync = true;
+        }
+    }
+
+    apply(changes);
+}
+
+bool MeshMqttProxy::subscribe(const std::string &topic, comm_message_callback_t callback, int qos) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    auto subscription = std::find_if(node_subscriptions.begin(), node_subscriptions.end(),
+                                     [&](const node_subscription_t &s) { return s.topic == topic; });
+
+    if (subscription == node_subscriptions.end()) {
+        if (node_subscriptions.size() >= 255) {
+            ESP_LOGE(PROXY_TAG, "Out of subscription IDs for %s", topic.c_str());
+            return false;
+        }
+
+        // IDs are handed out round robin, so that messages still in flight
+        // for a removed subscription do not reach a new one.
+        auto in_use = [this](uint8_t id) {
+            return std::any_of(node_subscriptions.begin(), node_subscriptions.end(),
+                               [id](const node_subscription_t &s) { return s.id == id; });
+        };
+        while (next_id == 0 || in_use(next_id)) {
+            next_id++;
+        }
+
+        node_subscriptions.push_back({ next_id++, topic, qos, callback });
+        subscription = std::prev(node_subscriptions.end());
+    } else {
+        subscription->qos = qos;
+        subscription->callback = callback;
+    }
+
+    stats.subscriptions = node_subscriptions.size();
+
+    if (!is_root && !send_subscribe(*subscription)) {
+        // Sent with the next keepalive instead
+        needs_resync = true;
+    }
+
+    return true;
+}
+
+bool MeshMqttProxy::unsubscribe(const std::string &topic) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    auto subscription = std::find_if(node_subscriptions.begin(), node_subscriptions.end(),
+                                     [&](const node_subscription_t &s) { return s.topic == topic; });
+    if (subscription == node_subscriptions.end()) {
+        return false;
+    }
+
+    uint8_t id = subscription->id;
+    node_subscriptions.erase(subscription);
+    stats.subscriptions = node_subscriptions.size();
+
+    // If this gets lost, the root keeps sending messages for the ID until
+    // the next resync, which are then ignored.
+    if (!is_root) {
+        start_frame(MESH_MQTT_UNSUBSCRIBE, id);
+        transport.send_to_root(frame, MESH_MQTT_HEADER_SIZE);
+    }
+
+    return true;
+}
+
+bool MeshMqttProxy::publish(std::string_view topic, const void *data, size_t length, bool retain, int qos) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    if (!is_connected() || topic.empty() || topic.size() > 255) {
+        return false;
+    }
+
+    size_t frame_length = MESH_MQTT_HEADER_SIZE + 1 + topic.size() + length;
+    if (frame_length > sizeof(frame)) {
+        ESP_LOGW(PROXY_TAG, "Dropping %u byte publish to %.*s", unsigned(frame_length), int(topic.size()), topic.data());
+        stats.messages_oversized++;
+        return false;
+    }
+
+    uint8_t *out = start_frame(MESH_MQTT_PUBLISH, (retain ? 1 : 0) | ((qos & 3) << 1));
+    out[0] = topic.size();
+    memcpy(out + 1, topic.data(), topic.size());
+    memcpy(out + 1 + topic.size(), data, length);
+
+    if (!transport.send_to_root(frame, frame_length)) {
+        return false;
+    }
+
+    stats.publishes_sent++;
+    return true;
+}
+
+void MeshMqttProxy::keepalive() {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    if (is_root) {
+        return;
+    }
+
+    if (needs_resync) {
+        bool all_sent = true;
+        for (auto &subscription : node_subscriptions) {
+            all_sent &= send_subscribe(subscription);
+        }
+        needs_resync = !all_sent;
+    }
+
+    start_frame(MESH_MQTT_KEEPALIVE, 0);
+    transport.send_to_root(frame, MESH_MQTT_HEADER_SIZE);
+}
+
+bool MeshMqttProxy::is_connected() const {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    return !is_root && root_connected && (clock() - last_status) < keepalive_timeout;
+}
+
+void MeshMqttProxy::set_broker_connected(bool connected) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    if (connected == broker_connected) {
+        return;
+    }
+    broker_connected = connected;
+
+    // Nodes hear about it right away, not only with their next keepalive
+    for (auto &child : children) {
+        send_status(child.mac, 0);
+    }
+}
+
+void MeshMqttProxy::route(std::string_view filter, std::string_view topic, std::string_view topic_rest,
+                          const void *data, size_t length) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    auto it = filters.find(filter);
+    if (it == filters.end()) {
+        return;
+    }
+
+    size_t frame_length = MESH_MQTT_HEADER_SIZE + 2 + topic.size() + length;
+    if (topic.size() > 255 || topic_rest.size() > topic.size() || frame_length > sizeof(frame)) {
+        ESP_LOGW(PROXY_TAG, "Dropping %u byte message on %.*s", unsigned(frame_length), int(topic.size()), topic.data());
+        stats.messages_oversized++;
+        return;
+    }
+
+    uint8_t *out = start_frame(MESH_MQTT_MESSAGE, 0);
+    out[0] = topic.size();
+    out[1] = topic_rest.size();
+    memcpy(out + 2, topic.data(), topic.size());
+    memcpy(out + 2 + topic.size(), data, length);
+
+    for (auto &subscriber : it->second.subscribers) {
+        frame[3] = subscriber.id;
+        if (transport.send_to(subscriber.child->mac, frame, frame_length)) {
+            stats.messages_routed++;
+        }
+    }
+}
+
+void MeshMqttProxy::expire() {
+    std::lock_guard<std::mutex> upstream_guard(upstream_lock);
+    std::vector<upstream_change_t> changes;
+
+    {
+        std::lock_guard<std::recursive_mutex> guard(lock);
+
+        int64_t now = clock();
+        for (auto child = children.begin(); child != children.end();) {
+            auto next = std::next(child);
+            if ((now - child->last_seen) >= keepalive_timeout) {
+                ESP_LOGI(PROXY_TAG, "Dropping silent node %02x:%02x:%02x:%02x:%02x:%02x",
+                         child->mac[0], child->mac[1], child->mac[2], child->mac[3], child->mac[4], child->mac[5]);
+                remove_child(child, changes);
+                stats.children_expired++;
+            }
+            child = next;
+        }
+    }
+
+    apply(changes);
+}
+
+mesh_mqtt_proxy_stats_t MeshMqttProxy::get_stats() {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    mesh_mqtt_proxy_stats_t out;
+    {
+        std::lock_guard<std::mutex> rx_guard(rx_lock);
+        out = stats;
+    }
+    out.children = children.size();
+    out.broker_subscriptions = filters.size();
+
+    return out;
+}
+
+} // namespace Communication
+} // namespace Xasin
@@ -0,0 +1,237 @@
+// MeshMqttProxy.h
+#pragma once
+
+#include "sdkconfig.h"
+
+#include "CommHandler.h"
+#include "MeshTransport.h"
+
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+
+// MQTT proxy frames, between nodes and the root:
+//
+//   u8 magic 'M', u8 version, u8 type, u8 argument, followed by
+//   SUBSCRIBE    node to root, argument subscription ID, u8 QoS, topic filter
+//   UNSUBSCRIBE  node to root, argument subscription ID
+//   PUBLISH      node to root, argument flags (bit 0 retain, bits 1-2 QoS),
+//                u8 topic length, topic, payload
+//   KEEPALIVE    node to root
+//   MESSAGE      root to node, argument subscription ID, u8 topic length,
+//                u8 length of the part matched by wildcards, which is
+//                always a suffix of the topic, full topic, payload
+//   STATUS       root to node, argument flags, see MESH_MQTT_STATUS_*
+//
+// Topics from nodes are relative to the node's own base topic, unless
+// they start with '/'.
+#define MESH_MQTT_MAGIC 'M'
+#define MESH_MQTT_VERSION 1
+
+#define MESH_MQTT_HEADER_SIZE 4
+// Largest frame either side sends, i.e. the largest packet esp_mesh_send
+// takes (MESH_MPS). Larger messages are dropped and counted, with a warning.
+#define MESH_MQTT_MAX_FRAME 1472
+// Received frames waiting for process_received(), more are dropped
+#define MESH_MQTT_RX_QUEUE 16
+
+// The root has a broker connection
+#define MESH_MQTT_STATUS_CONNECTED 0x01
+// The root does not know the node, i.e. after it restarted, so the node
+// has to send all its subscriptions again.
+#define MESH_MQTT_STATUS_RESYNC 0x02
+
+namespace Xasin {
+namespace Communication {
+
+struct mesh_mqtt_proxy_stats_t {
+    // Node side
+    uint32_t subscriptions;
+    uint32_t publishes_sent;
+    uint32_t messages_received;
+
+    // Root side
+    uint32_t children;
+    // Distinct filters, i.e. what the broker sees of all children
+    uint32_t broker_subscriptions;
+    uint32_t publishes_forwarded;
+    uint32_t messages_routed;
+    uint32_t children_expired;
+
+    uint32_t frames_malformed;
+    // Received while MESH_MQTT_RX_QUEUE frames were still waiting
+    uint32_t frames_dropped;
+    uint32_t messages_oversized;
+};
+
+// Lets mesh nodes use the root's broker connection, instead of each
+// holding a TLS session and keepalive of its own through the root's NAPT.
+//
+// Nodes keep their subscriptions locally, and register them with the root,
+// which subscribes to each distinct filter only once and hands matching
+// messages on to every node that asked for them. Publishes are forwarded
+// the same way. The latency critical game events take the shorter path
+// of the MeshBridge instead.
+//
+// Nodes send a keepalive every CONFIG_COMM_MESH_MQTT_KEEPALIVE. The root
+// answers with its broker state, and forgets nodes it has not heard from
+// for three intervals, along with their subscriptions.
+//
+// Frames from the transport are only queued, as it may deliver them on
+// a small receive task. Broker access and subscriber callbacks happen in
+// process_received(), on whichever task calls it.
+//
+// The broker is reached through the upstream functions, so that this
+// runs on the host against a LocalBroker as well.
+class MeshMqttProxy {
+public:
+    // Local monotonic time in µs, i.e. esp_timer_get_time
+    using clock_func_t = std::function<int64_t ()>;
+
+    // Broker access on the root. Filters and topics are always full.
+    // subscribe is called again with a higher QoS if a node asks for one.
+    // Messages for a filter have to be handed to route().
+    struct upstream_t {
+        std::function<void (const std::string &filter, int qos)> subscribe;
+        std::function<void (const std::string &filter)> unsubscribe;
+        std::function<bool (const char *topic, const void *data, size_t length, bool retain, int qos)> publish;
+    };
+
+private:
+    struct node_subscription_t {
+        uint8_t id;
+        std::string topic;
+        int qos;
+        comm_message_callback_t callback;
+    };
+
+    struct child_t {
+        uint8_t mac[6];
+        int64_t last_seen;
+    };
+    struct subscriber_t {
+        child_t *child;
+        uint8_t id;
+        int qos;
+    };
+    struct filter_t {
+        int qos;
+        std::vector<subscriber_t> subscribers;
+    };
+
+    struct received_frame_t {
+        uint8_t from[6];
+        std::vector<uint8_t> data;
+    };
+
+    struct upstream_change_t {
+        std::string filter;
+        // -1 to unsubscribe
+        int qos;
+    };
+
+    MeshTransport &transport;
+    const upstream_t upstream;
+    const std::string topic_prefix;
+    const clock_func_t clock;
+
+    // Callbacks run with this held, and may publish and subscribe,
+    // but must not unsubscribe their own subscription.
+    mutable std::recursive_mutex lock;
+    // Serialises broker subscription changes, which happen outside of
+    // lock, as the broker's message dispatch calls route() with its own
+    // lock held.
+    std::mutex upstream_lock;
+
+    // Only guards rx_queue, so that the transport never waits on the others
+    std::mutex rx_lock;
+    std::deque<received_frame_t> rx_queue;
+
+    bool is_root;
+    bool broker_connected;
+
+    // Node side
+    std::list<node_subscription_t> node_subscriptions;
+    uint8_t next_id;
+    bool needs_resync;
+    bool root_connected;
+    int64_t last_status;
+
+    // Root side
+    std::list<child_t> children;
+    // std::less<> allows looking up filters by string_view
+    std::map<std::string, filter_t, std::less<>> filters;
+
+    uint8_t frame[MESH_MQTT_MAX_FRAME];
+
+    mesh_mqtt_proxy_stats_t stats;
+
+    uint8_t *start_frame(uint8_t type, uint8_t argument);
+    bool send_subscribe(const node_subscription_t &subscription);
+
+    child_t *find_child(const uint8_t *mac);
+    size_t full_topic(const child_t &child, std::string_view topic, char *buffer, size_t size);
+    void add_subscriber(child_t &child, uint8_t id, const std::string &filter, int qos,
+                        std::vector<upstream_change_t> &changes);
+    void remove_subscriber(child_t &child, uint8_t id, std::vector<upstream_change_t> &changes);
+    void remove_child(std::list<child_t>::iterator child, std::vector<upstream_change_t> &changes);
+    void send_status(const uint8_t *mac, uint8_t flags);
+    void apply(const std::vector<upstream_change_t> &changes);
+
+    void queue_frame(const uint8_t *from, const uint8_t *data, size_t length);
+    void receive(const uint8_t *from, const uint8_t *data, size_t length);
+    bool receive_on_node(const uint8_t *data, size_t length);
+    int receive_on_root(const uint8_t *from, const uint8_t *data, size_t length,
+                        std::vector<upstream_change_t> &changes);
+
+public:
+    // Relative topics of nodes go to topic_prefix + node MAC + '/' + topic
+    MeshMqttProxy(MeshTransport &transport, const upstream_t &upstream,
+                  const std::string &topic_prefix, clock_func_t clock);
+
+    // Handles the frames queued since the last call, and returns how many
+    // there were. Subscriber callbacks run from here.
+    size_t process_received();
+    // Called from the transport's task when a frame was queued, i.e. to
+    // wake up the task calling process_received().
+    std::function<void ()> on_received;
+
+    // Nodes register their subscriptions again after turning from root
+    // into node. A root turning into a node forgets its children.
+    void set_root(bool is_root);
+
+    // Node side. Subscriptions are kept across reconnects, and sent to
+    // the root whenever it needs them.
+    bool subscribe(const std::string &topic, comm_message_callback_t callback, int qos = 0);
+    bool unsubscribe(const std::string &topic);
+    // Returns false if the root did not take the message.
+    bool publish(std::string_view topic, const void *data, size_t length, bool retain = false, int qos = 0);
+    // To be called every CONFIG_COMM_MESH_MQTT_KEEPALIVE
+    void keepalive();
+    // True while the root recently reported a broker connection
+    bool is_connected() const;
+
+    // Called on the node when the root's broker connection comes back,
+    // i.e. to send out queued messages.
+    std::function<void ()> on_connected;
+
+    // Root side
+    void set_broker_connected(bool connected);
+    // Hands a broker message for filter on to all nodes subscribed to it.
+    // topic_rest is the part of topic matched by the filter's wildcards.
+    void route(std::string_view filter, std::string_view topic, std::string_view topic_rest,
+               const void *data, size_t length);
+    // Forgets nodes not heard from in three keepalive intervals
+    void expire();
+
+    mesh_mqtt_proxy_stats_t get_stats();
+};
+
+} // namespace Communication
+} // namespace Xasin
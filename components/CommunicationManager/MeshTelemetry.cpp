@@ -0,0 +1,128 @@
+// MeshTelemetry.cpp
+#include "MeshTelemetry.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+namespace Xasin {
+namespace Communication {
+
+#define MESH_TELEMETRY_VERSION 1
+
+MeshTelemetry::MeshTelemetry(sample_func_t read_link)
+    : read_link(read_link), lock(), telemetry(), last_parent(), parent_known(false) {
+}
+
+void MeshTelemetry::note_parent_connected(const uint8_t *mac) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    // Reconnecting to the same parent is not a change of topology
+    if (parent_known && memcmp(mac, last_parent, 6) != 0) {
+        telemetry.parent_changes++;
+    }
+
+    memcpy(last_parent, mac, 6);
+    parent_known = true;
+}
+
+void MeshTelemetry::note_parent_lost() {
+    std::lock_guard<std::mutex> guard(lock);
+    telemetry.parent_losses++;
+}
+
+void MeshTelemetry::note_layer_change() {
+    std::lock_guard<std::mutex> guard(lock);
+    telemetry.layer_changes++;
+}
+
+void MeshTelemetry::sample() {
+    mesh_link_reading_t reading = {};
+    read_link(reading);
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    telemetry.link = reading;
+    telemetry.tx_pending_peak = std::max(telemetry.tx_pending_peak, reading.tx_pending);
+    telemetry.rx_pending_peak = std::max(telemetry.rx_pending_peak, reading.rx_pending);
+    telemetry.samples++;
+}
+
+mesh_telemetry_t MeshTelemetry::get(bool reset_peaks) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    mesh_telemetry_t out = telemetry;
+    if (reset_peaks) {
+        telemetry.tx_pending_peak = telemetry.link.tx_pending;
+        telemetry.rx_pending_peak = telemetry.link.rx_pending;
+    }
+
+    return out;
+}
+
+static uint8_t *put_u16(uint8_t *out, uint16_t value) {
+    out[0] = value;
+    out[1] = value >> 8;
+    return out + 2;
+}
+
+size_t MeshTelemetry::encode(const mesh_telemetry_t &telemetry, uint8_t *buffer, size_t size) {
+    if (size < MESH_TELEMETRY_SIZE) {
+        return 0;
+    }
+
+    const mesh_link_reading_t &link = telemetry.link;
+
+    uint8_t *out = buffer;
+    *out++ = MESH_TELEMETRY_VERSION;
+    *out++ = link.is_root ? 1 : 0;
+    *out++ = link.layer;
+    *out++ = uint8_t(link.parent_rssi);
+    memcpy(out, link.parent_mac, 6);
+    out += 6;
+
+    out = put_u16(out, link.routing_table_size);
+    out = put_u16(out, link.tx_pending);
+    out = put_u16(out, telemetry.tx_pending_peak);
+    out = put_u16(out, link.rx_pending);
+    out = put_u16(out, telemetry.rx_pending_peak);
+    out = put_u16(out, telemetry.parent_changes);
+    out = put_u16(out, telemetry.parent_losses);
+    out = put_u16(out, telemetry.layer_changes);
+
+    return out - buffer;
+}
+
+size_t MeshTelemetry::format(const mesh_telemetry_t &telemetry, char *buffer, size_t size) {
+    const mesh_link_reading_t &link = telemetry.link;
+    const uint8_t *mac = link.parent_mac;
+
+    int printed;
+    if (telemetry.samples == 0) {
+        printed = snprintf(buffer, size, "No mesh data yet");
+    } else {
+        printed = snprintf(buffer, size,
+            "Layer %u%s, %u routes\n"
+            "Parent %02x:%02x:%02x:%02x:%02x:%02x\n"
+            "RSSI %d dBm\n"
+            "TX queue %u (peak %u)\n"
+            "RX queue %u (peak %u)\n"
+            "Parent changes %u, lost %u\n"
+            "Layer changes %u",
+            link.layer, link.is_root ? " (root)" : "", link.routing_table_size,
+            mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
+            link.parent_rssi,
+            link.tx_pending, telemetry.tx_pending_peak,
+            link.rx_pending, telemetry.rx_pending_peak,
+            telemetry.parent_changes, telemetry.parent_losses,
+            telemetry.layer_changes);
+    }
+
+    if (printed < 0 || size_t(printed) >= size) {
+        return 0;
+    }
+    return printed;
+}
+
+} // namespace Communication
+} // namespace Xasin
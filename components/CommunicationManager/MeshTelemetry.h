@@ -0,0 +1,89 @@
+// MeshTelemetry.h
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Xasin {
+namespace Communication {
+
+// Link state as read from the mesh stack at one point in time
+struct mesh_link_reading_t {
+    bool is_root;
+    uint8_t layer;
+    uint8_t parent_mac[6];
+    // Of the parent's beacons, 0 if there is no parent
+    int8_t parent_rssi;
+
+    uint16_t routing_table_size;
+    // Summed over all queues of esp_mesh_get_tx_pending/rx_pending
+    uint16_t tx_pending;
+    uint16_t rx_pending;
+};
+
+struct mesh_telemetry_t {
+    mesh_link_reading_t link;
+
+    // Highest queue depths seen since the previous telemetry message,
+    // so that short spikes between two messages still show up.
+    uint16_t tx_pending_peak;
+    uint16_t rx_pending_peak;
+
+    // Counted since boot
+    uint16_t parent_changes;
+    uint16_t parent_losses;
+    uint16_t layer_changes;
+
+    uint32_t samples;
+};
+
+// Message size of encode(), see there
+#define MESH_TELEMETRY_SIZE 26
+
+// Collects mesh topology and link quality, to find out where latency
+// spikes come from in larger meshes.
+//
+// The link state is read through a sampling function, and topology changes
+// are counted through the note_* calls from the mesh event handler. Neither
+// touches the mesh stack directly, so everything in here also runs on the
+// host, with fake readings.
+class MeshTelemetry {
+public:
+    using sample_func_t = std::function<void (mesh_link_reading_t &reading)>;
+
+private:
+    const sample_func_t read_link;
+
+    std::mutex lock;
+    mesh_telemetry_t telemetry;
+    uint8_t last_parent[6];
+    bool parent_known;
+
+public:
+    MeshTelemetry(sample_func_t read_link);
+
+    void note_parent_connected(const uint8_t *mac);
+    void note_parent_lost();
+    void note_layer_change();
+
+    // Reads the link state, and updates the queue peaks.
+    void sample();
+    // Returns the telemetry of the last sample(), and resets the
+    // peaks if it is being sent out.
+    mesh_telemetry_t get(bool reset_peaks = false);
+
+    // Compact little endian message of MESH_TELEMETRY_SIZE bytes:
+    //   u8 version (1), u8 flags (bit 0: root), u8 layer, i8 parent RSSI,
+    //   u8[6] parent MAC, u16 routing table size,
+    //   u16 TX pending, u16 TX peak, u16 RX pending, u16 RX peak,
+    //   u16 parent changes, u16 parent losses, u16 layer changes
+    // Returns the length, or 0 if the buffer is too small.
+    static size_t encode(const mesh_telemetry_t &telemetry, uint8_t *buffer, size_t size);
+    // Multi-line text for diagnostics screens
+    static size_t format(const mesh_telemetry_t &telemetry, char *buffer, size_t size);
+};
+
+} // namespace Communication
+} // namespace Xasin
@@ -0,0 +1,147 @@
+// MeshTopologyCache.cpp
+#include "MeshTopologyCache.h"
+
+#include "esp_log.h"
+#include "nvs.h"
+
+#include <string.h>
+
+static const char *TOPOLOGY_TAG = "MeshTopology";
+
+namespace Xasin {
+namespace Communication {
+
+MeshTopologyCache::MeshTopologyCache(const char *nvs_namespace)
+    : nvs_namespace(nvs_namespace),
+      lock(),
+      stored(), boot_stats() {
+}
+
+// Blobs of a different size are from an older layout, and ignored.
+bool MeshTopologyCache::read(const char *key, void *data, size_t length) {
+    nvs_handle_t handle;
+    if (nvs_open(nvs_namespace, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+
+    size_t stored_length = length;
+    esp_err_t err = nvs_get_blob(handle, key, data, &stored_length);
+    nvs_close(handle);
+
+    return err == ESP_OK && stored_length == length;
+}
+
+void MeshTopologyCache::write(const char *key, const void *data, size_t length) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(nvs_namespace, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, key, data, length);
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TOPOLOGY_TAG, "Could not write %s: %s", key, esp_err_to_name(err));
+    }
+}
+
+bool MeshTopologyCache::load(uint32_t config_hash, mesh_topology_t &topology) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (!read("boots", &boot_stats, sizeof(boot_stats))) {
+        boot_stats = {};
+    }
+    boot_stats.last_reconnect_ms = 0;
+
+    if (!read("topology", &stored, sizeof(stored))) {
+        stored = {};
+        return false;
+    }
+    if (stored.config_hash != config_hash) {
+        ESP_LOGI(TOPOLOGY_TAG, "Configuration changed, not using the cached topology");
+        stored = {};
+        return false;
+    }
+
+    topology = stored;
+    return true;
+}
+
+void MeshTopologyCache::store(const mesh_topology_t &topology) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (memcmp(&topology, &stored, sizeof(stored)) == 0) {
+        return;
+    }
+
+    stored = topology;
+    write("topology", &stored, sizeof(stored));
+}
+
+void MeshTopologyCache::forget_parent() {
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (stored.parent_ssid_length == 0) {
+        return;
+    }
+
+    memset(stored.parent_bssid, 0, sizeof(stored.parent_bssid));
+    stored.parent_ssid_length = 0;
+    write("topology", &stored, sizeof(stored));
+}
+
+// Kept in RAM only, and written along with the next first publish, as
+// nodes moving around might try many rejoins.
+void MeshTopologyCache::record_fast_rejoin(bool succeeded) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    boot_stats.fast_rejoins++;
+    if (!succeeded) {
+        boot_stats.fast_rejoins_failed++;
+    }
+}
+
+void MeshTopologyCache::record_first_publish(uint32_t ms, bool warm) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    boot_stats.boots++;
+    if (warm) {
+        boot_stats.warm_boots++;
+    }
+
+    memmove(boot_stats.first_publish_ms + 1, boot_stats.first_publish_ms,
+            sizeof(boot_stats.first_publish_ms) - sizeof(boot_stats.first_publish_ms[0]));
+    boot_stats.first_publish_ms[0] = ms;
+    boot_stats.warm_mask = (boot_stats.warm_mask << 1) | (warm ? 1 : 0);
+
+    write("boots", &boot_stats, sizeof(boot_stats));
+}
+
+void MeshTopologyCache::record_reconnect(uint32_t ms) {
+    std::lock_guard<std::mutex> guard(lock);
+    boot_stats.last_reconnect_ms = ms;
+}
+
+mesh_boot_stats_t MeshTopologyCache::get_boot_stats() {
+    std::lock_guard<std::mutex> guard(lock);
+    return boot_stats;
+}
+
+uint32_t MeshTopologyCache::config_hash(std::initializer_list<std::string_view> parts) {
+    uint32_t hash = 2166136261U;
+
+    for (auto part : parts) {
+        for (char c : part) {
+            hash = (hash ^ uint8_t(c)) * 16777619U;
+        }
+        // Keeps "ab" + "c" apart from "a" + "bc"
+        hash = (hash ^ 0xff) * 16777619U;
+    }
+
+    return hash;
+}
+
+} // namespace Communication
+} // namespace Xasin
@@ -0,0 +1,93 @@
+// MeshTopologyCache.h
+#pragma once
+
+#include <initializer_list>
+#include <mutex>
+#include <string_view>
+#include <stdint.h>
+
+// Boots remembered for their time to the first publish
+#define MESH_BOOT_HISTORY 8
+
+namespace Xasin {
+namespace Communication {
+
+// Where the node was last seen in the mesh, to rejoin there directly
+// instead of scanning all channels on the next boot.
+struct mesh_topology_t {
+    // Of the mesh and router configuration this was learned with
+    uint32_t config_hash;
+
+    uint8_t channel;
+    bool was_root;
+
+    // As a node, the parent's mesh AP and the layer below it
+    uint8_t parent_bssid[6];
+    uint8_t parent_ssid[32];
+    uint8_t parent_ssid_length;
+    uint8_t layer;
+
+    // As root, the router it was connected to
+    uint8_t router_bssid[6];
+};
+
+struct mesh_boot_stats_t {
+    // Boots that got a message out, and how many of them had a topology
+    // to start from
+    uint32_t boots;
+    uint32_t warm_boots;
+
+    // Directed rejoins tried on a cached parent, and how many of them
+    // timed out into a full scan
+    uint32_t fast_rejoins;
+    uint32_t fast_rejoins_failed;
+
+    // Time from boot to the first publish, in ms, newest first.
+    // Bit n of warm_mask is set if entry n was a warm boot.
+    uint32_t first_publish_ms[MESH_BOOT_HISTORY];
+    uint8_t warm_mask;
+
+    // Not persisted. Time from the last lost connection to the next
+    // publish, in ms, 0 if there was none yet.
+    uint32_t last_reconnect_ms;
+};
+
+// Keeps the last known topology and the boot timings in NVS.
+//
+// The topology is written only when it changes, which is once per new
+// parent or router, so that a stable mesh does not wear the flash.
+class MeshTopologyCache {
+private:
+    const char *const nvs_namespace;
+
+    std::mutex lock;
+
+    mesh_topology_t stored;
+    mesh_boot_stats_t boot_stats;
+
+    bool read(const char *key, void *data, size_t length);
+    void write(const char *key, const void *data, size_t length);
+
+public:
+    MeshTopologyCache(const char *nvs_namespace = "mesh");
+
+    // Expects NVS to be initialised. Returns false if there is no
+    // topology, or only one learned with a different configuration.
+    bool load(uint32_t config_hash, mesh_topology_t &topology);
+    void store(const mesh_topology_t &topology);
+    // After a directed rejoin failed, so the next boot scans right away
+    void forget_parent();
+
+    void record_fast_rejoin(bool succeeded);
+    void record_first_publish(uint32_t ms, bool warm);
+    void record_reconnect(uint32_t ms);
+
+    mesh_boot_stats_t get_boot_stats();
+
+    // FNV-1a over all parts, to tell configurations apart without
+    // storing passwords
+    static uint32_t config_hash(std::initializer_list<std::string_view> parts);
+};
+
+} // namespace Communication
+} // namespace Xasin
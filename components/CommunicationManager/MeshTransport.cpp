@@ -0,0 +1,82 @@
+// MeshTransport.cpp
+#include "MeshTransport.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace Xasin {
+namespace Communication {
+
+void MeshTransport::set_handler(uint8_t magic, receive_callback_t callback) {
+    for (auto &handler : handlers) {
+        if (handler.magic == magic) {
+            handler.callback = std::move(callback);
+            return;
+        }
+    }
+
+    handlers.push_back({ magic, std::move(callback) });
+}
+
+void MeshTransport::deliver(const uint8_t *from, const uint8_t *data, size_t length) {
+    if (length == 0) {
+        return;
+    }
+
+    for (auto &handler : handlers) {
+        if (handler.magic == data[0]) {
+            handler.callback(from, data, length);
+            return;
+        }
+    }
+}
+
+LoopbackMeshTransport::LoopbackMeshTransport(const uint8_t mac[6], LoopbackMeshTransport *root)
+    : root(root), nodes(), connected(true), frames_sent(0), bytes_sent(0) {
+    memcpy(this->mac, mac, sizeof(this->mac));
+
+    if (root != nullptr) {
+        root->nodes.push_back(this);
+    }
+}
+
+LoopbackMeshTransport::~LoopbackMeshTransport() {
+    if (root != nullptr) {
+        auto &siblings = root->nodes;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+    }
+}
+
+bool LoopbackMeshTransport::send_to_root(const uint8_t *data, size_t length) {
+    if (root == nullptr || !connected) {
+        return false;
+    }
+
+    frames_sent++;
+    bytes_sent += length;
+
+    root->deliver(mac, data, length);
+    return true;
+}
+
+bool LoopbackMeshTransport::send_to(const uint8_t *mac, const uint8_t *data, size_t length) {
+    for (auto node : nodes) {
+        if (memcmp(node->mac, mac, sizeof(node->mac)) != 0) {
+            continue;
+        }
+        if (!node->connected) {
+            return false;
+        }
+
+        frames_sent++;
+        bytes_sent += length;
+
+        node->deliver(this->mac, data, length);
+        return true;
+    }
+
+    return false;
+}
+
+} // namespace Communication
+} // namespace Xasin
@@ -0,0 +1,69 @@
+// MeshTransport.h
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Xasin {
+namespace Communication {
+
+// Carries binary frames between mesh nodes and the root, see MeshBridge.h
+// and MeshClock.h. Frames of different users are told apart by their
+// first byte, i.e. MESH_FRAME_MAGIC.
+class MeshTransport {
+public:
+    // Called with the station MAC of the sending node and the frame,
+    // which is only valid for the duration of the call.
+    using receive_callback_t = std::function<void (const uint8_t *from, const uint8_t *data, size_t length)>;
+
+private:
+    struct handler_t {
+        uint8_t magic;
+        receive_callback_t callback;
+    };
+    std::vector<handler_t> handlers;
+
+protected:
+    // Hands a received frame to the handler for its first byte
+    void deliver(const uint8_t *from, const uint8_t *data, size_t length);
+
+public:
+    virtual ~MeshTransport() = default;
+
+    // Replaces any handler for the same magic byte. Only to be called
+    // during setup, before frames arrive.
+    void set_handler(uint8_t magic, receive_callback_t callback);
+
+    // Returns false if the frame could not be handed on, i.e. without a root.
+    virtual bool send_to_root(const uint8_t *data, size_t length) = 0;
+    // Sends to one node, from the root
+    virtual bool send_to(const uint8_t *mac, const uint8_t *data, size_t length) = 0;
+};
+
+// Transport that hands frames straight to another instance, without any
+// radio. Lets the framing and the bridge run on the host, with any number
+// of nodes pointing to one root.
+class LoopbackMeshTransport : public MeshTransport {
+private:
+    uint8_t mac[6];
+    LoopbackMeshTransport *root;
+    std::vector<LoopbackMeshTransport *> nodes;
+
+public:
+    // Drops all frames while false, like a node without a parent
+    bool connected;
+
+    uint32_t frames_sent;
+    uint32_t bytes_sent;
+
+    LoopbackMeshTransport(const uint8_t mac[6], LoopbackMeshTransport *root = nullptr);
+    ~LoopbackMeshTransport();
+
+    bool send_to_root(const uint8_t *data, size_t length) override;
+    bool send_to(const uint8_t *mac, const uint8_t *data, size_t length) override;
+};
+
+} // namespace Communication
+} // namespace Xasin
@@ -0,0 +1,229 @@
+// OutboundQueue.cpp
+#include "OutboundQueue.h"
+
+#include "esp_log.h"
+
+#include <string.h>
+#include <algorithm>
+
+static const char *OUTBOX_TAG = "OutboundQueue";
+
+#define OUTBOX_EVENT_TTL_US (int64_t(CONFIG_COMM_OUTBOX_EVENT_TTL) * 1000)
+
+namespace Xasin {
+namespace Communication {
+
+OutboundQueue::OutboundQueue(clock_func_t clock)
+    : clock(clock), slots(), head(0), tail(0), depth(0), stats() {
+    lock = xSemaphoreCreateMutex();
+    drain_lock = xSemaphoreCreateMutex();
+}
+
+OutboundQueue::~OutboundQueue() {
+    vSemaphoreDelete(drain_lock);
+    vSemaphoreDelete(lock);
+}
+
+void OutboundQueue::drop_head() {
+    if (slots[head].used) {
+        slots[head].used = false;
+        depth--;
+    }
+    head = (head + 1) % slots.size();
+}
+
+// Retained messages never expire, so expired events may sit behind
+// them. Those are taken out, and everything after moved up.
+void OutboundQueue::drop_expired(int64_t now) {
+    size_t count = depth;
+    size_t to = head;
+
+    for (size_t i = 0, from = head; i < count; i++, from = (from + 1) % slots.size()) {
+        slot_t &slot = slots[from];
+
+        if (!slot.retain && (now - slot.queued_at) >= OUTBOX_EVENT_TTL_US) {
+            ESP_LOGD(OUTBOX_TAG, "Queued event for '%s' expired", slot.topic);
+            stats.dropped_expired++;
+            slot.used = false;
+            depth--;
+            continue;
+        }
+
+        if (to != from) {
+            slots[to] = slot;
+            slot.used = false;
+        }
+        to = (to + 1) % slots.size();
+    }
+
+    tail = to;
+    if (depth == 0) {
+        head = tail;
+    }
+}
+
+bool OutboundQueue::push(const char *topic, const void *data, size_t length, bool retain, int qos) {
+    if (length > CONFIG_COMM_OUTBOX_PAYLOAD_LENGTH || strlen(topic) >= CONFIG_COMM_OUTBOX_TOPIC_LENGTH) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        stats.dropped_oversize++;
+        xSemaphoreGive(lock);
+
+        ESP_LOGW(OUTBOX_TAG, "Message for '%s' too large to queue (%u bytes)", topic, length);
+        return false;
+    }
+
+    int64_t now = clock();
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+
+    drop_expired(now);
+
+    slot_t *slot = nullptr;
+
+    if (retain) {
+        for (auto &s : slots) {
+            if (s.used && s.retain && strcmp(s.topic, topic) == 0) {
+                slot = &s;
+                stats.coalesced++;
+                break;
+            }
+        }
+    }
+
+    if (slot == nullptr) {
+        if (depth > 0 && tail == head) {
+            // State is worth more than old events, so retained messages
+            // are moved to the back. As the ring is full, that only takes
+            // moving head and tail along by one.
+            for (size_t i = 0; i < depth && slots[head].retain; i++) {
+                head = (head + 1) % slots.size();
+                tail = head;
+            }
+
+            ESP_LOGD(OUTBOX_TAG, "Queue full, dropping message for '%s'", slots[head].topic);
+
+            stats.dropped_full++;
+            drop_head();
+        }
+
+        slot = &slots[tail];
+        tail = (tail + 1) % slots.size();
+
+        strcpy(slot->topic, topic);
+        slot->used = true;
+        depth++;
+    }
+
+    slot->retain = retain;
+    slot->qos = qos;
+    slot->length = length;
+    slot->queued_at = now;
+    memcpy(slot->payload, data, length);
+
+    stats.queued++;
+    stats.max_depth = std::max<uint16_t>(stats.max_depth, depth);
+
+    xSemaphoreGive(lock);
+
+    return true;
+}
+
+size_t OutboundQueue::drain(const publish_func_t &publish) {
+    size_t sent = 0;
+
+    // A message pushed while the last drain was on its way out would
+    // otherwise wait for the next one, so the queue is checked again
+    // once the drain lock is released.
+    do {
+        // Never waits, as drain() may be called from the MQTT client's
+        // task, which a running drain may be waiting on to publish.
+        if (xSemaphoreTake(drain_lock, 0) != pdTRUE) {
+            break;
+        }
+
+        bool emptied = drain_once(publish, sent);
+        xSemaphoreGive(drain_lock);
+
+        if (!emptied) {
+            break;
+        }
+    } while (!empty());
+
+    if (sent > 0) {
+        ESP_LOGI(OUTBOX_TAG, "Sent %u queued messages", sent);
+    }
+
+    return sent;
+}
+
+// Expects drain_lock to be held. Returns false if publish refused a message.
+bool OutboundQueue::drain_once(const publish_func_t &publish, size_t &sent) {
+    slot_t out;
+
+    while (true) {
+        int64_t now = clock();
+
+        // Slots are copied out one by one, so that nothing has to wait
+        // on the lock while the message is being sent.
+        xSemaphoreTake(lock, portMAX_DELAY);
+        drop_expired(now);
+
+        if (depth == 0) {
+            xSemaphoreGive(lock);
+            return true;
+        }
+
+        out = slots[head];
+        xSemaphoreGive(lock);
+
+        if (!publish(out.topic, out.payload, out.length, out.retain, out.qos)) {
+            return false;
+        }
+
+        xSemaphoreTake(lock, portMAX_DELAY);
+        // A newer value may have been coalesced into the slot while it
+        // was being sent, in which case it stays queued. The message may
+        // also have expired or been pushed out in the meantime.
+        slot_t &slot = slots[head];
+        if (depth > 0 && slot.used && slot.queued_at == out.queued_at && strcmp(slot.topic, out.topic) == 0) {
+            drop_head();
+        }
+
+        stats.sent++;
+        stats.max_age_ms = std::max<uint32_t>(stats.max_age_ms, (now - out.queued_at) / 1000);
+        xSemaphoreGive(lock);
+
+        sent++;
+    }
+}
+
+bool OutboundQueue::empty() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool is_empty = depth == 0;
+    xSemaphoreGive(lock);
+
+    return is_empty;
+}
+
+outbound_queue_stats_t OutboundQueue::get_stats() {
+    int64_t now = clock();
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+
+    outbound_queue_stats_t out = stats;
+    out.depth = depth;
+
+    out.oldest_age_ms = 0;
+    for (auto &s : slots) {
+        if (s.used) {
+            out.oldest_age_ms = std::max<uint32_t>(out.oldest_age_ms, (now - s.queued_at) / 1000);
+        }
+    }
+
+    xSemaphoreGive(lock);
+
+    return out;
+}
+
+} // namespace Communication
+} // namespace Xasin
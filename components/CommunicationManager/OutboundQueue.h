@@ -0,0 +1,106 @@
+// OutboundQueue.h
+#pragma once
+
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_timer.h"
+
+#include <array>
+#include <functional>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Xasin {
+namespace Communication {
+
+struct outbound_queue_stats_t {
+    uint16_t depth;
+    uint16_t max_depth;
+
+    uint32_t queued;
+    // Retained messages that replaced an older queued value of their topic
+    uint32_t coalesced;
+    uint32_t sent;
+
+    // Oldest queued messages pushed out by new ones while full
+    uint32_t dropped_full;
+    uint32_t dropped_expired;
+    // Messages with a topic or payload too long for a slot
+    uint32_t dropped_oversize;
+
+    uint32_t oldest_age_ms;
+    // Longest any message waited before it was sent
+    uint32_t max_age_ms;
+};
+
+// Holds outgoing messages while the connection is down, to be sent
+// once it is back up.
+//
+// Messages are kept in a ring buffer of fixed size slots, so that the
+// queue never allocates. Retained messages carry state, so only the
+// latest value of a retained topic is kept, in the place of the first.
+// All other messages are events, which are kept in order, but expire
+// after CONFIG_COMM_OUTBOX_EVENT_TTL.
+// When full, the oldest event is dropped for the new message.
+//
+// Only one drain() runs at a time. Others return right away, and what
+// they would have sent goes out with the running one.
+class OutboundQueue {
+public:
+    using publish_func_t = std::function<bool (const char *topic, const void *data, size_t length, bool retain, int qos)>;
+    // Local monotonic time in µs, i.e. esp_timer_get_time
+    using clock_func_t = std::function<int64_t ()>;
+
+private:
+    struct slot_t {
+        bool used;
+        bool retain;
+        uint8_t qos;
+        uint16_t length;
+        int64_t queued_at;
+        char topic[CONFIG_COMM_OUTBOX_TOPIC_LENGTH];
+        uint8_t payload[CONFIG_COMM_OUTBOX_PAYLOAD_LENGTH];
+    };
+
+    const clock_func_t clock;
+
+    SemaphoreHandle_t lock;
+    // Held while draining, so that no message is sent twice
+    SemaphoreHandle_t drain_lock;
+
+    std::array<slot_t, CONFIG_COMM_OUTBOX_SLOTS> slots;
+    // Messages are removed at the head, or taken out of the middle with
+    // the rest moved up, and coalesced in place. So all slots from head
+    // to tail are in use.
+    size_t head;
+    size_t tail;
+    size_t depth;
+
+    outbound_queue_stats_t stats;
+
+    void drop_head();
+    void drop_expired(int64_t now);
+    bool drain_once(const publish_func_t &publish, size_t &sent);
+
+public:
+    OutboundQueue(clock_func_t clock = esp_timer_get_time);
+    ~OutboundQueue();
+
+    // Returns false if the message was too large to be queued.
+    bool push(const char *topic, const void *data, size_t length, bool retain, int qos);
+
+    // Sends all queued messages in order through publish, stopping at
+    // the first one it refuses, which then stays queued.
+    // Returns the number of messages sent, 0 if another drain is running.
+    size_t drain(const publish_func_t &publish);
+
+    bool empty();
+
+    outbound_queue_stats_t get_stats();
+};
+
+} // namespace Communication
+} // namespace Xasin
@@ -24,13 +24,16 @@ esp_err_t mqtt_handle_caller(esp_mqtt_event_t *event) {
 }
 
 Handler::Handler()
-	: subscriptions(),
+	: subscriptions(), matches(),
 	  mqtt_handle(nullptr),
 	  mqtt_started(false), mqtt_connected(false),
-	  status_topic("status"), status_msg("OK") {
+	  status_topic("status"), status_msg("OK"),
+	  on_connected(nullptr) {
 
 	config_lock = xSemaphoreCreateMutex();
 
+	matches.reserve(8);
+
 	base_topic.reserve(64);
 
 	base_topic 	= "/esp32/";
@@ -105,6 +108,14 @@ void Handler::start(const std::string uri) {
 }
 
 
+void Handler::reconnect() {
+	if(!mqtt_started || mqtt_connected)
+		return;
+
+	ESP_LOGI(mqtt_tag, "Reconnecting");
+	esp_mqtt_client_reconnect(mqtt_handle);
+}
+
 void Handler::mqtt_handler(esp_mqtt_event_t *event) {
 	xSemaphoreTake(config_lock, portMAX_DELAY);
 
@@ -113,12 +124,16 @@ void Handler::mqtt_handler(esp_mqtt_event_t *event) {
 		mqtt_connected = true;
 
 		if(!event->session_present) {
-			for(auto s : subscriptions)
-				s->raw_subscribe();
+			subscriptions.for_each_filter([this](const std::string &filter, int qos) {
+				raw_subscribe(filter, qos);
+			});
 		}
 		if(status_topic != "")
 			this->publish_to(status_topic, status_msg.data(), status_msg.length(), true);
 		ESP_LOGI(mqtt_tag, "Reconnected and subscribed");
+
+		if(on_connected)
+			on_connected();
 	break;
 
 	case MQTT_EVENT_DISCONNECTED:
@@ -127,14 +142,19 @@ void Handler::mqtt_handler(esp_mqtt_event_t *event) {
 	break;
 
 	case MQTT_EVENT_DATA: {
-		const std::string dataString = std::string(event->data, event->data_len);
-		const std::string topicString = std::string(event->topic, event->topic_len);
+		// Subscribers get views straight into the client's buffer,
+		// which stays valid until this handler returns.
+		const std::string_view topic_view(event->topic, event->topic_len);
+		const MQTT_Packet packet = { topic_view, std::string_view(event->data, event->data_len), topic_view };
 
-		ESP_LOGD(mqtt_tag, "Data for topic %s:", topicString.data());
-		ESP_LOG_BUFFER_HEXDUMP(mqtt_tag, dataString.data(), dataString.length(), ESP_LOG_VERBOSE);
+		ESP_LOGD(mqtt_tag, "Data for topic %.*s:", event->topic_len, event->topic);
+		ESP_LOG_BUFFER_HEXDUMP(mqtt_tag, event->data, event->data_len, ESP_LOG_VERBOSE);
 
-		for(auto s : subscriptions)
-			s->feed_data({topicString, dataString});
+		matches.clear();
+		subscriptions.match(topic_view, matches);
+
+		for(auto &m : matches)
+			m.subscription->feed_data(packet, m.topic_rest);
 	}
 	break;
 
@@ -144,6 +164,16 @@ void Handler::mqtt_handler(esp_mqtt_event_t *event) {
 	xSemaphoreGive(config_lock);
 }
 
+void Handler::raw_subscribe(const std::string &filter, int qos) {
+	ESP_LOGI(mqtt_tag, "Subscribing to %s", filter.data());
+	esp_mqtt_client_subscribe(mqtt_handle, filter.data(), qos);
+}
+
+void Handler::raw_unsubscribe(const std::string &filter) {
+	ESP_LOGI(mqtt_tag, "Unsubscribing from %s", filter.data());
+	esp_mqtt_client_unsubscribe(mqtt_handle, filter.data());
+}
+
 void Handler::set_status(const std::string &newStatus) {
 	if(status_topic == "")
 		return;
@@ -153,10 +183,10 @@ void Handler::set_status(const std::string &newStatus) {
 		this->publish_to(status_topic, status_msg.data(), status_msg.length(), true);
 }
 
-void Handler::publish_to(std::string topic, const void *data, size_t length, bool retain, int qos) {
+bool Handler::publish_to(std::string topic, const void *data, size_t length, bool retain, int qos) {
 	if(!mqtt_connected) {
 		ESP_LOGD(mqtt_tag, "Packet to %s dropped (disconnected)", topic.data());
-		return;
+		return false;
 	}
 
 	topicsize_string(topic);
@@ -164,8 +194,8 @@ void Handler::publish_to(std::string topic, const void *data, size_t length, boo
 	ESP_LOGD(mqtt_tag, "Publishing to %s", topic.data());
 	ESP_LOG_BUFFER_HEXDUMP(mqtt_tag, data, length, ESP_LOG_VERBOSE);
 	
-	esp_mqtt_client_publish(mqtt_handle, topic.data(), reinterpret_cast<const char*>(data)
-				, length, qos, retain);
+	return esp_mqtt_client_publish(mqtt_handle, topic.data(), reinterpret_cast<const char*>(data)
+				, length, qos, retain) >= 0;
 }
 
 void Handler::publish_int(const std::string &topic, int32_t data, bool retain, int qos) {
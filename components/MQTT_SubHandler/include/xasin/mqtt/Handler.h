@@ -15,8 +15,11 @@
 
 #include <freertos/semphr.h>
 
+#include "TopicTrie.h"
+
 #include <vector>
 #include <string>
+#include <string_view>
 #include <functional>
 
 #include <stdint.h>
@@ -37,10 +40,12 @@ extern const char *mqtt_tag;
 
 typedef esp_mqtt_client_config_t mqtt_cfg;
 
+// Views into the MQTT client's receive buffer, only valid for
+// the duration of the callback. Copy whatever needs to be kept.
 struct MQTT_Packet {
-	const std::string &topic; // This will hold the topic suffix/rest after matching
-	const std::string &data;
-	std::string full_topic; // This will hold the original full topic string from the broker
+	std::string_view topic; // Topic suffix/rest after matching
+	std::string_view data;
+	std::string_view full_topic; // Full topic string from the broker
 };
 typedef std::function<void (const MQTT_Packet)> mqtt_callback;
 
@@ -51,7 +56,9 @@ protected:
 	friend Subscription;
 
 	SemaphoreHandle_t config_lock;
-	std::vector<Subscription *> subscriptions;
+	TopicTrie subscriptions;
+	// Reused for every message, so that matching does not allocate.
+	std::vector<topic_match_t> matches;
 
 	esp_mqtt_client_handle_t mqtt_handle;
 
@@ -64,7 +71,13 @@ protected:
 
 	std::string base_topic;
 
+	void raw_subscribe(const std::string &filter, int qos);
+	void raw_unsubscribe(const std::string &filter);
+
 public:
+	// Called from the MQTT task on every (re)connect, after all
+	// subscriptions were restored.
+	std::function<void ()> on_connected;
 
 	Handler();
 	Handler(const std::string & base_topic);
@@ -73,12 +86,16 @@ public:
 
 	void start(const mqtt_cfg &config);
 	void start(const std::string URI);
+	// Skips the client's reconnect backoff, i.e. once the network is back.
+	// The client and its subscriptions are kept as they are.
+	void reconnect();
 
 	void mqtt_handler(esp_mqtt_event_t *event);
 
 	void set_status(const std::string &newStatus);
 
-	void publish_to(std::string topic, void const *data, size_t length, bool retain = false, int qos = 0);
+	// Returns false if the message was dropped as the broker is not connected.
+	bool publish_to(std::string topic, void const *data, size_t length, bool retain = false, int qos = 0);
 	void publish_int(const std::string &topic, int32_t data, bool retain = false, int qos = 0);
 
 	Subscription * subscribe_to(std::string topic, mqtt_callback callback, int qos = 1);
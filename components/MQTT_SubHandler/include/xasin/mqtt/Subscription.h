@@ -22,8 +22,7 @@ public:
 protected:
 	friend Handler;
 
-	void raw_subscribe();
-	void feed_data(MQTT_Packet data);
+	void feed_data(const MQTT_Packet &data, std::string_view topic_rest);
 
 public:
 	const std::string topic;
@@ -0,0 +1,269 @@
+/*
+ * TopicTrie.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_MQTT_SUBHANDLER_TOPICTRIE_H_
+#define ESP32_MQTT_SUBHANDLER_TOPICTRIE_H_
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+
+namespace Xasin {
+namespace MQTT {
+
+template<class S>
+struct basic_topic_match_t {
+	S *subscription;
+	// Part of the topic starting at the first wildcard level of the
+	// filter, empty for exact matches.
+	std::string_view topic_rest;
+};
+
+// Index of all subscriptions by their filter, split into topic levels.
+// A message topic is matched against every filter in a single walk down
+// the trie, following the exact level as well as any '+' and '#' nodes.
+//
+// Subscriptions with identical filters share one node, which counts them,
+// so that the broker only ever sees one subscription per filter.
+//
+// S can be any subscription type with a std::string topic and an int qos.
+template<class S>
+class BasicTopicTrie {
+private:
+	struct node_t {
+		// std::less<> allows looking up levels by string_view.
+		std::map<std::string, std::unique_ptr<node_t>, std::less<>> children;
+
+		std::vector<S *> subscriptions;
+		std::string filter;
+		int qos;
+	};
+
+	node_t root;
+	size_t filter_count;
+
+	void match_node(const node_t &node, std::string_view topic, size_t level_start, size_t rest_start,
+		std::vector<basic_topic_match_t<S>> &out) const;
+
+	void for_each_node(const node_t &node, const std::function<void (const std::string &filter, int qos)> &cb) const;
+
+public:
+	BasicTopicTrie();
+
+	// Both return true if the broker subscription for this filter
+	// needs to change: insert when the filter is new or needs a higher
+	// QoS, remove when the last subscription of a filter is gone or the
+	// remaining ones need a lower QoS. remove sets new_qos to the QoS
+	// the broker subscription should now have, or -1 to drop it.
+	bool insert(S *sub);
+	bool remove(S *sub, int *new_qos = nullptr);
+
+	// Appends all subscriptions matching the topic to out.
+	// The topic_rest views point into the given topic.
+	void match(std::string_view topic, std::vector<basic_topic_match_t<S>> &out) const;
+
+	// Calls cb once for every distinct filter, with the highest
+	// QoS any of its subscriptions asked for.
+	void for_each_filter(const std::function<void (const std::string &filter, int qos)> &cb) const;
+
+	size_t size() const;
+};
+
+template<class S>
+BasicTopicTrie<S>::BasicTopicTrie() : root(), filter_count(0) {
+	root.qos = 0;
+}
+
+template<class S>
+bool BasicTopicTrie<S>::insert(S *sub) {
+	node_t *node = &root;
+
+	std::string_view filter = sub->topic;
+	size_t start = 0;
+	while(true) {
+		size_t end = filter.find('/', start);
+		std::string_view level = filter.substr(start, end - start);
+
+		auto child = node->children.find(level);
+		if(child == node->children.end()) {
+			auto new_node = std::make_unique<node_t>();
+			new_node->qos = 0;
+
+			child = node->children.emplace(std::string(level), std::move(new_node)).first;
+		}
+		node = child->second.get();
+
+		if(end == std::string_view::npos)
+			break;
+		start = end + 1;
+	}
+
+	node->subscriptions.push_back(sub);
+
+	if(node->subscriptions.size() == 1) {
+		node->filter = sub->topic;
+		node->qos = sub->qos;
+		filter_count++;
+
+		return true;
+	}
+
+	if(sub->qos > node->qos) {
+		node->qos = sub->qos;
+		return true;
+	}
+
+	return false;
+}
+
+template<class S>
+bool BasicTopicTrie<S>::remove(S *sub, int *new_qos) {
+	// Remember the path, so that nodes left empty can be pruned afterwards.
+	std::vector<node_t *> path;
+	path.reserve(8);
+	path.push_back(&root);
+
+	std::string_view filter = sub->topic;
+	size_t start = 0;
+	while(true) {
+		size_t end = filter.find('/', start);
+
+		auto child = path.back()->children.find(filter.substr(start, end - start));
+		if(child == path.back()->children.end())
+			return false;
+		path.push_back(child->second.get());
+
+		if(end == std::string_view::npos)
+			break;
+		start = end + 1;
+	}
+
+	auto &subs = path.back()->subscriptions;
+	auto it = std::find(subs.begin(), subs.end(), sub);
+	if(it == subs.end())
+		return false;
+	subs.erase(it);
+
+	if(!subs.empty()) {
+		int qos = 0;
+		for(auto s : subs)
+			qos = std::max(qos, s->qos);
+
+		if(qos == path.back()->qos)
+			return false;
+
+		path.back()->qos = qos;
+		if(new_qos != nullptr)
+			*new_qos = qos;
+		return true;
+	}
+
+	if(new_qos != nullptr)
+		*new_qos = -1;
+
+	path.back()->filter.clear();
+	path.back()->qos = 0;
+	filter_count--;
+
+	for(size_t i = path.size() - 1; i > 0; i--) {
+		node_t *node = path[i];
+		if(!node->subscriptions.empty() || !node->children.empty())
+			break;
+
+		auto &siblings = path[i-1]->children;
+		for(auto c = siblings.begin(); c != siblings.end(); c++) {
+			if(c->second.get() == node) {
+				siblings.erase(c);
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+template<class S>
+void BasicTopicTrie<S>::match_node(const node_t &node, std::string_view topic, size_t level_start, size_t rest_start,
+	std::vector<basic_topic_match_t<S>> &out) const {
+
+	// All levels of the topic were consumed
+	if(level_start == std::string_view::npos) {
+		std::string_view rest = (rest_start == std::string_view::npos) ? std::string_view() : topic.substr(rest_start);
+		for(auto s : node.subscriptions)
+			out.push_back({s, rest});
+
+		// "a/b/#" also matches "a/b" itself
+		auto multi = node.children.find("#");
+		if(multi != node.children.end()) {
+			for(auto s : multi->second->subscriptions)
+				out.push_back({s, rest});
+		}
+
+		return;
+	}
+
+	size_t level_end = topic.find('/', level_start);
+	size_t next_start = (level_end == std::string_view::npos) ? std::string_view::npos : level_end + 1;
+
+	auto exact = node.children.find(topic.substr(level_start, level_end - level_start));
+	if(exact != node.children.end())
+		match_node(*exact->second, topic, next_start, rest_start, out);
+
+	// Wildcards at the first level must not match system topics such as "$SYS"
+	if(level_start == 0 && !topic.empty() && topic[0] == '$')
+		return;
+
+	size_t wildcard_rest = (rest_start == std::string_view::npos) ? level_start : rest_start;
+
+	auto single = node.children.find("+");
+	if(single != node.children.end())
+		match_node(*single->second, topic, next_start, wildcard_rest, out);
+
+	auto multi = node.children.find("#");
+	if(multi != node.children.end()) {
+		std::string_view rest = topic.substr(wildcard_rest);
+		for(auto s : multi->second->subscriptions)
+			out.push_back({s, rest});
+	}
+}
+
+template<class S>
+void BasicTopicTrie<S>::match(std::string_view topic, std::vector<basic_topic_match_t<S>> &out) const {
+	match_node(root, topic, 0, std::string_view::npos, out);
+}
+
+template<class S>
+void BasicTopicTrie<S>::for_each_node(const node_t &node, const std::function<void (const std::string &filter, int qos)> &cb) const {
+	if(!node.subscriptions.empty())
+		cb(node.filter, node.qos);
+
+	for(auto &c : node.children)
+		for_each_node(*c.second, cb);
+}
+
+template<class S>
+void BasicTopicTrie<S>::for_each_filter(const std::function<void (const std::string &filter, int qos)> &cb) const {
+	for_each_node(root, cb);
+}
+
+template<class S>
+size_t BasicTopicTrie<S>::size() const {
+	return filter_count;
+}
+
+class Subscription;
+
+using TopicTrie = BasicTopicTrie<Subscription>;
+using topic_match_t = basic_topic_match_t<Subscription>;
+
+} /* namespace MQTT */
+} /* namespace Xasin */
+
+#endif /* ESP32_MQTT_SUBHANDLER_TOPICTRIE_H_ */
@@ -0,0 +1,188 @@
+/*
+ * BurstCombiner.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "xasin/xirr/BurstCombiner.h"
+
+#include <string.h>
+
+namespace Xasin {
+namespace XIRR {
+
+namespace {
+
+bool same_frame(const decoded_frame_t &a, const decoded_frame_t &b) {
+	return a.channel == b.channel && a.length == b.length
+		&& memcmp(a.data, b.data, a.length) == 0;
+}
+
+// The check as copy 0 would have carried it. The CRC is affine, so the
+// difference the copy index in the header makes does not depend on the
+// rest of the frame, and can be taken out on its own.
+uint8_t first_copy_check(const decoded_frame_t &frame) {
+	uint8_t zeros[XIRR_V2_MAX_PAYLOAD + 2] = {};
+
+	zeros[0] = frame.length;
+	uint8_t first = crc8(zeros, frame.length + 2);
+	zeros[0] = frame.length | (frame.copy << 4);
+
+	return frame.check ^ first ^ crc8(zeros, frame.length + 2);
+}
+
+}
+
+BurstCombiner::BurstCombiner()
+	: transmissions(), stats() {
+}
+
+BurstCombiner::transmission_t *BurstCombiner::find(int64_t now_us, int64_t start_us,
+		decode_result_t result, const decoded_frame_t &frame) {
+	int64_t tolerance = v2_copy_us(frame.length, frame.fec) / 2;
+
+	for(auto &transmission : transmissions) {
+		if(transmission.end_us <= now_us
+				|| transmission.length != frame.length || transmission.fec != frame.fec)
+			continue;
+		if(start_us < transmission.start_us - tolerance || start_us > transmission.start_us + tolerance)
+			continue;
+
+		// Another shooter's frame, which happened to line up in time
+		if(result == DECODE_OK && transmission.delivered && !same_frame(transmission.frame, frame))
+			continue;
+
+		return &transmission;
+	}
+
+	return nullptr;
+}
+
+// Takes a free slot, or else the one that would be freed first
+BurstCombiner::transmission_t &BurstCombiner::open(int64_t start_us, const decoded_frame_t &frame) {
+	transmission_t *oldest = &transmissions[0];
+	for(auto &transmission : transmissions) {
+		if(transmission.end_us < oldest->end_us)
+			oldest = &transmission;
+	}
+
+	uint32_t copy_us = v2_copy_us(frame.length, frame.fec);
+
+	oldest->start_us = start_us;
+	oldest->end_us = start_us + int64_t(XIRR_V2_MAX_COPIES) * copy_us + copy_us / 2;
+	oldest->length = frame.length;
+	oldest->fec = frame.fec;
+	oldest->delivered = false;
+	oldest->candidate_count = 0;
+
+	return *oldest;
+}
+
+// Votes bitwise over the channel, payload and check of all damaged copies.
+// They all have the same length, or they would not be lined up here.
+bool BurstCombiner::vote(const transmission_t &transmission, decoded_frame_t &out) {
+	uint8_t count = transmission.candidate_count;
+	if(count < 3)
+		return false;
+
+	uint8_t length = transmission.length;
+
+	// Header of copy 0, channel, payload and CRC, as the CRC is worked
+	// out over them
+	uint8_t buffer[XIRR_V2_MAX_PAYLOAD + 3];
+	buffer[0] = length;
+
+	for(uint8_t byte = 1; byte < length + 3; byte++) {
+		uint8_t voted = 0;
+
+		for(uint8_t bit = 0; bit < 8; bit++) {
+			uint8_t ones = 0;
+			for(uint8_t i = 0; i < count; i++) {
+				const decoded_frame_t &candidate = transmission.candidates[i];
+
+				uint8_t value;
+				if(byte == 1)
+					value = candidate.channel;
+				else if(byte == length + 2)
+					value = first_copy_check(candidate);
+				else
+					value = candidate.data[byte - 2];
+
+				ones += (value >> bit) & 1;
+			}
+
+			if(2*ones > count)
+				voted |= 1 << bit;
+		}
+
+		buffer[byte] = voted;
+	}
+
+	if(crc8(buffer, length + 2) != buffer[length + 2])
+		return false;
+
+	out = {};
+	out.channel = buffer[1];
+	out.length = length;
+	memcpy(out.data, buffer + 2, length);
+	out.version = 2;
+	out.fec = transmission.fec;
+	out.check = buffer[length + 2];
+
+	return true;
+}
+
+bool BurstCombiner::feed(int64_t now_us, decode_result_t result, const decoded_frame_t &frame, decoded_frame_t &out) {
+	bool damaged_v2 = result == DECODE_BAD_CHECKSUM && frame.version == 2;
+	if(result != DECODE_OK && !damaged_v2)
+		return false;
+
+	if(frame.version != 2) {
+		out = frame;
+		stats.frames_delivered++;
+		return true;
+	}
+
+	int64_t start_us = now_us - int64_t(frame.copy) * v2_copy_us(frame.length, frame.fec);
+
+	transmission_t *transmission = find(now_us, start_us, result, frame);
+	if(transmission == nullptr)
+		transmission = &open(start_us, frame);
+
+	if(result == DECODE_OK) {
+		if(transmission->delivered) {
+			stats.repeats_suppressed++;
+			return false;
+		}
+
+		transmission->delivered = true;
+		transmission->frame = frame;
+		transmission->candidate_count = 0;
+
+		out = frame;
+		stats.frames_delivered++;
+		if(frame.corrected_bits > 0)
+			stats.frames_corrected++;
+		return true;
+	}
+
+	if(transmission->delivered)
+		return false;
+
+	if(transmission->candidate_count < XIRR_V2_MAX_COPIES)
+		transmission->candidates[transmission->candidate_count++] = frame;
+
+	if(!vote(*transmission, out))
+		return false;
+
+	transmission->delivered = true;
+	transmission->frame = out;
+	transmission->candidate_count = 0;
+
+	stats.frames_delivered++;
+	stats.frames_voted++;
+	return true;
+}
+
+} /* namespace XIRR */
+} /* namespace Xasin */
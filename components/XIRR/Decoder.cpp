@@ -0,0 +1,277 @@
+/*
+ * Decoder.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "xasin/xirr/Decoder.h"
+
+#include <algorithm>
+#include <array>
+#include <string.h>
+
+namespace Xasin {
+namespace XIRR {
+
+namespace {
+
+// Runs are looked up in steps of this many ticks, up to this length.
+// Longer ones only appear with long stretches of set bits, and are
+// worked out by division instead.
+#define RUN_STEP_SHIFT 4
+#define RUN_TABLE_SIZE 256
+
+#define RUN_OFF_GRID 0xFF
+
+constexpr uint8_t classify_run(uint32_t ticks) {
+	uint32_t bits = (ticks + XIRR_TICKS_PER_BIT/2) / XIRR_TICKS_PER_BIT;
+	int32_t error = int32_t(ticks) - int32_t(bits * XIRR_TICKS_PER_BIT);
+
+	if(bits == 0 || error > XIRR_TIMING_TOLERANCE || error < -XIRR_TIMING_TOLERANCE)
+		return RUN_OFF_GRID;
+	return bits;
+}
+
+// Bits in a run, by its length in steps, measured from the middle of each
+// step. RUN_OFF_GRID where it is no whole number of bits.
+constexpr std::array<uint8_t, RUN_TABLE_SIZE> make_run_table() {
+	std::array<uint8_t, RUN_TABLE_SIZE> table = {};
+
+	for(uint32_t i = 0; i < RUN_TABLE_SIZE; i++)
+		table[i] = classify_run((i << RUN_STEP_SHIFT) + (1 << (RUN_STEP_SHIFT - 1)));
+
+	return table;
+}
+
+constexpr std::array<uint8_t, RUN_TABLE_SIZE> run_table = make_run_table();
+
+static_assert(run_table[(XIRR_TICKS_PER_BIT * XIRR_START_BITS) >> RUN_STEP_SHIFT] == XIRR_START_BITS,
+		"Start marker must be on the bit grid");
+
+inline uint32_t run_bits(uint32_t ticks) {
+	if((ticks >> RUN_STEP_SHIFT) < RUN_TABLE_SIZE)
+		return run_table[ticks >> RUN_STEP_SHIFT];
+
+	return classify_run(ticks);
+}
+
+// Steps through the bits of a burst. Past its end, the line is idle,
+// which reads as cleared bits, as the RMT does not record the final space.
+class BitReader {
+private:
+	const rmt_item32_t *item;
+	const rmt_item32_t *const end;
+	const int32_t stretch;
+	const bool lenient;
+	bool second_half;
+
+	uint32_t bits_left;
+	bool level;
+
+public:
+	bool off_grid;
+
+	BitReader(const rmt_item32_t *items, size_t count, int32_t stretch, bool lenient)
+		: item(items), end(items + count), stretch(stretch), lenient(lenient), second_half(false),
+		  bits_left(0), level(false), off_grid(false) {
+	}
+
+	bool next() {
+		while(bits_left == 0) {
+			if(item == end)
+				return false;
+
+			int32_t ticks = second_half ? item->duration1 : item->duration0;
+			// The receiver pulls low on carrier
+			level = !(second_half ? item->level1 : item->level0);
+
+			if(second_half)
+				item++;
+			second_half = !second_half;
+
+			// Zero length marks the end of the capture
+			if(ticks == 0) {
+				item = end;
+				return false;
+			}
+
+			ticks += level ? -stretch : stretch;
+			bits_left = (ticks > 0) ? run_bits(ticks) : RUN_OFF_GRID;
+			if(bits_left == RUN_OFF_GRID && lenient)
+				bits_left = std::max<int32_t>(1, (ticks + XIRR_TICKS_PER_BIT/2) / XIRR_TICKS_PER_BIT);
+			if(bits_left == RUN_OFF_GRID) {
+				off_grid = true;
+				item = end;
+				bits_left = 0;
+				return false;
+			}
+		}
+
+		bits_left--;
+		return level;
+	}
+
+	// Reads up to the end of the capture, true if any carrier was left
+	bool carrier_left() {
+		while(bits_left > 0 || item != end) {
+			if(next())
+				return true;
+		}
+
+		return false;
+	}
+
+	uint8_t next_byte(uint8_t count = 8) {
+		uint8_t out = 0;
+		for(uint8_t i = 0; i < count; i++)
+			out |= next() << i;
+
+		return out;
+	}
+};
+
+// Start marker lengths, by protocol version and FEC
+struct start_marker_t {
+	uint8_t bits;
+	uint8_t version;
+	bool fec;
+};
+
+constexpr start_marker_t start_markers[] = {
+	{ XIRR_START_BITS, 1, false },
+	{ XIRR_V2_START_BITS, 2, false },
+	{ XIRR_V2_FEC_START_BITS, 2, true },
+};
+
+decode_result_t decode_v1(BitReader &reader, decoded_frame_t &frame) {
+	uint8_t buffer[XIRR_MAX_FRAME];
+	uint8_t length = 0;
+	uint8_t checksum = 0;
+
+	while(true) {
+		if(length == sizeof(buffer))
+			return DECODE_TOO_LONG;
+
+		uint8_t byte = reader.next_byte();
+		buffer[length++] = byte;
+
+		if(!reader.next())
+			break;
+		checksum += byte;
+	}
+
+	if(reader.off_grid)
+		return DECODE_BAD_TIMING;
+	if(length < 2)
+		return DECODE_TOO_SHORT;
+	if(buffer[length - 1] != checksum)
+		return DECODE_BAD_CHECKSUM;
+
+	frame.channel = buffer[0];
+	frame.length = length - 2;
+	memcpy(frame.data, buffer + 1, frame.length);
+	frame.version = 1;
+	frame.corrected_bits = 0;
+	frame.check = buffer[length - 1];
+
+	return DECODE_OK;
+}
+
+uint8_t read_v2_byte(BitReader &reader, bool fec, uint8_t &corrected_bits) {
+	if(!fec)
+		return reader.next_byte();
+
+	bool low_corrected, high_corrected;
+	uint8_t low = hamming_decode(reader.next_byte(7), low_corrected);
+	uint8_t high = hamming_decode(reader.next_byte(7), high_corrected);
+	corrected_bits += low_corrected + high_corrected;
+
+	return low | (high << 4);
+}
+
+decode_result_t decode_v2(BitReader &reader, bool fec, decoded_frame_t &frame) {
+	// Header, channel, payload and CRC
+	uint8_t buffer[XIRR_V2_MAX_PAYLOAD + 3];
+	uint8_t corrected_bits = 0;
+
+	buffer[0] = read_v2_byte(reader, fec, corrected_bits);
+	if(reader.off_grid)
+		return DECODE_BAD_TIMING;
+	if((buffer[0] & 0xC0) != 0)
+		return DECODE_BAD_HEADER;
+
+	uint8_t length = buffer[0] & 0x0F;
+	for(uint8_t i = 1; i < length + 3; i++)
+		buffer[i] = read_v2_byte(reader, fec, corrected_bits);
+
+	if(reader.off_grid)
+		return DECODE_BAD_TIMING;
+	// The header rejects few lengths, so a capture running on past the
+	// frame is what gives away overlapping frames and noise
+	if(reader.carrier_left() || reader.off_grid)
+		return DECODE_TOO_LONG;
+
+	frame.channel = buffer[1];
+	frame.length = length;
+	memcpy(frame.data, buffer + 2, length);
+	frame.version = 2;
+	frame.fec = fec;
+	frame.copy = (buffer[0] >> 4) & 3;
+	frame.corrected_bits = corrected_bits;
+	frame.check = buffer[length + 2];
+
+	if(crc8(buffer, length + 2) != frame.check)
+		return DECODE_BAD_CHECKSUM;
+
+	return DECODE_OK;
+}
+
+}
+
+decode_result_t decode(const rmt_item32_t *items, size_t count, decoded_frame_t &frame) {
+	if(items == nullptr || count < 2)
+		return DECODE_TOO_SHORT;
+
+	// Almost all noise is rejected right here, without reading any further
+	if(items[0].level0 != 0)
+		return DECODE_NO_START;
+
+	const start_marker_t *marker = nullptr;
+	int32_t stretch = 0;
+	for(auto &candidate : start_markers) {
+		stretch = int32_t(items[0].duration0) - candidate.bits * XIRR_TICKS_PER_BIT;
+		if(stretch <= XIRR_MAX_STRETCH && stretch >= -XIRR_MAX_STRETCH) {
+			marker = &candidate;
+			break;
+		}
+	}
+	if(marker == nullptr)
+		return DECODE_NO_START;
+
+	BitReader reader(items, count, stretch, marker->fec);
+	for(uint8_t i = 0; i < marker->bits; i++)
+		reader.next();
+	if(reader.next())
+		return DECODE_NO_START;
+
+	if(marker->version == 1)
+		return decode_v1(reader, frame);
+
+	return decode_v2(reader, marker->fec, frame);
+}
+
+const char *decode_result_name(decode_result_t result) {
+	switch(result) {
+	case DECODE_OK:				return "ok";
+	case DECODE_TOO_SHORT:		return "too short";
+	case DECODE_NO_START:		return "no start";
+	case DECODE_BAD_TIMING:		return "bad timing";
+	case DECODE_TOO_LONG:		return "too long";
+	case DECODE_BAD_HEADER:		return "bad header";
+	case DECODE_BAD_CHECKSUM:	return "bad checksum";
+	default:					return "unknown";
+	}
+}
+
+} /* namespace XIRR */
+} /* namespace Xasin */
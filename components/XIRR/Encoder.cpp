@@ -0,0 +1,168 @@
+/*
+ * Encoder.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "xasin/xirr/Encoder.h"
+
+#include <algorithm>
+
+namespace Xasin {
+namespace XIRR {
+
+namespace {
+
+// Writes a frame as runs of equal bits, one per item half. Each run is a
+// single edge on air, where one item per bit would end every bit with an
+// edge.
+class FrameWriter {
+private:
+	tx_frame_t &frame;
+	size_t halves;
+
+	bool carrier;
+	uint32_t bits;
+	bool gap;
+
+	bool failed;
+
+	void flush() {
+		uint32_t ticks = bits * XIRR_TICKS_PER_BIT;
+		bits = 0;
+
+		while(ticks > 0) {
+			if(halves == 2*XIRR_TX_MAX_ITEMS) {
+				failed = true;
+				return;
+			}
+
+			uint32_t part = std::min<uint32_t>(ticks, 0x7FFF);
+			ticks -= part;
+
+			rmt_item32_t &item = frame.items[halves / 2];
+			if(halves % 2 == 0) {
+				item.duration0 = part;
+				item.level0 = carrier;
+			} else {
+				item.duration1 = part;
+				item.level1 = carrier;
+			}
+			halves++;
+		}
+	}
+
+public:
+	FrameWriter(tx_frame_t &frame) : frame(frame), halves(0), carrier(true), bits(0), gap(false), failed(false) {
+	}
+
+	void add_bits(bool level, uint32_t count) {
+		if(level != carrier) {
+			if(bits >= XIRR_IDLE_BITS && !gap)
+				failed = true;
+
+			flush();
+			carrier = level;
+			gap = false;
+		}
+		bits += count;
+	}
+
+	void add_byte(uint8_t data, uint8_t count = 8) {
+		for(uint8_t i=0; i<count; i++) {
+			add_bits(data & 1, 1);
+			data >>= 1;
+		}
+	}
+
+	// The gap is the only run allowed to be this long
+	void add_gap() {
+		if(!carrier && bits >= XIRR_IDLE_BITS)
+			failed = true;
+
+		add_bits(false, XIRR_GAP_BITS);
+		gap = true;
+	}
+
+	bool finish() {
+		flush();
+
+		// A zero length half ends the frame
+		if(halves % 2 == 1) {
+			frame.items[halves / 2].duration1 = 0;
+			frame.items[halves / 2].level1 = 0;
+		}
+		frame.item_count = (halves + 1) / 2;
+
+		return !failed;
+	}
+};
+
+}
+
+bool encode(tx_frame_t &frame, const void *data, size_t length, uint8_t channel) {
+	if(length + 2 > XIRR_MAX_FRAME)
+		return false;
+
+	FrameWriter writer(frame);
+
+	writer.add_bits(true, XIRR_START_BITS);
+	writer.add_bits(false, 1);
+
+	uint8_t add_checksum = channel;
+	writer.add_byte(channel);
+	writer.add_bits(true, 1);
+
+	for(size_t i = 0; i<length; i++) {
+		uint8_t formatData = *(reinterpret_cast<const uint8_t*>(data)+i);
+		add_checksum += formatData;
+
+		writer.add_byte(formatData);
+		writer.add_bits(true, 1);
+	}
+	writer.add_byte(add_checksum);
+	writer.add_bits(false, 1);
+
+	writer.add_gap();
+
+	return writer.finish();
+}
+
+bool encode_v2(tx_frame_t &frame, const void *data, size_t length, uint8_t channel,
+		bool fec, uint8_t repeats) {
+	if(length > XIRR_V2_MAX_PAYLOAD || repeats == 0 || repeats > XIRR_V2_MAX_COPIES)
+		return false;
+
+	uint8_t buffer[XIRR_V2_MAX_PAYLOAD + 3];
+	buffer[1] = channel;
+	for(size_t i = 0; i<length; i++)
+		buffer[2 + i] = reinterpret_cast<const uint8_t*>(data)[i];
+
+	FrameWriter writer(frame);
+
+	for(uint8_t i = 0; i<repeats; i++) {
+		// Each copy carries its index, so the receiver knows when the
+		// transmission started
+		buffer[0] = length | (i << 4);
+		buffer[length + 2] = crc8(buffer, length + 2);
+
+		writer.add_bits(true, fec ? XIRR_V2_FEC_START_BITS : XIRR_V2_START_BITS);
+		writer.add_bits(false, 1);
+
+		for(size_t j = 0; j<length + 3; j++) {
+			if(fec) {
+				writer.add_byte(hamming_encode(buffer[j]), 7);
+				writer.add_byte(hamming_encode(buffer[j] >> 4), 7);
+			}
+			else
+				writer.add_byte(buffer[j]);
+		}
+
+		writer.add_gap();
+	}
+
+	return writer.finish();
+}
+
+} /* namespace XIRR */
+} /* namespace Xasin */
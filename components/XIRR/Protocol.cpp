@@ -0,0 +1,120 @@
+/*
+ * Protocol.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "xasin/xirr/Protocol.h"
+
+#include <array>
+
+namespace Xasin {
+namespace XIRR {
+
+namespace {
+
+#define CRC8_POLYNOMIAL 0x2F
+
+constexpr std::array<uint8_t, 256> make_crc_table() {
+	std::array<uint8_t, 256> table = {};
+
+	for(uint32_t i = 0; i < 256; i++) {
+		uint8_t crc = i;
+		for(uint8_t j = 0; j < 8; j++)
+			crc = (crc & 0x80) ? uint8_t(crc << 1) ^ CRC8_POLYNOMIAL : uint8_t(crc << 1);
+		table[i] = crc;
+	}
+
+	return table;
+}
+
+constexpr std::array<uint8_t, 256> crc_table = make_crc_table();
+
+// Codeword bits, LSB first, are p1 p2 d1 p3 d2 d3 d4. Each parity bit
+// covers the positions that have its own position's bit set.
+constexpr uint8_t make_codeword(uint8_t nibble) {
+	uint8_t d1 = nibble & 1;
+	uint8_t d2 = (nibble >> 1) & 1;
+	uint8_t d3 = (nibble >> 2) & 1;
+	uint8_t d4 = (nibble >> 3) & 1;
+
+	uint8_t p1 = d1 ^ d2 ^ d4;
+	uint8_t p2 = d1 ^ d3 ^ d4;
+	uint8_t p3 = d2 ^ d3 ^ d4;
+
+	return p1 | (p2 << 1) | (d1 << 2) | (p3 << 3) | (d2 << 4) | (d3 << 5) | (d4 << 6);
+}
+
+// Codewords go on air with p3 inverted. However they follow each other,
+// that keeps runs of equal bits to seven, where 0x00 or 0xFF would
+// otherwise be sent as fourteen.
+#define HAMMING_AIR_MASK 0x08
+
+constexpr std::array<uint8_t, 16> make_encode_table() {
+	std::array<uint8_t, 16> table = {};
+
+	for(uint8_t i = 0; i < 16; i++)
+		table[i] = make_codeword(i) ^ HAMMING_AIR_MASK;
+
+	return table;
+}
+
+// Nibble for every received word, with bit 4 set where a bit was flipped
+constexpr std::array<uint8_t, 128> make_decode_table() {
+	std::array<uint8_t, 128> table = {};
+
+	for(uint8_t received = 0; received < 128; received++) {
+		uint8_t word = received ^ HAMMING_AIR_MASK;
+
+		uint8_t syndrome = 0;
+		for(uint8_t position = 1; position <= 7; position++) {
+			if(word & (1 << (position - 1)))
+				syndrome ^= position;
+		}
+
+		uint8_t fixed = syndrome ? (word ^ (1 << (syndrome - 1))) : word;
+		uint8_t nibble = ((fixed >> 2) & 1) | (((fixed >> 4) & 1) << 1)
+				| (((fixed >> 5) & 1) << 2) | (((fixed >> 6) & 1) << 3);
+
+		table[received] = nibble | (syndrome ? 0x10 : 0);
+	}
+
+	return table;
+}
+
+constexpr std::array<uint8_t, 16> encode_table = make_encode_table();
+constexpr std::array<uint8_t, 128> decode_table = make_decode_table();
+
+static_assert(decode_table[encode_table[0xB]] == 0xB, "Hamming tables must round trip");
+
+}
+
+uint32_t v2_copy_us(uint8_t length, bool fec) {
+	uint32_t bits = (fec ? XIRR_V2_FEC_START_BITS : XIRR_V2_START_BITS) + 1
+		+ (length + 3) * (fec ? 14 : 8) + XIRR_GAP_BITS;
+
+	return bits * XIRR_BIT_US;
+}
+
+uint8_t crc8(const uint8_t *data, size_t length) {
+	uint8_t crc = 0xFF;
+
+	for(size_t i = 0; i < length; i++)
+		crc = crc_table[crc ^ data[i]];
+
+	return crc ^ 0xFF;
+}
+
+uint8_t hamming_encode(uint8_t nibble) {
+	return encode_table[nibble & 0x0F];
+}
+
+uint8_t hamming_decode(uint8_t codeword, bool &corrected) {
+	uint8_t entry = decode_table[codeword & 0x7F];
+
+	corrected = entry & 0x10;
+	return entry & 0x0F;
+}
+
+} /* namespace XIRR */
+} /* namespace Xasin */
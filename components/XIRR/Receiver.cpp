@@ -9,8 +9,7 @@
 
 #define LOG_LOCAL_LEVEL ESP_LOG_INFO
 #include "esp_log.h"
-
-#define TPB ((80000000/200)/2000)
+#include "esp_timer.h"
 
 namespace Xasin {
 namespace XIRR {
@@ -22,7 +21,7 @@ void ir_rx_task(void *args) {
 Receiver::Receiver(gpio_num_t pin, rmt_channel_t channel) :
 	rxPin(pin), rmtChannel(channel),
 	rxTaskHandle(nullptr),
-	currentItem(nullptr), itemOffset(0), numItems(0) {
+	combiner() {
 }
 
 Receiver::~Receiver() {
@@ -40,7 +39,7 @@ void Receiver::init() {
 
 	rx_cfg.filter_en = true;
 	rx_cfg.filter_ticks_thresh = 200;
-	rx_cfg.idle_threshold = TPB*9;
+	rx_cfg.idle_threshold = XIRR_TICKS_PER_BIT*XIRR_IDLE_BITS;
 
 	cfg.rx_config = rx_cfg;
 
@@ -57,73 +56,19 @@ void Receiver::init() {
 	xTaskCreate(ir_rx_task, "XIRR:RX", 4096, this, 5, &rxTaskHandle);
 }
 
-bool Receiver::get_next_bit() {
-	if(numItems == 0)
-		return false;
-
-	bool out = false;
-
-	if(itemOffset < currentItem->duration0)
-		out = !currentItem->level0;
-	else
-		out = !currentItem->level1;
+void Receiver::parse_item(const rmt_item32_t *head, size_t len) {
+	decoded_frame_t frame;
+	decode_result_t result = decode(head, len, frame);
 
-	auto tDur = currentItem->duration0 + currentItem->duration1;
-
-	if(itemOffset < currentItem->duration0
-			&& (itemOffset + TPB) > currentItem->duration0) {
-		itemOffset = currentItem->duration0 + 0.5*TPB;
-	}
-	else if((itemOffset + TPB) > tDur) {
-		itemOffset = 0.5*TPB;
-		currentItem++;
-		numItems--;
-	}
-	else
-		itemOffset += TPB;
+	ESP_LOGV("XIRR", "%u items, %s", unsigned(len), decode_result_name(result));
 
-	ESP_LOGV("XIRR", "Bit: %s", out ? "1" : "0");
-	return out;
+	decoded_frame_t out;
+	if(combiner.feed(esp_timer_get_time(), result, frame, out) && on_rx != nullptr)
+		on_rx(out.data, out.length, out.channel);
 }
 
-void Receiver::parse_item(rmt_item32_t *head, size_t len) {
-	if(head == nullptr)
-		return;
-	if(len < 2)
-		return;
-
-	currentItem = head;
-	itemOffset  = TPB*0.5;
-	numItems   = len;
-
-	for(uint8_t i=0; i<8; i++) {
-		if(get_next_bit() != (i != 7))
-			return;
-	}
-
-	ESP_LOGV("XIRR", "Start OK");
-
-	uint8_t chksum = 0;
-	std::vector<uint8_t> dataBuffer;
-
-	while(true) {
-		uint8_t byteBuf = 0;
-
-		for(uint8_t i=0; i<8; i++)
-			byteBuf |= get_next_bit() << i;
-
-		dataBuffer.push_back(byteBuf);
-		if(!get_next_bit()) {
-			break;
-		}
-
-		chksum += byteBuf;
-	}
-
-	ESP_LOG_BUFFER_HEX_LEVEL("XIRR", dataBuffer.data(), dataBuffer.size(), ESP_LOG_VERBOSE);
-
-	if(dataBuffer[dataBuffer.size()-1] == chksum && on_rx != nullptr)
-		on_rx(dataBuffer.data()+1, dataBuffer.size()-2, dataBuffer[0]);
+burst_stats_t Receiver::get_burst_stats() {
+	return combiner.stats;
 }
 
 void Receiver::_rx_task() {
@@ -135,15 +80,14 @@ void Receiver::_rx_task() {
 	ESP_LOGI("XIRR", "RX Task started!");
 
 	while(true) {
-		size_t dNum = 0;
-		rmt_item32_t *headItem = reinterpret_cast<rmt_item32_t*>(xRingbufferReceive(rx_buffer, &dNum, portMAX_DELAY));
-
-		ESP_LOGV("XIRR", "Data received, %d items", dNum);
+		size_t dSize = 0;
+		rmt_item32_t *headItem = reinterpret_cast<rmt_item32_t*>(xRingbufferReceive(rx_buffer, &dSize, portMAX_DELAY));
 
 		if(headItem == nullptr)
 			continue;
 
-		parse_item(headItem, dNum);
+		// The ring buffer hands out bytes, not items
+		parse_item(headItem, dSize / sizeof(rmt_item32_t));
 
 		vRingbufferReturnItem(rx_buffer, headItem);
 	}
@@ -7,16 +7,48 @@
 
 #include "xasin/xirr/Transmitter.h"
 
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include <algorithm>
+#include <string.h>
+
 namespace Xasin {
 namespace XIRR {
 
+namespace {
+
+// The RMT has a single TX end callback for all channels
+Transmitter *channel_transmitters[RMT_CHANNEL_MAX] = {};
+
+void IRAM_ATTR tx_end_callback(rmt_channel_t channel, void *args) {
+	if(unsigned(channel) >= RMT_CHANNEL_MAX)
+		return;
+
+	if(channel_transmitters[channel] != nullptr)
+		channel_transmitters[channel]->_tx_done();
+}
+
+void ir_tx_task(void *args) {
+	reinterpret_cast<Transmitter*>(args)->_tx_task();
+}
+
+}
+
 Transmitter::Transmitter(gpio_num_t pin, rmt_channel_t channel) :
-		txPin(pin), rmtChannel(channel), rmt_buffer() {
+		txPin(pin), rmtChannel(channel),
+		txTaskHandle(nullptr),
+		freeSlots(nullptr), pendingSlots(nullptr), slots(),
+		statsLock(xSemaphoreCreateMutex()), stats() {
 
 	esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, NULL, &powerLock);
 }
 
 Transmitter::~Transmitter() {
+	if(txTaskHandle != nullptr)
+		vTaskDelete(txTaskHandle);
+	channel_transmitters[rmtChannel] = nullptr;
+
 	esp_pm_lock_delete(powerLock);
 
 	rmt_driver_uninstall(rmtChannel);
@@ -48,57 +80,112 @@ void Transmitter::init() {
 
 	rmt_config(&cfg);
 	rmt_driver_install(rmtChannel, 0, 0);
-}
 
-void Transmitter::add_byte(uint8_t data, uint8_t cont) {
-	rmt_item32_t low = {};
-	low.duration0 = (80000000/200)/2000 - 1;
-	low.level0    = 0;
-	low.duration1 = 1;
-	low.level1	  = 0;
+	freeSlots = xQueueCreate(XIRR_TX_QUEUE_LENGTH, sizeof(uint8_t));
+	pendingSlots = xQueueCreate(XIRR_TX_QUEUE_LENGTH, sizeof(uint8_t));
+	for(uint8_t i=0; i<XIRR_TX_QUEUE_LENGTH; i++)
+		xQueueSend(freeSlots, &i, 0);
 
-	rmt_item32_t high = low;
-	high.level0 = 1;
+	// Above the weapon thread, so that a queued shot goes on air right away
+	xTaskCreate(ir_tx_task, "XIRR:TX", 2048, this, 6, &txTaskHandle);
 
-	for(uint8_t i=0; i<8; i++) {
-		rmt_buffer.emplace_back((data & 1) ? high : low);
-		data >>= 1;
-	}
+	channel_transmitters[rmtChannel] = this;
+	rmt_register_tx_end_callback(tx_end_callback, nullptr);
+}
+
+bool Transmitter::take_slot(uint8_t &index) {
+	if(freeSlots != nullptr && xQueueReceive(freeSlots, &index, 0) == pdTRUE)
+		return true;
+
+	xSemaphoreTake(statsLock, portMAX_DELAY);
+	stats.frames_dropped++;
+	xSemaphoreGive(statsLock);
 
-	if(cont == 1)
-		rmt_buffer.emplace_back(high);
-	else if(cont == 2)
-		rmt_buffer.emplace_back(low);
+	return false;
 }
 
-void Transmitter::send(const void *data, size_t length, uint8_t channel) {
+void Transmitter::queue_slot(uint8_t index) {
+	slots[index].queued_us = esp_timer_get_time();
+	xQueueSend(pendingSlots, &index, 0);
+}
 
-	rmt_item32_t start = {};
-	start.duration0 = (80000000/200)/2000 * 7;
-	start.level0    = 1;
-	start.duration1 = (80000000/200)/2000;
-	start.level1    = 0;
+bool Transmitter::send(const tx_frame_t &frame) {
+	uint8_t index;
+	if(!take_slot(index))
+		return false;
 
-	rmt_buffer.emplace_back(start);
+	tx_frame_t &slot_frame = slots[index].frame;
+	slot_frame.item_count = frame.item_count;
+	memcpy(slot_frame.items, frame.items, frame.item_count * sizeof(rmt_item32_t));
 
-	uint8_t add_checksum = 0;
-	add_byte(channel, 1);
-	add_checksum += channel;
+	queue_slot(index);
+	return true;
+}
 
-	for(size_t i = 0; i<length; i++) {
-		uint8_t formatData = *(reinterpret_cast<const uint8_t*>(data)+i);
-		add_checksum += formatData;
+bool Transmitter::send(const void *data, size_t length, uint8_t channel) {
+	uint8_t index;
+	if(!take_slot(index))
+		return false;
 
-		add_byte(formatData, 1);
+	if(!encode(slots[index].frame, data, length, channel)) {
+		xQueueSend(freeSlots, &index, 0);
+		return false;
 	}
-	add_byte(add_checksum, 2);
 
+	queue_slot(index);
+	return true;
+}
 
-	esp_pm_lock_acquire(powerLock);
-	rmt_write_items(rmtChannel, rmt_buffer.data(), rmt_buffer.size(), true);
-	esp_pm_lock_release(powerLock);
+tx_stats_t Transmitter::get_stats() {
+	xSemaphoreTake(statsLock, portMAX_DELAY);
+	tx_stats_t out = stats;
+	xSemaphoreGive(statsLock);
 
-	rmt_buffer.clear();
+	return out;
+}
+
+void IRAM_ATTR Transmitter::_tx_done() {
+	BaseType_t woken = pdFALSE;
+	vTaskNotifyGiveFromISR(txTaskHandle, &woken);
+
+	if(woken)
+		portYIELD_FROM_ISR();
+}
+
+void Transmitter::_tx_task() {
+	while(true) {
+		uint8_t index;
+		if(xQueueReceive(pendingSlots, &index, portMAX_DELAY) != pdTRUE)
+			continue;
+
+		tx_slot_t &slot = slots[index];
+
+		esp_pm_lock_acquire(powerLock);
+		ulTaskNotifyTake(pdTRUE, 0);
+
+		uint32_t latency = esp_timer_get_time() - slot.queued_us;
+		rmt_write_items(rmtChannel, slot.frame.items, slot.frame.item_count, false);
+
+		xSemaphoreTake(statsLock, portMAX_DELAY);
+		stats.frames_sent++;
+		stats.last_latency_us = latency;
+		stats.max_latency_us = std::max(stats.max_latency_us, latency);
+		if(stats.frames_sent == 1)
+			stats.average_latency_us = latency;
+		else
+			stats.average_latency_us = (stats.average_latency_us * 7 + latency) / 8;
+		xSemaphoreGive(statsLock);
+
+		// Even the longest frame is on air for well under this. The slot may
+		// only be handed back once the RMT is done reading it.
+		if(ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(250)) == 0) {
+			ESP_LOGW("XIRR", "TX end callback missed");
+			rmt_wait_tx_done(rmtChannel, portMAX_DELAY);
+		}
+
+		esp_pm_lock_release(powerLock);
+		xQueueSend(freeSlots, &index, 0);
+	}
 }
 
 } /* namespace XIRR */
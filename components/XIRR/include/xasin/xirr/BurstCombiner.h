@@ -0,0 +1,75 @@
+/*
+ * BurstCombiner.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_XIRR_BURSTCOMBINER_H_
+#define ESP32_XIRR_BURSTCOMBINER_H_
+
+#include "xasin/xirr/Decoder.h"
+
+// Transmissions followed at once, i.e. shooters firing at the same time
+#define XIRR_BURST_SLOTS 4
+
+namespace Xasin {
+namespace XIRR {
+
+struct burst_stats_t {
+	uint32_t frames_delivered;
+	// Copies of a frame that was already delivered
+	uint32_t repeats_suppressed;
+	// Frames no copy of which passed its CRC, but a vote over them did
+	uint32_t frames_voted;
+	// Frames the Hamming code had to fix
+	uint32_t frames_corrected;
+};
+
+// Turns the copies of a repeated version 2 frame into a single frame.
+// Each copy carries its index, which together with the time it arrived
+// tells when its transmission started. Copies are only ever combined with
+// others of the same transmission, so that shooters firing at the same
+// time, or one shooter firing the same shot again, each get theirs through.
+//
+// The first copy that passes its CRC is delivered right away, and later
+// copies of the same transmission are dropped. If copies keep failing, a
+// bitwise majority vote over three or more of them is tried.
+//
+// Version 1 frames are not repeated, and passed straight through.
+// Only used from the receiver task, so not locked.
+class BurstCombiner {
+private:
+	struct transmission_t {
+		// When copy 0 started, as estimated from each copy
+		int64_t start_us;
+		// No more copies arrive after this, and the slot is free again
+		int64_t end_us;
+		uint8_t length;
+		bool fec;
+
+		bool delivered;
+		decoded_frame_t frame;
+
+		uint8_t candidate_count;
+		decoded_frame_t candidates[XIRR_V2_MAX_COPIES];
+	};
+
+	transmission_t transmissions[XIRR_BURST_SLOTS];
+
+	transmission_t *find(int64_t now_us, int64_t start_us, decode_result_t result, const decoded_frame_t &frame);
+	transmission_t &open(int64_t start_us, const decoded_frame_t &frame);
+	bool vote(const transmission_t &transmission, decoded_frame_t &out);
+
+public:
+	burst_stats_t stats;
+
+	BurstCombiner();
+
+	// Feeds one decoded capture. True if out holds a frame to pass on.
+	bool feed(int64_t now_us, decode_result_t result, const decoded_frame_t &frame, decoded_frame_t &out);
+};
+
+} /* namespace XIRR */
+} /* namespace Xasin */
+
+#endif /* ESP32_XIRR_BURSTCOMBINER_H_ */
@@ -0,0 +1,73 @@
+/*
+ * Decoder.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_XIRR_DECODER_H_
+#define ESP32_XIRR_DECODER_H_
+
+#include "driver/rmt.h"
+
+#include "xasin/xirr/Protocol.h"
+
+// Receivers stretch marks and shorten spaces by a few carrier cycles.
+// The start marker tells by how much, within this many ticks either way.
+#define XIRR_MAX_STRETCH (XIRR_TICKS_PER_BIT / 2 - 1)
+// How far a run may be off a whole number of bits once the stretch is
+// taken out, in ticks
+#define XIRR_TIMING_TOLERANCE (XIRR_TICKS_PER_BIT * 3 / 8)
+
+namespace Xasin {
+namespace XIRR {
+
+enum decode_result_t {
+	DECODE_OK,
+	// Fewer items than any frame has
+	DECODE_TOO_SHORT,
+	// Not starting with the start marker, i.e. other remotes or noise
+	DECODE_NO_START,
+	// A run off the bit grid, i.e. noise or two overlapping frames
+	DECODE_BAD_TIMING,
+	DECODE_TOO_LONG,
+	// Version 2 header with reserved bits set
+	DECODE_BAD_HEADER,
+	DECODE_BAD_CHECKSUM,
+	DECODE_RESULT_COUNT
+};
+
+struct decoded_frame_t {
+	uint8_t channel;
+	uint8_t length;
+	uint8_t data[XIRR_MAX_FRAME - 2];
+
+	uint8_t version;
+	// Version 2 only: sent with the Hamming code, and which copy of its
+	// transmission this is
+	bool fec;
+	uint8_t copy;
+	// Bits the Hamming code fixed, version 2 only
+	uint8_t corrected_bits;
+	// Checksum or CRC as received
+	uint8_t check;
+};
+
+// Decodes one burst as the RMT captured it from the receiver, whose output
+// is low while it sees carrier. Both protocol versions are taken, see
+// Protocol.h, telling them apart by the start marker.
+//
+// The stretch is measured on the start marker and taken out of every run
+// after it. Runs on every burst, noise included, so it uses integer timing
+// only, does not allocate, and gives up on most noise after the first item.
+//
+// Version 2 frames that fail their CRC are still filled in, so that
+// repeated copies can be voted on. With FEC, runs off the bit grid are
+// rounded rather than rejected, and left to the Hamming code and CRC.
+decode_result_t decode(const rmt_item32_t *items, size_t count, decoded_frame_t &frame);
+
+const char *decode_result_name(decode_result_t result);
+
+} /* namespace XIRR */
+} /* namespace Xasin */
+
+#endif /* ESP32_XIRR_DECODER_H_ */
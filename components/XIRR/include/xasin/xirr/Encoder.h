@@ -0,0 +1,42 @@
+/*
+ * Encoder.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_XIRR_ENCODER_H_
+#define ESP32_XIRR_ENCODER_H_
+
+#include "driver/rmt.h"
+
+#include "xasin/xirr/Protocol.h"
+
+// RMT items a frame may take. Each item holds two runs of equal bits, so
+// this is enough for the largest version 1 frame, or a few repeats of a
+// short version 2 frame.
+#define XIRR_TX_MAX_ITEMS 150
+
+namespace Xasin {
+namespace XIRR {
+
+// A frame encoded for the RMT, so that it can be kept and sent again
+// without encoding it each time.
+struct tx_frame_t {
+	uint16_t item_count;
+	rmt_item32_t items[XIRR_TX_MAX_ITEMS];
+};
+
+// Encode as version 1, as beacons and older guns send it. False if the
+// frame is too long, or has a run the receiver would end the capture in.
+bool encode(tx_frame_t &frame, const void *data, size_t length, uint8_t channel);
+
+// Encode as version 2, sent repeats times in a row so that the receiver
+// can pick the best copy. Same failures as encode(), and at most
+// XIRR_V2_MAX_PAYLOAD bytes of payload and XIRR_V2_MAX_COPIES repeats.
+bool encode_v2(tx_frame_t &frame, const void *data, size_t length, uint8_t channel,
+		bool fec = false, uint8_t repeats = 1);
+
+} /* namespace XIRR */
+} /* namespace Xasin */
+
+#endif /* ESP32_XIRR_ENCODER_H_ */
@@ -0,0 +1,58 @@
+/*
+ * Protocol.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_XIRR_PROTOCOL_H_
+#define ESP32_XIRR_PROTOCOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// RMT ticks per bit. Both sides run the RMT at 80MHz/200, with 2000 bits/s.
+#define XIRR_TICKS_PER_BIT ((80000000/200)/2000)
+#define XIRR_BIT_US (1000000/2000)
+
+// Frames start with a run of carrier, then one bit of silence. Its length
+// tells the protocol apart:
+// Version 1, the channel, payload and an additive checksum, each byte
+// followed by a bit that is set on all but the last. Beacons send this.
+#define XIRR_START_BITS 7
+// Version 2, a header byte, then the channel, the payload and a CRC-8, all
+// plain bytes. The header holds the payload length in bits 0-3, and which
+// copy of the transmission this is in bits 4-5. Bits 6-7 are zero.
+#define XIRR_V2_START_BITS 9
+// Version 2, with every byte sent as two Hamming(7,4) codewords
+#define XIRR_V2_FEC_START_BITS 11
+
+// Largest frame, channel and checksum included
+#define XIRR_MAX_FRAME 32
+#define XIRR_V2_MAX_PAYLOAD 15
+#define XIRR_V2_MAX_COPIES 4
+
+// The receiver ends a capture after this many bits without an edge, and
+// the transmitter leaves a longer gap after each frame. No frame may have
+// a run this long.
+#define XIRR_IDLE_BITS 14
+#define XIRR_GAP_BITS 16
+
+namespace Xasin {
+namespace XIRR {
+
+// CRC-8/AUTOSAR, polynomial 0x2F. Detects all errors of up to three bits
+// in frames this short.
+uint8_t crc8(const uint8_t *data, size_t length);
+
+// Time from the start of one copy of a version 2 frame to the next
+uint32_t v2_copy_us(uint8_t length, bool fec);
+
+// Hamming(7,4), the codeword as sent on air, LSB first
+uint8_t hamming_encode(uint8_t nibble);
+// Corrects a single flipped bit, and sets corrected if it did
+uint8_t hamming_decode(uint8_t codeword, bool &corrected);
+
+} /* namespace XIRR */
+} /* namespace Xasin */
+
+#endif /* ESP32_XIRR_PROTOCOL_H_ */
@@ -12,9 +12,9 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
-#include <functional>
+#include "xasin/xirr/BurstCombiner.h"
 
-#include <vector>
+#include <functional>
 
 namespace Xasin {
 namespace XIRR {
@@ -26,12 +26,9 @@ private:
 
 	TaskHandle_t rxTaskHandle;
 
+	BurstCombiner combiner;
 
-	rmt_item32_t *currentItem;
-	uint32_t itemOffset;
-	size_t numItems;
-	bool get_next_bit();
-	void parse_item(rmt_item32_t *item, size_t num);
+	void parse_item(const rmt_item32_t *item, size_t num);
 
 public:
 	Receiver(gpio_num_t pin, rmt_channel_t channel);
@@ -41,6 +38,9 @@ public:
 
 	std::function<void(const uint8_t *data, uint8_t len, uint8_t channel)> on_rx;
 
+	// Written by the RX task, so only roughly current
+	burst_stats_t get_burst_stats();
+
 	void _rx_task();
 };
 
@@ -9,26 +9,59 @@
 #define ESP32_XIRR_TRANSMITTER_H_
 
 #include "driver/rmt.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
 
 #include "esp_pm.h"
 #include "esp32/pm.h"
 
+#include "xasin/xirr/Encoder.h"
+
 #include <string>
-#include <vector>
+
+// Frames that may wait to be sent, the one on air included
+#define XIRR_TX_QUEUE_LENGTH 4
 
 namespace Xasin {
 namespace XIRR {
 
+struct tx_stats_t {
+	uint32_t frames_sent;
+	// Frames not sent because the queue was full
+	uint32_t frames_dropped;
+
+	// From send() to the RMT starting the frame
+	uint32_t last_latency_us;
+	uint32_t average_latency_us;
+	uint32_t max_latency_us;
+};
+
 class Transmitter {
 private:
+	struct tx_slot_t {
+		int64_t queued_us;
+		tx_frame_t frame;
+	};
+
 	const gpio_num_t txPin;
 	const rmt_channel_t rmtChannel;
 
 	esp_pm_lock_handle_t powerLock;
 
-	std::vector<rmt_item32_t> rmt_buffer;
+	TaskHandle_t txTaskHandle;
+	// Indices into slots. Senders take a free slot, fill it and queue it,
+	// the TX task hands it back once it is on air.
+	QueueHandle_t freeSlots;
+	QueueHandle_t pendingSlots;
+	tx_slot_t slots[XIRR_TX_QUEUE_LENGTH];
+
+	SemaphoreHandle_t statsLock;
+	tx_stats_t stats;
 
-	void add_byte(uint8_t data, uint8_t cont);
+	bool take_slot(uint8_t &index);
+	void queue_slot(uint8_t index);
 
 public:
 	Transmitter(gpio_num_t pin, rmt_channel_t channel);
@@ -36,12 +69,21 @@ public:
 
 	void init();
 
-	void send(const void *data, size_t length, uint8_t channel);
+	// Queues the frame and returns right away, the RMT sends it in the
+	// background. False if it was dropped.
+	bool send(const tx_frame_t &frame);
+	// Encodes as version 1, false if it cannot be encoded
+	bool send(const void *data, size_t length, uint8_t channel);
 
 	template <typename T>
-	void send(const T &data, uint8_t channel) {
-		send(&data, sizeof(T), channel);
+	bool send(const T &data, uint8_t channel) {
+		return send(&data, sizeof(T), channel);
 	};
+
+	tx_stats_t get_stats();
+
+	void _tx_task();
+	void _tx_done();
 };
 
 } /* namespace XIRR */
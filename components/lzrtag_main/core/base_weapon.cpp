@@ -29,6 +29,7 @@ void BaseWeapon::bump_shot_tick() {
 
 void BaseWeapon::reload_start() {}
 void BaseWeapon::reload_tick() {}
+void BaseWeapon::preload_sfx() {}
 
 void BaseWeapon::shot_process() {
 	xTaskNotifyWait(0, 0, nullptr, portMAX_DELAY);
@@ -36,6 +36,13 @@ void BeamWeapon::reload_tick()
 	wants_to_reload = false;
 }
 
+void BeamWeapon::preload_sfx() {
+	// The loop sounds are far too long to be cached, and are streamed.
+	Xasin::Audio::ByteCassette::preload(config.start_sounds);
+	Xasin::Audio::ByteCassette::preload(config.end_sounds);
+	Xasin::Audio::ByteCassette::preload(config.reload_sound);
+}
+
 void BeamWeapon::shot_process() {
 	if(handler.wait_for_trigger() != TRIGGER_PRESSED)
 		return;
@@ -4,12 +4,22 @@
 #include "esp_log.h"
 #include "lzrtag/weapon/handler.h"
 #include "EspMeshHandler.h"
+#include "lzrtag/wire_format.h"
+
+#include "esp_mac.h"
+#include "esp_timer.h"
 
 namespace LZRTag {
 namespace Weapon {
 
 static const char *LZR_WPN_HANDLER_TAG = "LZR:WPN:Handler"; // Renamed to avoid conflict with handler_tag
 
+#if CONFIG_LZR_IR_FEC
+static const bool IR_SHOT_FEC = true;
+#else
+static const bool IR_SHOT_FEC = false;
+#endif
+
 void handler_start_thread_func(void *args) {
 	reinterpret_cast<Handler *>(args)->_internal_run_thread();
 }
@@ -20,11 +30,15 @@ Handler::Handler (Xasin::Audio::TX & audio, Xasin::Communication::CommHandler* c
 	process_task(0), action_start_tick(0),
 	last_shot_tick(0), last_ir_arbitration_code_(1),
 	trigger_state(false), trigger_state_read(false),
+	trigger_edge_us(0),
+	trigger_stats_lock(xSemaphoreCreateMutex()), trigger_stats(),
 	gun_heat(0),
     ir_tx_(PIN_IR_OUT, RMT_CHANNEL_1), // Initialize IR transmitter
     ir_rx_(PIN_IR_IN, RMT_CHANNEL_2),   // Initialize IR receiver
     comm_handler_(comm_handler),        // Initialize CommHandler
     player_(player),                    // Initialize Player
+    shot_frames_(), shot_frames_id_(-1),
+    hit_filter_(CONFIG_LZR_IR_HIT_WINDOW),
 	on_shot_func(),
 	can_shoot_func()
 {
@@ -50,6 +64,8 @@ wait_failure_t Handler::wait_for_trigger(TickType_t max_ticks, bool repress_need
 
 		if(trigger_state) {
 			if(!repress_needed || !trigger_state_read) {
+				if(!trigger_state_read)
+					count_trigger_press();
 				trigger_state_read = true;
 				return TRIGGER_PRESSED;
 			}
@@ -142,9 +158,14 @@ void Handler::_internal_run_thread() {
 		// the target weapon's equip delay is used here.
 		// The swap CAN be interrupted, which is why xTaskNotifyWait is used
 		else if (current_weapon != target_weapon) {
-			if (action_start_tick == 0)
+			if (action_start_tick == 0) {
 				action_start_tick = xTaskGetTickCount();
 
+				// The equip delay hides the time needed to cache
+				// the new weapon's sounds from the SD card.
+				target_weapon->preload_sfx();
+			}
+
 			if ((xTaskGetTickCount() - action_start_tick) >= target_weapon->equip_duration) {
 				ESP_LOGD(LZR_WPN_HANDLER_TAG, "Equipped weapon!");
 
@@ -198,16 +219,39 @@ void Handler::start_thread() {
 	xTaskCreate(handler_start_thread_func, "LZR::WPN", 4096, this, 5, &process_task);
 }
 
-void Handler::update_btn(bool new_button_state) {
+void Handler::update_btn(bool new_button_state, int64_t edge_us) {
 	if (new_button_state == trigger_state)
 		return;
 
+	trigger_edge_us = (edge_us < 0) ? esp_timer_get_time() : edge_us;
 	trigger_state = new_button_state;
 	trigger_state_read = false;
 
 	boop_thread();
 }
 
+void Handler::count_trigger_press() {
+	uint32_t latency = esp_timer_get_time() - trigger_edge_us;
+
+	xSemaphoreTake(trigger_stats_lock, portMAX_DELAY);
+	trigger_stats.presses++;
+	trigger_stats.last_latency_us = latency;
+	trigger_stats.max_latency_us = std::max(trigger_stats.max_latency_us, latency);
+	if(trigger_stats.presses == 1)
+		trigger_stats.average_latency_us = latency;
+	else
+		trigger_stats.average_latency_us = (trigger_stats.average_latency_us * 7 + latency) / 8;
+	xSemaphoreGive(trigger_stats_lock);
+}
+
+trigger_stats_t Handler::get_trigger_stats() {
+	xSemaphoreTake(trigger_stats_lock, portMAX_DELAY);
+	trigger_stats_t out = trigger_stats;
+	xSemaphoreGive(trigger_stats_lock);
+
+	return out;
+}
+
 void Handler::fx_tick() {
 	if (current_weapon == nullptr)
 		gun_heat *= 0.95F;
@@ -309,7 +353,14 @@ void Handler::init_ir_system() {
         } else if (channel >= 130 && channel < 134) { // Hit code
             const uint8_t *dPtr = reinterpret_cast<const uint8_t *>(data);
             if (player_ && dPtr[0] != player_->get_id()) { // Check if player_ is valid
-                send_ir_hit_event(dPtr[0], channel - 130);
+                // The receiver hands over one frame per transmission, not
+                // per copy, so a beam's repeats are all counted here.
+                LZR::recent_hit_t hit;
+                Xasin::Communication::mesh_time_t received = Xasin::Communication::mesh_time_stamp();
+                if (hit_filter_.feed(dPtr[0], channel - 130, esp_timer_get_time(),
+                                     received.us, received.timebase, hit)) {
+                    send_ir_hit_event(hit);
+                }
             }
         }
     };
@@ -336,43 +387,88 @@ void Handler::send_ir_signal(int8_t cCode) {
         }
         cCode = last_ir_arbitration_code_;
     }
+    if (cCode < 0 || cCode >= 4) {
+        ESP_LOGE(LZR_WPN_HANDLER_TAG, "Invalid IR arbitration code %d", cCode);
+        return;
+    }
 
-    uint8_t shotID = player_->get_id();
+    // The ID only changes when the player is reassigned, so the frames are
+    // encoded once and then only copied into the transmit queue.
+    int playerID = player_->get_id();
+    if (playerID != shot_frames_id_) {
+        uint8_t shotID = playerID;
+        for (uint8_t i = 0; i < 4; i++) {
+#if CONFIG_LZR_IR_PROTOCOL_V2
+            bool encoded = Xasin::XIRR::encode_v2(shot_frames_[i], &shotID, 1, 130 + i, IR_SHOT_FEC, CONFIG_LZR_IR_REPEATS);
+#else
+            bool encoded = Xasin::XIRR::encode(shot_frames_[i], &shotID, 1, 130 + i);
+#endif
+            if (!encoded) {
+                ESP_LOGE(LZR_WPN_HANDLER_TAG, "Cannot encode shot frame for ID %d", playerID);
+            }
+        }
+        shot_frames_id_ = playerID;
+    }
+
+    // Beam weapons shoot faster than frames go on air, so dropping some is expected
+    if (ir_tx_.send(shot_frames_[cCode])) {
+        ESP_LOGD(LZR_WPN_HANDLER_TAG, "Sent IR signal: shooterID=%d, arbCode=%d", playerID, cCode);
+    } else {
+        ESP_LOGD(LZR_WPN_HANDLER_TAG, "IR transmit queue full, shot dropped");
+    }
+}
 
-    ir_tx_.send(shotID, 130 + cCode);
-    ESP_LOGD(LZR_WPN_HANDLER_TAG, "Sent IR signal: shooterID=%d, arbCode=%d", shotID, cCode);
+Xasin::XIRR::tx_stats_t Handler::get_ir_tx_stats() {
+    return ir_tx_.get_stats();
+}
 
+LZR::hit_filter_stats_t Handler::get_ir_hit_stats() {
+    return hit_filter_.get_stats();
 }
 
-void Handler::send_ir_hit_event(uint8_t pID, uint8_t arbCode) {
-    if (!comm_handler_ || !comm_handler_->isConnected()) {
-        ESP_LOGW(LZR_WPN_HANDLER_TAG, "Cannot send IR hit event: CommHandler not connected or not set.");
-        return;
+void Handler::ir_tick() {
+    LZR::recent_hit_t hit;
+    int64_t now = esp_timer_get_time();
+
+    while (hit_filter_.pop_expired(now, hit)) {
+        send_ir_hit_event(hit);
     }
+}
 
-    auto output = cJSON_CreateObject();
-    if (!output) {
-        ESP_LOGE(LZR_WPN_HANDLER_TAG, "Failed to create cJSON object for IR hit event.");
+void Handler::send_ir_hit_event(const LZR::recent_hit_t &hit) {
+    // While disconnected, the CommHandler queues the event until it is
+    // back, or until it is too old to matter
+    if (!comm_handler_) {
+        ESP_LOGW(LZR_WPN_HANDLER_TAG, "Cannot send IR hit event: CommHandler not set.");
         return;
     }
 
-    cJSON_AddNumberToObject(output, "shooterID", pID);
-    std::string device_id_str = Xasin::Communication::get_device_mac_string(); // Get device ID as std::string
-    cJSON_AddStringToObject(output, "target", device_id_str.c_str()); // Use .c_str() for const char*
-    cJSON_AddNumberToObject(output, "arbCode", arbCode);
-
-    char outStr[128] = {}; // Increased buffer size
-    if (cJSON_PrintPreallocated(output, outStr, sizeof(outStr) -1, false)) {
-        comm_handler_->publish("event/ir_hit", outStr, strlen(outStr));
-        ESP_LOGD(LZR_WPN_HANDLER_TAG, "Sent IR hit event: shooterID=%d, target=%s, arbCode=%d", pID, device_id_str.c_str(), arbCode);
+    LZR::Wire::ir_hit_t msg = {};
+    msg.shooter_id = hit.shooter_id;
+    msg.arb_code = hit.arb_code;
+    esp_read_mac(msg.target_mac, ESP_MAC_WIFI_STA);
+    msg.mesh_time_us = hit.first_mesh_us;
+    msg.repeats = hit.repeats;
+    msg.last_mesh_time_us = hit.last_mesh_us;
+    msg.mesh_timebase = hit.mesh_timebase;
+
+    char outStr[160];
+    size_t length = LZR::Wire::encode(msg, outStr, sizeof(outStr));
+    if (length > 0) {
+        comm_handler_->publish("event/ir_hit", outStr, length);
+        ESP_LOGD(LZR_WPN_HANDLER_TAG, "Sent IR hit event: shooterID=%d, arbCode=%d, repeats=%d",
+                 hit.shooter_id, hit.arb_code, hit.repeats);
     } else {
-        ESP_LOGE(LZR_WPN_HANDLER_TAG, "Failed to print cJSON for IR hit event.");
+        ESP_LOGE(LZR_WPN_HANDLER_TAG, "Failed to encode IR hit event.");
     }
-
-    cJSON_Delete(output);
 }
 
 // --- AUDIO PLAYBACK METHODS ---
+LZRTag::Weapon::AudioSource* Handler::play(Xasin::Audio::sound_id_t sfx) {
+    Xasin::Audio::ByteCassette::play(audio, sfx);
+    return nullptr; // Optionally, return a real AudioSource if needed
+}
+
 LZRTag::Weapon::AudioSource* Handler::play(const Xasin::Audio::bytecassette_data_t& sfx) {
     Xasin::Audio::ByteCassette::play(audio, sfx);
     return nullptr; // Optionally, return a real AudioSource if needed
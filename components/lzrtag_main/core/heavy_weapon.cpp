@@ -37,6 +37,13 @@ void HeavyWeapon::reload_tick()
 	wants_to_reload = false;
 }
 
+void HeavyWeapon::preload_sfx() {
+	// Shots play far more often, the reload sound only gets what space is left
+	Xasin::Audio::ByteCassette::preload(config.shot_sfx);
+	Xasin::Audio::ByteCassette::preload(config.start_sfx);
+	Xasin::Audio::ByteCassette::preload(config.reload_sfx, false);
+}
+
 void HeavyWeapon::shot_process() {
 
 	if(handler.wait_for_trigger(portMAX_DELAY) != TRIGGER_PRESSED)
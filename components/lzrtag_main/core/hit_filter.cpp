@@ -0,0 +1,110 @@
+/*
+ * hit_filter.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "lzrtag/hit_filter.h"
+
+namespace LZR {
+
+HitFilter::HitFilter(uint32_t window_ms) :
+	window_us(int64_t(window_ms) * 1000),
+	lock(xSemaphoreCreateMutex()),
+	table(), used(), stats() {
+}
+
+HitFilter::~HitFilter() {
+	vSemaphoreDelete(lock);
+}
+
+bool HitFilter::feed(uint8_t shooter_id, uint8_t arb_code, int64_t now_us, int64_t mesh_us, uint8_t mesh_timebase,
+		recent_hit_t &out) {
+	recent_hit_t hit = { shooter_id, arb_code, 0, now_us, mesh_us, mesh_us, mesh_timebase };
+
+	xSemaphoreTake(lock, portMAX_DELAY);
+	stats.frames++;
+
+	if(window_us <= 0) {
+		stats.hits++;
+		xSemaphoreGive(lock);
+
+		out = hit;
+		return true;
+	}
+
+	int free_slot = -1;
+	int oldest = 0;
+	for(int i = 0; i < LZR_HIT_TABLE_SIZE; i++) {
+		if(!used[i]) {
+			if(free_slot < 0)
+				free_slot = i;
+			continue;
+		}
+
+		recent_hit_t &entry = table[i];
+		// Frames after the window are a new hit, even if this one was not
+		// popped yet
+		if(entry.shooter_id == shooter_id && entry.arb_code == arb_code
+				&& (now_us - entry.first_us) < window_us) {
+			if(entry.repeats < UINT16_MAX)
+				entry.repeats++;
+			entry.last_mesh_us = mesh_us;
+			if(entry.mesh_timebase != mesh_timebase)
+				entry.mesh_timebase = 0;
+			stats.frames_suppressed++;
+
+			xSemaphoreGive(lock);
+			return false;
+		}
+
+		if(entry.first_us < table[oldest].first_us || !used[oldest])
+			oldest = i;
+	}
+
+	bool evicted = false;
+	if(free_slot < 0) {
+		out = table[oldest];
+		free_slot = oldest;
+
+		stats.hits++;
+		stats.evictions++;
+		evicted = true;
+	}
+
+	table[free_slot] = hit;
+	used[free_slot] = true;
+
+	xSemaphoreGive(lock);
+	return evicted;
+}
+
+bool HitFilter::pop_expired(int64_t now_us, recent_hit_t &out) {
+	bool found = false;
+
+	xSemaphoreTake(lock, portMAX_DELAY);
+	for(int i = 0; i < LZR_HIT_TABLE_SIZE; i++) {
+		if(!used[i] || (now_us - table[i].first_us) < window_us)
+			continue;
+
+		out = table[i];
+		used[i] = false;
+		stats.hits++;
+
+		found = true;
+		break;
+	}
+	xSemaphoreGive(lock);
+
+	return found;
+}
+
+hit_filter_stats_t HitFilter::get_stats() {
+	xSemaphoreTake(lock, portMAX_DELAY);
+	hit_filter_stats_t out = stats;
+	xSemaphoreGive(lock);
+
+	return out;
+}
+
+} /* namespace LZR */
@@ -13,8 +13,8 @@
 #include "lzrtag/animatorThread.h"
 #include "lzrtag/colorSets.h"
 
-#include <cJSON.h>
 #include <cstring>
+#include <algorithm>
 
 namespace LZR {
 
@@ -27,11 +27,12 @@ Player::Player(const std::string devID, Xasin::Communication::CommHandler &comm_
 	name(""),
 	deadUntil(0), hitUntil(0), vibrateUntil(0),
 	currentGun(0), shotLocked(0),
+	state(comm_handler),
 	comm_handler(comm_handler), should_reload(false) {
 
 	comm_handler.subscribe("event/#",
 		[this](const Xasin::Communication::CommReceivedData& message) {
-			std::string topic_str(message.topic.begin(), message.topic.end());
+			std::string topic_str(message.sub_topic);
 			std::string payload_str(message.payload.begin(), message.payload.end());
 
 			if(topic_str == "hit")
@@ -45,36 +46,37 @@ Player::Player(const std::string devID, Xasin::Communication::CommHandler &comm_
 
 	comm_handler.subscribe("get/#",
 			[this](const Xasin::Communication::CommReceivedData& message) {
-			std::string topic_str(message.topic.begin(), message.topic.end());
-			std::string payload_str(message.payload.begin(), message.payload.end());
+			const std::string_view topic = message.sub_topic;
 
-		cJSON * json;
-			if(payload_str.length() > 0)
-				json = cJSON_Parse(payload_str.c_str());
-			else
-				json = cJSON_CreateNull();
+			// Set by servers that understand the binary format, see wire_format.h.
+			// Not a JSON scalar when published bare.
+			if(topic == "wire_format") {
+				Wire::output_format = Wire::decode_format(message.payload.data(), message.payload.size());
+				return;
+			}
 
-			if(json == nullptr)
+			Wire::config_value_t value;
+			if(!Wire::decode(message.payload.data(), message.payload.size(), value))
 				return;
 
-			if(topic_str == "id" && (cJSON_IsNumber(json) || cJSON_IsNull(json)))
-				ID = json->valueint;
-			else if(topic_str == "team" && (cJSON_IsNumber(json) || cJSON_IsNull(json)))
-				team = json->valueint;
-			else if(topic_str == "brightness" && (cJSON_IsNumber(json) || cJSON_IsNull(json)))
-				brightness = json->valueint;
-			else if(topic_str == "gun_config") {
-				if(cJSON_IsNull(json)) {
+			if(topic == "id" && (value.kind == value.VALUE_NUMBER || value.kind == value.VALUE_NONE))
+				ID = value.value_int();
+			else if(topic == "team" && (value.kind == value.VALUE_NUMBER || value.kind == value.VALUE_NONE))
+				team = value.value_int();
+			else if(topic == "brightness" && (value.kind == value.VALUE_NUMBER || value.kind == value.VALUE_NONE))
+				brightness = value.value_int();
+			else if(topic == "gun_config") {
+				if(value.kind == value.VALUE_NONE) {
 					currentGun = 0;
 				}
-				else if(cJSON_IsNumber(json))
-					currentGun = json->valueint;
+				else if(value.kind == value.VALUE_NUMBER)
+					currentGun = value.number;
 				
 				shotLocked = currentGun <= 0;
 			}
-			else if(topic_str == "mark_config") {
-				isMarked = !cJSON_IsFalse(json);
-				uint32_t markerCode = json->valueint;
+			else if(topic == "mark_config") {
+				isMarked = !value.is_false();
+				int32_t markerCode = value.value_int();
 
 				if(markerCode <= 0)
 					isMarked = false;
@@ -83,12 +85,14 @@ Player::Player(const std::string devID, Xasin::Communication::CommHandler &comm_
 				else
 					markerColor = markerCode;
 			}
-			else if(topic_str == "heartbeat")
-				heartbeat = cJSON_IsTrue(json);
-			else if(topic_str == "name")
-				name = json->valuestring;
-			else if(topic_str == "dead") {
-				if(cJSON_IsTrue(json)) {
+			else if(topic == "heartbeat")
+				heartbeat = value.is_true();
+			else if(topic == "name") {
+				if(value.kind == value.VALUE_STRING)
+					name = std::string(value.string);
+			}
+			else if(topic == "dead") {
+				if(value.is_true()) {
 					if(deadUntil == 0) {
 						deadUntil = portMAX_DELAY;
 					}
@@ -97,8 +101,6 @@ Player::Player(const std::string devID, Xasin::Communication::CommHandler &comm_
 					deadUntil = 0;
 				}
 			}
-
-			cJSON_Delete(json);
 		}
 	);
 }
@@ -111,6 +113,10 @@ void Player::tick() {
 		deadUntil = 0;
 		comm_handler.publish("get/dead", "false", strlen("false"), 1, true);
 	}
+
+	state.set_weapon(std::max(0, std::min(255, currentGun)));
+	state.set_dead(is_dead());
+	state.tick();
 }
 
 int Player::get_id() {
@@ -171,38 +177,10 @@ int Player::get_gun_num() {
 	return currentGun;
 }
 void Player::set_gun_ammo(int32_t current, int32_t clipsize, int32_t total) {
-	if(gun_ammo_info == nullptr) {
-		gun_ammo_info = cJSON_CreateObject();
-		cJSON_AddNumberToObject(gun_ammo_info, "current", 0);
-		cJSON_AddNumberToObject(gun_ammo_info, "clipsize", 0);
-		cJSON_AddNumberToObject(gun_ammo_info, "total", 0);
-	}
-
-	bool changed = false;
-
-	cJSON * json = cJSON_GetObjectItem(gun_ammo_info, "current");
-	if(json->valueint != current) {
-		changed = true;
-		cJSON_SetNumberValue(json, current);
-	}
-
-	json = cJSON_GetObjectItem(gun_ammo_info, "clipsize");
-	if(json->valueint != clipsize) {
-		changed = true;
-		cJSON_SetNumberValue(json, clipsize);
-	}
-
-	json = cJSON_GetObjectItem(gun_ammo_info, "total");
-	if(json->valueint != total) {
-		changed = true;
-		cJSON_SetNumberValue(json, total);
-	}
-
-	if(changed) {
-		char * printed = cJSON_PrintUnformatted(gun_ammo_info);
-		comm_handler.publish("get/ammo", printed, strlen(printed), 0, true);
-		cJSON_free(printed);
-	}
+	state.set_ammo(current, clipsize, total);
+}
+void Player::set_gun_heat(float heat) {
+	state.set_heat(heat);
 }
 
 bool Player::is_dead() {
@@ -0,0 +1,118 @@
+/*
+ * player_state.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "lzrtag/player_state.h"
+#include "MeshClock.h"
+
+#include "freertos/task.h"
+
+#include <stdlib.h>
+#include <algorithm>
+
+namespace LZR {
+
+PlayerState::PlayerState(Xasin::Communication::CommHandler &comm_handler) :
+	comm_handler(comm_handler),
+	state(), published_heat(0),
+	// The first tick publishes a full snapshot
+	dirty(DIRTY_AMMO | DIRTY_HEAT | DIRTY_WEAPON | DIRTY_DEAD), urgent(false),
+	last_publish(0) {
+}
+
+void PlayerState::set_ammo(int32_t current, int32_t clipsize, int32_t total) {
+	Wire::ammo_t ammo = { current, clipsize, total };
+	if(ammo == state.ammo)
+		return;
+
+	// An empty clip changes what the server shows, so it should not lag behind
+	if(current == 0 && state.ammo.current != 0)
+		urgent = true;
+
+	state.ammo = ammo;
+	dirty |= DIRTY_AMMO;
+}
+
+void PlayerState::set_heat(float heat) {
+	uint8_t new_heat = std::min(255.0F, std::max(0.0F, heat));
+	if(new_heat == state.heat)
+		return;
+
+	state.heat = new_heat;
+
+	// Heat changes every tick, only a big enough change is worth a message
+	if(abs(int(new_heat) - int(published_heat)) >= CONFIG_LZR_STATE_HEAT_STEP)
+		dirty |= DIRTY_HEAT;
+}
+
+void PlayerState::set_weapon(uint8_t weapon) {
+	if(weapon == state.weapon)
+		return;
+
+	state.weapon = weapon;
+	dirty |= DIRTY_WEAPON;
+	urgent = true;
+}
+
+void PlayerState::set_dead(bool dead) {
+	if(dead == state.dead)
+		return;
+
+	state.dead = dead;
+	dirty |= DIRTY_DEAD;
+	urgent = true;
+}
+
+void PlayerState::tick() {
+	if(dirty == 0)
+		return;
+
+	if(!urgent && (xTaskGetTickCount() - last_publish) < pdMS_TO_TICKS(CONFIG_LZR_STATE_PUBLISH_INTERVAL))
+		return;
+
+	flush();
+}
+
+void PlayerState::flush() {
+	if(dirty == 0)
+		return;
+
+	Xasin::Communication::mesh_time_t now = Xasin::Communication::mesh_time_stamp();
+	state.mesh_time_us = now.us;
+	state.mesh_timebase = now.timebase;
+
+	char buffer[160];
+	size_t length = Wire::encode(state, buffer, sizeof(buffer));
+	if(length == 0)
+		return;
+
+	// Retained, so that only the latest snapshot is kept while offline
+	if(!comm_handler.publish("get/state", buffer, length, true, 1))
+		return;
+
+	// Servers that do not know get/state yet follow the ammo on its own
+	// topic, as before. Retained as well, so that while offline it is
+	// coalesced, instead of every shot's update filling the outbox.
+	if(dirty & DIRTY_AMMO) {
+		length = Wire::encode(state.ammo, buffer, sizeof(buffer));
+		if(length > 0)
+			comm_handler.publish("get/ammo", buffer, length, true, 1);
+	}
+
+	published_heat = state.heat;
+	dirty = 0;
+	urgent = false;
+	last_publish = xTaskGetTickCount();
+}
+
+uint8_t PlayerState::get_dirty() const {
+	return dirty;
+}
+
+const Wire::player_state_t &PlayerState::get() const {
+	return state;
+}
+
+} /* namespace LZR */
@@ -58,6 +58,12 @@ while(true) {
 		vTaskDelay(std::max<int32_t>(150, 150*1000 / std::max<int32_t>(shot_speed, 150)) + esp_random() / (UINT32_MAX / 20));
 	}*/
 
+void ShotWeapon::preload_sfx() {
+	// Shots play far more often, the reload sound only gets what space they left
+	Xasin::Audio::ByteCassette::preload(config.shot_sfx);
+	Xasin::Audio::ByteCassette::preload(config.reload_sfx, false);
+}
+
 void ShotWeapon::shot_process()
 {
 	TickType_t last_shot = 0;
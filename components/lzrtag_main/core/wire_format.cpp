@@ -0,0 +1,355 @@
+/*
+ * wire_format.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "lzrtag/wire_format.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace LZR {
+namespace Wire {
+
+format_t output_format = JSON;
+
+// Fixed payload sizes of the current schema version
+#define IR_HIT_SIZE 27
+#define AMMO_SIZE 12
+#define PING_REPLY_SIZE 14
+#define CONFIG_VALUE_SIZE 5
+#define PLAYER_STATE_SIZE 24
+
+// Sizes before version 2 appended the mesh time
+#define IR_HIT_V1_SIZE 8
+#define PLAYER_STATE_V1_SIZE 15
+// and before version 3 appended the hit repeats
+#define IR_HIT_V2_SIZE 16
+// and before version 4 appended the mesh timebase
+#define IR_HIT_V3_SIZE 26
+#define PLAYER_STATE_V3_SIZE 23
+
+static void put_u32(uint8_t *out, uint32_t value) {
+	out[0] = value;
+	out[1] = value >> 8;
+	out[2] = value >> 16;
+	out[3] = value >> 24;
+}
+static uint32_t get_u32(const uint8_t *in) {
+	return in[0] | (in[1] << 8) | (in[2] << 16) | (uint32_t(in[3]) << 24);
+}
+static void put_i64(uint8_t *out, int64_t value) {
+	put_u32(out, uint64_t(value));
+	put_u32(out + 4, uint64_t(value) >> 32);
+}
+static int64_t get_i64(const uint8_t *in) {
+	return get_u32(in) | (uint64_t(get_u32(in + 4)) << 32);
+}
+
+// Writes the schema header, and returns the payload pointer,
+// or nullptr if the message does not fit.
+static uint8_t *start_binary(char *buffer, size_t size, message_type_t type, uint8_t payload_size) {
+	if(size < size_t(LZR_WIRE_HEADER_SIZE + payload_size))
+		return nullptr;
+
+	uint8_t *out = reinterpret_cast<uint8_t*>(buffer);
+	out[0] = LZR_WIRE_MARKER;
+	out[1] = LZR_WIRE_VERSION;
+	out[2] = type;
+	out[3] = payload_size;
+
+	return out + LZR_WIRE_HEADER_SIZE;
+}
+
+// Returns the payload, or nullptr if this is not a binary message of
+// the given type with at least payload_size bytes of payload.
+// The actual payload length goes to *actual_size, if given.
+static const uint8_t *open_binary(const void *data, size_t length, message_type_t type, uint8_t payload_size,
+		uint8_t *actual_size = nullptr) {
+	const uint8_t *in = reinterpret_cast<const uint8_t*>(data);
+
+	if(length < LZR_WIRE_HEADER_SIZE || in[0] != LZR_WIRE_MARKER)
+		return nullptr;
+	if(in[1] == 0 || in[2] != type)
+		return nullptr;
+	if(in[3] < payload_size || length < LZR_WIRE_HEADER_SIZE + size_t(in[3]))
+		return nullptr;
+
+	if(actual_size != nullptr)
+		*actual_size = in[3];
+	return in + LZR_WIRE_HEADER_SIZE;
+}
+
+// snprintf reports the length it wanted, which is no use if truncated.
+static size_t json_length(int printed, size_t size) {
+	if(printed < 0 || size_t(printed) >= size)
+		return 0;
+	return printed;
+}
+
+size_t encode(const ir_hit_t &msg, char *buffer, size_t size, format_t format) {
+	if(format == BINARY) {
+		uint8_t *out = start_binary(buffer, size, MSG_IR_HIT, IR_HIT_SIZE);
+		if(out == nullptr)
+			return 0;
+
+		out[0] = msg.shooter_id;
+		out[1] = msg.arb_code;
+		memcpy(out + 2, msg.target_mac, 6);
+		put_i64(out + 8, msg.mesh_time_us);
+		out[16] = msg.repeats;
+		out[17] = msg.repeats >> 8;
+		put_i64(out + 18, msg.last_mesh_time_us);
+		out[26] = msg.mesh_timebase;
+
+		return LZR_WIRE_HEADER_SIZE + IR_HIT_SIZE;
+	}
+
+	const uint8_t *mac = msg.target_mac;
+	return json_length(snprintf(buffer, size,
+		"{\"shooterID\":%u,\"target\":\"%02x:%02x:%02x:%02x:%02x:%02x\",\"arbCode\":%u,\"meshTime\":%lld,"
+		"\"repeats\":%u,\"lastMeshTime\":%lld,\"meshTimebase\":%u}",
+		msg.shooter_id, mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], msg.arb_code,
+		(long long)msg.mesh_time_us, unsigned(msg.repeats), (long long)msg.last_mesh_time_us,
+		msg.mesh_timebase), size);
+}
+
+size_t encode(const ammo_t &msg, char *buffer, size_t size, format_t format) {
+	if(format == BINARY) {
+		uint8_t *out = start_binary(buffer, size, MSG_AMMO, AMMO_SIZE);
+		if(out == nullptr)
+			return 0;
+
+		put_u32(out, msg.current);
+		put_u32(out + 4, msg.clipsize);
+		put_u32(out + 8, msg.total);
+
+		return LZR_WIRE_HEADER_SIZE + AMMO_SIZE;
+	}
+
+	return json_length(snprintf(buffer, size, "{\"current\":%d,\"clipsize\":%d,\"total\":%d}",
+		int(msg.current), int(msg.clipsize), int(msg.total)), size);
+}
+
+size_t encode(const ping_reply_t &msg, char *buffer, size_t size, format_t format) {
+	if(format == BINARY) {
+		uint8_t *out = start_binary(buffer, size, MSG_PING_REPLY, PING_REPLY_SIZE);
+		if(out == nullptr)
+			return 0;
+
+		put_u32(out, msg.battery_mv);
+		out[4] = msg.battery_percentage;
+		out[5] = msg.has_ping_ticks ? 1 : 0;
+		put_u32(out + 6, msg.ping_ticks);
+		put_u32(out + 10, msg.heap);
+
+		return LZR_WIRE_HEADER_SIZE + PING_REPLY_SIZE;
+	}
+
+	int printed;
+	if(msg.has_ping_ticks)
+		printed = snprintf(buffer, size, "{\"battery\":{\"mv\":%u,\"percentage\":%u},\"ping_ticks\":%u,\"heap\":%u}",
+			unsigned(msg.battery_mv), msg.battery_percentage, unsigned(msg.ping_ticks), unsigned(msg.heap));
+	else
+		printed = snprintf(buffer, size, "{\"battery\":{\"mv\":%u,\"percentage\":%u},\"heap\":%u}",
+			unsigned(msg.battery_mv), msg.battery_percentage, unsigned(msg.heap));
+
+	return json_length(printed, size);
+}
+
+size_t encode(const player_state_t &msg, char *buffer, size_t size, format_t format) {
+	if(format == BINARY) {
+		uint8_t *out = start_binary(buffer, size, MSG_PLAYER_STATE, PLAYER_STATE_SIZE);
+		if(out == nullptr)
+			return 0;
+
+		put_u32(out, msg.ammo.current);
+		put_u32(out + 4, msg.ammo.clipsize);
+		put_u32(out + 8, msg.ammo.total);
+		out[12] = msg.heat;
+		out[13] = msg.weapon;
+		out[14] = msg.dead ? 1 : 0;
+		put_i64(out + 15, msg.mesh_time_us);
+		out[23] = msg.mesh_timebase;
+
+		return LZR_WIRE_HEADER_SIZE + PLAYER_STATE_SIZE;
+	}
+
+	return json_length(snprintf(buffer, size,
+		"{\"ammo\":{\"current\":%d,\"clipsize\":%d,\"total\":%d},\"heat\":%u,\"weapon\":%u,\"dead\":%s,\"meshTime\":%lld,"
+		"\"meshTimebase\":%u}",
+		int(msg.ammo.current), int(msg.ammo.clipsize), int(msg.ammo.total),
+		msg.heat, msg.weapon, msg.dead ? "true" : "false", (long long)msg.mesh_time_us, msg.mesh_timebase), size);
+}
+
+size_t encode(const config_value_t &msg, char *buffer, size_t size, format_t format) {
+	if(format == BINARY && msg.kind != config_value_t::VALUE_STRING) {
+		uint8_t *out = start_binary(buffer, size, MSG_CONFIG_VALUE, CONFIG_VALUE_SIZE);
+		if(out == nullptr)
+			return 0;
+
+		out[0] = msg.kind;
+		put_u32(out + 1, msg.number);
+
+		return LZR_WIRE_HEADER_SIZE + CONFIG_VALUE_SIZE;
+	}
+
+	int printed = -1;
+	switch(msg.kind) {
+	case config_value_t::VALUE_NONE:   printed = snprintf(buffer, size, "null"); break;
+	case config_value_t::VALUE_FALSE:  printed = snprintf(buffer, size, "false"); break;
+	case config_value_t::VALUE_TRUE:   printed = snprintf(buffer, size, "true"); break;
+	case config_value_t::VALUE_NUMBER: printed = snprintf(buffer, size, "%d", int(msg.number)); break;
+	case config_value_t::VALUE_STRING:
+		printed = snprintf(buffer, size, "\"%.*s\"", int(msg.string.size()), msg.string.data());
+	break;
+	}
+
+	return json_length(printed, size);
+}
+
+bool decode(const void *data, size_t length, ir_hit_t &out) {
+	uint8_t size;
+	const uint8_t *in = open_binary(data, length, MSG_IR_HIT, IR_HIT_V1_SIZE, &size);
+	if(in == nullptr)
+		return false;
+
+	out.shooter_id = in[0];
+	out.arb_code = in[1];
+	memcpy(out.target_mac, in + 2, 6);
+	out.mesh_time_us = (size >= IR_HIT_V2_SIZE) ? get_i64(in + 8) : 0;
+
+	if(size >= IR_HIT_V3_SIZE) {
+		out.repeats = in[16] | (in[17] << 8);
+		out.last_mesh_time_us = get_i64(in + 18);
+	}
+	else {
+		out.repeats = 0;
+		out.last_mesh_time_us = out.mesh_time_us;
+	}
+	out.mesh_timebase = (size >= IR_HIT_SIZE) ? in[26] : 0;
+
+	return true;
+}
+
+bool decode(const void *data, size_t length, ammo_t &out) {
+	const uint8_t *in = open_binary(data, length, MSG_AMMO, AMMO_SIZE);
+	if(in == nullptr)
+		return false;
+
+	out.current = get_u32(in);
+	out.clipsize = get_u32(in + 4);
+	out.total = get_u32(in + 8);
+
+	return true;
+}
+
+bool decode(const void *data, size_t length, ping_reply_t &out) {
+	const uint8_t *in = open_binary(data, length, MSG_PING_REPLY, PING_REPLY_SIZE);
+	if(in == nullptr)
+		return false;
+
+	out.battery_mv = get_u32(in);
+	out.battery_percentage = in[4];
+	out.has_ping_ticks = in[5] & 1;
+	out.ping_ticks = get_u32(in + 6);
+	out.heap = get_u32(in + 10);
+
+	return true;
+}
+
+bool decode(const void *data, size_t length, player_state_t &out) {
+	uint8_t size;
+	const uint8_t *in = open_binary(data, length, MSG_PLAYER_STATE, PLAYER_STATE_V1_SIZE, &size);
+	if(in == nullptr)
+		return false;
+
+	out.ammo.current = get_u32(in);
+	out.ammo.clipsize = get_u32(in + 4);
+	out.ammo.total = get_u32(in + 8);
+	out.heat = in[12];
+	out.weapon = in[13];
+	out.dead = in[14] & 1;
+	out.mesh_time_us = (size >= PLAYER_STATE_V3_SIZE) ? get_i64(in + 15) : 0;
+	out.mesh_timebase = (size >= PLAYER_STATE_SIZE) ? in[23] : 0;
+
+	return true;
+}
+
+// Parses a single JSON scalar, the only thing the config topics carry.
+static bool decode_json_scalar(std::string_view text, config_value_t &out) {
+	while(!text.empty() && isspace(text.front()))
+		text.remove_prefix(1);
+	while(!text.empty() && isspace(text.back()))
+		text.remove_suffix(1);
+
+	out.number = 0;
+	out.string = std::string_view();
+
+	if(text.empty() || text == "null")
+		out.kind = config_value_t::VALUE_NONE;
+	else if(text == "true")
+		out.kind = config_value_t::VALUE_TRUE;
+	else if(text == "false")
+		out.kind = config_value_t::VALUE_FALSE;
+	else if(text.size() >= 2 && text.front() == '"' && text.back() == '"') {
+		out.kind = config_value_t::VALUE_STRING;
+		out.string = text.substr(1, text.size() - 2);
+	}
+	else {
+		// strtod needs a terminated string, numbers are never long
+		char number[24];
+		if(text.size() >= sizeof(number))
+			return false;
+
+		memcpy(number, text.data(), text.size());
+		number[text.size()] = 0;
+
+		char *end;
+		double value = strtod(number, &end);
+		if(end != number + text.size())
+			return false;
+
+		out.kind = config_value_t::VALUE_NUMBER;
+		out.number = value;
+	}
+
+	return true;
+}
+
+format_t decode_format(const void *data, size_t length) {
+	std::string_view text(reinterpret_cast<const char*>(data), length);
+
+	while(!text.empty() && isspace(text.front()))
+		text.remove_prefix(1);
+	while(!text.empty() && isspace(text.back()))
+		text.remove_suffix(1);
+
+	if(text.size() >= 2 && text.front() == '"' && text.back() == '"')
+		text = text.substr(1, text.size() - 2);
+
+	return (text == "binary") ? BINARY : JSON;
+}
+
+bool decode(const void *data, size_t length, config_value_t &out) {
+	const uint8_t *bytes = reinterpret_cast<const uint8_t*>(data);
+
+	if(length == 0 || bytes[0] != LZR_WIRE_MARKER)
+		return decode_json_scalar(std::string_view(reinterpret_cast<const char*>(data), length), out);
+
+	const uint8_t *in = open_binary(data, length, MSG_CONFIG_VALUE, CONFIG_VALUE_SIZE);
+	if(in == nullptr || in[0] > config_value_t::VALUE_NUMBER)
+		return false;
+
+	out.kind = config_value_t::kind_t(in[0]);
+	out.number = get_u32(in + 1);
+	out.string = std::string_view();
+
+	return true;
+}
+
+} /* namespace Wire */
+} /* namespace LZR */
@@ -169,8 +169,9 @@ void Animator::animation_task_runner() {
             weapon_handler_->set_weapon((*weapons_)[g_num-1]); // g_num is 1-indexed
         }
 
-        weapon_handler_->update_btn(!lzrtag_get_trigger());
+        // The trigger is read by LZR::TriggerInput
         weapon_handler_->fx_tick();
+        weapon_handler_->ir_tick();
 
         if (player_->should_reload) {
             weapon_handler_->tempt_reload();
@@ -179,6 +180,7 @@ void Animator::animation_task_runner() {
         
         auto ammo_info = weapon_handler_->get_ammo();
         player_->set_gun_ammo(ammo_info.current_ammo, ammo_info.clipsize, ammo_info.total_ammo);
+        player_->set_gun_heat(weapon_handler_->get_gun_heat());
 
         status_led_tick_internal();
 
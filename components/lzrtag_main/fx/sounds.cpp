@@ -10,25 +10,13 @@
 #include "lzrtag/sounds.h"
 #include "CommHandler.h"
 
-#define GAME_START_SOUND_PATH "DEI/lzrtag-sfx/game_start.wav"
-#define KILL_SCORE_SOUND_PATH "DEI/lzrtag-sfx/kill_score.wav"
-#define MINOR_SCORE_SOUND_PATH "DEI/lzrtag-sfx/minor_score.wav"
-#define OWN_DEATH_SOUND_PATH "DEI/lzrtag-sfx/own_death.wav"
-#define OWN_HIT_SOUND_PATH "DEI/lzrtag-sfx/own_hit.wav"
-#define EMPTY_CLICK_SOUND_PATH "DEI/lzrtag-sfx/empty_click.wav"
-#define RELOAD_FULL_SOUND_PATH "DEI/lzrtag-sfx/reload_full.wav"
-#define DENYBEEP_SOUND_PATH "DEI/lzrtag-sfx/denybeep.wav"
+#include "lzrtag/sfx_ids.h"
 
+// Not part of lzrtag-sfx, and thus not in the sound bank.
+#define RELOAD_FULL_SOUND_PATH "DEI/lzrtag-sfx/reload_full.wav"
 
 #define DEFAULT_FX_SAMPLERATE 44100
-#define DEFAULT_FX_VOLUME_GAME_START (40000 >> 8)
-#define DEFAULT_FX_VOLUME_KILL_SCORE (15000 >> 8)
-#define DEFAULT_FX_VOLUME_MINOR_SCORE (23000 >> 8)
-#define DEFAULT_FX_VOLUME_OWN_DEATH (40000 >> 8)
-#define DEFAULT_FX_VOLUME_OWN_HIT (20000 >> 8)
-#define DEFAULT_FX_VOLUME_EMPTY_CLICK (15000 >> 8)
 #define DEFAULT_FX_VOLUME_RELOAD_FULL (12000 >> 8)
-#define DEFAULT_FX_VOLUME_DENYBEEP (20000 >> 8)
 
 
 using namespace Xasin::NeoController;
@@ -36,14 +24,16 @@ using namespace Xasin::NeoController;
 namespace LZR {
 namespace Sounds {
 
-auto cassette_game_start = XASAUDIO_CASSETTE(GAME_START_SOUND_PATH, DEFAULT_FX_SAMPLERATE, DEFAULT_FX_VOLUME_GAME_START);
-auto cassette_kill_scored = XASAUDIO_CASSETTE(KILL_SCORE_SOUND_PATH, DEFAULT_FX_SAMPLERATE, DEFAULT_FX_VOLUME_KILL_SCORE);
-auto cassette_minor_score = XASAUDIO_CASSETTE(MINOR_SCORE_SOUND_PATH, DEFAULT_FX_SAMPLERATE, DEFAULT_FX_VOLUME_MINOR_SCORE);
-auto cassette_death = XASAUDIO_CASSETTE(OWN_DEATH_SOUND_PATH, DEFAULT_FX_SAMPLERATE, DEFAULT_FX_VOLUME_OWN_DEATH);
-auto cassette_hit = XASAUDIO_CASSETTE(OWN_HIT_SOUND_PATH, DEFAULT_FX_SAMPLERATE, DEFAULT_FX_VOLUME_OWN_HIT);
-auto cassette_click = XASAUDIO_CASSETTE(EMPTY_CLICK_SOUND_PATH, DEFAULT_FX_SAMPLERATE, DEFAULT_FX_VOLUME_EMPTY_CLICK);
+// Sample rate and volume of the bank sounds are set by the sound
+// bank, see lzrtag-sfx/volumes.txt.
+const Xasin::Audio::sound_id_t cassette_game_start = LZR::SFX::GAME_START;
+const Xasin::Audio::sound_id_t cassette_kill_scored = LZR::SFX::KILL_SCORE;
+const Xasin::Audio::sound_id_t cassette_minor_score = LZR::SFX::MINOR_SCORE;
+const Xasin::Audio::sound_id_t cassette_death = LZR::SFX::OWN_DEATH;
+const Xasin::Audio::sound_id_t cassette_hit = LZR::SFX::OWN_HIT;
+const Xasin::Audio::sound_id_t cassette_click = LZR::SFX::EMPTY_CLICK;
 auto cassette_reload_full = XASAUDIO_CASSETTE(RELOAD_FULL_SOUND_PATH, DEFAULT_FX_SAMPLERATE, DEFAULT_FX_VOLUME_RELOAD_FULL);
-auto cassette_deny = XASAUDIO_CASSETTE(DENYBEEP_SOUND_PATH, DEFAULT_FX_SAMPLERATE, DEFAULT_FX_VOLUME_DENYBEEP);
+const Xasin::Audio::sound_id_t cassette_deny = LZR::SFX::DENYBEEP3;
 
 SoundManager::SoundManager(Xasin::Audio::TX& audioManager, Xasin::Communication::CommHandler* commHandler)
     : audioManager_(audioManager), comm_handler_(commHandler) {}
@@ -68,6 +58,12 @@ void SoundManager::play_audio(const std::string& aName) {
 }
 
 void SoundManager::init() {
+    // Most of these are triggered by game events and should start
+    // right away, so keep them in RAM from the beginning.
+    Xasin::Audio::ByteCassette::preload(Xasin::Audio::ByteCassetteCollection{ cassette_hit, cassette_click, cassette_deny,
+                                                                               cassette_minor_score, cassette_kill_scored, cassette_death, cassette_game_start });
+    Xasin::Audio::ByteCassette::preload(cassette_reload_full);
+
     comm_handler_->subscribe("Sound/#", [this](Xasin::Communication::CommReceivedData data) {
         // Only expect the payload to be the sound name
         play_audio(std::string(data.payload.begin(), data.payload.end()));
@@ -0,0 +1,211 @@
+/*
+ * trigger_input.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "lzrtag/trigger_input.h"
+
+#include "driver/i2c.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+namespace LZR {
+
+static const char *TRIGGER_TAG = "LZR:Trigger";
+
+// MCP23008 registers, the wrapper only covers direction and pin levels
+#define MCP_REG_GPINTEN 0x02
+#define MCP_REG_INTCON  0x04
+#define MCP_REG_IOCON   0x05
+
+// IOCON: INT open drain, and active high
+#define MCP_IOCON_ODR    0x04
+#define MCP_IOCON_INTPOL 0x02
+
+#define MCP_I2C_TIMEOUT pdMS_TO_TICKS(10)
+
+static esp_err_t mcp_read_reg(mcp23008_t &mcp, uint8_t reg, uint8_t &value) {
+	return i2c_master_write_read_device(mcp.port, mcp.address, &reg, 1, &value, 1, MCP_I2C_TIMEOUT);
+}
+
+static esp_err_t mcp_write_reg(mcp23008_t &mcp, uint8_t reg, uint8_t value) {
+	uint8_t data[2] = { reg, value };
+	return i2c_master_write_to_device(mcp.port, mcp.address, data, sizeof(data), MCP_I2C_TIMEOUT);
+}
+
+static esp_err_t mcp_update_reg(mcp23008_t &mcp, uint8_t reg, uint8_t clear, uint8_t set) {
+	uint8_t value;
+	esp_err_t err = mcp_read_reg(mcp, reg, value);
+	if(err != ESP_OK)
+		return err;
+
+	return mcp_write_reg(mcp, reg, (value & ~clear) | set);
+}
+
+static void IRAM_ATTR trigger_isr(void *args) {
+	reinterpret_cast<TriggerInput*>(args)->_isr();
+}
+
+static void trigger_task(void *args) {
+	reinterpret_cast<TriggerInput*>(args)->_task();
+}
+
+TriggerInput::TriggerInput(LZRTag::Weapon::Handler &handler, mcp23008_t &mcp, gpio_num_t int_pin) :
+	handler(handler), mcp(mcp), int_pin(int_pin),
+	use_interrupt(false), task(nullptr),
+	stopping(false), task_stopped(xSemaphoreCreateBinary()),
+	edge_us(0), pressed(false),
+	stats_lock(xSemaphoreCreateMutex()), stats() {
+}
+
+TriggerInput::~TriggerInput() {
+	// First, so that no edge notifies the task while it goes away
+	if(use_interrupt)
+		gpio_isr_handler_remove(int_pin);
+
+	if(task != nullptr) {
+		stopping = true;
+		xTaskNotifyGive(task);
+		xSemaphoreTake(task_stopped, portMAX_DELAY);
+	}
+
+	if(use_interrupt) {
+		gpio_reset_pin(int_pin);
+		mcp_update_reg(mcp, MCP_REG_GPINTEN, 1 << MCP2_PIN_GUN_TRIGGER, 0);
+	}
+
+	vSemaphoreDelete(task_stopped);
+	vSemaphoreDelete(stats_lock);
+}
+
+bool TriggerInput::setup_interrupt() {
+	if(int_pin == GPIO_NUM_NC)
+		return false;
+
+	// Named pins are the bit in the GPIO registers
+	const uint8_t mask = 1 << MCP2_PIN_GUN_TRIGGER;
+
+	// Push-pull, active low INT, interrupt on any change of the trigger
+	if(mcp_update_reg(mcp, MCP_REG_IOCON, MCP_IOCON_ODR | MCP_IOCON_INTPOL, 0) != ESP_OK
+			|| mcp_update_reg(mcp, MCP_REG_INTCON, mask, 0) != ESP_OK
+			|| mcp_update_reg(mcp, MCP_REG_GPINTEN, 0, mask) != ESP_OK) {
+		ESP_LOGE(TRIGGER_TAG, "Could not set up the MCP23008 interrupt, polling");
+		return false;
+	}
+
+	gpio_config_t cfg = {};
+	cfg.pin_bit_mask = 1ULL << int_pin;
+	cfg.mode = GPIO_MODE_INPUT;
+	cfg.pull_up_en = GPIO_PULLUP_ENABLE;
+	cfg.intr_type = GPIO_INTR_NEGEDGE;
+	gpio_config(&cfg);
+
+	// Someone else may have installed it already
+	esp_err_t err = gpio_install_isr_service(0);
+	if(err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+		ESP_LOGE(TRIGGER_TAG, "No GPIO ISR service (%s), polling", esp_err_to_name(err));
+		return false;
+	}
+
+	// The handler itself is only added once the task it wakes exists
+	return true;
+}
+
+void TriggerInput::start() {
+	if(task != nullptr)
+		return;
+
+	use_interrupt = setup_interrupt();
+	ESP_LOGI(TRIGGER_TAG, "Trigger input %s", use_interrupt ? "on INT" : "polled");
+
+	// Above the weapon thread, which it wakes
+	xTaskCreate(trigger_task, "LZR::Trigger", 2048, this, 6, &task);
+
+	if(use_interrupt)
+		gpio_isr_handler_add(int_pin, trigger_isr, this);
+}
+
+bool TriggerInput::read(bool &out) {
+	// Reading the port also clears the INT line
+	bool level = false;
+	if(mcp23008_wrapper_read_pin(&mcp, (MCP23008_NamedPin)MCP2_PIN_GUN_TRIGGER, &level) != ESP_OK) {
+		xSemaphoreTake(stats_lock, portMAX_DELAY);
+		stats.read_errors++;
+		xSemaphoreGive(stats_lock);
+
+		return false;
+	}
+
+	// Pulled low while pressed
+	out = !level;
+	return true;
+}
+
+bool TriggerInput::uses_interrupt() const {
+	return use_interrupt;
+}
+
+trigger_input_stats_t TriggerInput::get_stats() {
+	xSemaphoreTake(stats_lock, portMAX_DELAY);
+	trigger_input_stats_t out = stats;
+	xSemaphoreGive(stats_lock);
+
+	return out;
+}
+
+void IRAM_ATTR TriggerInput::_isr() {
+	edge_us = esp_timer_get_time();
+
+	BaseType_t woken = pdFALSE;
+	vTaskNotifyGiveFromISR(task, &woken);
+
+	if(woken)
+		portYIELD_FROM_ISR();
+}
+
+void TriggerInput::_task() {
+	const TickType_t idle_wait = pdMS_TO_TICKS(use_interrupt ? LZR_TRIGGER_FALLBACK_POLL_MS : LZR_TRIGGER_POLL_MS);
+	bool settle = false;
+
+	while(true) {
+		// Right after a debounce, the trigger is read once more to pick up
+		// where it settled
+		bool settling = settle;
+		settle = false;
+
+		bool edge = ulTaskNotifyTake(pdTRUE, settling ? 0 : idle_wait) > 0;
+		if(stopping)
+			break;
+		int64_t seen_us = edge ? edge_us : esp_timer_get_time();
+
+		bool now_pressed;
+		if(!read(now_pressed))
+			continue;
+
+		xSemaphoreTake(stats_lock, portMAX_DELAY);
+		if(edge)
+			stats.interrupts++;
+		else
+			stats.polls++;
+		if(!edge && !settling && use_interrupt && now_pressed != pressed)
+			stats.missed_edges++;
+		xSemaphoreGive(stats_lock);
+
+		if(now_pressed == pressed)
+			continue;
+
+		pressed = now_pressed;
+		handler.update_btn(pressed, seen_us);
+
+		vTaskDelay(pdMS_TO_TICKS(LZR_TRIGGER_DEBOUNCE_MS));
+		// Only throws away edges, a stop request is still seen above
+		ulTaskNotifyTake(pdTRUE, 0);
+		settle = true;
+	}
+
+	xSemaphoreGive(task_stopped);
+	vTaskDelete(nullptr);
+}
+
+} /* namespace LZR */
@@ -0,0 +1,90 @@
+/*
+ * hit_filter.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef LZRTAG_HIT_FILTER_H_
+#define LZRTAG_HIT_FILTER_H_
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include <stdint.h>
+
+// Hits that may be merging at the same time. Each shooter cycles through
+// four arbitration codes, so this covers two players firing at once.
+#define LZR_HIT_TABLE_SIZE 8
+
+namespace LZR {
+
+// A hit, and the frames of the same shot merged into it
+struct recent_hit_t {
+	uint8_t shooter_id;
+	uint8_t arb_code;
+	// Frames after the first
+	uint16_t repeats;
+
+	// Local time of the first frame, esp_timer_get_time
+	int64_t first_us;
+	// Mesh time of the first and last frame
+	int64_t first_mesh_us;
+	int64_t last_mesh_us;
+	// Timebase of both mesh times, 0 if either was taken while not synced,
+	// or the timebase changed in between
+	uint8_t mesh_timebase;
+};
+
+struct hit_filter_stats_t {
+	// Hit frames fed in
+	uint32_t frames;
+	// Hits handed out, with all their repeats
+	uint32_t hits;
+	// Frames merged into an earlier hit instead of being handed out
+	uint32_t frames_suppressed;
+	// Hits handed out before their window closed, as the table was full
+	uint32_t evictions;
+};
+
+// Merges hit frames with the same shooter and arbitration code, arriving
+// within the window after the first one, into a single hit.
+//
+// Beam weapons and reflections deliver the same frame many times over.
+// Instead of one event/ir_hit per frame, each shot is held for the window,
+// then handed out once, with the number of repeats and when the last one
+// arrived. The window is fixed from the first frame, so a (shooter, code)
+// pair also never causes more than one hit per window.
+//
+// feed() and pop_expired() may be called from different tasks.
+class HitFilter {
+private:
+	const int64_t window_us;
+
+	SemaphoreHandle_t lock;
+
+	recent_hit_t table[LZR_HIT_TABLE_SIZE];
+	bool used[LZR_HIT_TABLE_SIZE];
+
+	hit_filter_stats_t stats;
+
+public:
+	// A window of 0 hands out every frame right away
+	HitFilter(uint32_t window_ms);
+	~HitFilter();
+
+	// Adds a frame received at now_us, local time, and mesh_us, on the
+	// given mesh timebase.
+	// True if out holds a hit to send right away, either this one or one
+	// evicted to make room for it.
+	bool feed(uint8_t shooter_id, uint8_t arb_code, int64_t now_us, int64_t mesh_us, uint8_t mesh_timebase,
+			recent_hit_t &out);
+	// Takes out one hit whose window closed, false if there is none.
+	// Meant to be called in a loop every few ms.
+	bool pop_expired(int64_t now_us, recent_hit_t &out);
+
+	hit_filter_stats_t get_stats();
+};
+
+} /* namespace LZR */
+
+#endif /* LZRTAG_HIT_FILTER_H_ */
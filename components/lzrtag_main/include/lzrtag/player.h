@@ -13,8 +13,7 @@
 
 #include "lzrtag/animatorThread.h"
 #include "lzrtag/pattern_types.h"
-
-#include <cJSON.h>
+#include "lzrtag/player_state.h"
 
 namespace LZR {
 
@@ -40,10 +39,10 @@ private:
 
 	int 	currentGun;
 
-	cJSON * gun_ammo_info;
-
 	bool	shotLocked;
 
+	PlayerState state;
+
 public:
 	Xasin::Communication::CommHandler &comm_handler;
 
@@ -69,6 +68,7 @@ public:
 	bool can_shoot();
 	int  get_gun_num();
 	void set_gun_ammo(int32_t current, int32_t clipsize, int32_t total);
+	void set_gun_heat(float heat);
 
 	bool is_dead();
 	bool is_hit();
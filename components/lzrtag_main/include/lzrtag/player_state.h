@@ -0,0 +1,68 @@
+/*
+ * player_state.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef LZRTAG_PLAYER_STATE_H_
+#define LZRTAG_PLAYER_STATE_H_
+
+#include "freertos/FreeRTOS.h"
+#include "CommHandler.h"
+
+#include "lzrtag/wire_format.h"
+
+namespace LZR {
+
+// Everything about the player that changes during a game, published as
+// one retained get/state message instead of a topic per value.
+//
+// The setters are cheap enough to be called every animation tick, they
+// only mark what changed. tick() then publishes the collected changes at
+// most every CONFIG_LZR_STATE_PUBLISH_INTERVAL, except for transitions the
+// server needs to know about right away. Ammo changes also still go out,
+// retained, on get/ammo, for servers that only know the old topic.
+//
+// Not thread safe, all calls are expected from the animation task.
+class PlayerState {
+public:
+	enum dirty_flag_t : uint8_t {
+		DIRTY_AMMO   = 1,
+		DIRTY_HEAT   = 2,
+		DIRTY_WEAPON = 4,
+		DIRTY_DEAD   = 8,
+	};
+
+private:
+	Xasin::Communication::CommHandler &comm_handler;
+
+	Wire::player_state_t state;
+	// Heat at the last publish, changes are only counted in steps
+	uint8_t published_heat;
+
+	uint8_t dirty;
+	bool urgent;
+
+	TickType_t last_publish;
+
+public:
+	PlayerState(Xasin::Communication::CommHandler &comm_handler);
+
+	void set_ammo(int32_t current, int32_t clipsize, int32_t total);
+	void set_heat(float heat);
+	void set_weapon(uint8_t weapon);
+	void set_dead(bool dead);
+
+	// Publishes if anything changed and the interval has passed,
+	// or right away for urgent changes.
+	void tick();
+	// Publishes any changes right now
+	void flush();
+
+	uint8_t get_dirty() const;
+	const Wire::player_state_t &get() const;
+};
+
+} /* namespace LZR */
+
+#endif /* LZRTAG_PLAYER_STATE_H_ */
@@ -0,0 +1,85 @@
+/*
+ * trigger_input.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef LZRTAG_TRIGGER_INPUT_H_
+#define LZRTAG_TRIGGER_INPUT_H_
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "driver/gpio.h"
+#include "mcp23008_wrapper.h"
+
+#include "lzrtag/weapon/handler.h"
+
+// Trigger read interval without the INT line
+#define LZR_TRIGGER_POLL_MS 10
+// Read interval with the INT line, only to catch missed edges
+#define LZR_TRIGGER_FALLBACK_POLL_MS 200
+// Changes are ignored for this long after an edge, while the contacts
+// bounce. One tick at 100 Hz.
+#define LZR_TRIGGER_DEBOUNCE_MS 10
+
+namespace LZR {
+
+struct trigger_input_stats_t {
+	// Edges signalled on the INT line
+	uint32_t interrupts;
+	// Trigger reads without an edge
+	uint32_t polls;
+	// Changes only found by polling, despite the INT line
+	uint32_t missed_edges;
+	uint32_t read_errors;
+};
+
+// Reads the trigger on the gun MCP23008 and hands it to the weapon handler.
+//
+// With the MCP23008 INT pin wired to a GPIO, the expander raises it on any
+// trigger change, and the ISR wakes the trigger task, which reads the pin
+// right away and passes the time of the edge on. Otherwise, and as a
+// fallback, the trigger is polled over I2C.
+class TriggerInput {
+private:
+	LZRTag::Weapon::Handler &handler;
+	mcp23008_t &mcp;
+	const gpio_num_t int_pin;
+
+	bool use_interrupt;
+	TaskHandle_t task;
+	// Set to end the task, which gives task_stopped on its way out, so
+	// that it never goes away in the middle of an I2C read or holding
+	// stats_lock
+	volatile bool stopping;
+	SemaphoreHandle_t task_stopped;
+
+	// Set by the ISR, esp_timer_get_time
+	volatile int64_t edge_us;
+	bool pressed;
+
+	SemaphoreHandle_t stats_lock;
+	trigger_input_stats_t stats;
+
+	bool setup_interrupt();
+	bool read(bool &out);
+
+public:
+	// GPIO_NUM_NC for int_pin polls only
+	TriggerInput(LZRTag::Weapon::Handler &handler, mcp23008_t &mcp, gpio_num_t int_pin);
+	~TriggerInput();
+
+	void start();
+
+	bool uses_interrupt() const;
+	trigger_input_stats_t get_stats();
+
+	void _isr();
+	void _task();
+};
+
+} /* namespace LZR */
+
+#endif /* LZRTAG_TRIGGER_INPUT_H_ */
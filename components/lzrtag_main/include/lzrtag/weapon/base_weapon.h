@@ -28,6 +28,11 @@ protected:
     virtual void reload_start();
     virtual void reload_tick();
 
+    //! Pull this weapon's sounds into the audio cache.
+    //  Called by the handler while the weapon is being equipped,
+    //  so that shots do not have to wait for the SD card.
+    virtual void preload_sfx();
+
     void bump_shot_tick();
 
     /*! @brief Run the shot process
@@ -14,7 +14,7 @@ struct beam_weapon_config {
 
 	TickType_t beam_start_delay;
 
-	Xasin::Audio::bytecassette_data_t reload_sound;
+	Xasin::Audio::sound_id_t reload_sound;
 
 	Xasin::Audio::ByteCassetteCollection start_sounds;
 	Xasin::Audio::ByteCassetteCollection loop_sounds;
@@ -36,6 +36,8 @@ protected:
 	void reload_start();
 	void reload_tick();
 
+	void preload_sfx();
+
 	void shot_process();
 
 public:
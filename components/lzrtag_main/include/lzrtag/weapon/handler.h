@@ -3,6 +3,7 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 
 #include <xasin/audio/ByteCassette.h>
 #include "xasin/audio/ByteCassette.h"
@@ -14,8 +15,8 @@
 #include "xasin/xirr/Receiver.h"   // For Xasin::XIRR::Receiver
 #include "CommHandler.h"           // For Xasin::Communication::CommHandler and CommReceivedData
 #include "lzrtag/player.h"         // For LZR::Player
-#include "cJSON.h"                 // For cJSON operations
 #include "lzrtag/LZRConfig.h"      // For PIN_IR_OUT, PIN_IR_IN
+#include "lzrtag/hit_filter.h"
 
 namespace LZRTag {
 namespace Weapon {
@@ -33,6 +34,17 @@ struct ammo_info_t {
 	int32_t  total_ammo;
 };
 
+struct trigger_stats_t {
+	// Fresh presses seen by the weapon
+	uint32_t presses;
+
+	// From the trigger edge to shot_process seeing the press. Polled
+	// presses count from the poll that saw them.
+	uint32_t last_latency_us;
+	uint32_t average_latency_us;
+	uint32_t max_latency_us;
+};
+
 class BaseWeapon;
 
 class AudioSource {
@@ -72,6 +84,13 @@ friend BaseWeapon;
 	// "New" flag for the trigger button state. Allows weapons to only wait
 	// for the initial button press, and no re-trigger until the button is released.
 	bool trigger_state_read;
+	// When the trigger last changed, esp_timer_get_time
+	int64_t trigger_edge_us;
+
+	SemaphoreHandle_t trigger_stats_lock;
+	trigger_stats_t trigger_stats;
+
+	void count_trigger_press();
 
 	float gun_heat;
 
@@ -81,12 +100,19 @@ friend BaseWeapon;
     Xasin::Communication::CommHandler* comm_handler_;
     LZR::Player* player_; // Pointer to the player instance
 
+    // Shot frames for each arbitration code, encoded for the player ID in
+    // shot_frames_id_. -1 until first encoded.
+    Xasin::XIRR::tx_frame_t shot_frames_[4];
+    int shot_frames_id_;
+
+    // Received hits, held back to merge repeated frames of the same shot
+    LZR::HitFilter hit_filter_;
+
 public:
 	Handler(Xasin::Audio::TX & audio, Xasin::Communication::CommHandler* comm_handler, LZR::Player* player);
 	void _internal_run_thread();
 	void start_thread();
-	AudioSource* play(int sound_id);
-	AudioSource* play(const std::vector<int>& sound_ids);
+	AudioSource* play(Xasin::Audio::sound_id_t sfx);
 	AudioSource* play(const Xasin::Audio::ByteCassetteCollection& sfx);
 	AudioSource* play(const Xasin::Audio::bytecassette_data_t& sfx);
 
@@ -95,13 +121,15 @@ public:
 	wait_failure_t wait_ticks(TickType_t ticks);
 
 	void boop_thread();
-	void update_btn(bool new_button_state);
+	// edge_us is when the button changed, esp_timer_get_time, or -1 for now
+	void update_btn(bool new_button_state, int64_t edge_us = -1);
 	void fx_tick();
 	float get_gun_heat();
 	bool was_shot_tick();
 	TickType_t get_last_shot_tick();
 	std::function<void (void)> on_shot_func;
 	bool get_btn_state(bool only_fresh = false);
+	trigger_stats_t get_trigger_stats();
 	bool can_shoot();
 	std::function<bool (void)> can_shoot_func;
 	bool infinite_clips();
@@ -116,7 +144,11 @@ public:
     void init_ir_system();
     void shutdown_ir_system(); 
     void send_ir_signal(int8_t cCode = -1); 
-    void send_ir_hit_event(uint8_t pID, uint8_t arbCode);
+    // Publishes hits whose merge window has closed, call every few ms
+    void ir_tick();
+    void send_ir_hit_event(const LZR::recent_hit_t &hit);
+    Xasin::XIRR::tx_stats_t get_ir_tx_stats();
+    LZR::hit_filter_stats_t get_ir_hit_stats();
 
 };
 
@@ -15,7 +15,7 @@ struct heavy_weapon_config {
 	int32_t equip_time;
 	int32_t reload_time;
 
-	Xasin::Audio::bytecassette_data_t reload_sfx;
+	Xasin::Audio::sound_id_t reload_sfx;
 
 	Xasin::Audio::ByteCassetteCollection start_sfx;
 	Xasin::Audio::ByteCassetteCollection shot_sfx;
@@ -38,6 +38,8 @@ friend Handler;
 	void reload_start();
 	void reload_tick();
 
+	void preload_sfx();
+
 	void shot_process();
 
 public:
@@ -1,68 +1,64 @@
 #include "weapon.h"
 #include "xasin/audio/ByteCassette.h"
 
-#define WEAPON_CASSETTE(path) XASAUDIO_CASSETTE("DEI/lzrtag-sfx/" path, DEFAULT_SAMPLERATE, DEFAULT_VOLUME)
-
-
-// Example samplerate and volume - adjust as needed
-#define DEFAULT_SAMPLERATE 441000
-#define DEFAULT_VOLUME 255
+// Generated at build time from lzrtag-sfx by mksoundbank.py
+#include "lzrtag/sfx_ids.h"
 
 static const Xasin::Audio::ByteCassetteCollection collection_SCALPEL_V9_end = {
-    WEAPON_CASSETTE("SCALPEL-V9/SCALPEL_V9_shot_1_end.wav"),
-    WEAPON_CASSETTE("SCALPEL-V9/SCALPEL_V9_shot_3_end.wav"),
-    WEAPON_CASSETTE("SCALPEL-V9/SCALPEL_V9_shot_4_end.wav"),
-    WEAPON_CASSETTE("SCALPEL-V9/SCALPEL_V9_shot_5_end.wav")
+    LZR::SFX::SCALPEL_V9_SHOT_1_END,
+    LZR::SFX::SCALPEL_V9_SHOT_3_END,
+    LZR::SFX::SCALPEL_V9_SHOT_4_END,
+    LZR::SFX::SCALPEL_V9_SHOT_5_END
 };
 
 static const Xasin::Audio::ByteCassetteCollection collection_SCALPEL_V9_start = {
-    WEAPON_CASSETTE("SCALPEL-V9/SCALPEL_V9_shot_1_start.wav"),
-    WEAPON_CASSETTE("SCALPEL-V9/SCALPEL_V9_shot_3_start.wav"),
-    WEAPON_CASSETTE("SCALPEL-V9/SCALPEL_V9_shot_4_start.wav"),
-    WEAPON_CASSETTE("SCALPEL-V9/SCALPEL_V9_shot_5_start.wav")
+    LZR::SFX::SCALPEL_V9_SHOT_1_START,
+    LZR::SFX::SCALPEL_V9_SHOT_3_START,
+    LZR::SFX::SCALPEL_V9_SHOT_4_START,
+    LZR::SFX::SCALPEL_V9_SHOT_5_START
 };
 
 static const Xasin::Audio::ByteCassetteCollection collection_SCALPEL_V9_loop = {
-    WEAPON_CASSETTE("SCALPEL-V9/SCALPEL_V9_shot_1_loop.wav"),
-    WEAPON_CASSETTE("SCALPEL-V9/SCALPEL_V9_shot_3_loop.wav"),
-    WEAPON_CASSETTE("SCALPEL-V9/SCALPEL_V9_shot_4_loop.wav"),
-    WEAPON_CASSETTE("SCALPEL-V9/SCALPEL_V9_shot_5_loop.wav")
+    LZR::SFX::SCALPEL_V9_SHOT_1_LOOP,
+    LZR::SFX::SCALPEL_V9_SHOT_3_LOOP,
+    LZR::SFX::SCALPEL_V9_SHOT_4_LOOP,
+    LZR::SFX::SCALPEL_V9_SHOT_5_LOOP
 };
 
 static const LZRTag::Weapon::beam_weapon_config scalpel_cfg = {
     6000, 0, 1500,
-    WEAPON_CASSETTE("RELOADING/Large_EnergyGun_reload_3.wav"),
+    LZR::SFX::LARGE_ENERGY_GUN_RELOAD_3,
     collection_SCALPEL_V9_start, collection_SCALPEL_V9_loop, collection_SCALPEL_V9_end,
 };
 
 static const Xasin::Audio::ByteCassetteCollection collection_FN_001_WHIP = {
-    WEAPON_CASSETTE("FN-001-WHIP/FN-001-WHIP_shot_1.wav"),
-    WEAPON_CASSETTE("FN-001-WHIP/FN-001-WHIP_shot_2.wav"),
-    WEAPON_CASSETTE("FN-001-WHIP/FN-001-WHIP_shot_3.wav"),
-    WEAPON_CASSETTE("FN-001-WHIP/FN-001-WHIP_shot_4.wav"),
-    WEAPON_CASSETTE("FN-001-WHIP/FN-001-WHIP_shot_5.wav"),
-    WEAPON_CASSETTE("FN-001-WHIP/FN-001-WHIP_shot_6.wav"),
-    WEAPON_CASSETTE("FN-001-WHIP/FN-001-WHIP_shot_7.wav"),
-    WEAPON_CASSETTE("FN-001-WHIP/FN-001-WHIP_shot_8.wav"),
-    WEAPON_CASSETTE("FN-001-WHIP/FN-001-WHIP_shot_9.wav"),
-    WEAPON_CASSETTE("FN-001-WHIP/FN-001-WHIP_shot_10.wav")
+    LZR::SFX::FN_001_WHIP_SHOT_1,
+    LZR::SFX::FN_001_WHIP_SHOT_2,
+    LZR::SFX::FN_001_WHIP_SHOT_3,
+    LZR::SFX::FN_001_WHIP_SHOT_4,
+    LZR::SFX::FN_001_WHIP_SHOT_5,
+    LZR::SFX::FN_001_WHIP_SHOT_6,
+    LZR::SFX::FN_001_WHIP_SHOT_7,
+    LZR::SFX::FN_001_WHIP_SHOT_8,
+    LZR::SFX::FN_001_WHIP_SHOT_9,
+    LZR::SFX::FN_001_WHIP_SHOT_10
 };
 
 static const LZRTag::Weapon::shot_weapon_config colibri_config = {
     12, 24,
     1000, 4000,
     
-    WEAPON_CASSETTE("RELOADING/RELOADING_3_Laser_pistol_heavy_3.wav"),
+    LZR::SFX::RELOADING_3_LASER_PISTOL_HEAVY_3,
     collection_FN_001_WHIP,
     170, 2, 150, true
 };
 
 static const Xasin::Audio::ByteCassetteCollection collection_COLIBRI_M2 = {
-    WEAPON_CASSETTE("COLIBRI M2/COLIBRI_M2_shot_1.wav"),
-    WEAPON_CASSETTE("COLIBRI M2/COLIBRI_M2_shot_2.wav"),
-    WEAPON_CASSETTE("COLIBRI M2/COLIBRI_M2_shot_3.wav"),
-    WEAPON_CASSETTE("COLIBRI M2/COLIBRI_M2_shot_4.wav"),
-    WEAPON_CASSETTE("COLIBRI M2/COLIBRI_M2_shot_5.wav")
+    LZR::SFX::COLIBRI_M2_SHOT_1,
+    LZR::SFX::COLIBRI_M2_SHOT_2,
+    LZR::SFX::COLIBRI_M2_SHOT_3,
+    LZR::SFX::COLIBRI_M2_SHOT_4,
+    LZR::SFX::COLIBRI_M2_SHOT_5
 };
 
 static const LZRTag::Weapon::shot_weapon_config whip_config = {
@@ -70,23 +66,23 @@ static const LZRTag::Weapon::shot_weapon_config whip_config = {
 
     2500, 3500,
 
-    WEAPON_CASSETTE("RELOADING/RELOADING_3_Assault_rifle_med_1.wav"),
+    LZR::SFX::RELOADING_3_ASSAULT_RIFLE_MED_1,
     collection_COLIBRI_M2,
 
     130, 0, 0, false
 };
 
 static const Xasin::Audio::ByteCassetteCollection collection_DP_116_STEELFINGER = {
-    WEAPON_CASSETTE("DP-116-STEELFINGER/DP-116-STEELFINGER_shot_1.wav"),
-    WEAPON_CASSETTE("DP-116-STEELFINGER/DP-116-STEELFINGER_shot_2.wav"),
-    WEAPON_CASSETTE("DP-116-STEELFINGER/DP-116-STEELFINGER_shot_3.wav"),
-    WEAPON_CASSETTE("DP-116-STEELFINGER/DP-116-STEELFINGER_shot_4.wav"),
-    WEAPON_CASSETTE("DP-116-STEELFINGER/DP-116-STEELFINGER_shot_5.wav"),
-    WEAPON_CASSETTE("DP-116-STEELFINGER/DP-116-STEELFINGER_shot_6.wav"),
-    WEAPON_CASSETTE("DP-116-STEELFINGER/DP-116-STEELFINGER_shot_7.wav"),
-    WEAPON_CASSETTE("DP-116-STEELFINGER/DP-116-STEELFINGER_shot_8.wav"),
-    WEAPON_CASSETTE("DP-116-STEELFINGER/DP-116-STEELFINGER_shot_9.wav"),
-    WEAPON_CASSETTE("DP-116-STEELFINGER/DP-116-STEELFINGER_shot_10.wav")
+    LZR::SFX::DP_116_STEELFINGER_SHOT_1,
+    LZR::SFX::DP_116_STEELFINGER_SHOT_2,
+    LZR::SFX::DP_116_STEELFINGER_SHOT_3,
+    LZR::SFX::DP_116_STEELFINGER_SHOT_4,
+    LZR::SFX::DP_116_STEELFINGER_SHOT_5,
+    LZR::SFX::DP_116_STEELFINGER_SHOT_6,
+    LZR::SFX::DP_116_STEELFINGER_SHOT_7,
+    LZR::SFX::DP_116_STEELFINGER_SHOT_8,
+    LZR::SFX::DP_116_STEELFINGER_SHOT_9,
+    LZR::SFX::DP_116_STEELFINGER_SHOT_10
 };
 
 static const LZRTag::Weapon::shot_weapon_config steelfinger_config = {
@@ -94,23 +90,23 @@ static const LZRTag::Weapon::shot_weapon_config steelfinger_config = {
 
     2500, 3500,
 
-    WEAPON_CASSETTE("RELOADING/RELOADING_3_Laser_rifle_heavy_1.wav"),
+    LZR::SFX::RELOADING_3_LASER_RIFLE_HEAVY_1,
     collection_DP_116_STEELFINGER,
     250, 0, 0, false
 };
 
 static const Xasin::Audio::ByteCassetteCollection collection_SW_554 = {
-    WEAPON_CASSETTE("SW-554/SW-554_shot_1.wav"),
-    WEAPON_CASSETTE("SW-554/SW-554_shot_2.wav"),
-    WEAPON_CASSETTE("SW-554/SW-554_shot_3.wav"),
-    WEAPON_CASSETTE("SW-554/SW-554_shot_4.wav"),
-    WEAPON_CASSETTE("SW-554/SW-554_shot_5.wav"),
-    WEAPON_CASSETTE("SW-554/SW-554_shot_6.wav"),
-    WEAPON_CASSETTE("SW-554/SW-554_shot_7.wav"),
-    WEAPON_CASSETTE("SW-554/SW-554_shot_8.wav"),
-    WEAPON_CASSETTE("SW-554/SW-554_shot_9.wav"),
-    WEAPON_CASSETTE("SW-554/SW-554_shot_10.wav"),
-    WEAPON_CASSETTE("SW-554/SW-554_shot_11.wav")
+    LZR::SFX::SW_554M1_SHOT_01,
+    LZR::SFX::SW_554M1_SHOT_02,
+    LZR::SFX::SW_554M1_SHOT_03,
+    LZR::SFX::SW_554M1_SHOT_04,
+    LZR::SFX::SW_554M1_SHOT_05,
+    LZR::SFX::SW_554M1_SHOT_06,
+    LZR::SFX::SW_554M1_SHOT_07,
+    LZR::SFX::SW_554M1_SHOT_08,
+    LZR::SFX::SW_554M1_SHOT_09,
+    LZR::SFX::SW_554M1_SHOT_10,
+    LZR::SFX::SW_554M1_SHOT_11
 };
 
 static const LZRTag::Weapon::shot_weapon_config sw_554_config = {
@@ -118,30 +114,30 @@ static const LZRTag::Weapon::shot_weapon_config sw_554_config = {
 
     2500, 3500,
 
-    WEAPON_CASSETTE("RELOADING/RELOADING_3_Sniper_rifle_light_1.wav"),
+    LZR::SFX::RELOADING_3_SNIPER_RIFLE_LIGHT_1,
     collection_SW_554,
 
     1000, 0, 0, true
 };
 
 static const Xasin::Audio::ByteCassetteCollection collection_NICO_6 = {
-    WEAPON_CASSETTE("NICO-6/NICO-6_shot_clean_1.wav"),
-    WEAPON_CASSETTE("NICO-6/NICO-6_shot_clean_2.wav"),
-    WEAPON_CASSETTE("NICO-6/NICO-6_shot_clean_3.wav"),
-    WEAPON_CASSETTE("NICO-6/NICO-6_shot_clean_5.wav"),
-    WEAPON_CASSETTE("NICO-6/NICO-6_shot_clean_6.wav"),
-    WEAPON_CASSETTE("NICO-6/NICO-6_shot_clean_7.wav"),
-    WEAPON_CASSETTE("NICO-6/NICO-6_shot_clean_8.wav"),
-    WEAPON_CASSETTE("NICO-6/NICO-6_shot_clean_10.wav"),
-    WEAPON_CASSETTE("NICO-6/NICO-6_shot_clean_11.wav"),
-    WEAPON_CASSETTE("NICO-6/NICO-6_shot_clean_12.wav")
+    LZR::SFX::NICO_6_SHOT_CLEAN_1,
+    LZR::SFX::NICO_6_SHOT_CLEAN_2,
+    LZR::SFX::NICO_6_SHOT_CLEAN_3,
+    LZR::SFX::NICO_6_SHOT_CLEAN_5,
+    LZR::SFX::NICO_6_SHOT_CLEAN_6,
+    LZR::SFX::NICO_6_SHOT_CLEAN_7,
+    LZR::SFX::NICO_6_SHOT_CLEAN_8,
+    LZR::SFX::NICO_6_SHOT_CLEAN_10,
+    LZR::SFX::NICO_6_SHOT_CLEAN_11,
+    LZR::SFX::NICO_6_SHOT_CLEAN_12
 };
 
 static const Xasin::Audio::ByteCassetteCollection collection_NICO_6_charge = {
-    WEAPON_CASSETTE("NICO-6/charge/NICO-6_shot_1.wav"),
-    WEAPON_CASSETTE("NICO-6/charge/NICO-6_shot_2.wav"),
-    WEAPON_CASSETTE("NICO-6/charge/NICO-6_shot_3.wav"),
-    WEAPON_CASSETTE("NICO-6/charge/NICO-6_shot_4.wav")
+    LZR::SFX::NICO_6_SHOT_1,
+    LZR::SFX::NICO_6_SHOT_2,
+    LZR::SFX::NICO_6_SHOT_3,
+    LZR::SFX::NICO_6_SHOT_4
 };
 
 static const LZRTag::Weapon::heavy_weapon_config nico_6_config = {
@@ -149,7 +145,7 @@ static const LZRTag::Weapon::heavy_weapon_config nico_6_config = {
 
     3500, 3500,
 
-    WEAPON_CASSETTE("RELOADING/RELOADING_2_large_2.wav"),
+    LZR::SFX::RELOADING_2_LARGE_2,
     collection_NICO_6_charge,
     collection_NICO_6,
 
@@ -0,0 +1,155 @@
+/*
+ * wire_format.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef LZRTAG_WIRE_FORMAT_H_
+#define LZRTAG_WIRE_FORMAT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string_view>
+
+// Encoding of the high frequency game messages.
+//
+// Every message can be sent either as JSON, which the existing game server
+// understands, or in a fixed layout binary format. The server switches a
+// device over by publishing "binary" to its retained get/wire_format topic,
+// either bare or as a JSON string.
+// Decoders accept both, telling them apart by the first byte.
+//
+// Binary messages start with a schema header, all values little endian:
+//   u8 0x00 (never the start of JSON), u8 schema version,
+//   u8 message type, u8 payload length
+// Newer schema versions only ever append fields, so decoders accept
+// longer payloads than they know about, and fill fields missing from
+// older ones with 0.
+//
+// Version 2 appended the mesh time to hits and player state.
+// Version 3 appended the repeat count and time of the last merged frame to
+// hits.
+// Version 4 appended the mesh timebase to hits and player state.
+//
+// Nothing in here allocates, all encoders write into a caller buffer.
+#define LZR_WIRE_MARKER 0x00
+#define LZR_WIRE_VERSION 4
+#define LZR_WIRE_HEADER_SIZE 4
+
+namespace LZR {
+namespace Wire {
+
+enum format_t : uint8_t {
+	JSON,
+	BINARY,
+};
+
+// Format used by the encoders unless told otherwise
+extern format_t output_format;
+
+enum message_type_t : uint8_t {
+	MSG_IR_HIT = 1,
+	MSG_AMMO,
+	MSG_PING_REPLY,
+	MSG_CONFIG_VALUE,
+	MSG_PLAYER_STATE,
+};
+
+// event/ir_hit
+struct ir_hit_t {
+	uint8_t shooter_id;
+	uint8_t arb_code;
+	uint8_t target_mac[6];
+	// When the hit was received, in mesh time (µs), common to all players
+	int64_t mesh_time_us;
+	// Further frames of the same shot merged into this hit, i.e. reflections
+	// or a beam weapon, and when the last of them was received.
+	// Decoded from older messages as 0, and the time of the hit.
+	uint16_t repeats;
+	int64_t last_mesh_time_us;
+	// The root timebase both times are on, 0 if the device was not synced
+	// and they are only its local clock. Times are only comparable between
+	// messages with the same, non-zero timebase.
+	uint8_t mesh_timebase;
+};
+
+// get/ammo
+struct ammo_t {
+	int32_t current;
+	int32_t clipsize;
+	int32_t total;
+
+	bool operator==(const ammo_t &other) const {
+		return current == other.current && clipsize == other.clipsize && total == other.total;
+	}
+};
+
+// get/_ping
+struct ping_reply_t {
+	uint32_t battery_mv;
+	uint8_t  battery_percentage;
+	bool     has_ping_ticks;
+	uint32_t ping_ticks;
+	uint32_t heap;
+};
+
+// get/state, everything about the player that changes during a game
+struct player_state_t {
+	ammo_t  ammo;
+	// Gun heat, 0 to 255
+	uint8_t heat;
+	// Gun number as set by get/gun_config, 0 for none
+	uint8_t weapon;
+	bool    dead;
+	// When this snapshot was taken, in mesh time (µs)
+	int64_t mesh_time_us;
+	// As for ir_hit_t
+	uint8_t mesh_timebase;
+};
+
+// The player config topics below get/, like get/team or get/dead
+struct config_value_t {
+	enum kind_t : uint8_t {
+		VALUE_NONE,
+		VALUE_FALSE,
+		VALUE_TRUE,
+		VALUE_NUMBER,
+		VALUE_STRING,
+	} kind;
+
+	int32_t number;
+	// Only for VALUE_STRING, which only exists as JSON. Points into the decoded
+	// payload, with any escape sequences left as they are.
+	std::string_view string;
+
+	bool is_true() const { return kind == VALUE_TRUE; }
+	bool is_false() const { return kind == VALUE_FALSE; }
+	// Same as cJSON's valueint: 0 for anything but numbers
+	int32_t value_int() const { return kind == VALUE_NUMBER ? number : 0; }
+};
+
+// Reads the payload of get/wire_format. Anything but "binary", bare or
+// quoted, selects JSON, as does an empty payload.
+format_t decode_format(const void *data, size_t length);
+
+// All encoders return the encoded length, or 0 if the buffer was too small.
+size_t encode(const ir_hit_t &msg, char *buffer, size_t size, format_t format = output_format);
+size_t encode(const ammo_t &msg, char *buffer, size_t size, format_t format = output_format);
+size_t encode(const ping_reply_t &msg, char *buffer, size_t size, format_t format = output_format);
+size_t encode(const player_state_t &msg, char *buffer, size_t size, format_t format = output_format);
+size_t encode(const config_value_t &msg, char *buffer, size_t size, format_t format = output_format);
+
+// Decoders return false for malformed messages, or messages of another type.
+// The outgoing messages can only be decoded from their binary form.
+bool decode(const void *data, size_t length, ir_hit_t &out);
+bool decode(const void *data, size_t length, ammo_t &out);
+bool decode(const void *data, size_t length, ping_reply_t &out);
+bool decode(const void *data, size_t length, player_state_t &out);
+// Accepts JSON scalars as well. An empty payload decodes to VALUE_NONE,
+// same as a cleared retained topic.
+bool decode(const void *data, size_t length, config_value_t &out);
+
+} /* namespace Wire */
+} /* namespace LZR */
+
+#endif /* LZRTAG_WIRE_FORMAT_H_ */
@@ -0,0 +1,138 @@
+/*
+ * TXStreamSimulation.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "TXStreamSimulation.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#define FRAME_US (CONFIG_XASAUDIO_TX_FRAMELENGTH * 1000)
+
+namespace Xasin {
+namespace Audio {
+
+namespace {
+
+// A TXStream on the simulation's clock, with frames pulled by hand
+class SimulatedStream : public TXStream {
+public:
+	int64_t clock;
+
+	SimulatedStream(TX &handler) : TXStream(handler), clock(0) {}
+
+	int64_t now_us() override {
+		return clock;
+	}
+
+	bool pull_frame() {
+		return process_frame();
+	}
+};
+
+struct arrival_t {
+	int64_t time_us;
+	uint16_t first_sequence;
+};
+
+}
+
+TXStreamSimulation::TXStreamSimulation(const tx_stream_simulation_config_t &config)
+	: config(config) {
+}
+
+tx_stream_simulation_report_t TXStreamSimulation::run() {
+	tx_stream_simulation_report_t report = {};
+
+	std::mt19937 random(config.seed);
+	std::uniform_real_distribution<float> chance(0, 1);
+	std::exponential_distribution<double> jitter(1.0 / std::max<uint32_t>(config.jitter_us, 1));
+
+	// The stream takes 0 as "nothing arrived yet"
+	const int64_t start = 1000000;
+	const int64_t end = start + int64_t(config.duration_ms) * 1000;
+	const int64_t batch_us = int64_t(config.batch_packets) * FRAME_US;
+
+	std::vector<arrival_t> arrivals;
+	uint16_t sequence = 0;
+	for(int64_t sent = start; sent < end; sent += batch_us) {
+		report.batches_sent++;
+
+		double delay = config.delay_us + jitter(random);
+		if(chance(random) < config.spike_probability)
+			delay += config.spike_us * chance(random);
+
+		if(chance(random) < config.loss_probability)
+			report.batches_lost++;
+		else
+			arrivals.push_back({ sent + int64_t(delay), sequence });
+
+		sequence += config.batch_packets;
+	}
+
+	std::stable_sort(arrivals.begin(), arrivals.end(),
+		[](const arrival_t &a, const arrival_t &b) { return a.time_us < b.time_us; });
+
+	// Every packet a flat, valid ADPCM frame
+	std::vector<uint8_t> message(3 + config.batch_packets * XASAUDIO_TX_STREAM_MAX_PACKETSIZE, 0);
+	for(uint8_t i = 0; i < config.batch_packets; i++)
+		message[3 + i * XASAUDIO_TX_STREAM_MAX_PACKETSIZE + 1] = 0x04;
+	message[2] = config.batch_packets;
+
+	TX handler;
+	SimulatedStream stream(handler);
+
+	auto next = arrivals.begin();
+	bool started = false;
+	uint64_t depth_sum = 0;
+
+	for(int64_t now = start; now < end; now += FRAME_US) {
+		for(; next != arrivals.end() && next->time_us <= now; next++) {
+			stream.clock = next->time_us;
+			message[0] = next->first_sequence & 0xFF;
+			message[1] = next->first_sequence >> 8;
+			stream.feed_message(message.data(), message.size());
+		}
+
+		stream.clock = now;
+		bool played = stream.pull_frame();
+
+		if(played && !started) {
+			started = true;
+			report.startup_ms = (now - start) / 1000;
+		}
+		if(!started)
+			continue;
+
+		report.frames_requested++;
+		if(!played)
+			report.frames_silent++;
+		depth_sum += stream.get_stats().depth;
+	}
+
+	report.stream = stream.get_stats();
+	if(report.frames_requested > 0)
+		report.average_depth_ms = float(depth_sum) * CONFIG_XASAUDIO_TX_FRAMELENGTH / report.frames_requested;
+
+	return report;
+}
+
+void TXStreamSimulation::print_report(const tx_stream_simulation_report_t &report) {
+	const tx_stream_stats_t &stream = report.stream;
+
+	printf("TX stream: %u batches, %u lost in transit, started after %ums, %.0fms average depth\n",
+		unsigned(report.batches_sent), unsigned(report.batches_lost),
+		unsigned(report.startup_ms), report.average_depth_ms);
+	printf("  Packets %u received, %u late, %u lost; %u frames concealed, %u underruns, %u/%u frames silent\n",
+		unsigned(stream.packets_received), unsigned(stream.packets_late), unsigned(stream.packets_lost),
+		unsigned(stream.frames_concealed), unsigned(stream.underruns),
+		unsigned(report.frames_silent), unsigned(report.frames_requested));
+	printf("  Jitter %uus, target depth %u frames\n", unsigned(stream.jitter_us), unsigned(stream.target_depth));
+}
+
+} /* namespace Audio */
+} /* namespace Xasin */
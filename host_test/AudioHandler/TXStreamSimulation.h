@@ -0,0 +1,73 @@
+/*
+ * TXStreamSimulation.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_AUDIOHANDLER_TXSTREAMSIMULATION_H_
+#define ESP32_AUDIOHANDLER_TXSTREAMSIMULATION_H_
+
+#include "xasin/audio/TXStream.h"
+
+#include <stdint.h>
+
+namespace Xasin {
+namespace Audio {
+
+struct tx_stream_simulation_config_t {
+	uint32_t duration_ms = 60000;
+
+	// Packets per voice_stream message, as the server batches them
+	uint8_t batch_packets = 3;
+
+	// One way delay: base + exponentially distributed jitter, plus
+	// occasional long stalls while the mesh is busy
+	uint32_t delay_us = 5000;
+	uint32_t jitter_us = 8000;
+	float spike_probability = 0.02F;
+	uint32_t spike_us = 120000;
+	// Whole batches that never arrive
+	float loss_probability = 0.01F;
+
+	uint32_t seed = 1;
+};
+
+struct tx_stream_simulation_report_t {
+	uint32_t batches_sent;
+	uint32_t batches_lost;
+
+	// Frames the TX asked for once playback first started, and those
+	// the stream had nothing for, not even concealment
+	uint32_t frames_requested;
+	uint32_t frames_silent;
+
+	// From the first packet sent to the first frame played
+	uint32_t startup_ms;
+	// Average buffer depth while playing, i.e. the added latency
+	float average_depth_ms;
+
+	tx_stream_stats_t stream;
+};
+
+// Replays a jittery packet trace into a TXStream, on a virtual timeline.
+// Batches are sent at the pace of the audio, arrive after the simulated
+// delay, possibly out of order, and are fed in as the voice_stream
+// subscription would. Frames are pulled at the TX's frame rate.
+//
+// Runs in virtual time, so a minute of audio takes a few ms on the host.
+class TXStreamSimulation {
+private:
+	const tx_stream_simulation_config_t config;
+
+public:
+	TXStreamSimulation(const tx_stream_simulation_config_t &config);
+
+	tx_stream_simulation_report_t run();
+
+	static void print_report(const tx_stream_simulation_report_t &report);
+};
+
+} /* namespace Audio */
+} /* namespace Xasin */
+
+#endif /* ESP32_AUDIOHANDLER_TXSTREAMSIMULATION_H_ */
@@ -0,0 +1,136 @@
+/*
+ * WavFileSink.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "WavFileSink.h"
+
+#include "esp_timer.h"
+
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#define FRAME_US (CONFIG_XASAUDIO_TX_FRAMELENGTH * 1000)
+
+namespace Xasin {
+namespace Audio {
+
+namespace {
+
+void put_u16(uint8_t *out, uint16_t value) {
+	out[0] = value;
+	out[1] = value >> 8;
+}
+void put_u32(uint8_t *out, uint32_t value) {
+	put_u16(out, value);
+	put_u16(out + 2, value >> 16);
+}
+
+}
+
+WavFileSink::WavFileSink(const std::string &path)
+	: path(path), file(nullptr),
+	  lock(), stats(),
+	  running(false), start_us(0), played_until_us(0) {
+}
+
+WavFileSink::~WavFileSink() {
+	close();
+}
+
+void WavFileSink::write_header(uint32_t data_bytes) {
+	uint8_t header[44] = { 'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+		'f', 'm', 't', ' ', 16, 0, 0, 0,  1, 0,  1, 0 };
+
+	put_u32(header + 4, 36 + data_bytes);
+	put_u32(header + 24, CONFIG_XASAUDIO_TX_SAMPLERATE);
+	put_u32(header + 28, CONFIG_XASAUDIO_TX_SAMPLERATE * sizeof(int16_t));
+	put_u16(header + 32, sizeof(int16_t));
+	put_u16(header + 34, 16);
+	memcpy(header + 36, "data", 4);
+	put_u32(header + 40, data_bytes);
+
+	fseek(file, 0, SEEK_SET);
+	fwrite(header, sizeof(header), 1, file);
+}
+
+void WavFileSink::init() {
+	std::lock_guard<std::mutex> guard(lock);
+
+	file = fopen(path.c_str(), "wb");
+	if(file == nullptr) {
+		fprintf(stderr, "Could not open %s\n", path.c_str());
+		return;
+	}
+
+	// Sizes are filled in by close()
+	write_header(0);
+}
+
+void WavFileSink::write_frame(const int16_t *data) {
+	int64_t wait_until;
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		stats.frames_written++;
+		if(!running)
+			stats.frames_while_stopped++;
+
+		// WAV is little endian, as is every host this runs on
+		if(file != nullptr)
+			fwrite(data, sizeof(int16_t), XASAUDIO_TX_FRAME_SAMPLE_NO, file);
+
+		int64_t now = esp_timer_get_time();
+		if(running && now > played_until_us && played_until_us > start_us) {
+			stats.underruns++;
+			stats.max_late_us = std::max<uint32_t>(stats.max_late_us, now - played_until_us);
+		}
+
+		played_until_us = std::max(played_until_us, now) + FRAME_US;
+		wait_until = played_until_us - int64_t(CONFIG_XASAUDIO_TX_DMA_COUNT) * FRAME_US;
+	}
+
+	int64_t wait_us = wait_until - esp_timer_get_time();
+	if(wait_us > 0)
+		std::this_thread::sleep_for(std::chrono::microseconds(wait_us));
+}
+
+void WavFileSink::start() {
+	std::lock_guard<std::mutex> guard(lock);
+
+	stats.starts++;
+	running = true;
+	start_us = esp_timer_get_time();
+	played_until_us = start_us;
+}
+
+void WavFileSink::stop() {
+	std::lock_guard<std::mutex> guard(lock);
+
+	stats.stops++;
+	running = false;
+	stats.last_playback_us = esp_timer_get_time() - start_us;
+}
+
+void WavFileSink::close() {
+	std::lock_guard<std::mutex> guard(lock);
+
+	if(file == nullptr)
+		return;
+
+	write_header(stats.frames_written * XASAUDIO_TX_FRAME_SAMPLE_NO * sizeof(int16_t));
+	fclose(file);
+	file = nullptr;
+}
+
+wav_file_sink_stats_t WavFileSink::get_stats() {
+	std::lock_guard<std::mutex> guard(lock);
+	return stats;
+}
+
+} /* namespace Audio */
+} /* namespace Xasin */
@@ -0,0 +1,76 @@
+/*
+ * WavFileSink.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_AUDIOHANDLER_WAVFILESINK_H_
+#define ESP32_AUDIOHANDLER_WAVFILESINK_H_
+
+#include "xasin/audio/AudioTX.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <mutex>
+#include <string>
+
+namespace Xasin {
+namespace Audio {
+
+struct wav_file_sink_stats_t {
+	uint32_t frames_written;
+	// Frames handed over while stopped, which the I2S DMA would not play
+	uint32_t frames_while_stopped;
+
+	uint32_t starts;
+	uint32_t stops;
+
+	// Frames that arrived after the DMA buffers had run dry, and by how
+	// much the latest one was late
+	uint32_t underruns;
+	uint32_t max_late_us;
+
+	// Time from start() to stop(), of the last playback
+	int64_t last_playback_us;
+};
+
+// Writes the TX output into a 16 bit mono WAV file, and paces
+// write_frame() like the I2S DMA does: the first
+// CONFIG_XASAUDIO_TX_DMA_COUNT frames after start() fill the buffers,
+// every further one blocks until a buffer has been played out.
+// Frames that come too late to keep the buffers filled are counted as
+// underruns.
+class WavFileSink : public OutputSink {
+private:
+	const std::string path;
+	FILE *file;
+
+	std::mutex lock;
+	wav_file_sink_stats_t stats;
+
+	bool running;
+	int64_t start_us;
+	// When the frames handed over so far will have been played out
+	int64_t played_until_us;
+
+	void write_header(uint32_t data_bytes);
+
+public:
+	WavFileSink(const std::string &path);
+	~WavFileSink();
+
+	void init() override;
+	void write_frame(const int16_t *data) override;
+	void start() override;
+	void stop() override;
+
+	// Fills in the sizes of the WAV header and closes the file
+	void close();
+
+	wav_file_sink_stats_t get_stats();
+};
+
+} /* namespace Audio */
+} /* namespace Xasin */
+
+#endif /* ESP32_AUDIOHANDLER_WAVFILESINK_H_ */
@@ -0,0 +1,234 @@
+// LoadGenerator.cpp
+#include "LoadGenerator.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace Xasin {
+namespace Communication {
+
+static const std::string HIT_TOPIC = "event/ir_hit";
+static const std::string PING_TOPIC = "ping_signal";
+static const char *const CONFIG_KEYS[] = { "team", "dead", "gun_config", "heartbeat" };
+
+static uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Latency since the timestamp at the start of the payload
+static void record_latency(std::vector<uint32_t> &latencies, const void *data, size_t length) {
+    uint64_t sent;
+    if (length < sizeof(sent)) {
+        return;
+    }
+
+    memcpy(&sent, data, sizeof(sent));
+    latencies.push_back(std::min<uint64_t>(now_ns() - sent, UINT32_MAX));
+}
+
+static load_latency_t summarize(std::vector<uint32_t> &latencies) {
+    load_latency_t out = {};
+    out.count = latencies.size();
+    if (latencies.empty()) {
+        return out;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    auto percentile = [&](float p) {
+        size_t index = std::min<size_t>(latencies.size() * p, latencies.size() - 1);
+        return latencies[index] / 1000.0F;
+    };
+
+    out.p50 = percentile(0.50);
+    out.p90 = percentile(0.90);
+    out.p99 = percentile(0.99);
+    out.max = latencies.back() / 1000.0F;
+
+    return out;
+}
+
+LoadGenerator::LoadGenerator(const load_generator_config_t &config)
+    : config(config), broker(), server(), players(),
+      hit_latencies(), ping_latencies(), config_latencies(),
+      config_topics(), ping_reply_topics(),
+      payload() {
+
+    setup();
+}
+
+LoadGenerator::~LoadGenerator() {
+    // Players and server unsubscribe from the broker, which has to outlive them
+    players.clear();
+    server.reset();
+}
+
+void LoadGenerator::setup() {
+    payload.resize(std::max({ config.hit_size, config.ping_size, config.config_size, uint32_t(8) }));
+
+    // Sized for the whole run, so that recording does not allocate
+    float seconds = config.duration_ms / 1000.0F;
+    hit_latencies.reserve(config.players * config.hit_rate * seconds * 1.5F + 16);
+    ping_latencies.reserve(config.players * config.ping_rate * seconds * 1.5F + 16);
+    config_latencies.reserve(config.players * config.config_rate * seconds * 1.5F + 16);
+
+    server = std::make_unique<LoopbackCommHandler>(broker, "server", true);
+    server->start();
+
+    server->subscribe("/esp32/LZR/+/event/#", [this](const CommReceivedData &message) {
+        record_latency(hit_latencies, message.payload.data(), message.payload.size());
+    });
+
+    // Sends the ping straight back, timestamp and all
+    server->subscribe("/esp32/LZR/+/" + PING_TOPIC, [this](const CommReceivedData &message) {
+        auto reply_topic = ping_reply_topics.find(message.source_id);
+        if (reply_topic != ping_reply_topics.end()) {
+            server->publish(reply_topic->second, message.payload.data(), message.payload.size());
+        }
+    });
+
+    for (uint32_t i = 0; i < config.players; i++) {
+        char device_id[24];
+        snprintf(device_id, sizeof(device_id), "player_%u", unsigned(i));
+
+        auto player = std::make_unique<LoopbackCommHandler>(broker, device_id);
+        player->start();
+
+        player->subscribe("get/#", [this](const CommReceivedData &message) {
+            if (message.sub_topic == "_ping") {
+                record_latency(ping_latencies, message.payload.data(), message.payload.size());
+            } else {
+                record_latency(config_latencies, message.payload.data(), message.payload.size());
+            }
+        });
+
+        std::string base_topic = std::string("/esp32/LZR/") + device_id + "/";
+        ping_reply_topics[device_id] = base_topic + "get/_ping";
+
+        config_topics.emplace_back();
+        for (auto key : CONFIG_KEYS) {
+            config_topics.back().push_back(base_topic + "get/" + key);
+        }
+
+        players.push_back(std::move(player));
+    }
+}
+
+void LoadGenerator::send(LoopbackCommHandler &handler, const std::string &topic, uint32_t size, bool retain) {
+    uint64_t timestamp = now_ns();
+    memcpy(payload.data(), &timestamp, sizeof(timestamp));
+
+    handler.publish(topic, payload.data(), std::max<uint32_t>(size, sizeof(timestamp)), retain);
+}
+
+load_report_t LoadGenerator::run() {
+    struct stream_t {
+        uint32_t player;
+        uint8_t kind;
+        uint64_t interval;
+        uint64_t next;
+        uint32_t sent;
+    };
+
+    const float rates[] = { config.hit_rate, config.ping_rate, config.config_rate };
+
+    uint64_t start = now_ns();
+    uint64_t end = start + uint64_t(config.duration_ms) * 1000000;
+
+    // Spread out over the first interval, instead of all players
+    // sending at the same instant.
+    std::vector<stream_t> streams;
+    for (uint32_t i = 0; i < config.players; i++) {
+        for (uint8_t kind = 0; kind < 3; kind++) {
+            if (rates[kind] <= 0) {
+                continue;
+            }
+
+            uint64_t interval = 1e9F / rates[kind];
+            streams.push_back({ i, kind, interval, start + interval * i / config.players, 0 });
+        }
+    }
+
+    uint32_t published_before = broker.get_stats().published;
+    uint64_t allocations = 0;
+
+    uint64_t now = start;
+    while (now < end) {
+        uint64_t next_due = end;
+
+        for (auto &stream : streams) {
+            while (stream.next <= now) {
+                LoopbackCommHandler &player = *players[stream.player];
+                uint64_t allocations_before = config.allocation_count ? config.allocation_count() : 0;
+
+                switch (stream.kind) {
+                case 0:
+                    send(player, HIT_TOPIC, config.hit_size, false);
+                    break;
+                case 1:
+                    send(player, PING_TOPIC, config.ping_size, false);
+                    break;
+                default: {
+                    auto &topics = config_topics[stream.player];
+                    send(*server, topics[stream.sent % topics.size()], config.config_size, true);
+                }
+                break;
+                }
+
+                if (config.allocation_count) {
+                    allocations += config.allocation_count() - allocations_before;
+                }
+
+                stream.sent++;
+                stream.next += stream.interval;
+            }
+
+            next_due = std::min(next_due, stream.next);
+        }
+
+        std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(next_due)));
+        now = now_ns();
+    }
+
+    load_report_t report = {};
+    report.hits = summarize(hit_latencies);
+    report.pings = summarize(ping_latencies);
+    report.configs = summarize(config_latencies);
+
+    report.broker = broker.get_stats();
+    report.messages = report.broker.published - published_before;
+
+    if (!config.allocation_count) {
+        report.allocations_per_message = -1;
+    } else if (report.messages > 0) {
+        report.allocations_per_message = float(allocations) / report.messages;
+    }
+
+    return report;
+}
+
+void LoadGenerator::print_report(const load_report_t &report) {
+    auto print_latency = [](const char *name, const load_latency_t &latency) {
+        printf("  %-8s %8u msgs  p50 %8.2fus  p90 %8.2fus  p99 %8.2fus  max %8.2fus\n", name,
+               unsigned(latency.count), latency.p50, latency.p90, latency.p99, latency.max);
+    };
+
+    printf("Load generator: %u messages, %u deliveries, %u unrouted\n",
+           unsigned(report.messages), unsigned(report.broker.delivered), unsigned(report.broker.unrouted));
+    print_latency("hits", report.hits);
+    print_latency("pings", report.pings);
+    print_latency("configs", report.configs);
+
+    if (report.allocations_per_message >= 0) {
+        printf("  %.3f allocations per message\n", report.allocations_per_message);
+    } else {
+        printf("  Allocations not counted\n");
+    }
+}
+
+} // namespace Communication
+} // namespace Xasin
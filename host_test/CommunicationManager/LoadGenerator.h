@@ -0,0 +1,99 @@
+// LoadGenerator.h
+#pragma once
+
+#include "LocalBroker.h"
+#include "LoopbackCommHandler.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace Xasin {
+namespace Communication {
+
+struct load_generator_config_t {
+    uint32_t players = 20;
+    uint32_t duration_ms = 10000;
+
+    // Messages per second, per player
+    float hit_rate = 5;
+    float ping_rate = 0.5;
+    float config_rate = 0.2;
+
+    // Payload sizes, at least 8 bytes for the timestamp
+    uint32_t hit_size = 12;
+    uint32_t ping_size = 22;
+    uint32_t config_size = 8;
+
+    // Returns the number of heap allocations made so far, i.e.
+    // host_allocations(). Optional.
+    std::function<uint64_t ()> allocation_count;
+};
+
+struct load_latency_t {
+    uint32_t count;
+    // End to end, from the publish call to the callback, in µs
+    float p50;
+    float p90;
+    float p99;
+    float max;
+};
+
+struct load_report_t {
+    load_latency_t hits;
+    // Round trip, player to server and back
+    load_latency_t pings;
+    load_latency_t configs;
+
+    uint64_t messages;
+    float allocations_per_message; // Negative if not counted
+    local_broker_stats_t broker;
+};
+
+// Simulates a game on a LocalBroker: a number of players, each with its
+// own LoopbackCommHandler, and a game server.
+//  - Players publish event/ir_hit, which the server receives
+//  - Players publish ping_signal, which the server answers on get/_ping
+//  - The server publishes retained get/<key> config updates to players
+// Every payload starts with the time it was sent, so the receiving side
+// can tell how long the dispatch took.
+//
+// Only needs the C++ standard library besides LocalBroker, and runs as
+// the load_generator host benchmark.
+class LoadGenerator {
+private:
+    const load_generator_config_t config;
+
+    LocalBroker broker;
+    std::unique_ptr<LoopbackCommHandler> server;
+    std::vector<std::unique_ptr<LoopbackCommHandler>> players;
+
+    std::vector<uint32_t> hit_latencies;
+    std::vector<uint32_t> ping_latencies;
+    std::vector<uint32_t> config_latencies;
+
+    // Built up front, so that sending does not allocate
+    std::vector<std::vector<std::string>> config_topics;
+    std::map<std::string, std::string, std::less<>> ping_reply_topics;
+
+    std::vector<uint8_t> payload;
+
+    void setup();
+    void send(LoopbackCommHandler &handler, const std::string &topic, uint32_t size, bool retain);
+
+public:
+    LoadGenerator(const load_generator_config_t &config);
+    ~LoadGenerator();
+
+    // Runs for config.duration_ms of real time, publishing at the
+    // configured rates.
+    load_report_t run();
+
+    static void print_report(const load_report_t &report);
+};
+
+} // namespace Communication
+} // namespace Xasin
@@ -0,0 +1,122 @@
+// LocalBroker.cpp
+#include "LocalBroker.h"
+
+namespace Xasin {
+namespace Communication {
+
+LocalBroker::LocalBroker()
+    : lock(), subscriptions(), trie(), retained(),
+      match_buffers(), publish_depth(0),
+      stats() {
+}
+
+LocalBroker::subscription_t *LocalBroker::subscribe(const std::string &filter, callback_t callback, int qos) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    subscriptions.push_back({ filter, qos, std::move(callback) });
+    subscription_t *subscription = &subscriptions.back();
+
+    trie.insert(subscription);
+    stats.subscriptions++;
+
+    // Matching the filter alone against each retained topic keeps the
+    // wildcard rules in one place, the trie.
+    MQTT::BasicTopicTrie<subscription_t> single;
+    single.insert(subscription);
+
+    std::vector<MQTT::basic_topic_match_t<subscription_t>> matches;
+    std::vector<std::string> matched_topics;
+    for (auto &message : retained) {
+        matches.clear();
+        single.match(message.first, matches);
+
+        if (!matches.empty()) {
+            matched_topics.push_back(message.first);
+        }
+    }
+
+    // Delivered in a second pass, as callbacks may change retained topics.
+    for (auto &topic : matched_topics) {
+        auto message = retained.find(topic);
+        if (message == retained.end()) {
+            continue;
+        }
+
+        matches.clear();
+        single.match(message->first, matches);
+
+        for (auto &match : matches) {
+            stats.delivered++;
+            subscription->callback(message->first, match.topic_rest,
+                                   message->second.data(), message->second.size(), true);
+        }
+    }
+
+    return subscription;
+}
+
+void LocalBroker::unsubscribe(subscription_t *subscription) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    trie.remove(subscription);
+
+    for (auto it = subscriptions.begin(); it != subscriptions.end(); it++) {
+        if (&*it == subscription) {
+            subscriptions.erase(it);
+            stats.subscriptions--;
+            break;
+        }
+    }
+}
+
+void LocalBroker::publish(std::string_view topic, const void *data, size_t length, bool retain) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    stats.published++;
+
+    if (retain) {
+        auto message = retained.find(topic);
+
+        if (length == 0) {
+            if (message != retained.end()) {
+                retained.erase(message);
+            }
+        } else if (message != retained.end()) {
+            // Reuses the stored payload's capacity
+            message->second.assign(static_cast<const char *>(data), length);
+        } else {
+            retained.emplace(std::string(topic), std::string(static_cast<const char *>(data), length));
+        }
+
+        stats.retained_topics = retained.size();
+    }
+
+    if (publish_depth == match_buffers.size()) {
+        match_buffers.emplace_back();
+        match_buffers.back().reserve(8);
+    }
+
+    auto &matches = match_buffers[publish_depth];
+    matches.clear();
+    trie.match(topic, matches);
+
+    if (matches.empty()) {
+        stats.unrouted++;
+        return;
+    }
+
+    publish_depth++;
+    for (auto &match : matches) {
+        stats.delivered++;
+        match.subscription->callback(topic, match.topic_rest, data, length, false);
+    }
+    publish_depth--;
+}
+
+local_broker_stats_t LocalBroker::get_stats() {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    return stats;
+}
+
+} // namespace Communication
+} // namespace Xasin
@@ -0,0 +1,82 @@
+// LocalBroker.h
+#pragma once
+
+#include "xasin/mqtt/TopicTrie.h"
+
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+
+namespace Xasin {
+namespace Communication {
+
+struct local_broker_stats_t {
+    uint32_t published;
+    uint32_t delivered;
+    // Messages no subscription matched
+    uint32_t unrouted;
+
+    uint32_t retained_topics;
+    uint32_t subscriptions;
+};
+
+// Minimal MQTT style broker running in the same process, for the
+// LoopbackCommHandler. Supports '+' and '#' wildcards and retained
+// messages, with the same matching rules as MQTT::Handler.
+//
+// Messages are dispatched synchronously from publish(), on the publishing
+// task. Callbacks may publish themselves, but must not unsubscribe.
+// Once the match buffers have grown, routing a message does not allocate;
+// only storing a new retained topic does.
+class LocalBroker {
+public:
+    // topic is the full topic of the message, topic_rest the part of it
+    // matched by the filter's wildcards.
+    using callback_t = std::function<void (std::string_view topic, std::string_view topic_rest,
+                                           const void *data, size_t length, bool retained)>;
+
+    struct subscription_t {
+        const std::string topic;
+        const int qos;
+        callback_t callback;
+    };
+
+private:
+    std::recursive_mutex lock;
+
+    std::list<subscription_t> subscriptions;
+    MQTT::BasicTopicTrie<subscription_t> trie;
+
+    // std::less<> allows looking up topics by string_view
+    std::map<std::string, std::string, std::less<>> retained;
+
+    // One buffer per nesting level of publish(), so that callbacks can
+    // publish while the outer message is still being delivered.
+    // A deque never moves its elements when growing.
+    std::deque<std::vector<MQTT::basic_topic_match_t<subscription_t>>> match_buffers;
+    size_t publish_depth;
+
+    local_broker_stats_t stats;
+
+public:
+    LocalBroker();
+
+    // Returns a handle for unsubscribe(). All retained messages matching
+    // the filter are delivered right away, before this returns.
+    subscription_t *subscribe(const std::string &filter, callback_t callback, int qos = 0);
+    void unsubscribe(subscription_t *subscription);
+
+    // A retained message with an empty payload clears the topic.
+    void publish(std::string_view topic, const void *data, size_t length, bool retain = false);
+
+    local_broker_stats_t get_stats();
+};
+
+} // namespace Communication
+} // namespace Xasin
@@ -0,0 +1,137 @@
+// LoopbackCommHandler.cpp
+#include "LoopbackCommHandler.h"
+
+#include <string.h>
+
+namespace Xasin {
+namespace Communication {
+
+LoopbackCommHandler::LoopbackCommHandler(LocalBroker &broker, const std::string &device_id, bool is_root_node)
+    : broker_(broker), device_id_(device_id),
+      base_topic_("/esp32/LZR/" + device_id + "/"),
+      is_root_(is_root_node) {
+}
+
+LoopbackCommHandler::~LoopbackCommHandler() {
+    stop();
+}
+
+std::string LoopbackCommHandler::full_topic(const std::string &topic) const {
+    if (!topic.empty() && topic[0] == '/') {
+        return topic;
+    }
+
+    return base_topic_ + topic;
+}
+
+LocalBroker::subscription_t *LoopbackCommHandler::broker_subscribe(const std::string &topic,
+        const comm_message_callback_t &callback, int qos) {
+    return broker_.subscribe(full_topic(topic),
+        [topic, callback](std::string_view full, std::string_view topic_rest, const void *data, size_t length, bool) {
+            CommReceivedData received_data;
+            received_data.topic = topic;
+            received_data.sub_topic = topic_rest;
+            received_data.payload = { static_cast<const uint8_t *>(data), length };
+            received_data.source_id = topic_segment(full, 2);
+
+            callback(received_data);
+        }, qos);
+}
+
+bool LoopbackCommHandler::start(void *) {
+    if (connected_) {
+        return true;
+    }
+    connected_ = true;
+
+    for (auto &sub : active_subscriptions_) {
+        sub.second.broker_sub = broker_subscribe(sub.first, sub.second.callback, sub.second.qos);
+    }
+
+    return true;
+}
+
+void LoopbackCommHandler::stop() {
+    if (!connected_) {
+        return;
+    }
+    connected_ = false;
+
+    // Subscriptions are kept, and renewed on the next start()
+    for (auto &sub : active_subscriptions_) {
+        broker_.unsubscribe(sub.second.broker_sub);
+        sub.second.broker_sub = nullptr;
+    }
+}
+
+bool LoopbackCommHandler::isConnected() const {
+    return connected_;
+}
+
+bool LoopbackCommHandler::publish(const std::string &topic, const void *data, size_t length, bool retain, int) {
+    if (!connected_) {
+        return false;
+    }
+
+    if (!topic.empty() && topic[0] == '/') {
+        broker_.publish(topic, data, length, retain);
+        return true;
+    }
+
+    // Short topics are put together on the stack, so that publishing
+    // does not allocate.
+    char topic_buffer[128];
+    size_t topic_length = base_topic_.size() + topic.size();
+
+    if (topic_length <= sizeof(topic_buffer)) {
+        memcpy(topic_buffer, base_topic_.data(), base_topic_.size());
+        memcpy(topic_buffer + base_topic_.size(), topic.data(), topic.size());
+
+        broker_.publish(std::string_view(topic_buffer, topic_length), data, length, retain);
+    } else {
+        broker_.publish(full_topic(topic), data, length, retain);
+    }
+
+    return true;
+}
+
+bool LoopbackCommHandler::subscribe(const std::string &topic, comm_message_callback_t callback, int qos) {
+    unsubscribe(topic);
+
+    SubscriptionInfo info = { nullptr, std::move(callback), qos };
+    if (connected_) {
+        info.broker_sub = broker_subscribe(topic, info.callback, qos);
+    }
+
+    active_subscriptions_[topic] = std::move(info);
+    return true;
+}
+
+bool LoopbackCommHandler::unsubscribe(const std::string &topic) {
+    auto it = active_subscriptions_.find(topic);
+    if (it == active_subscriptions_.end()) {
+        return false;
+    }
+
+    if (it->second.broker_sub != nullptr) {
+        broker_.unsubscribe(it->second.broker_sub);
+    }
+
+    active_subscriptions_.erase(it);
+    return true;
+}
+
+void LoopbackCommHandler::update() {
+    // Everything is delivered from within publish()
+}
+
+std::string LoopbackCommHandler::getDeviceId() {
+    return device_id_;
+}
+
+bool LoopbackCommHandler::isRootNode() const {
+    return is_root_;
+}
+
+} // namespace Communication
+} // namespace Xasin
@@ -0,0 +1,59 @@
+// LoopbackCommHandler.h
+#pragma once
+
+#include "CommHandler.h"
+#include "LocalBroker.h"
+
+#include <map>
+#include <string>
+
+namespace Xasin {
+namespace Communication {
+
+// CommHandler talking to a LocalBroker in the same process, instead of a
+// real broker over the mesh. Lets the game logic and any number of
+// simulated players run together without a network, i.e. on the host.
+//
+// Topics are relative to "/esp32/LZR/<device id>/" unless they start
+// with '/', same as for the EspMeshHandler. Messages are delivered
+// synchronously, from within publish().
+class LoopbackCommHandler : public CommHandler {
+private:
+    LocalBroker &broker_;
+    const std::string device_id_;
+    const std::string base_topic_;
+    const bool is_root_;
+
+    bool connected_ = false;
+
+    struct SubscriptionInfo {
+        LocalBroker::subscription_t *broker_sub;
+        comm_message_callback_t callback;
+        int qos;
+    };
+    std::map<std::string, SubscriptionInfo> active_subscriptions_;
+
+    std::string full_topic(const std::string &topic) const;
+    LocalBroker::subscription_t *broker_subscribe(const std::string &topic, const comm_message_callback_t &callback, int qos);
+
+public:
+    LoopbackCommHandler(LocalBroker &broker, const std::string &device_id, bool is_root_node = false);
+    ~LoopbackCommHandler() override;
+
+    // Connects to the broker, which delivers the retained messages of
+    // all subscriptions again, like after an MQTT reconnect.
+    bool start(void *config = nullptr) override;
+    void stop() override;
+    bool isConnected() const override;
+
+    // Returns false while stopped, nothing is queued.
+    bool publish(const std::string &topic, const void *data, size_t length, bool retain = false, int qos = 0) override;
+    bool subscribe(const std::string &topic, comm_message_callback_t callback, int qos = 0) override;
+    bool unsubscribe(const std::string &topic) override;
+    void update() override;
+    std::string getDeviceId() override;
+    bool isRootNode() const override;
+};
+
+} // namespace Communication
+} // namespace Xasin
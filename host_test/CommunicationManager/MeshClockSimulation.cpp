@@ -0,0 +1,149 @@
+// MeshClockSimulation.cpp
+#include "MeshClockSimulation.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace Xasin {
+namespace Communication {
+
+namespace {
+
+// Keeps the last frame sent, for the simulation to deliver later
+class SimulatedTransport : public MeshTransport {
+public:
+    std::vector<uint8_t> sent;
+
+    bool send_to_root(const uint8_t *data, size_t length) override {
+        sent.assign(data, data + length);
+        return true;
+    }
+    bool send_to(const uint8_t *, const uint8_t *data, size_t length) override {
+        sent.assign(data, data + length);
+        return true;
+    }
+
+    void receive(const uint8_t *from, const std::vector<uint8_t> &frame) {
+        deliver(from, frame.data(), frame.size());
+    }
+};
+
+}
+
+MeshClockSimulation::MeshClockSimulation(const mesh_clock_simulation_config_t &config)
+    : config(config) {
+}
+
+mesh_clock_simulation_report_t MeshClockSimulation::run() {
+    static const uint8_t root_mac[6] = { 0x02, 0, 0, 0, 0, 1 };
+    static const uint8_t node_mac[6] = { 0x02, 0, 0, 0, 0, 2 };
+
+    mesh_clock_simulation_report_t report = {};
+
+    std::mt19937 random(config.seed);
+    std::uniform_real_distribution<float> chance(0, 1);
+    std::exponential_distribution<double> jitter(1.0 / std::max<uint32_t>(config.jitter_us, 1));
+
+    auto one_way_delay = [&](uint32_t extra) {
+        double delay = config.delay_us + extra + jitter(random);
+        if (chance(random) < config.spike_probability) {
+            delay += config.spike_us * chance(random);
+        }
+        return int64_t(delay);
+    };
+
+    // True time, the root's clock runs exactly on it
+    int64_t now = 0;
+    const double rate = 1 + config.drift_ppm * 1e-6;
+    auto node_time = [&]() { return config.initial_offset_us + int64_t(now * rate); };
+
+    SimulatedTransport root_transport;
+    SimulatedTransport node_transport;
+
+    MeshClock root(root_transport, [&]() { return now; });
+    MeshClock node(node_transport, node_time);
+    root.set_root(true);
+
+    const int64_t duration = int64_t(config.duration_ms) * 1000;
+    const int64_t interval = int64_t(config.sync_interval_ms) * 1000;
+    // Checked a few times per interval, as the error grows with drift
+    const int checks_per_interval = 4;
+
+    std::vector<int64_t> check_times;
+    std::vector<float> errors;
+
+    for (int64_t exchange_start = 0; exchange_start < duration; exchange_start += interval) {
+        now = exchange_start;
+        report.exchanges++;
+
+        node.request_sync();
+        if (chance(random) < config.loss_probability) {
+            report.lost++;
+        } else {
+            now += one_way_delay(config.asymmetry_us);
+            root_transport.sent.clear();
+            root_transport.receive(node_mac, node_transport.sent);
+
+            if (chance(random) < config.loss_probability) {
+                report.lost++;
+            } else {
+                now += one_way_delay(0);
+                node_transport.receive(root_mac, root_transport.sent);
+            }
+        }
+
+        for (int i = 0; i < checks_per_interval; i++) {
+            now = std::max(now, exchange_start + interval * (2 * i + 1) / (2 * checks_per_interval));
+            if (node.is_synced()) {
+                check_times.push_back(now);
+                errors.push_back(std::abs(float(node.now() - now)));
+            }
+        }
+    }
+
+    mesh_clock_stats_t stats = node.get_stats();
+    report.rejected = stats.samples_rejected;
+    report.drift_estimate_ppm = stats.drift_ppm;
+
+    // Converged from just after the last check that was out of bounds
+    size_t first_good = errors.size();
+    while (first_good > 0 && errors[first_good - 1] <= config.threshold_us) {
+        first_good--;
+    }
+
+    if (first_good == errors.size()) {
+        report.converged_after_ms = -1;
+        return report;
+    }
+    report.converged_after_ms = check_times[first_good] / 1000;
+
+    std::vector<float> converged(errors.begin() + first_good, errors.end());
+    std::sort(converged.begin(), converged.end());
+
+    report.error_p50 = converged[converged.size() / 2];
+    report.error_p99 = converged[std::min(converged.size() - 1, converged.size() * 99 / 100)];
+    report.error_max = converged.back();
+
+    return report;
+}
+
+void MeshClockSimulation::print_report(const mesh_clock_simulation_report_t &report) {
+    printf("Mesh clock: %u exchanges, %u lost, %u rejected\n",
+           unsigned(report.exchanges), unsigned(report.lost), unsigned(report.rejected));
+
+    if (report.converged_after_ms < 0) {
+        printf("  Never converged\n");
+        return;
+    }
+
+    printf("  Converged after %.1fs, error p50 %.1fus  p99 %.1fus  max %.1fus, drift %.2fppm\n",
+           report.converged_after_ms / 1000.0F, report.error_p50, report.error_p99, report.error_max,
+           report.drift_estimate_ppm);
+}
+
+} // namespace Communication
+} // namespace Xasin
@@ -0,0 +1,73 @@
+// MeshClockSimulation.h
+#pragma once
+
+#include "sdkconfig.h"
+
+#include "MeshClock.h"
+
+#include <stdint.h>
+
+namespace Xasin {
+namespace Communication {
+
+struct mesh_clock_simulation_config_t {
+    uint32_t duration_ms = 600000;
+    uint32_t sync_interval_ms = CONFIG_COMM_MESH_TIME_SYNC_INTERVAL;
+
+    // Node clock against the root's
+    float drift_ppm = 30;
+    int64_t initial_offset_us = 5000000;
+
+    // One way delay: base + exponentially distributed jitter. The uplink
+    // is slower by asymmetry_us, which no filter can see.
+    uint32_t delay_us = 2000;
+    uint32_t jitter_us = 1500;
+    uint32_t asymmetry_us = 200;
+    // Occasional long queueing delays, i.e. while the mesh is busy
+    float spike_probability = 0.05;
+    uint32_t spike_us = 40000;
+    float loss_probability = 0.05;
+
+    // Errors within this count as converged
+    uint32_t threshold_us = 1000;
+    uint32_t seed = 1;
+};
+
+struct mesh_clock_simulation_report_t {
+    uint32_t exchanges;
+    uint32_t lost;
+    uint32_t rejected;
+
+    // From which point on the error stayed within threshold_us,
+    // negative if it never did
+    int32_t converged_after_ms;
+
+    // Of the absolute error after convergence, in µs
+    float error_p50;
+    float error_p99;
+    float error_max;
+
+    float drift_estimate_ppm;
+};
+
+// Runs the time sync protocol between a simulated root and node on
+// a virtual timeline, with injected delay, jitter, asymmetry and loss.
+// Both sides are real MeshClock instances talking through a transport
+// that delivers frames after the simulated delay, so this covers the
+// frame handling as well as the filter.
+//
+// Runs in virtual time, i.e. a 10 minute run takes a few ms on the host.
+class MeshClockSimulation {
+private:
+    const mesh_clock_simulation_config_t config;
+
+public:
+    MeshClockSimulation(const mesh_clock_simulation_config_t &config);
+
+    mesh_clock_simulation_report_t run();
+
+    static void print_report(const mesh_clock_simulation_report_t &report);
+};
+
+} // namespace Communication
+} // namespace Xasin
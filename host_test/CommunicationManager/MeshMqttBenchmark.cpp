@@ -0,0 +1,193 @@
+// MeshMqttBenchmark.cpp
+#include "MeshMqttBenchmark.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace Xasin {
+namespace Communication {
+
+MeshMqttBenchmark::MeshMqttBenchmark(const mesh_mqtt_benchmark_config_t &config)
+    : config(config), now(0),
+      broker(), broker_subscriptions(),
+      root_transport(), root(),
+      node_transports(), nodes() {
+}
+
+MeshMqttBenchmark::~MeshMqttBenchmark() {
+    // Nodes unregister from the root transport, so they go first
+    nodes.clear();
+    node_transports.clear();
+}
+
+int64_t MeshMqttBenchmark::heap_used() {
+    return config.heap_used ? config.heap_used() : 0;
+}
+
+mesh_mqtt_benchmark_report_t MeshMqttBenchmark::run() {
+    static const char *topic_prefix = "/esp32/LZR/";
+
+    mesh_mqtt_benchmark_report_t report = {};
+    report.children = config.children;
+
+    auto clock = [this]() { return now; };
+
+    MeshMqttProxy::upstream_t upstream;
+    upstream.subscribe = [this](const std::string &filter, int qos) {
+        if (broker_subscriptions.count(filter) != 0) {
+            return;
+        }
+
+        broker_subscriptions[filter] = broker.subscribe(filter,
+            [this, filter](std::string_view topic, std::string_view topic_rest, const void *data, size_t length, bool) {
+                root->route(filter, topic, topic_rest, data, length);
+            }, qos);
+    };
+    upstream.unsubscribe = [this](const std::string &filter) {
+        auto it = broker_subscriptions.find(filter);
+        if (it != broker_subscriptions.end()) {
+            broker.unsubscribe(it->second);
+            broker_subscriptions.erase(it);
+        }
+    };
+    upstream.publish = [this](const char *topic, const void *data, size_t length, bool retain, int) {
+        broker.publish(topic, data, length, retain);
+        return true;
+    };
+
+    static const uint8_t root_mac[6] = { 0x02, 0, 0, 0, 0xff, 0xff };
+    root_transport = std::make_unique<LoopbackMeshTransport>(root_mac);
+    root = std::make_unique<MeshMqttProxy>(*root_transport, upstream, topic_prefix, clock);
+    root->set_root(true);
+    root->set_broker_connected(true);
+
+    uint32_t delivered = 0;
+    auto count = [&delivered](const CommReceivedData &) { delivered++; };
+
+    // Nodes set up while out of reach, so that their own cost can be
+    // told apart from the root's.
+    int64_t heap_start = heap_used();
+
+    for (uint32_t i = 0; i < config.children; i++) {
+        uint8_t mac[6] = { 0x02, 0, 0, 0, uint8_t(i >> 8), uint8_t(i) };
+
+        node_transports.push_back(std::make_unique<LoopbackMeshTransport>(mac, root_transport.get()));
+        node_transports.back()->connected = false;
+
+        nodes.push_back(std::make_unique<MeshMqttProxy>(*node_transports.back(), MeshMqttProxy::upstream_t(),
+                                                        topic_prefix, clock));
+        for (auto &filter : config.filters) {
+            nodes.back()->subscribe(filter, count);
+        }
+        nodes.back()->subscribe(config.shared_filter, count);
+    }
+
+    int64_t heap_nodes = heap_used();
+
+    // The first keepalive sends all subscriptions, the second one only
+    // asks for the broker state.
+    for (uint32_t i = 0; i < config.children; i++) {
+        node_transports[i]->connected = true;
+        nodes[i]->keepalive();
+        nodes[i]->keepalive();
+        process_received();
+    }
+
+    int64_t heap_root = heap_used();
+
+    if (config.heap_used) {
+        report.node_heap_per_child = float(heap_nodes - heap_start) / config.children;
+        report.root_heap_per_child = float(heap_root - heap_nodes) / config.children;
+    } else {
+        report.node_heap_per_child = -1;
+        report.root_heap_per_child = -1;
+    }
+
+    uint32_t filters_per_node = config.filters.size() + 1;
+    report.broker_connections_direct = config.children + 1;
+    report.broker_connections_proxied = 1;
+    report.broker_subscriptions_direct = config.children * filters_per_node;
+    report.broker_subscriptions_proxied = broker.get_stats().subscriptions;
+
+    std::vector<uint8_t> payload(config.payload_size, 0x55);
+
+    // Broker to nodes, one message for each node, and every tenth round
+    // one for all of them
+    std::vector<std::string> node_topics;
+    for (uint32_t i = 0; i < config.children; i++) {
+        char topic[64];
+        snprintf(topic, sizeof(topic), "%s02:00:00:00:%02x:%02x/get/config", topic_prefix, (i >> 8) & 0xff, i & 0xff);
+        node_topics.push_back(topic);
+    }
+
+    std::string shared_topic = config.shared_filter;
+    if (shared_topic.size() >= 2 && shared_topic.compare(shared_topic.size() - 2, 2, "/#") == 0) {
+        shared_topic.replace(shared_topic.size() - 1, 1, "announce");
+    }
+
+    for (uint32_t round = 0; round < config.messages; round++) {
+        now += 100000;
+
+        for (auto &topic : node_topics) {
+            broker.publish(topic, payload.data(), payload.size());
+            report.messages_expected++;
+        }
+
+        if (round % 10 == 0) {
+            broker.publish(shared_topic, payload.data(), payload.size());
+            report.messages_expected += config.children;
+        }
+        process_received();
+    }
+    report.messages_delivered = delivered;
+
+    // Nodes to broker
+    uint32_t published_before = broker.get_stats().published;
+    for (uint32_t round = 0; round < config.messages; round++) {
+        for (auto &node : nodes) {
+            node->publish("telemetry/stats", payload.data(), payload.size());
+            report.publishes_expected++;
+            process_received();
+        }
+    }
+    report.publishes_arrived = broker.get_stats().published - published_before;
+
+    report.root = root->get_stats();
+
+    return report;
+}
+
+// Until all answers to answers went through
+void MeshMqttBenchmark::process_received() {
+    size_t handled;
+    do {
+        handled = root->process_received();
+        for (auto &node : nodes) {
+            handled += node->process_received();
+        }
+    } while (handled > 0);
+}
+
+void MeshMqttBenchmark::print_report(const mesh_mqtt_benchmark_report_t &report) {
+    printf("Mesh MQTT proxy: %u nodes\n", unsigned(report.children));
+    printf("  Broker connections  %4u direct, %4u proxied\n",
+           unsigned(report.broker_connections_direct), unsigned(report.broker_connections_proxied));
+    printf("  Broker subscriptions %3u direct, %4u proxied\n",
+           unsigned(report.broker_subscriptions_direct), unsigned(report.broker_subscriptions_proxied));
+
+    if (report.node_heap_per_child >= 0) {
+        printf("  Heap per node: %.0f bytes on the node, %.0f bytes on the root\n",
+               report.node_heap_per_child, report.root_heap_per_child);
+    } else {
+        printf("  Heap not measured\n");
+    }
+
+    printf("  Messages %u/%u delivered, publishes %u/%u arrived, %u malformed, %u dropped, %u oversized\n",
+           unsigned(report.messages_delivered), unsigned(report.messages_expected),
+           unsigned(report.publishes_arrived), unsigned(report.publishes_expected),
+           unsigned(report.root.frames_malformed), unsigned(report.root.frames_dropped),
+           unsigned(report.root.messages_oversized));
+}
+
+} // namespace Communication
+} // namespace Xasin
@@ -0,0 +1,92 @@
+// MeshMqttBenchmark.h
+#pragma once
+
+#include "LocalBroker.h"
+#include "MeshMqttProxy.h"
+#include "MeshTransport.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace Xasin {
+namespace Communication {
+
+struct mesh_mqtt_benchmark_config_t {
+    uint32_t children = 20;
+
+    // What every player subscribes to, relative to its own base topic
+    std::vector<std::string> filters = { "event/#", "get/#", "Sound/#" };
+    // Subscribed to by every player as well, i.e. game wide announcements
+    std::string shared_filter = "/esp32/LZR/game/#";
+
+    // Sent both ways, per child
+    uint32_t messages = 50;
+    uint32_t payload_size = 32;
+
+    // Returns the bytes currently allocated on the heap, i.e.
+    // host_heap_used(). Optional.
+    std::function<int64_t ()> heap_used;
+};
+
+struct mesh_mqtt_benchmark_report_t {
+    uint32_t children;
+
+    // Every node with its own MQTT client, against the root's proxy
+    uint32_t broker_connections_direct;
+    uint32_t broker_connections_proxied;
+    uint32_t broker_subscriptions_direct;
+    uint32_t broker_subscriptions_proxied;
+
+    // Negative if not measured. The node side is the thin client with
+    // its subscriptions, the root side what the proxy and broker
+    // subscriptions take for each node.
+    float node_heap_per_child;
+    float root_heap_per_child;
+
+    uint32_t messages_expected;
+    uint32_t messages_delivered;
+    uint32_t publishes_expected;
+    uint32_t publishes_arrived;
+
+    mesh_mqtt_proxy_stats_t root;
+};
+
+// Connects a number of nodes to a root through LoopbackMeshTransports and
+// MeshMqttProxy, with a LocalBroker standing in for the broker, and counts
+// what the broker sees and what the proxy costs on either side.
+//
+// Everything runs on the calling task, in virtual time. Received frames
+// are handled after every step, as the MeshMqtt task would.
+class MeshMqttBenchmark {
+private:
+    const mesh_mqtt_benchmark_config_t config;
+
+    int64_t now;
+
+    LocalBroker broker;
+    std::map<std::string, LocalBroker::subscription_t *> broker_subscriptions;
+
+    std::unique_ptr<LoopbackMeshTransport> root_transport;
+    std::unique_ptr<MeshMqttProxy> root;
+
+    std::vector<std::unique_ptr<LoopbackMeshTransport>> node_transports;
+    std::vector<std::unique_ptr<MeshMqttProxy>> nodes;
+
+    int64_t heap_used();
+    void process_received();
+
+public:
+    MeshMqttBenchmark(const mesh_mqtt_benchmark_config_t &config);
+    ~MeshMqttBenchmark();
+
+    mesh_mqtt_benchmark_report_t run();
+
+    static void print_report(const mesh_mqtt_benchmark_report_t &report);
+};
+
+} // namespace Communication
+} // namespace Xasin
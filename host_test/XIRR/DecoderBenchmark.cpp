@@ -0,0 +1,429 @@
+/*
+ * DecoderBenchmark.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#include "DecoderBenchmark.h"
+
+#include "xasin/xirr/Encoder.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+
+namespace Xasin {
+namespace XIRR {
+
+namespace {
+
+struct run_t {
+	bool carrier;
+	int32_t ticks;
+};
+
+// Splits an encoded frame into its copies, bit by bit, at the gaps where
+// the receiver ends a capture
+std::vector<std::vector<bool>> copies_of(const tx_frame_t &frame) {
+	std::vector<std::vector<bool>> copies(1);
+
+	for(uint16_t i = 0; i < frame.item_count * 2; i++) {
+		const rmt_item32_t &item = frame.items[i / 2];
+		uint32_t ticks = (i % 2) ? item.duration1 : item.duration0;
+		bool carrier = (i % 2) ? item.level1 : item.level0;
+
+		if(ticks == 0)
+			break;
+
+		uint32_t bits = ticks / XIRR_TICKS_PER_BIT;
+		if(!carrier && bits >= XIRR_IDLE_BITS) {
+			copies.emplace_back();
+			continue;
+		}
+
+		copies.back().insert(copies.back().end(), bits, carrier);
+	}
+
+	while(!copies.empty() && copies.back().empty())
+		copies.pop_back();
+
+	return copies;
+}
+
+std::vector<run_t> runs_of(const std::vector<bool> &bits) {
+	std::vector<run_t> runs;
+
+	for(bool bit : bits) {
+		if(!runs.empty() && runs.back().carrier == bit)
+			runs.back().ticks += XIRR_TICKS_PER_BIT;
+		else
+			runs.push_back({ bit, XIRR_TICKS_PER_BIT });
+	}
+
+	return runs;
+}
+
+void add_bits(std::vector<run_t> &runs, bool carrier, uint32_t bits) {
+	if(!runs.empty() && runs.back().carrier == carrier)
+		runs.back().ticks += bits * XIRR_TICKS_PER_BIT;
+	else
+		runs.push_back({ carrier, int32_t(bits * XIRR_TICKS_PER_BIT) });
+}
+
+// Packs runs the way the RMT captures them. The receiver pulls low on
+// carrier, the final space is never recorded, and a zero duration at the
+// idle level marks the end.
+std::vector<rmt_item32_t> to_items(std::vector<run_t> runs) {
+	while(!runs.empty() && !runs.back().carrier)
+		runs.pop_back();
+
+	std::vector<rmt_item32_t> items((runs.size() + 2) / 2);
+	for(auto &item : items) {
+		item.level0 = 1;
+		item.level1 = 1;
+	}
+	for(size_t i = 0; i < runs.size(); i++) {
+		uint32_t ticks = std::min<int32_t>(std::max<int32_t>(runs[i].ticks, 1), 0x7FFF);
+		uint32_t level = runs[i].carrier ? 0 : 1;
+
+		if(i % 2 == 0) {
+			items[i/2].duration0 = ticks;
+			items[i/2].level0 = level;
+		} else {
+			items[i/2].duration1 = ticks;
+			items[i/2].level1 = level;
+		}
+	}
+
+	return items;
+}
+
+bool matches(decode_result_t result, const decoded_frame_t &decoded, const decoded_frame_t &sent) {
+	return result == DECODE_OK
+		&& decoded.channel == sent.channel && decoded.length == sent.length
+		&& memcmp(decoded.data, sent.data, sent.length) == 0;
+}
+
+}
+
+DecoderBenchmark::DecoderBenchmark(const decoder_benchmark_config_t &config)
+	: config(config) {
+}
+
+std::vector<DecoderBenchmark::capture_t> DecoderBenchmark::make_corpus() {
+	std::mt19937 random(config.seed);
+	std::uniform_real_distribution<float> chance(0, 1);
+	auto between = [&](int32_t low, int32_t high) {
+		return std::uniform_int_distribution<int32_t>(low, high)(random);
+	};
+
+	auto distort = [&](std::vector<run_t> &runs) {
+		for(auto &run : runs) {
+			run.ticks += (run.carrier ? 1 : -1) * int32_t(config.mark_stretch);
+			run.ticks += between(-int32_t(config.jitter), config.jitter);
+		}
+	};
+
+	uint32_t max_payload = std::min<uint32_t>(config.max_payload,
+			(config.version == 1) ? XIRR_MAX_FRAME - 2 : XIRR_V2_MAX_PAYLOAD);
+
+	std::vector<capture_t> corpus;
+	std::vector<capture_t> clean_copies;
+
+	for(uint32_t i = 0; i < config.frames; i++) {
+		decoded_frame_t frame = {};
+		tx_frame_t encoded;
+
+		// Payloads with runs the receiver cannot capture are drawn again
+		do {
+			uint32_t type = between(0, 9);
+			if(type < 3) {
+				// Beacon, with its ID
+				frame.channel = 129;
+				frame.length = 1;
+			} else if(type < 8) {
+				// Hit, with the shooter's ID
+				frame.channel = 130 + between(0, 3);
+				frame.length = 1;
+			} else {
+				frame.channel = between(0, 255);
+				frame.length = between(0, max_payload);
+			}
+			for(uint8_t j = 0; j < frame.length; j++)
+				frame.data[j] = between(0, 255);
+		} while(!((config.version == 1)
+				? encode(encoded, frame.data, frame.length, frame.channel)
+				: encode_v2(encoded, frame.data, frame.length, frame.channel, config.fec, config.repeats)));
+
+		auto copies = copies_of(encoded);
+		for(uint8_t copy = 0; copy < copies.size(); copy++) {
+			capture_t capture = {};
+			capture.kind = CAPTURE_FRAME;
+			capture.frame = frame;
+			capture.frame_index = i;
+			capture.copy = copy;
+
+			std::vector<bool> &bits = copies[copy];
+			capture.items = to_items(runs_of(bits));
+			clean_copies.push_back(capture);
+
+			if(chance(random) < config.bit_error_probability) {
+				// Past the start marker, which would only give no start
+				size_t start = std::find(bits.begin(), bits.end(), false) - bits.begin();
+				for(int32_t j = between(1, 2); j > 0; j--) {
+					size_t at = between(start + 1, bits.size() - 1);
+					bits[at] = !bits[at];
+				}
+				capture.kind = CAPTURE_DAMAGED;
+			}
+
+			std::vector<run_t> runs = runs_of(bits);
+			distort(runs);
+
+			if(chance(random) < config.glitch_probability) {
+				size_t at = between(0, runs.size() - 1);
+				int32_t spike = between(4, 40);
+				int32_t before = between(spike, std::max(spike, runs[at].ticks - 2*spike));
+
+				run_t rest = { runs[at].carrier, std::max(1, runs[at].ticks - before - spike) };
+				runs[at].ticks = before;
+				runs.insert(runs.begin() + at + 1, { !rest.carrier, spike });
+				runs.insert(runs.begin() + at + 2, rest);
+
+				capture.kind = CAPTURE_DAMAGED;
+			}
+
+			capture.items = to_items(runs);
+			corpus.push_back(capture);
+		}
+	}
+
+	for(uint32_t i = 0; i < config.noise_bursts; i++) {
+		capture_t capture = {};
+		capture.kind = CAPTURE_NOISE;
+
+		std::vector<run_t> runs;
+		switch(between(0, 3)) {
+		case 0:
+			// NEC remote: 9ms leader, 4.5ms space, 32 bits of 560µs marks
+			runs.push_back({ true, 3600 });
+			runs.push_back({ false, 1800 });
+			for(uint8_t j = 0; j < 32; j++) {
+				runs.push_back({ true, 224 });
+				runs.push_back({ false, between(0, 1) ? 676 : 224 });
+			}
+			runs.push_back({ true, 224 });
+		break;
+
+		case 1: {
+			// Lamp flicker, at twice the mains frequency
+			bool carrier = between(0, 1);
+			for(int32_t j = between(10, 40); j > 0; j--) {
+				runs.push_back({ carrier, between(1950, 2050) });
+				carrier = !carrier;
+			}
+		}
+		break;
+
+		case 2: {
+			// Random edges
+			bool carrier = between(0, 1);
+			for(int32_t j = between(2, 60); j > 0; j--) {
+				runs.push_back({ carrier, between(2, 3000) });
+				carrier = !carrier;
+			}
+		}
+		break;
+
+		default:
+			// A start marker followed by random bits, i.e. two frames on
+			// top of each other. Only the checksum can reject these.
+			if(config.version == 1)
+				add_bits(runs, true, XIRR_START_BITS);
+			else
+				add_bits(runs, true, config.fec ? XIRR_V2_FEC_START_BITS : XIRR_V2_START_BITS);
+			add_bits(runs, false, 1);
+			for(int32_t j = between(9, 90); j > 0; j--)
+				add_bits(runs, between(0, 1), 1);
+			distort(runs);
+		break;
+		}
+
+		capture.items = to_items(runs);
+		corpus.push_back(capture);
+	}
+
+	for(uint32_t i = 0; i < config.mutations && !clean_copies.empty(); i++) {
+		capture_t capture = clean_copies[between(0, clean_copies.size() - 1)];
+		capture.kind = CAPTURE_MUTATED;
+
+		auto &items = capture.items;
+		for(int32_t j = between(1, 4); j > 0; j--) {
+			size_t at = between(0, items.size() - 1);
+			bool second = between(0, 1);
+
+			switch(between(0, 4)) {
+			case 0:
+				if(second)
+					items[at].duration1 = between(0, 3000);
+				else
+					items[at].duration0 = between(0, 3000);
+			break;
+			case 1:
+				if(second)
+					items[at].level1 = !items[at].level1;
+				else
+					items[at].level0 = !items[at].level0;
+			break;
+			case 2:
+				items.resize(between(1, items.size()));
+			break;
+			case 3:
+				items.insert(items.begin() + at, items[at]);
+			break;
+			default:
+				if(items.size() > 1)
+					items.erase(items.begin() + at);
+			break;
+			}
+		}
+
+		corpus.push_back(capture);
+	}
+
+	return corpus;
+}
+
+decoder_benchmark_report_t DecoderBenchmark::run() {
+	decoder_benchmark_report_t report = {};
+	report.frames = config.frames;
+
+	std::vector<capture_t> corpus = make_corpus();
+
+	// Copies go through the BurstCombiner in the order they arrive
+	struct arrival_t {
+		int64_t now_us;
+		const capture_t *capture;
+		decode_result_t result;
+		decoded_frame_t frame;
+	};
+	std::vector<arrival_t> arrivals;
+
+	size_t total_items = 0;
+	for(auto &capture : corpus) {
+		total_items += capture.items.size();
+
+		decoded_frame_t frame = {};
+		decode_result_t result = decode(capture.items.data(), capture.items.size(), frame);
+		report.results[result]++;
+
+		bool correct = matches(result, frame, capture.frame);
+
+		switch(capture.kind) {
+		case CAPTURE_FRAME:
+		case CAPTURE_DAMAGED: {
+			report.captures++;
+			if(correct) {
+				report.captures_decoded++;
+				if(capture.copy == 0)
+					report.frames_first_copy++;
+			}
+			else if(result == DECODE_OK)
+				report.false_accepts++;
+
+			// Frames a second apart, or pairs of them, and copies as far
+			// apart as on air
+			int64_t copy_us = v2_copy_us(capture.frame.length, config.fec);
+			int64_t now_us = int64_t(config.interleave ? capture.frame_index / 2 : capture.frame_index) * 1000000
+				+ ((config.interleave && capture.frame_index % 2) ? copy_us / 2 : 0)
+				+ capture.copy * copy_us;
+			arrivals.push_back({ now_us, &capture, result, frame });
+		}
+		break;
+
+		case CAPTURE_NOISE:
+			report.noise_bursts++;
+			if(result == DECODE_OK)
+				report.noise_accepts++;
+		break;
+
+		case CAPTURE_MUTATED:
+			report.mutations++;
+			if(result == DECODE_OK && !correct)
+				report.noise_accepts++;
+		break;
+		}
+	}
+
+	std::stable_sort(arrivals.begin(), arrivals.end(),
+		[](const arrival_t &a, const arrival_t &b) { return a.now_us < b.now_us; });
+
+	BurstCombiner combiner;
+	std::vector<uint32_t> delivered(config.frames);
+
+	for(auto &arrival : arrivals) {
+		decoded_frame_t out;
+		if(!combiner.feed(arrival.now_us, arrival.result, arrival.frame, out))
+			continue;
+
+		if(matches(DECODE_OK, out, arrival.capture->frame))
+			delivered[arrival.capture->frame_index]++;
+		else
+			report.false_accepts++;
+	}
+
+	for(uint32_t count : delivered) {
+		report.frames_delivered += count > 0;
+		report.frames_duplicated += count > 1 ? count - 1 : 0;
+	}
+	report.burst = combiner.stats;
+
+	report.us_per_capture = -1;
+	report.frames_per_second = -1;
+	if(!config.clock_us || corpus.empty())
+		return report;
+
+	// Keeps the compiler from dropping the decodes
+	volatile uint32_t decoded = 0;
+
+	int64_t start = config.clock_us();
+	for(uint32_t i = 0; i < config.iterations; i++) {
+		for(auto &capture : corpus) {
+			decoded_frame_t frame;
+			decoded += decode(capture.items.data(), capture.items.size(), frame) == DECODE_OK;
+		}
+	}
+	int64_t elapsed = std::max<int64_t>(config.clock_us() - start, 1);
+
+	report.us_per_capture = float(elapsed) / (corpus.size() * config.iterations);
+	report.frames_per_second = float(corpus.size()) * config.iterations * 1e6F / elapsed;
+
+	return report;
+}
+
+void DecoderBenchmark::print_report(const decoder_benchmark_report_t &report) {
+	printf("XIRR decoder: %u/%u frames delivered, %u with their first copy, %u/%u copies decoded\n",
+		unsigned(report.frames_delivered), unsigned(report.frames), unsigned(report.frames_first_copy),
+		unsigned(report.captures_decoded), unsigned(report.captures));
+	printf("  %u noise bursts, %u mutations, %u of them accepted, %u false accepts, %u duplicates\n",
+		unsigned(report.noise_bursts), unsigned(report.mutations), unsigned(report.noise_accepts),
+		unsigned(report.false_accepts), unsigned(report.frames_duplicated));
+
+	printf("  Results:");
+	for(uint8_t i = 0; i < DECODE_RESULT_COUNT; i++)
+		printf(" %s %u%s", decode_result_name(decode_result_t(i)), unsigned(report.results[i]),
+			(i + 1 < DECODE_RESULT_COUNT) ? "," : "\n");
+
+	printf("  Bursts: %u repeats suppressed, %u voted, %u corrected\n",
+		unsigned(report.burst.repeats_suppressed), unsigned(report.burst.frames_voted),
+		unsigned(report.burst.frames_corrected));
+
+	if(report.us_per_capture >= 0)
+		printf("  %.2fus per capture, %.0f frames/s\n", report.us_per_capture, report.frames_per_second);
+	else
+		printf("  Throughput not measured\n");
+}
+
+} /* namespace XIRR */
+} /* namespace Xasin */
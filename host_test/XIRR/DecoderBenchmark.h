@@ -0,0 +1,130 @@
+/*
+ * DecoderBenchmark.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#ifndef ESP32_XIRR_DECODERBENCHMARK_H_
+#define ESP32_XIRR_DECODERBENCHMARK_H_
+
+#include "xasin/xirr/BurstCombiner.h"
+#include "xasin/xirr/Decoder.h"
+
+#include <functional>
+#include <vector>
+
+namespace Xasin {
+namespace XIRR {
+
+struct decoder_benchmark_config_t {
+	uint32_t seed = 1;
+
+	// How frames are encoded, see encode_v2
+	uint8_t version = 2;
+	bool fec = false;
+	uint8_t repeats = 2;
+
+	// Frames as the game sends them, beacons and hits, plus some with
+	// longer payloads
+	uint32_t frames = 200;
+	uint32_t max_payload = 8;
+	// Frames go out in pairs, the second half a copy after the first, as
+	// two shooters firing at once. The receiver picks up whichever copy is
+	// stronger, so their copies arrive interleaved.
+	bool interleave = false;
+
+	// Receiver distortion, in ticks. Marks come out longer and spaces
+	// shorter by the stretch, every edge moves by up to the jitter.
+	uint32_t mark_stretch = 40;
+	uint32_t jitter = 20;
+	// Copies with a short spike in them
+	float glitch_probability = 0.05F;
+	// Copies with one or two bits flipped, as the receiver losing or
+	// picking up carrier for a bit in sunlight
+	float bit_error_probability = 0.1F;
+
+	// Bursts of other remotes, lamp flicker and random edges
+	uint32_t noise_bursts = 200;
+	// Frames with random damage to their items, i.e. fuzzing. These may
+	// be rejected, but never decode into anything else.
+	uint32_t mutations = 200;
+
+	// Times the whole corpus is decoded for the throughput figures
+	uint32_t iterations = 20;
+
+	// Monotonic time in µs, i.e. esp_timer_get_time. Optional, without
+	// it only the decode results are reported.
+	std::function<int64_t ()> clock_us;
+};
+
+struct decoder_benchmark_report_t {
+	uint32_t frames;
+	// Copies of the frames, each captured on its own
+	uint32_t captures;
+	uint32_t captures_decoded;
+	// Frames whose first copy decoded, as without repeats
+	uint32_t frames_first_copy;
+	// Frames delivered once their copies went through the BurstCombiner
+	uint32_t frames_delivered;
+	// Further deliveries of a frame that was already delivered
+	uint32_t frames_duplicated;
+
+	uint32_t noise_bursts;
+	uint32_t mutations;
+
+	// Copies or combined frames that decoded into something that was never
+	// sent
+	uint32_t false_accepts;
+	// Noise bursts and mutations that decoded into anything. With a CRC-8
+	// about one in 256 of those reaching the CRC gets through.
+	uint32_t noise_accepts;
+
+	uint32_t results[DECODE_RESULT_COUNT];
+	burst_stats_t burst;
+
+	// Negative if not measured
+	float us_per_capture;
+	float frames_per_second;
+};
+
+// Decodes a corpus of synthetic RMT captures and checks every result
+// against what was sent. Frames come from the encoder, distorted the way
+// the receiver does, and go through the BurstCombiner as the receiver
+// would. Noise bursts and fuzzed frames are mixed in.
+class DecoderBenchmark {
+public:
+	enum capture_kind_t {
+		CAPTURE_FRAME,
+		// A frame with a spike or flipped bit in it, which may only
+		// decode into itself
+		CAPTURE_DAMAGED,
+		CAPTURE_NOISE,
+		CAPTURE_MUTATED,
+	};
+
+	struct capture_t {
+		capture_kind_t kind;
+		std::vector<rmt_item32_t> items;
+		// What was sent, unless noise
+		decoded_frame_t frame;
+		// Which frame this is a copy of, and which copy
+		uint32_t frame_index;
+		uint8_t copy;
+	};
+
+private:
+	const decoder_benchmark_config_t config;
+
+public:
+	DecoderBenchmark(const decoder_benchmark_config_t &config);
+
+	std::vector<capture_t> make_corpus();
+	decoder_benchmark_report_t run();
+
+	static void print_report(const decoder_benchmark_report_t &report);
+};
+
+} /* namespace XIRR */
+} /* namespace Xasin */
+
+#endif /* ESP32_XIRR_DECODERBENCHMARK_H_ */
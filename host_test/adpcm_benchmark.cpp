@@ -0,0 +1,172 @@
+// adpcm_benchmark.cpp
+//
+// Decodes packets written by tools/mkpacketstream.py against golden
+// output, round-trips a tone through the same encoder, and times decoding
+// one TX frame, as PacketCassette does on the processing task.
+#include "xasin/audio/ADPCM.h"
+#include "xasin/audio/AudioTX.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+using namespace Xasin::Audio;
+
+namespace {
+
+const size_t FRAME_SAMPLES = XASAUDIO_TX_FRAME_SAMPLE_NO;
+
+bool check(bool ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "FAILED: %s\n", what);
+    }
+    return ok;
+}
+
+// Packets from mkpacketstream.encode_packet() for
+// 0, 1000, 2000, -3000, 32767, -32768, 500, 0, 100, -100, 7,
+// and the encoder's predictor after every sample
+bool golden() {
+    const uint8_t from_zero[] = { 0x00, 0x00, 0x00, 0x00, 0x70, 0xf7, 0xf7, 0xa7, 0x90, 0x01 };
+    const int16_t from_zero_expected[] = { 0, 11, 41, -22, 114, -179, 452, 0, 82, -141, 63 };
+
+    // Starting from predictor -1234 and step index 40
+    const uint8_t from_state[] = { 0x2e, 0xfb, 0x28, 0x00, 0x77, 0xf3, 0xf7, 0x82, 0x80, 0x08 };
+    const int16_t from_state_expected[] = { -603, 754, 2112, -532, 5138, -7019, 1667, 88, 1523, 218, -968 };
+
+    int16_t out[12];
+    bool ok = true;
+
+    size_t count = ADPCM::decode_packet(from_zero, sizeof(from_zero), out, 11);
+    ok &= check(count == 11 && memcmp(out, from_zero_expected, sizeof(from_zero_expected)) == 0,
+                "golden packet from a zero state");
+
+    count = ADPCM::decode_packet(from_state, sizeof(from_state), out, 11);
+    ok &= check(count == 11 && memcmp(out, from_state_expected, sizeof(from_state_expected)) == 0,
+                "golden packet from a stored state");
+
+    // The padding nibble decodes too, unless max_samples cuts it off
+    ok &= check(ADPCM::decode_packet(from_zero, sizeof(from_zero), out, 12) == 12, "padding nibble decoded");
+    ok &= check(ADPCM::decode_packet(from_zero, 3, out, 12) == 0, "truncated header refused");
+
+    return ok;
+}
+
+// Same as encode_packet() in tools/mkpacketstream.py
+const int8_t index_table[16] = { -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8 };
+const int16_t step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+std::vector<uint8_t> encode_packet(const int16_t *samples, size_t count, int32_t &predictor, int32_t &index) {
+    std::vector<uint8_t> packet(XASAUDIO_ADPCM_PACKET_SIZE(count), 0);
+    packet[0] = uint16_t(predictor);
+    packet[1] = uint16_t(predictor) >> 8;
+    packet[2] = index;
+
+    for (size_t i = 0; i < count; i++) {
+        int32_t step = step_table[index];
+        int32_t diff = samples[i] - predictor;
+
+        uint8_t code = 0;
+        if (diff < 0) {
+            code = 8;
+            diff = -diff;
+        }
+
+        int32_t delta = step >> 3;
+        if (diff >= step) {
+            code |= 4;
+            diff -= step;
+            delta += step;
+        }
+        if (diff >= step >> 1) {
+            code |= 2;
+            diff -= step >> 1;
+            delta += step >> 1;
+        }
+        if (diff >= step >> 2) {
+            code |= 1;
+            delta += step >> 2;
+        }
+
+        predictor = std::clamp<int32_t>((code & 8) ? predictor - delta : predictor + delta, INT16_MIN, INT16_MAX);
+        index = std::clamp<int32_t>(index + index_table[code], 0, 88);
+
+        packet[XASAUDIO_ADPCM_PACKET_HEADER_SIZE + i / 2] |= code << ((i & 1) * 4);
+    }
+
+    return packet;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int rounds = 20;
+    if (argc > 1 && strcmp(argv[1], "--quick") == 0) {
+        rounds = 2;
+    }
+
+    bool ok = golden();
+
+    // One second of a 440 Hz tone, a frame per packet
+    const size_t frames = CONFIG_XASAUDIO_TX_SAMPLERATE / FRAME_SAMPLES;
+    std::vector<int16_t> tone(frames * FRAME_SAMPLES);
+    for (size_t i = 0; i < tone.size(); i++) {
+        double t = double(i) / CONFIG_XASAUDIO_TX_SAMPLERATE;
+        tone[i] = int16_t(16000 * sin(2 * M_PI * 440 * t));
+    }
+
+    std::vector<std::vector<uint8_t>> packets;
+    int32_t predictor = 0;
+    int32_t index = 0;
+    for (size_t f = 0; f < frames; f++) {
+        packets.push_back(encode_packet(tone.data() + f * FRAME_SAMPLES, FRAME_SAMPLES, predictor, index));
+    }
+
+    std::vector<int16_t> decoded(tone.size());
+    double signal = 0;
+    double noise = 0;
+    for (size_t f = 0; f < frames; f++) {
+        size_t count = ADPCM::decode_packet(packets[f].data(), packets[f].size(), decoded.data() + f * FRAME_SAMPLES, FRAME_SAMPLES);
+        ok &= check(count == FRAME_SAMPLES, "one frame per packet");
+    }
+    for (size_t i = 0; i < tone.size(); i++) {
+        signal += double(tone[i]) * tone[i];
+        noise += double(tone[i] - decoded[i]) * (tone[i] - decoded[i]);
+    }
+    double snr_db = 10 * log10(signal / noise);
+
+    // Decoding every packet of the second, rounds times over
+    volatile int32_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (auto &packet : packets) {
+            ADPCM::decode_packet(packet.data(), packet.size(), decoded.data(), FRAME_SAMPLES);
+            sink = sink + decoded[FRAME_SAMPLES - 1];
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double frame_ns = seconds * 1e9 / (rounds * frames);
+    printf("%u samples per packet, %u bytes per packet (%.1fx smaller than 16 bit PCM), %.1f dB SNR\n",
+           unsigned(FRAME_SAMPLES), unsigned(packets[0].size()),
+           double(FRAME_SAMPLES * sizeof(int16_t)) / packets[0].size(), snr_db);
+    printf("Decode: %.0f ns per frame, %.1f M samples/s, %.4f%% of a %u ms frame\n",
+           frame_ns, FRAME_SAMPLES / frame_ns * 1e3, frame_ns / (CONFIG_XASAUDIO_TX_FRAMELENGTH * 1e6) * 100,
+           unsigned(CONFIG_XASAUDIO_TX_FRAMELENGTH));
+
+    ok &= check(snr_db >= 30, "tone decodes with at least 30 dB SNR");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+// asset_cache_test.cpp
+//
+// Plays sounds out of the AssetCache from the host "SD card". Fails if a
+// cached sound differs from its file, if a hit, or a repeated lookup of a
+// sound too large or missing, touches the SD card, or if eviction drops a
+// sound that is still playing or the budget is exceeded.
+// Also reports the cache hit rate of weapon shots, out of a sound bank
+// with the shot sizes of the real one at 16 kHz, and fails if a shot
+// picked by ByteCassette::pick() is not a hit.
+#include "xasin/audio/AssetCache.h"
+#include "xasin/audio/AudioTX.h"
+#include "xasin/audio/ByteCassette.h"
+#include "xasin/audio/SoundBank.h"
+#include "host_sd.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+using namespace Xasin::Audio;
+
+namespace {
+
+std::string root;
+
+bool check(bool ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "FAILED: %s\n", what);
+    }
+    return ok;
+}
+
+std::vector<uint8_t> write_file(const char *name, size_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = uint8_t(i * 13 + name[0]);
+    }
+
+    FILE *file = fopen((root + "/" + name).c_str(), "wb");
+    fwrite(data.data(), 1, data.size(), file);
+    fclose(file);
+
+    return data;
+}
+
+// Sound sizes in the bank, as mksoundbank.py packs them at 16 kHz
+const std::vector<uint32_t> colibri_sizes = { 9182, 8777, 8829, 9937, 9355 };
+const std::vector<uint32_t> steelfinger_sizes = { 22610, 22608, 24071, 23137, 23089,
+                                                  23594, 22802, 22610, 22610, 25355 };
+const uint32_t colibri_reload_size = 21583;
+const uint32_t steelfinger_reload_size = 40010;
+
+// Writes a U8 sound bank holding the given sounds, in order
+void write_bank(const char *name, const std::vector<uint32_t> &sizes) {
+    sound_bank_header_t header = {};
+    memcpy(header.magic, "XSBK", 4);
+    header.version = 1;
+    header.sound_count = sizes.size();
+    header.data_offset = sizeof(header) + sizes.size() * sizeof(sound_bank_entry_t);
+
+    FILE *file = fopen((root + "/" + name).c_str(), "wb");
+    fwrite(&header, sizeof(header), 1, file);
+
+    uint32_t offset = header.data_offset;
+    for (uint32_t size : sizes) {
+        sound_bank_entry_t entry = {};
+        entry.offset = offset;
+        entry.length = size;
+        entry.sample_rate = CONFIG_XASAUDIO_TX_SAMPLERATE;
+        entry.format = SOUND_FORMAT_U8;
+        fwrite(&entry, sizeof(entry), 1, file);
+        offset += size;
+    }
+
+    std::vector<uint8_t> data(offset - header.data_offset, 0x80);
+    fwrite(data.data(), 1, data.size(), file);
+    fclose(file);
+}
+
+bool is_cached(sound_id_t sound_id) {
+    return AssetCache::contains(("#" + std::to_string(sound_id)).c_str());
+}
+
+// Preloads a weapon's sounds the way ShotWeapon::preload_sfx() does, then
+// fires it. Returns the share of shots that were cache hits.
+double fire(TX &tx, const char *name, const ByteCassetteCollection &shots, sound_id_t reload) {
+    ByteCassette::preload(shots);
+    ByteCassette::preload(reload, false);
+
+    int cached = 0;
+    for (auto sound_id : shots) {
+        cached += is_cached(sound_id);
+    }
+
+    const int count = 200;
+    uint32_t hits_before = AssetCache::get_stats().hits;
+    for (int i = 0; i < count; i++) {
+        delete new ByteCassette(tx, ByteCassette::pick(shots));
+    }
+    double hit_rate = double(AssetCache::get_stats().hits - hits_before) / count;
+
+    printf("%-22s %2d of %2u shots cached, hit rate %3.0f%% at random, %3.0f%% picked\n", name, cached,
+           unsigned(shots.size()), 100.0 * cached / shots.size(), 100 * hit_rate);
+    return hit_rate;
+}
+
+uint64_t sd_calls() {
+    return host_sd_get_stats().calls;
+}
+
+// SD calls made by func
+template<typename func_t>
+uint64_t sd_calls_of(func_t func) {
+    uint64_t before = sd_calls();
+    func();
+    return sd_calls() - before;
+}
+
+} // namespace
+
+int main() {
+    char dir[] = "/tmp/asset_cache_testXXXXXX";
+    if (mkdtemp(dir) == nullptr) {
+        perror("mkdtemp");
+        return 1;
+    }
+    root = dir;
+    host_sd_set_root(dir);
+
+    const uint32_t entry_size = CONFIG_XASAUDIO_ASSET_CACHE_MAX_ENTRY;
+    const int entries_in_budget = CONFIG_XASAUDIO_ASSET_CACHE_SIZE / entry_size;
+
+    std::vector<uint8_t> hit = write_file("hit.u8", 2000);
+    write_file("long.u8", entry_size + 1);
+
+    std::vector<std::string> names;
+    for (int i = 0; i <= entries_in_budget; i++) {
+        names.push_back("fill" + std::to_string(i) + ".u8");
+        write_file(names.back().c_str(), entry_size);
+    }
+
+    bool ok = check(AssetCache::get("hit.u8") == nullptr, "nothing cached before init()");
+    AssetCache::init();
+
+    AssetHandle asset;
+    ok &= check(sd_calls_of([&]() { asset = AssetCache::get("hit.u8"); }) > 0, "first play loads");
+    ok &= check(asset != nullptr && asset->size == hit.size() && memcmp(asset->data, hit.data(), hit.size()) == 0,
+                "cached sound matches its file");
+    ok &= check(sd_calls_of([&]() { asset = AssetCache::get("hit.u8"); }) == 0 && asset != nullptr,
+                "hits need no SD access");
+
+    // Too large to cache, missing, and too large out of a sound bank
+    ok &= check(AssetCache::get("long.u8") == nullptr, "long sound is streamed");
+    ok &= check(AssetCache::get("missing.u8") == nullptr, "missing sound is not cached");
+    ok &= check(AssetCache::get("#7", "long.u8", 0, entry_size + 1) == nullptr, "long bank sound is streamed");
+
+    uint64_t calls = sd_calls_of([&]() {
+        for (int i = 0; i < 10; i++) {
+            AssetCache::get("long.u8");
+            AssetCache::get("missing.u8");
+            AssetCache::get("#7", "long.u8", 0, entry_size + 1);
+        }
+    });
+    ok &= check(calls == 0, "uncacheable sounds are only looked at once");
+    ok &= check(!AssetCache::preload("long.u8"), "uncacheable sounds do not preload");
+
+    asset_cache_stats_t stats = AssetCache::get_stats();
+    printf("%u hits, %u misses, %u negative hits, %u entries, %u bytes\n", unsigned(stats.hits),
+           unsigned(stats.misses), unsigned(stats.negative_hits), unsigned(stats.entries),
+           unsigned(stats.bytes_used));
+    ok &= check(stats.hits == 1 && stats.misses == 4 && stats.negative_hits == 30, "hit and miss counts");
+
+    // Filling the budget evicts the least recently used entry, but never
+    // one that is still playing
+    AssetHandle playing = AssetCache::get("hit.u8");
+    for (auto &name : names) {
+        AssetCache::get(name.c_str());
+    }
+
+    stats = AssetCache::get_stats();
+    ok &= check(stats.bytes_used <= CONFIG_XASAUDIO_ASSET_CACHE_SIZE, "budget kept");
+    ok &= check(stats.evictions > 0, "entries evicted once the budget is full");
+    ok &= check(sd_calls_of([&]() { AssetCache::get("hit.u8"); }) == 0, "playing sound not evicted");
+    ok &= check(sd_calls_of([&]() { AssetCache::get(names.back().c_str()); }) == 0, "newest sound kept");
+
+    // After clear(), sounds are looked at again, i.e. once the card changed
+    AssetCache::clear();
+    ok &= check(sd_calls_of([&]() { AssetCache::get("missing.u8"); }) > 0, "clear() forgets missing sounds");
+    ok &= check(playing->size == hit.size() && memcmp(playing->data, hit.data(), hit.size()) == 0,
+                "playing sound survives clear()");
+
+    // Weapon shots, on a fresh start and after switching weapons
+    std::vector<uint32_t> sizes = colibri_sizes;
+    sizes.insert(sizes.end(), steelfinger_sizes.begin(), steelfinger_sizes.end());
+    sizes.push_back(colibri_reload_size);
+    sizes.push_back(steelfinger_reload_size);
+    write_bank("shots.bank", sizes);
+    ok &= check(SoundBank::load("shots.bank"), "sound bank loaded");
+
+    ByteCassetteCollection colibri, steelfinger;
+    for (sound_id_t i = 0; i < colibri_sizes.size(); i++) {
+        colibri.push_back(i);
+    }
+    for (sound_id_t i = 0; i < steelfinger_sizes.size(); i++) {
+        steelfinger.push_back(colibri_sizes.size() + i);
+    }
+    const sound_id_t colibri_reload = sizes.size() - 2;
+    const sound_id_t steelfinger_reload = sizes.size() - 1;
+
+    TX tx;
+    AssetCache::clear();
+    ok &= check(fire(tx, "COLIBRI M2", colibri, colibri_reload) == 1, "COLIBRI M2 shots all hit");
+    for (auto sound_id : colibri) {
+        ok &= check(is_cached(sound_id), "COLIBRI M2 fits as a whole");
+    }
+    ok &= check(fire(tx, "DP-116 STEELFINGER", steelfinger, steelfinger_reload) == 1,
+                "DP-116 STEELFINGER shots all hit");
+    ok &= check(fire(tx, "COLIBRI M2, switched", colibri, colibri_reload) == 1,
+                "COLIBRI M2 shots all hit after a weapon switch");
+    ok &= check(AssetCache::get_stats().bytes_used <= CONFIG_XASAUDIO_ASSET_CACHE_SIZE, "budget kept with shots");
+
+    unlink((root + "/shots.bank").c_str());
+    for (auto &name : names) {
+        unlink((root + "/" + name).c_str());
+    }
+    unlink((root + "/hit.u8").c_str());
+    unlink((root + "/long.u8").c_str());
+    rmdir(dir);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+// audio_tx_wav.cpp
+//
+// Plays a known pattern through the TX into a WAV file, paced like the
+// I2S DMA, and fails if the file holds anything but the pattern followed
+// by silence, if the output ran dry while playing, or if playback did not
+// take as long as the audio it played.
+#include "xasin/audio/AudioTX.h"
+#include "WavFileSink.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace Xasin::Audio;
+
+namespace {
+
+const uint32_t PATTERN_FRAMES = 50;
+const int64_t FRAME_US = CONFIG_XASAUDIO_TX_FRAMELENGTH * 1000;
+
+int16_t pattern_sample(uint32_t index) {
+    return int16_t(int32_t(index * 37 % 20000) - 10000);
+}
+
+// Plays PATTERN_FRAMES frames of the pattern at full volume
+class PatternSource : public Source {
+private:
+    std::array<int16_t, XASAUDIO_TX_FRAME_SAMPLE_NO> samples;
+    uint32_t frame;
+
+protected:
+    bool process_frame() override {
+        if (frame >= PATTERN_FRAMES) {
+            return false;
+        }
+
+        for (size_t i = 0; i < samples.size(); i++) {
+            samples[i] = pattern_sample(frame * samples.size() + i);
+        }
+        add_mono_frame_to_handler(samples.data(), 255);
+
+        frame++;
+        return true;
+    }
+
+public:
+    PatternSource(TX &handler) : Source(handler), samples(), frame(0) {}
+
+    bool is_finished() override {
+        return frame >= PATTERN_FRAMES;
+    }
+};
+
+TX tx;
+
+void processing_task(void *) {
+    while (true) {
+        xTaskNotifyWait(0, 0, nullptr, portMAX_DELAY);
+        tx.largestack_process();
+    }
+}
+
+bool check(bool ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "FAILED: %s\n", what);
+    }
+    return ok;
+}
+
+uint32_t get_u32(const uint8_t *in) {
+    return in[0] | (in[1] << 8) | (in[2] << 16) | (uint32_t(in[3]) << 24);
+}
+
+} // namespace
+
+int main() {
+    const char *path = "audio_tx_wav.wav";
+    WavFileSink sink(path);
+
+    TaskHandle_t processing = nullptr;
+    xTaskCreate(processing_task, "Processing", 8192, nullptr, 10, &processing);
+    tx.init(processing, &sink);
+
+    (new PatternSource(tx))->start(true);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (sink.get_stats().stops == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    sink.close();
+
+    wav_file_sink_stats_t stats = sink.get_stats();
+    printf("%u frames written, %u underruns (latest %u us late), playback took %.1f ms for %u frames of %u ms\n",
+           unsigned(stats.frames_written), unsigned(stats.underruns), unsigned(stats.max_late_us),
+           stats.last_playback_us / 1000.0, unsigned(stats.frames_written), unsigned(CONFIG_XASAUDIO_TX_FRAMELENGTH));
+
+    bool ok = check(stats.starts == 1 && stats.stops == 1, "output started and stopped once");
+    ok &= check(stats.frames_while_stopped == 0, "no frames written while stopped");
+    ok &= check(stats.underruns == 0, "no underruns while playing");
+
+    // The sink only blocks once the DMA buffers are full, and has the
+    // last ones still to play when stopped
+    int64_t audio_us = int64_t(stats.frames_written) * FRAME_US;
+    ok &= check(stats.last_playback_us >= audio_us - (CONFIG_XASAUDIO_TX_DMA_COUNT + 1) * FRAME_US,
+                "playback paced to the sample rate");
+    ok &= check(stats.last_playback_us <= audio_us + 100000, "playback not slower than the audio");
+
+    // Read back: the header, then the pattern at full volume, then silence
+    FILE *file = fopen(path, "rb");
+    if (!check(file != nullptr, "WAV file written")) {
+        return 1;
+    }
+
+    std::vector<uint8_t> contents;
+    uint8_t buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents.insert(contents.end(), buffer, buffer + read);
+    }
+    fclose(file);
+
+    if (!check(contents.size() >= 44, "WAV header present")) {
+        return 1;
+    }
+
+    const uint8_t *header = contents.data();
+    uint32_t data_bytes = get_u32(header + 40);
+    ok &= check(memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "WAVEfmt ", 8) == 0
+                && memcmp(header + 36, "data", 4) == 0, "WAV chunk names");
+    ok &= check(get_u32(header + 4) == 36 + data_bytes, "RIFF size");
+    ok &= check(get_u32(header + 24) == CONFIG_XASAUDIO_TX_SAMPLERATE, "WAV sample rate");
+    ok &= check(header[22] == 1 && header[34] == 16, "WAV mono 16 bit");
+    ok &= check(data_bytes == contents.size() - 44, "WAV data size");
+    ok &= check(data_bytes == stats.frames_written * XASAUDIO_TX_FRAME_SAMPLE_NO * sizeof(int16_t),
+                "every frame in the file");
+
+    const int16_t *samples = reinterpret_cast<const int16_t *>(contents.data() + 44);
+    size_t sample_count = data_bytes / sizeof(int16_t);
+    size_t pattern_samples = PATTERN_FRAMES * XASAUDIO_TX_FRAME_SAMPLE_NO;
+
+    if (!check(sample_count > pattern_samples, "pattern and trailing silence in the file")) {
+        return 1;
+    }
+
+    // Q15 gain of the global and the source's volume
+    int32_t gain = (int32_t(tx.volume_mod) * 255) >> 1;
+    size_t mismatches = 0;
+    for (size_t i = 0; i < sample_count; i++) {
+        int16_t expected = i < pattern_samples ? int16_t((pattern_sample(i) * gain) >> 15) : 0;
+        if (samples[i] != expected) {
+            mismatches++;
+        }
+    }
+    printf("%u of %u samples differ from the pattern\n", unsigned(mismatches), unsigned(sample_count));
+    ok &= check(mismatches == 0, "samples match the pattern");
+
+    remove(path);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+// beam_hits.cpp
+//
+// Sends a beam weapon's shot frames back to back, as the gun does while
+// the trigger is held, through the BurstCombiner and HitFilter as the
+// weapon handler does. Every transmission has to reach the HitFilter once,
+// so that its repeat count matches the beam, also with copies lost.
+#include "lzrtag/hit_filter.h"
+#include "xasin/xirr/BurstCombiner.h"
+
+#include <stdio.h>
+#include <random>
+
+using namespace Xasin::XIRR;
+
+struct beam_result_t {
+    uint32_t transmissions;
+    uint32_t frames_delivered;
+    uint32_t hits;
+    uint32_t repeats;
+};
+
+static beam_result_t run_beam(uint8_t copies, float loss, uint32_t transmissions) {
+    BurstCombiner combiner;
+    LZR::HitFilter hit_filter(150);
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> chance(0, 1);
+
+    beam_result_t result = {};
+    result.transmissions = transmissions;
+
+    const uint8_t shooter_id = 3;
+    const uint32_t copy_us = v2_copy_us(1, false);
+
+    auto add_hit = [&result](const LZR::recent_hit_t &hit) {
+        result.hits++;
+        result.repeats += hit.repeats;
+    };
+
+    int64_t now_us = 0;
+    for (uint32_t i = 0; i < transmissions; i++) {
+        // At least one copy of each gets through, which is all the
+        // combiner needs
+        uint8_t kept = std::uniform_int_distribution<int>(0, copies - 1)(random);
+
+        for (uint8_t copy = 0; copy < copies; copy++, now_us += copy_us) {
+            if (copy != kept && chance(random) < loss) {
+                continue;
+            }
+
+            decoded_frame_t frame = {};
+            frame.channel = 130;
+            frame.length = 1;
+            frame.data[0] = shooter_id;
+            frame.version = 2;
+            frame.copy = copy;
+
+            decoded_frame_t out;
+            if (!combiner.feed(now_us, DECODE_OK, frame, out)) {
+                continue;
+            }
+            result.frames_delivered++;
+
+            LZR::recent_hit_t hit;
+            if (hit_filter.feed(out.data[0], out.channel - 130, now_us, now_us, 1, hit)) {
+                add_hit(hit);
+            }
+        }
+
+        LZR::recent_hit_t hit;
+        while (hit_filter.pop_expired(now_us, hit)) {
+            add_hit(hit);
+        }
+    }
+
+    LZR::recent_hit_t hit;
+    while (hit_filter.pop_expired(now_us + 1000000, hit)) {
+        add_hit(hit);
+    }
+
+    return result;
+}
+
+int main() {
+    bool ok = true;
+
+    for (uint8_t copies = 1; copies <= XIRR_V2_MAX_COPIES; copies++) {
+        for (float loss : { 0.0F, 0.5F }) {
+            beam_result_t result = run_beam(copies, loss, 100);
+
+            printf("%u copies, %.0f%% lost: %u/%u transmissions delivered, %u hits with %u repeats\n",
+                   unsigned(copies), loss * 100, unsigned(result.frames_delivered),
+                   unsigned(result.transmissions), unsigned(result.hits), unsigned(result.repeats));
+
+            if (result.frames_delivered != result.transmissions
+                    || result.hits + result.repeats != result.transmissions) {
+                fprintf(stderr, "%u copies: beam repeats lost\n", unsigned(copies));
+                ok = false;
+            }
+        }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+// decoder_benchmark.cpp
+//
+// Decodes the synthetic capture corpus for each frame format, and fails
+// on any false accept or duplicate, if too few frames make it through, or
+// if noise gets through more often than the CRC-8 should let it.
+#include "DecoderBenchmark.h"
+
+#include "esp_timer.h"
+
+#include <stdio.h>
+
+using namespace Xasin::XIRR;
+
+// Corpora the noise acceptance is averaged over, as a single one only
+// holds a few hundred noise bursts and mutations
+#define NOISE_SEEDS 10
+
+static bool run(const char *name, decoder_benchmark_config_t config) {
+    printf("%s\n", name);
+    config.clock_us = esp_timer_get_time;
+
+    decoder_benchmark_report_t report = DecoderBenchmark(config).run();
+    DecoderBenchmark::print_report(report);
+
+    if (report.false_accepts != 0 || report.frames_duplicated != 0) {
+        fprintf(stderr, "%s: %u false accepts, %u duplicates\n", name,
+                unsigned(report.false_accepts), unsigned(report.frames_duplicated));
+        return false;
+    }
+    // Version 1 has no repeats to fall back on
+    uint32_t expected = config.version == 1 ? report.frames_first_copy : report.frames * 95 / 100;
+    if (report.frames_delivered < expected) {
+        fprintf(stderr, "%s: only %u/%u frames delivered\n", name,
+                unsigned(report.frames_delivered), unsigned(report.frames));
+        return false;
+    }
+
+    uint32_t accepted = 0;
+    uint32_t total = 0;
+    config.clock_us = nullptr;
+    for (uint32_t seed = 1; seed <= NOISE_SEEDS; seed++) {
+        config.seed = seed;
+        report = DecoderBenchmark(config).run();
+        accepted += report.noise_accepts;
+        total += report.noise_bursts + report.mutations;
+    }
+    printf("  Noise accepted over %u corpora: %u/%u\n", NOISE_SEEDS, unsigned(accepted), unsigned(total));
+    // Well below one in 256, as most noise never gets to the checksum
+    if (accepted * 400 > total) {
+        fprintf(stderr, "%s: %u/%u noise captures accepted\n", name, unsigned(accepted), unsigned(total));
+        return false;
+    }
+
+    return true;
+}
+
+int main() {
+    bool ok = true;
+
+    decoder_benchmark_config_t config;
+    config.version = 1;
+    config.repeats = 1;
+    ok &= run("Version 1", config);
+
+    config.version = 2;
+    config.repeats = 2;
+    ok &= run("Version 2", config);
+
+    config.fec = true;
+    ok &= run("Version 2 with FEC", config);
+
+    // Enough copies for a vote, from two shooters at once
+    config.fec = false;
+    config.repeats = 3;
+    config.interleave = true;
+    ok &= run("Version 2, interleaved shooters", config);
+
+    return ok ? 0 : 1;
+}
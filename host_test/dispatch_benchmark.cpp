@@ -0,0 +1,310 @@
+// dispatch_benchmark.cpp
+//
+// Dispatches received MQTT messages to a player's subscriptions, once the
+// way MQTT::Handler and EspMeshHandler used to, copying topic and payload
+// at every step, and once the way they do now, handing on views. Reports
+// messages/s and heap allocations per message for both, and fails if the
+// two deliver different messages or the view path allocates.
+#include "CommHandler.h"
+#include "host_heap.h"
+#include "xasin/mqtt/TopicTrie.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace Xasin::Communication;
+
+namespace {
+
+struct dispatch_result_t {
+    uint64_t delivered;
+    uint64_t payload_bytes;
+    uint64_t sub_topic_bytes;
+};
+
+// The copying path, as it was before messages were passed on as views
+namespace legacy {
+
+struct packet_t {
+    std::string topic;
+    std::string data;
+    std::string full_topic;
+};
+
+struct received_t {
+    std::string topic;
+    std::vector<uint8_t> payload;
+    std::string source_id;
+};
+
+struct subscription_t {
+    std::string topic;
+    std::function<void (const packet_t)> on_received;
+
+    void feed_data(packet_t data) {
+        std::string original_full_topic = data.topic;
+        if (data.topic.length() < topic.length()) {
+            return;
+        }
+
+        std::string topic_rest;
+        size_t i = 0;
+        while (true) {
+            if (topic.at(i) == '#') {
+                topic_rest = std::string(original_full_topic.data() + i, original_full_topic.length() - i);
+                break;
+            }
+            if (topic.at(i) != original_full_topic.at(i)) {
+                return;
+            }
+
+            i++;
+            if (i == topic.length()) {
+                if (i == original_full_topic.length()) {
+                    topic_rest = "";
+                } else if (original_full_topic.at(i) == '/') {
+                    topic_rest = std::string(original_full_topic.data() + i + 1, original_full_topic.length() - i - 1);
+                } else {
+                    return;
+                }
+                break;
+            }
+            if (i == original_full_topic.length()) {
+                return;
+            }
+        }
+
+        on_received({ topic_rest, data.data, original_full_topic });
+    }
+};
+
+struct handler_t {
+    std::list<subscription_t> subscriptions;
+
+    void subscribe(const std::string &filter, std::function<void (const received_t &)> callback) {
+        std::string topic_filter = filter;
+        subscriptions.push_back({ filter, [callback, topic_filter](const packet_t &packet) {
+            received_t received;
+            received.topic = topic_filter;
+            received.payload = std::vector<uint8_t>(packet.data.begin(), packet.data.end());
+
+            std::string full_topic = packet.topic;
+            size_t start = (!full_topic.empty() && full_topic[0] == '/') ? 1 : 0;
+
+            std::string segment;
+            std::vector<std::string> segments;
+            std::istringstream stream(full_topic.substr(start));
+            while (std::getline(stream, segment, '/')) {
+                segments.push_back(segment);
+            }
+            if (segments.size() >= 3) {
+                received.source_id = segments[2];
+            }
+
+            callback(received);
+        } });
+    }
+
+    void receive(const char *topic, size_t topic_length, const char *data, size_t data_length) {
+        const std::string data_string = std::string(data, data_length);
+        const std::string topic_string = std::string(topic, topic_length);
+
+        for (auto &s : subscriptions) {
+            s.feed_data({ topic_string, data_string });
+        }
+    }
+};
+
+} // namespace legacy
+
+// The view path, as MQTT::Handler, Subscription and EspMeshHandler now
+// hand messages on
+namespace views {
+
+struct packet_t {
+    std::string_view topic;
+    std::string_view data;
+    std::string_view full_topic;
+};
+
+struct subscription_t {
+    std::string topic;
+    int qos;
+    std::function<void (const packet_t)> on_received;
+
+    void feed_data(const packet_t &data, std::string_view topic_rest) {
+        on_received({ topic_rest, data.data, data.full_topic });
+    }
+};
+
+struct handler_t {
+    std::list<subscription_t> subscriptions;
+    Xasin::MQTT::BasicTopicTrie<subscription_t> trie;
+    std::vector<Xasin::MQTT::basic_topic_match_t<subscription_t>> matches;
+
+    void subscribe(const std::string &filter, comm_message_callback_t callback) {
+        std::string topic_filter = filter;
+        subscriptions.push_back({ filter, 1, [callback, topic_filter](const packet_t &packet) {
+            CommReceivedData received;
+            received.topic = topic_filter;
+            received.sub_topic = packet.topic;
+            received.payload = { reinterpret_cast<const uint8_t *>(packet.data.data()), packet.data.size() };
+            received.source_id = topic_segment(packet.full_topic, 2);
+
+            callback(received);
+        } });
+        trie.insert(&subscriptions.back());
+    }
+
+    void receive(const char *topic, size_t topic_length, const char *data, size_t data_length) {
+        const std::string_view topic_view(topic, topic_length);
+        const packet_t packet = { topic_view, std::string_view(data, data_length), topic_view };
+
+        matches.clear();
+        trie.match(topic_view, matches);
+
+        for (auto &m : matches) {
+            m.subscription->feed_data(packet, m.topic_rest);
+        }
+    }
+};
+
+} // namespace views
+
+// The player's own topics, the menu items and the game state
+std::vector<std::string> make_filters() {
+    std::vector<std::string> filters = {
+        "/esp32/LZR/24:0a:c4:00:00:01/event/#",
+        "/esp32/LZR/24:0a:c4:00:00:01/get/#",
+        "/esp32/LZR/game/#",
+    };
+
+    char filter[64];
+    for (int i = 0; i < 40; i++) {
+        snprintf(filter, sizeof(filter), "/esp32/LZR/game/menu/item%02d", i);
+        filters.push_back(filter);
+    }
+
+    return filters;
+}
+
+struct message_t {
+    std::string topic;
+    std::string payload;
+};
+
+std::vector<message_t> make_messages() {
+    std::vector<message_t> messages;
+    char topic[64];
+
+    for (int i = 0; i < 64; i++) {
+        switch (i % 4) {
+        case 0:
+            messages.push_back({ "/esp32/LZR/24:0a:c4:00:00:01/get/ammo",
+                                 "{\"current\":12,\"clipsize\":30,\"total\":120}" });
+            break;
+        case 1:
+            messages.push_back({ "/esp32/LZR/24:0a:c4:00:00:01/event/hit", "0.5" });
+            break;
+        case 2:
+            snprintf(topic, sizeof(topic), "/esp32/LZR/game/menu/item%02d", i % 40);
+            messages.push_back({ topic, "true" });
+            break;
+        default:
+            messages.push_back({ "/esp32/LZR/24:0a:c4:00:00:02/get/ammo", "{\"current\":3}" });
+            break;
+        }
+    }
+
+    return messages;
+}
+
+template<typename handler_t>
+void receive_all(handler_t &handler, const std::vector<message_t> &messages) {
+    for (auto &message : messages) {
+        handler.receive(message.topic.data(), message.topic.size(), message.payload.data(), message.payload.size());
+    }
+}
+
+struct run_report_t {
+    double messages_per_s;
+    double allocations_per_message;
+};
+
+template<typename handler_t>
+run_report_t run(handler_t &handler, const std::vector<message_t> &messages, int rounds) {
+    // Once, to grow any buffers
+    receive_all(handler, messages);
+
+    uint64_t allocations = host_allocations();
+    auto start = std::chrono::steady_clock::now();
+
+    for (int r = 0; r < rounds; r++) {
+        receive_all(handler, messages);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t count = uint64_t(rounds) * messages.size();
+
+    return { count / seconds, double(host_allocations() - allocations) / count };
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int rounds = 5000;
+    if (argc > 1 && strcmp(argv[1], "--quick") == 0) {
+        rounds = 200;
+    }
+
+    std::vector<std::string> filters = make_filters();
+    std::vector<message_t> messages = make_messages();
+
+    dispatch_result_t legacy_result = {};
+    legacy::handler_t legacy_handler;
+    for (auto &filter : filters) {
+        legacy_handler.subscribe(filter, [&](const legacy::received_t &message) {
+            legacy_result.delivered++;
+            legacy_result.payload_bytes += message.payload.size();
+        });
+    }
+
+    dispatch_result_t views_result = {};
+    views::handler_t views_handler;
+    for (auto &filter : filters) {
+        views_handler.subscribe(filter, [&](const CommReceivedData &message) {
+            views_result.delivered++;
+            views_result.payload_bytes += message.payload.size();
+            views_result.sub_topic_bytes += message.sub_topic.size();
+        });
+    }
+
+    run_report_t before = run(legacy_handler, messages, rounds);
+    run_report_t after = run(views_handler, messages, rounds);
+
+    printf("%u subscriptions, %u messages per round, %.2f deliveries per message\n",
+           unsigned(filters.size()), unsigned(messages.size()),
+           double(views_result.delivered) / (uint64_t(rounds + 1) * messages.size()));
+    printf("Copies: %9.0f messages/s, %5.1f allocations per message\n", before.messages_per_s, before.allocations_per_message);
+    printf("Views:  %9.0f messages/s, %5.1f allocations per message\n", after.messages_per_s, after.allocations_per_message);
+
+    bool ok = true;
+    if (legacy_result.delivered != views_result.delivered || legacy_result.payload_bytes != views_result.payload_bytes) {
+        fprintf(stderr, "FAILED: copies delivered %u messages, views %u\n",
+                unsigned(legacy_result.delivered), unsigned(views_result.delivered));
+        ok = false;
+    }
+    if (after.allocations_per_message != 0) {
+        fprintf(stderr, "FAILED: dispatching views allocates\n");
+        ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
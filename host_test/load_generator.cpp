@@ -0,0 +1,38 @@
+// load_generator.cpp
+//
+// Runs the LoadGenerator with its default game, or a short one with
+// --quick, and fails if any message went missing.
+#include "LoadGenerator.h"
+#include "host_heap.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace Xasin::Communication;
+
+int main(int argc, char **argv) {
+    load_generator_config_t config;
+    config.allocation_count = host_allocations;
+
+    if (argc > 1 && strcmp(argv[1], "--quick") == 0) {
+        config.duration_ms = 1000;
+        // Faster than any real game, so a short run still sends plenty
+        config.ping_rate = 5;
+        config.config_rate = 5;
+    }
+
+    load_report_t report = LoadGenerator(config).run();
+    LoadGenerator::print_report(report);
+
+    // Every hit reaches the server, every ping comes back, every config
+    // update reaches its player; the ping replies are the messages on
+    // top of what the players and server sent.
+    uint64_t sent = report.hits.count + report.pings.count + report.configs.count;
+    if (report.broker.unrouted != 0 || report.messages != sent + report.pings.count) {
+        fprintf(stderr, "Messages lost: %u published, %u received\n",
+                unsigned(report.messages), unsigned(sent + report.pings.count));
+        return 1;
+    }
+
+    return 0;
+}
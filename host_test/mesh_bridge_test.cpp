@@ -0,0 +1,310 @@
+// mesh_bridge_test.cpp
+//
+// Runs nodes and a root MeshBridge over LoopbackMeshTransports, and fails
+// if a record is lost, reordered or published under the wrong topic, if
+// the root publishes from the mesh receive path instead of flush(), or if
+// a frame is sent with the bridge's lock held. Also reports the fan-in
+// throughput and records per frame.
+#include "MeshBridge.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Xasin::Communication;
+
+static const char *TOPIC_PREFIX = "/esp32/test/";
+static const uint8_t ROOT_MAC[6] = { 0x24, 0x0a, 0xc4, 0xff, 0xff, 0xff };
+
+struct test_payload_t {
+    uint32_t node;
+    uint32_t sequence;
+    uint8_t padding[8];
+};
+
+static bool check(bool ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "FAILED: %s\n", what);
+    }
+    return ok;
+}
+
+static void make_mac(uint32_t index, uint8_t mac[6]) {
+    const uint8_t base[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x00 };
+    memcpy(mac, base, sizeof(base));
+    mac[4] = index >> 8;
+    mac[5] = index;
+}
+
+static std::string node_topic(const uint8_t mac[6], uint8_t topic_id) {
+    char topic[96];
+    snprintf(topic, sizeof(topic), "%s%02x:%02x:%02x:%02x:%02x:%02x/%s", TOPIC_PREFIX,
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], mesh_topic_name(topic_id));
+    return topic;
+}
+
+// Root and nodes, with the root's publishes recorded per topic
+struct test_mesh_t {
+    LoopbackMeshTransport root_transport;
+    std::unique_ptr<MeshBridge> root;
+
+    std::vector<std::unique_ptr<LoopbackMeshTransport>> node_transports;
+    std::vector<std::unique_ptr<MeshBridge>> nodes;
+
+    bool in_root_flush;
+    uint32_t published_outside_flush;
+    uint32_t root_pending;
+    std::map<std::string, std::vector<uint32_t>> published;
+
+    uint32_t node_fallbacks;
+
+    test_mesh_t(uint32_t node_count)
+        : root_transport(ROOT_MAC),
+          root(), node_transports(), nodes(),
+          in_root_flush(false), published_outside_flush(0), root_pending(0), published(),
+          node_fallbacks(0) {
+
+        root.reset(new MeshBridge(root_transport,
+            [this](const char *topic, const void *data, size_t length, bool, int) {
+                if (!in_root_flush) {
+                    published_outside_flush++;
+                }
+
+                test_payload_t payload;
+                if (length == sizeof(payload)) {
+                    memcpy(&payload, data, sizeof(payload));
+                    published[topic].push_back(payload.sequence);
+                }
+                return true;
+            }, TOPIC_PREFIX));
+        root->on_pending = [this]() { root_pending++; };
+
+        for (uint32_t i = 0; i < node_count; i++) {
+            uint8_t mac[6];
+            make_mac(i, mac);
+
+            node_transports.emplace_back(new LoopbackMeshTransport(mac, &root_transport));
+            nodes.emplace_back(new MeshBridge(*node_transports.back(),
+                [this](const char *, const void *, size_t, bool, int) {
+                    node_fallbacks++;
+                    return true;
+                }, TOPIC_PREFIX));
+        }
+    }
+
+    void flush_root() {
+        in_root_flush = true;
+        root->flush();
+        in_root_flush = false;
+    }
+
+    bool publish(uint32_t node, uint32_t sequence) {
+        test_payload_t payload = {};
+        payload.node = node;
+        payload.sequence = sequence;
+        return nodes[node]->publish("event/ir_hit", &payload, sizeof(payload), false, 1);
+    }
+
+    // Every node's records arrived once, in order, under its own topic
+    bool check_published(uint32_t per_node) {
+        bool ok = true;
+
+        for (uint32_t i = 0; ok && i < nodes.size(); i++) {
+            uint8_t mac[6];
+            make_mac(i, mac);
+
+            const auto &sequences = published[node_topic(mac, MESH_TOPIC_IR_HIT)];
+            ok = check(sequences.size() == per_node, "every record bridged exactly once");
+            for (uint32_t s = 0; ok && s < per_node; s++) {
+                ok = check(sequences[s] == s, "records bridged in order");
+            }
+        }
+
+        return ok && check(published.size() == nodes.size(), "records bridged only under the node topics");
+    }
+};
+
+// Many nodes, with every record going through a node batch, the loopback
+// and the root's batch
+static bool fan_in(uint32_t node_count, uint32_t rounds, uint32_t per_round) {
+    test_mesh_t mesh(node_count);
+
+    auto start = std::chrono::steady_clock::now();
+
+    uint32_t sequence = 0;
+    for (uint32_t round = 0; round < rounds; round++) {
+        for (uint32_t i = 0; i < node_count; i++) {
+            for (uint32_t r = 0; r < per_round; r++) {
+                mesh.publish(i, sequence + r);
+            }
+            mesh.nodes[i]->flush();
+        }
+        sequence += per_round;
+
+        mesh.flush_root();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    mesh_bridge_stats_t root_stats = mesh.root->get_stats();
+    uint32_t frames_sent = 0;
+    uint32_t bytes_sent = 0;
+    for (auto &node : mesh.nodes) {
+        mesh_bridge_stats_t node_stats = node->get_stats();
+        frames_sent += node_stats.frames_sent;
+        bytes_sent += node_stats.bytes_sent;
+    }
+
+    uint32_t records = node_count * sequence;
+    printf("Fan-in, %u nodes: %u records in %u frames (%.1f records/frame, %.1f bytes/record), "
+           "%.0f records/s, max %u records per batch\n",
+           unsigned(node_count), unsigned(records), unsigned(frames_sent),
+           double(records) / frames_sent, double(bytes_sent) / records,
+           records / seconds, unsigned(root_stats.max_batch_records));
+
+    bool ok = mesh.check_published(sequence);
+    ok &= check(root_stats.records_bridged == records, "root counted every record");
+    ok &= check(root_stats.records_dropped == 0, "no records dropped with a flush per round");
+    ok &= check(mesh.published_outside_flush == 0, "root only publishes from flush()");
+    return ok && check(mesh.node_fallbacks == 0, "no fallback with a reachable root");
+}
+
+// A node batch that fills up is sent right away, and the next record
+// starts the other one
+static bool full_node_batch() {
+    test_mesh_t mesh(1);
+
+    const uint32_t records = 4 * CONFIG_COMM_MESH_BATCH_SIZE / sizeof(test_payload_t);
+    for (uint32_t s = 0; s < records; s++) {
+        check(mesh.publish(0, s), "record accepted");
+        // The root keeps up, as the bridge task would
+        mesh.flush_root();
+    }
+    mesh.nodes[0]->flush();
+    mesh.flush_root();
+
+    mesh_bridge_stats_t stats = mesh.nodes[0]->get_stats();
+    printf("Full node batches: %u records in %u frames\n", unsigned(records), unsigned(stats.frames_sent));
+
+    bool ok = mesh.check_published(records);
+    return ok && check(stats.frames_sent > 1, "full batches sent before the flush");
+}
+
+// Without a parent the records go to MQTT, under their plain topic
+static bool fallback() {
+    test_mesh_t mesh(1);
+    mesh.node_transports[0]->connected = false;
+
+    for (uint32_t s = 0; s < 5; s++) {
+        mesh.publish(0, s);
+    }
+    mesh.nodes[0]->flush();
+    mesh.flush_root();
+
+    mesh_bridge_stats_t stats = mesh.nodes[0]->get_stats();
+    printf("Fallback: %u records over MQTT\n", unsigned(stats.records_fallback));
+
+    bool ok = check(mesh.node_fallbacks == 5, "records handed to MQTT without a root");
+    ok &= check(stats.records_fallback == 5, "fallback counted");
+    return ok && check(mesh.published.empty(), "nothing bridged without a root");
+}
+
+// With both root batches full, records are dropped and counted, instead
+// of being published from the receive path
+static bool root_overflow() {
+    const uint32_t node_count = 20;
+    const uint32_t per_node = 20;
+    test_mesh_t mesh(node_count);
+
+    for (uint32_t i = 0; i < node_count; i++) {
+        for (uint32_t s = 0; s < per_node; s++) {
+            mesh.publish(i, s);
+        }
+        mesh.nodes[i]->flush();
+    }
+
+    mesh_bridge_stats_t before = mesh.root->get_stats();
+    mesh.flush_root();
+    mesh_bridge_stats_t after = mesh.root->get_stats();
+
+    printf("Root overflow: %u records bridged, %u dropped, %u wake-ups\n",
+           unsigned(after.records_bridged), unsigned(after.records_dropped), unsigned(mesh.root_pending));
+
+    bool ok = check(before.records_bridged == 0, "nothing published before flush()");
+    ok &= check(after.records_dropped > 0, "records beyond both batches dropped");
+    ok &= check(after.records_bridged + after.records_dropped == node_count * per_node, "every record bridged or counted");
+    ok &= check(mesh.root_pending >= 2, "flush() woken up again once a batch filled");
+    return ok && check(mesh.published_outside_flush == 0, "root only publishes from flush()");
+}
+
+// Transport that checks the bridge's lock is free while it sends, as
+// esp_mesh_send() may block for as long as the parent is busy
+class LockCheckTransport : public LoopbackMeshTransport {
+public:
+    MeshBridge *bridge;
+    uint32_t sends;
+
+    LockCheckTransport(const uint8_t mac[6], LoopbackMeshTransport *root)
+        : LoopbackMeshTransport(mac, root), bridge(nullptr), sends(0) {
+    }
+
+    bool send_to_root(const uint8_t *data, size_t length) override {
+        std::atomic<bool> done(false);
+        std::thread([this, &done]() {
+            bridge->get_stats();
+            done = true;
+        }).detach();
+
+        for (int i = 0; i < 1000 && !done; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (!done) {
+            fprintf(stderr, "FAILED: bridge locked while sending a frame\n");
+            std::_Exit(1);
+        }
+
+        sends++;
+        return LoopbackMeshTransport::send_to_root(data, length);
+    }
+};
+
+static bool send_outside_lock() {
+    LoopbackMeshTransport root_transport(ROOT_MAC);
+    MeshBridge root(root_transport, [](const char *, const void *, size_t, bool, int) { return true; }, TOPIC_PREFIX);
+
+    uint8_t mac[6];
+    make_mac(0, mac);
+    LockCheckTransport transport(mac, &root_transport);
+    MeshBridge node(transport, [](const char *, const void *, size_t, bool, int) { return true; }, TOPIC_PREFIX);
+    transport.bridge = &node;
+
+    test_payload_t payload = {};
+    const uint32_t records = 2 * CONFIG_COMM_MESH_BATCH_SIZE / sizeof(payload);
+    for (uint32_t s = 0; s < records; s++) {
+        payload.sequence = s;
+        node.publish("event/ir_hit", &payload, sizeof(payload), false, 1);
+    }
+    node.flush();
+
+    return check(transport.sends > 1, "frames sent from publish() and flush()");
+}
+
+int main() {
+    bool ok = true;
+
+    ok &= fan_in(5, 200, 3);
+    ok &= fan_in(20, 200, 3);
+    ok &= full_node_batch();
+    ok &= fallback();
+    ok &= root_overflow();
+    ok &= send_outside_lock();
+
+    return ok ? 0 : 1;
+}
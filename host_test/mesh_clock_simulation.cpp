@@ -0,0 +1,121 @@
+// mesh_clock_simulation.cpp
+//
+// Runs the time sync protocol in virtual time, once with the default
+// link and once with a bad one, and fails if either does not converge
+// to within the threshold. Also hands a node from one root to another,
+// and fails if its stamps do not say when they are on which root's clock.
+#include "MeshClockSimulation.h"
+
+#include <stdio.h>
+
+using namespace Xasin::Communication;
+
+// Delivers frames straight to a peer, which can be switched over
+class SwitchableTransport : public MeshTransport {
+public:
+    uint8_t mac[6];
+    SwitchableTransport *peer = nullptr;
+
+    SwitchableTransport(uint8_t id) : mac{ 0x02, 0, 0, 0, 0, id } {}
+
+    bool send_to_root(const uint8_t *data, size_t length) override {
+        peer->deliver(mac, data, length);
+        return true;
+    }
+    bool send_to(const uint8_t *, const uint8_t *data, size_t length) override {
+        peer->deliver(mac, data, length);
+        return true;
+    }
+};
+
+static bool check(bool ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "FAILED: %s\n", what);
+    }
+    return ok;
+}
+
+static bool root_change() {
+    int64_t now = 1000;
+
+    SwitchableTransport first_transport(1);
+    SwitchableTransport second_transport(2);
+    SwitchableTransport node_transport(3);
+
+    MeshClock first(first_transport, [&]() { return now; });
+    MeshClock second(second_transport, [&]() { return now + 1000000000; });
+    MeshClock node(node_transport, [&]() { return now + 5000000; });
+    node.make_default();
+
+    mesh_time_t stamp = mesh_time_stamp();
+    bool ok = check(!stamp.synced() && !mesh_time_synced() && stamp.us == now + 5000000,
+                    "local clock, marked as such, before the first sync");
+
+    first.set_root(true);
+    first_transport.peer = &node_transport;
+    node_transport.peer = &first_transport;
+    node.request_sync();
+
+    mesh_time_t on_first = mesh_time_stamp();
+    ok &= check(on_first.synced() && on_first.us == now, "synced to the first root");
+
+    // The second root takes over, with a clock a long way off
+    now = 2000;
+    first.set_root(false);
+    second.set_root(true);
+    second_transport.peer = &node_transport;
+    node_transport.peer = &second_transport;
+    node.request_sync();
+
+    mesh_time_t on_second = mesh_time_stamp();
+    ok &= check(on_second.synced() && on_second.us == now + 1000000000, "synced to the second root");
+    ok &= check(on_second.timebase != on_first.timebase, "new root, new timebase");
+
+    // The first one comes back as root, with a timebase of its own again
+    now = 3000;
+    second.set_root(false);
+    first.set_root(true);
+    node_transport.peer = &first_transport;
+    node.request_sync();
+
+    mesh_time_t back = mesh_time_stamp();
+    ok &= check(back.synced() && back.us == now && back.timebase != on_second.timebase
+                && back.timebase != on_first.timebase, "root that came back has a new timebase");
+    ok &= check(node.get_stats().timebase_changes == 2, "timebase changes counted");
+
+    return ok;
+}
+
+static bool run(const char *name, const mesh_clock_simulation_config_t &config) {
+    printf("%s\n", name);
+
+    mesh_clock_simulation_report_t report = MeshClockSimulation(config).run();
+    MeshClockSimulation::print_report(report);
+
+    if (report.converged_after_ms < 0 || report.error_max > config.threshold_us) {
+        fprintf(stderr, "%s: did not stay within %uus\n", name, unsigned(config.threshold_us));
+        return false;
+    }
+
+    return true;
+}
+
+int main() {
+    bool ok = true;
+
+    mesh_clock_simulation_config_t config;
+    ok &= run("Default link", config);
+
+    // Three hops deep on a busy channel
+    mesh_clock_simulation_config_t busy;
+    busy.delay_us = 6000;
+    busy.jitter_us = 4000;
+    busy.spike_probability = 0.2;
+    busy.loss_probability = 0.2;
+    busy.seed = 2;
+    ok &= run("Busy link", busy);
+
+    ok &= root_change();
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+// mesh_mqtt_benchmark.cpp
+//
+// Counts broker connections, subscriptions and heap per node for the
+// mesh MQTT proxy, and fails if a message or publish got lost, also with
+// payloads the size of a voice stream batch.
+#include "MeshMqttBenchmark.h"
+#include "host_heap.h"
+
+#include <stdio.h>
+
+using namespace Xasin::Communication;
+
+int main() {
+    bool ok = true;
+
+    // Eight 20 ms ADPCM packets of 164 bytes, behind the batch header
+    static const uint32_t voice_batch_size = 3 + 8 * 164;
+
+    struct run_t {
+        uint32_t children;
+        uint32_t payload_size;
+    };
+
+    for (const run_t &run : { run_t{ 5, 32 }, run_t{ 20, 32 }, run_t{ 50, 32 }, run_t{ 5, voice_batch_size } }) {
+        uint32_t children = run.children;
+
+        mesh_mqtt_benchmark_config_t config;
+        config.children = children;
+        config.payload_size = run.payload_size;
+        config.heap_used = host_heap_used;
+
+        mesh_mqtt_benchmark_report_t report = MeshMqttBenchmark(config).run();
+        MeshMqttBenchmark::print_report(report);
+
+        if (report.messages_delivered != report.messages_expected
+                || report.publishes_arrived != report.publishes_expected
+                || report.root.messages_oversized > 0
+                || report.broker_subscriptions_proxied >= report.broker_subscriptions_direct) {
+            fprintf(stderr, "%u nodes, %u byte payloads: messages lost or subscriptions not shared\n",
+                    unsigned(children), unsigned(run.payload_size));
+            ok = false;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+// mesh_telemetry_test.cpp
+//
+// Feeds MeshTelemetry fake link readings and topology events, and fails if
+// the queue peaks are not held until get(true) and then reset, if a
+// reconnect to the same parent counts as a parent change, if encode()
+// does not match the documented layout, or if format() hands back a
+// truncated text.
+#include "MeshTelemetry.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace Xasin::Communication;
+
+static const uint8_t PARENT_A[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x01 };
+static const uint8_t PARENT_B[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x02 };
+
+static bool check(bool ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "FAILED: %s\n", what);
+    }
+    return ok;
+}
+
+static uint16_t get_u16(const uint8_t *in) {
+    return in[0] | (in[1] << 8);
+}
+
+int main() {
+    mesh_link_reading_t next = {};
+    MeshTelemetry telemetry([&](mesh_link_reading_t &reading) { reading = next; });
+
+    char text[256];
+    bool ok = check(MeshTelemetry::format(telemetry.get(), text, sizeof(text)) > 0
+                        && strcmp(text, "No mesh data yet") == 0, "no data before the first sample");
+
+    // Queue peaks are held until the telemetry is sent out
+    next.layer = 2;
+    next.parent_rssi = -67;
+    memcpy(next.parent_mac, PARENT_A, 6);
+    next.routing_table_size = 300;
+    for (uint16_t tx_pending : { 3, 12, 5 }) {
+        next.tx_pending = tx_pending;
+        next.rx_pending = tx_pending / 2;
+        telemetry.sample();
+    }
+
+    mesh_telemetry_t sent = telemetry.get(true);
+    ok &= check(sent.samples == 3 && sent.link.tx_pending == 5, "latest reading returned");
+    ok &= check(sent.tx_pending_peak == 12 && sent.rx_pending_peak == 6, "peaks held between messages");
+
+    mesh_telemetry_t after = telemetry.get();
+    ok &= check(after.tx_pending_peak == 5 && after.rx_pending_peak == 2, "peaks reset to the current depth");
+
+    next.tx_pending = 9;
+    telemetry.sample();
+    ok &= check(telemetry.get().tx_pending_peak == 9, "peaks rise again after a reset");
+    ok &= check(telemetry.get().tx_pending_peak == 9, "get() without reset keeps the peaks");
+
+    // Topology, counted since boot
+    telemetry.note_parent_connected(PARENT_A);
+    telemetry.note_parent_lost();
+    telemetry.note_parent_connected(PARENT_A);
+    ok &= check(telemetry.get().parent_changes == 0, "first parent and reconnects are no change");
+
+    telemetry.note_parent_lost();
+    telemetry.note_parent_connected(PARENT_B);
+    telemetry.note_parent_connected(PARENT_A);
+    telemetry.note_layer_change();
+
+    mesh_telemetry_t topology = telemetry.get();
+    printf("%u parent changes, %u losses, %u layer changes\n", unsigned(topology.parent_changes),
+           unsigned(topology.parent_losses), unsigned(topology.layer_changes));
+    ok &= check(topology.parent_changes == 2 && topology.parent_losses == 2 && topology.layer_changes == 1,
+                "topology changes counted");
+
+    // Wire layout, as documented in MeshTelemetry.h
+    uint8_t message[64];
+    ok &= check(MeshTelemetry::encode(topology, message, MESH_TELEMETRY_SIZE - 1) == 0,
+                "encode() refuses a short buffer");
+    ok &= check(MeshTelemetry::encode(topology, message, sizeof(message)) == MESH_TELEMETRY_SIZE,
+                "encode() size");
+    ok &= check(message[0] == 1 && message[1] == 0 && message[2] == 2 && int8_t(message[3]) == -67,
+                "encode() header");
+    ok &= check(memcmp(message + 4, PARENT_A, 6) == 0, "encode() parent MAC");
+    ok &= check(get_u16(message + 10) == 300 && get_u16(message + 12) == 9 && get_u16(message + 14) == 9
+                    && get_u16(message + 16) == 2 && get_u16(message + 18) == 2,
+                "encode() routes and queues");
+    ok &= check(get_u16(message + 20) == 2 && get_u16(message + 22) == 2 && get_u16(message + 24) == 1,
+                "encode() topology counters");
+
+    topology.link.is_root = true;
+    MeshTelemetry::encode(topology, message, sizeof(message));
+    ok &= check(message[1] == 1, "encode() root flag");
+
+    // Text for the diagnostics screen, never cut off half way
+    size_t length = MeshTelemetry::format(topology, text, sizeof(text));
+    printf("%s\n", text);
+    ok &= check(length == strlen(text) && strstr(text, "(root)") != nullptr
+                    && strstr(text, "TX queue 9 (peak 9)") != nullptr,
+                "format() text");
+    ok &= check(MeshTelemetry::format(topology, text, length) == 0, "format() reports truncation");
+    ok &= check(MeshTelemetry::format(topology, text, length + 1) == length, "format() fits exactly");
+
+    return ok ? 0 : 1;
+}
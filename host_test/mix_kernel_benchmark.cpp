@@ -0,0 +1,193 @@
+// mix_kernel_benchmark.cpp
+//
+// Checks the TX mix kernel against golden output and a plain 64 bit
+// reference mix, and times it for 1 to 8 sources against the per-source
+// clamping loop it replaced. Fails on any output difference.
+#include "xasin/audio/AudioTX.h"
+#include "xasin/audio/MixKernel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <array>
+#include <chrono>
+#include <random>
+#include <vector>
+
+using namespace Xasin::Audio;
+
+static const size_t FRAME_SAMPLES = XASAUDIO_TX_FRAME_SAMPLE_NO;
+static const int MAX_SOURCES = 8;
+
+static bool check(bool ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "FAILED: %s\n", what);
+    }
+    return ok;
+}
+
+// Two sources, full and half volume, with the extremes of the input range
+static bool golden() {
+    const int16_t first[10] = { 0, 1, -1, 16384, -16384, 32767, -32768, 12345, -23456, 30000 };
+    const int16_t second[10] = { 100, -100, 32767, 16384, -32768, -32768, 32767, -12345, 23456, 30000 };
+    const int16_t expected[10] = { 49, -50, 16318, 24416, -32576, 16191, -16193, 6099, -11591, 32767 };
+    const uint64_t expected_square_sum = 3693205958ULL;
+
+    bool ok = check(Mix::q15_gain(255, 255) == 32512, "full volume gain");
+    ok &= check(Mix::q15_gain(255, 128) == 16320, "half volume gain");
+    ok &= check(Mix::q15_gain(0, 255) == 0, "muted gain");
+
+    int32_t acc[10] = {};
+    Mix::accumulate(acc, first, 10, Mix::q15_gain(255, 255));
+    Mix::accumulate(acc, second, 10, Mix::q15_gain(255, 128));
+
+    int16_t out[10];
+    uint64_t square_sum = 0;
+    bool clipped = Mix::saturate(acc, out, 10, &square_sum);
+
+    ok &= check(memcmp(out, expected, sizeof(out)) == 0, "golden mix output");
+    ok &= check(clipped, "clipping of the last sample flagged");
+    ok &= check(square_sum == expected_square_sum, "golden square sum");
+
+    // Without clipping nothing is flagged, and the RMS-less path matches
+    int32_t quiet[3] = { -32768, 0, 32767 };
+    int16_t quiet_out[3];
+    ok &= check(!Mix::saturate(quiet, quiet_out, 3), "no clipping at the range limits");
+    ok &= check(quiet_out[0] == -32768 && quiet_out[2] == 32767, "range limits kept");
+
+    return ok;
+}
+
+struct test_frame_t {
+    std::vector<std::array<int16_t, FRAME_SAMPLES>> sources;
+    std::vector<uint8_t> volumes;
+};
+
+static test_frame_t make_frame(int source_count, std::mt19937 &rng) {
+    std::uniform_int_distribution<int> sample(INT16_MIN, INT16_MAX);
+    std::uniform_int_distribution<int> volume(0, 255);
+
+    test_frame_t frame;
+    frame.sources.resize(source_count);
+    for (auto &source : frame.sources) {
+        for (auto &value : source) {
+            value = sample(rng);
+        }
+        frame.volumes.push_back(volume(rng));
+    }
+
+    return frame;
+}
+
+// What the kernel has to produce: every source scaled on its own, summed
+// without any intermediate clamping, clamped once
+static uint64_t reference_mix(const test_frame_t &frame, uint8_t volume_mod, int16_t *out) {
+    uint64_t square_sum = 0;
+
+    for (size_t i = 0; i < FRAME_SAMPLES; i++) {
+        int64_t value = 0;
+        for (size_t s = 0; s < frame.sources.size(); s++) {
+            int64_t gain = (int64_t(volume_mod) * frame.volumes[s]) / 2;
+            value += (int64_t(frame.sources[s][i]) * gain) >> 15;
+        }
+
+        value = std::max<int64_t>(INT16_MIN, std::min<int64_t>(INT16_MAX, value));
+        out[i] = int16_t(value);
+        square_sum += uint64_t(value * value);
+    }
+
+    return square_sum;
+}
+
+static uint64_t kernel_mix(const test_frame_t &frame, uint8_t volume_mod, int32_t *acc, int16_t *out) {
+    memset(acc, 0, FRAME_SAMPLES * sizeof(int32_t));
+    for (size_t s = 0; s < frame.sources.size(); s++) {
+        Mix::accumulate(acc, frame.sources[s].data(), FRAME_SAMPLES, Mix::q15_gain(volume_mod, frame.volumes[s]));
+    }
+
+    uint64_t square_sum = 0;
+    Mix::saturate(acc, out, FRAME_SAMPLES, &square_sum);
+    return square_sum;
+}
+
+// TX::add_mono_frame() and calculate_audio_rms() before the kernel
+static uint64_t legacy_mix(const test_frame_t &frame, uint8_t volume_mod, int16_t *out) {
+    memset(out, 0, FRAME_SAMPLES * sizeof(int16_t));
+
+    for (size_t s = 0; s < frame.sources.size(); s++) {
+        const int16_t *data = frame.sources[s].data();
+        for (size_t i = 0; i < FRAME_SAMPLES; i++) {
+            int32_t value = out[i];
+            value += (volume_mod * frame.volumes[s] * int32_t(data[i])) >> 16;
+
+            if (value > INT16_MAX) {
+                value = INT16_MAX;
+            } else if (value < INT16_MIN) {
+                value = INT16_MIN;
+            }
+            out[i] = int16_t(value);
+        }
+    }
+
+    uint64_t square_sum = 0;
+    for (size_t i = 0; i < FRAME_SAMPLES; i++) {
+        square_sum += int32_t(out[i]) * out[i];
+    }
+    return square_sum;
+}
+
+template<typename mix_func_t>
+static double time_frames(int frames, mix_func_t mix) {
+    volatile uint64_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        sink = sink + mix();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / frames;
+}
+
+int main(int argc, char **argv) {
+    int frames = 20000;
+    if (argc > 1 && strcmp(argv[1], "--quick") == 0) {
+        frames = 1000;
+    }
+
+    bool ok = golden();
+
+    std::mt19937 rng(1);
+    std::vector<int32_t> acc(FRAME_SAMPLES);
+    std::vector<int16_t> out(FRAME_SAMPLES);
+    std::vector<int16_t> expected(FRAME_SAMPLES);
+
+    printf("%u samples per frame\n", unsigned(FRAME_SAMPLES));
+    printf("sources  kernel ns/frame  legacy ns/frame  speedup\n");
+
+    for (int sources = 1; sources <= MAX_SOURCES; sources++) {
+        // Output has to match the reference for quiet and clipping mixes
+        for (int run = 0; run < 20; run++) {
+            test_frame_t frame = make_frame(sources, rng);
+            uint8_t volume_mod = run % 2 ? 255 : 64;
+
+            uint64_t expected_square_sum = reference_mix(frame, volume_mod, expected.data());
+            uint64_t square_sum = kernel_mix(frame, volume_mod, acc.data(), out.data());
+
+            if (memcmp(out.data(), expected.data(), FRAME_SAMPLES * sizeof(int16_t)) != 0
+                    || square_sum != expected_square_sum) {
+                fprintf(stderr, "FAILED: %d sources: mix differs from the reference\n", sources);
+                ok = false;
+                break;
+            }
+        }
+
+        test_frame_t frame = make_frame(sources, rng);
+        double kernel_ns = time_frames(frames, [&]() { return kernel_mix(frame, 255, acc.data(), out.data()); });
+        double legacy_ns = time_frames(frames, [&]() { return legacy_mix(frame, 255, out.data()); });
+
+        printf("%7d  %15.0f  %15.0f  %6.2fx\n", sources, kernel_ns, legacy_ns, legacy_ns / kernel_ns);
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+// outbound_queue_test.cpp
+//
+// Drains the OutboundQueue from several threads at once, as the MQTT
+// client, the mesh proxy and publishers do, and fails if a message is sent
+// twice, out of order, or left behind. Also checks that events expire
+// behind a retained message, and that a long offline stretch of player
+// state updates does not push the hit events out.
+#include "OutboundQueue.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Xasin::Communication;
+
+static int64_t fake_now = 0;
+
+static bool check(bool ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "FAILED: %s\n", what);
+    }
+    return ok;
+}
+
+static bool concurrent_drains() {
+    OutboundQueue queue;
+
+    const int messages = CONFIG_COMM_OUTBOX_SLOTS;
+    for (int i = 0; i < messages; i++) {
+        char topic[16];
+        snprintf(topic, sizeof(topic), "event/%d", i);
+        queue.push(topic, &i, sizeof(i), false, 1);
+    }
+
+    std::mutex sent_lock;
+    std::vector<int> sent;
+    auto publish = [&](const char *, const void *data, size_t, bool, int) {
+        int value;
+        memcpy(&value, data, sizeof(value));
+        // Long enough for the other threads to try draining meanwhile
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+        std::lock_guard<std::mutex> guard(sent_lock);
+        sent.push_back(value);
+        return true;
+    };
+
+    std::vector<std::thread> drainers;
+    for (int i = 0; i < 4; i++) {
+        drainers.emplace_back([&]() { queue.drain(publish); });
+    }
+    for (auto &drainer : drainers) {
+        drainer.join();
+    }
+
+    bool ok = check(int(sent.size()) == messages, "every message sent exactly once");
+    for (int i = 0; ok && i < messages; i++) {
+        ok = check(sent[i] == i, "messages sent in order");
+    }
+    printf("Concurrent drains: %u/%d sent\n", unsigned(sent.size()), messages);
+
+    return ok && check(queue.empty(), "queue empty after the drains");
+}
+
+// A message queued while a drain is on its way out still goes out
+static bool push_during_drain() {
+    OutboundQueue queue;
+    int value = 1;
+    queue.push("event/first", &value, sizeof(value), false, 1);
+
+    std::vector<std::string> sent;
+    std::function<bool (const char *, const void *, size_t, bool, int)> publish;
+    publish = [&](const char *topic, const void *, size_t, bool, int) {
+        sent.push_back(topic);
+
+        if (sent.size() == 1) {
+            // Another publisher, finding the drain busy
+            std::thread other([&]() {
+                queue.push("event/second", &value, sizeof(value), false, 1);
+                queue.drain(publish);
+            });
+            other.join();
+        }
+        return true;
+    };
+    queue.drain(publish);
+
+    printf("Push during drain: %u/2 sent\n", unsigned(sent.size()));
+    return check(sent.size() == 2 && sent[1] == "event/second", "message pushed during a drain sent")
+        && check(queue.empty(), "queue empty after the drain");
+}
+
+static bool expiry_behind_retained() {
+    fake_now = 0;
+    OutboundQueue queue([]() { return fake_now; });
+
+    int value = 0;
+    queue.push("get/state", &value, sizeof(value), true, 1);
+    queue.push("event/old", &value, sizeof(value), false, 1);
+
+    fake_now += int64_t(CONFIG_COMM_OUTBOX_EVENT_TTL) * 1000;
+    queue.push("event/new", &value, sizeof(value), false, 1);
+
+    std::vector<std::string> sent;
+    queue.drain([&](const char *topic, const void *, size_t, bool, int) {
+        sent.push_back(topic);
+        return true;
+    });
+
+    outbound_queue_stats_t stats = queue.get_stats();
+    printf("Expiry behind a retained message: %u sent, %u expired\n",
+           unsigned(sent.size()), unsigned(stats.dropped_expired));
+
+    return check(stats.dropped_expired == 1, "event behind a retained message expired")
+        && check(sent == std::vector<std::string>({ "get/state", "event/new" }), "rest sent in order");
+}
+
+// Expired events make room without breaking up the ring
+static bool refill_after_expiry() {
+    fake_now = 0;
+    OutboundQueue queue([]() { return fake_now; });
+
+    int value = 0;
+    queue.push("get/state", &value, sizeof(value), true, 1);
+    for (int i = 1; i < CONFIG_COMM_OUTBOX_SLOTS; i++) {
+        queue.push("event/old", &value, sizeof(value), false, 1);
+    }
+
+    fake_now += int64_t(CONFIG_COMM_OUTBOX_EVENT_TTL) * 1000;
+    for (int i = 1; i < CONFIG_COMM_OUTBOX_SLOTS; i++) {
+        value = i;
+        queue.push("event/new", &value, sizeof(value), false, 1);
+    }
+
+    std::vector<int> sent;
+    queue.drain([&](const char *topic, const void *data, size_t, bool, int) {
+        if (strcmp(topic, "event/new") == 0) {
+            int v;
+            memcpy(&v, data, sizeof(v));
+            sent.push_back(v);
+        }
+        return true;
+    });
+
+    outbound_queue_stats_t stats = queue.get_stats();
+    bool ok = check(stats.dropped_full == 0, "no event pushed out while expired ones made room")
+        && check(int(sent.size()) == CONFIG_COMM_OUTBOX_SLOTS - 1, "all new events sent");
+    for (int i = 0; ok && i < int(sent.size()); i++) {
+        ok = check(sent[i] == i + 1, "new events sent in order");
+    }
+    printf("Refill after expiry: %u sent\n", unsigned(sent.size()));
+
+    return ok;
+}
+
+// Offline, as PlayerState::flush() publishes after every shot, with a
+// hit now and then. Only the latest state and ammo are kept.
+static bool offline_state_updates() {
+    fake_now = 0;
+    OutboundQueue queue([]() { return fake_now; });
+
+    const int shots = 200;
+    int hits = 0;
+    for (int ammo = shots; ammo > 0; ammo--) {
+        queue.push("get/state", &ammo, sizeof(ammo), true, 1);
+        queue.push("get/ammo", &ammo, sizeof(ammo), true, 1);
+
+        if (ammo % 20 == 0) {
+            queue.push("event/ir_hit", &ammo, sizeof(ammo), false, 1);
+            hits++;
+        }
+        fake_now += 10000;
+    }
+
+    std::map<std::string, int> sent;
+    int last_ammo = 0;
+    queue.drain([&](const char *topic, const void *data, size_t, bool, int) {
+        sent[topic]++;
+        if (strcmp(topic, "get/ammo") == 0) {
+            memcpy(&last_ammo, data, sizeof(last_ammo));
+        }
+        return true;
+    });
+
+    outbound_queue_stats_t stats = queue.get_stats();
+    printf("Offline state updates: %d hits sent of %d, %u coalesced, %u dropped\n", sent["event/ir_hit"], hits,
+           unsigned(stats.coalesced), unsigned(stats.dropped_full));
+
+    return check(stats.dropped_full == 0, "no message dropped for state updates")
+        && check(sent["event/ir_hit"] == hits, "every hit sent")
+        && check(sent["get/state"] == 1 && sent["get/ammo"] == 1, "state and ammo coalesced")
+        && check(last_ammo == 1, "latest ammo sent");
+}
+
+int main() {
+    bool ok = true;
+
+    ok &= concurrent_drains();
+    ok &= push_during_drain();
+    ok &= expiry_behind_retained();
+    ok &= refill_after_expiry();
+    ok &= offline_state_updates();
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,275 @@
+// sd_stream_benchmark.cpp
+//
+// Plays a sound file off the host "SD card" the way ByteCassette used to,
+// with a seek and a one byte read per output sample, and the way it does
+// now, through an SDStream kept topped up by the prefetch task. Reports
+// SD calls and s_sd_mutex acquisitions per second of audio for both.
+// Fails if a stream returns other bytes than the file holds, or does not
+// end at a short read, if paced
+// playback of several streams at once underruns, or if streaming does
+// not cut the SD traffic by at least two orders of magnitude.
+#include "xasin/audio/AudioTX.h"
+#include "xasin/audio/ByteCassette.h"
+#include "xasin/audio/SDStream.h"
+#include "host_sd.h"
+#include "sd_raw_access.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Xasin::Audio;
+
+namespace {
+
+const char *FILE_NAME = "stream.u8";
+const uint32_t FILE_SAMPLERATE = 22050;
+const int STREAMS = 3;
+const auto FRAME_LENGTH = std::chrono::milliseconds(CONFIG_XASAUDIO_TX_FRAMELENGTH);
+
+bool check(bool ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "FAILED: %s\n", what);
+    }
+    return ok;
+}
+
+// ByteCassette::process_frame() before the SDStream, SD access and all
+class LegacyCassette : public Source {
+private:
+    FILE *sound_file;
+    long file_size;
+    long current_file_pos;
+    uint32_t sample_position_counter;
+    const uint32_t per_sample_increase;
+
+protected:
+    bool process_frame() override {
+        if (!sound_file || current_file_pos >= file_size) {
+            return false;
+        }
+
+        std::array<int16_t, XASAUDIO_TX_FRAME_SAMPLE_NO> temp_buffer = {};
+        uint8_t prev_byte_val = 0;
+        uint8_t next_byte_val = 0;
+
+        sd_raw_fseek(sound_file, current_file_pos > 0 ? current_file_pos - 1 : 0, SEEK_SET);
+        sd_raw_fread(&prev_byte_val, 1, 1, sound_file);
+        if (current_file_pos == 0) {
+            next_byte_val = prev_byte_val;
+        }
+
+        for (int i = 0; i < XASAUDIO_TX_FRAME_SAMPLE_NO; i++) {
+            if (current_file_pos + 1 >= file_size) {
+                sd_raw_fseek(sound_file, current_file_pos, SEEK_SET);
+                sd_raw_fread(&next_byte_val, 1, 1, sound_file);
+            } else {
+                sd_raw_fseek(sound_file, current_file_pos + 1, SEEK_SET);
+                sd_raw_fread(&next_byte_val, 1, 1, sound_file);
+            }
+
+            sample_position_counter += per_sample_increase;
+            uint16_t sample_fraction = sample_position_counter & 0xFFFF;
+            temp_buffer[i] = (((0xFFFF - sample_fraction) * (int32_t(prev_byte_val) - 0x80))
+                              + (sample_fraction * (int32_t(next_byte_val) - 0x80))) >> 8;
+
+            current_file_pos += sample_position_counter >> 16;
+            sample_position_counter &= 0xFFFF;
+            if (current_file_pos >= file_size) {
+                break;
+            }
+
+            prev_byte_val = next_byte_val;
+        }
+
+        add_mono_frame_to_handler(temp_buffer.data(), 255);
+        return current_file_pos < file_size;
+    }
+
+public:
+    LegacyCassette(TX &handler, const char *file_path, uint32_t samplerate)
+        : Source(handler), sound_file(sd_raw_fopen(file_path, "rb")),
+          file_size(sd_raw_get_file_size(file_path)), current_file_pos(0), sample_position_counter(0),
+          per_sample_increase((samplerate << 16) / CONFIG_XASAUDIO_TX_SAMPLERATE) {
+    }
+
+    ~LegacyCassette() {
+        detach();
+        if (sound_file) {
+            sd_raw_fclose(sound_file);
+        }
+    }
+
+    bool next_frame() {
+        return process_frame();
+    }
+
+    bool is_finished() override {
+        return !sound_file || current_file_pos >= file_size;
+    }
+};
+
+class StreamedCassette : public ByteCassette {
+public:
+    using ByteCassette::ByteCassette;
+
+    bool next_frame() {
+        return process_frame();
+    }
+};
+
+struct traffic_t {
+    host_sd_stats_t sd;
+    sd_stream_stats_t stream;
+};
+
+traffic_t traffic() {
+    return { host_sd_get_stats(), SDStream::get_stats() };
+}
+
+struct run_report_t {
+    double audio_seconds;
+    double sd_calls;
+    double block_reads;
+    double underruns;
+    double frame_us;
+};
+
+// Plays count cassettes side by side, one frame each per TX frame length
+// if paced, until all of them finished
+template<typename cassette_t>
+run_report_t play(TX &tx, int count, bool paced) {
+    traffic_t before = traffic();
+
+    std::vector<std::unique_ptr<cassette_t>> cassettes;
+    for (int i = 0; i < count; i++) {
+        cassettes.emplace_back(new cassette_t(tx, FILE_NAME, FILE_SAMPLERATE));
+    }
+
+    uint32_t frames = 0;
+    std::chrono::duration<double, std::micro> busy(0);
+    auto next = std::chrono::steady_clock::now();
+
+    bool playing = true;
+    while (playing) {
+        playing = false;
+
+        auto start = std::chrono::steady_clock::now();
+        for (auto &cassette : cassettes) {
+            if (!cassette->is_finished()) {
+                cassette->next_frame();
+                playing = true;
+            }
+        }
+        busy += std::chrono::steady_clock::now() - start;
+        frames++;
+
+        if (paced) {
+            next += FRAME_LENGTH;
+            std::this_thread::sleep_until(next);
+        }
+    }
+    cassettes.clear();
+
+    traffic_t after = traffic();
+
+    run_report_t report = {};
+    report.audio_seconds = double(count) * frames * CONFIG_XASAUDIO_TX_FRAMELENGTH / 1000;
+    report.sd_calls = double(after.sd.calls - before.sd.calls);
+    report.block_reads = double(after.stream.block_reads - before.stream.block_reads);
+    report.underruns = double(after.stream.underruns - before.stream.underruns);
+    report.frame_us = busy.count() / (double(count) * frames);
+    return report;
+}
+
+// Reads a stream dry and compares it against the file's bytes
+bool reads_back(SDStream &stream, const uint8_t *expected, uint32_t length) {
+    std::vector<uint8_t> data;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+    while (!stream.at_end() && std::chrono::steady_clock::now() < deadline) {
+        uint8_t byte;
+        if (stream.pop(byte)) {
+            data.push_back(byte);
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    return data.size() == length && memcmp(data.data(), expected, length) == 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    double file_seconds = 3;
+    if (argc > 1 && strcmp(argv[1], "--quick") == 0) {
+        file_seconds = 1;
+    }
+
+    char root[] = "/tmp/sd_stream_benchmarkXXXXXX";
+    if (mkdtemp(root) == nullptr) {
+        perror("mkdtemp");
+        return 1;
+    }
+    host_sd_set_root(root);
+    std::string file_path = std::string(root) + "/" + FILE_NAME;
+
+    // Too long for the AssetCache, which is not started here either
+    std::vector<uint8_t> file(uint32_t(file_seconds * FILE_SAMPLERATE));
+    for (size_t i = 0; i < file.size(); i++) {
+        file[i] = uint8_t(i * 7 + (i >> 9));
+    }
+    FILE *out = fopen(file_path.c_str(), "wb");
+    fwrite(file.data(), 1, file.size(), out);
+    fclose(out);
+
+    SDStream::start_prefetch_task();
+
+    bool ok = true;
+    {
+        SDStream whole(FILE_NAME);
+        ok &= check(whole.is_open() && whole.size() == long(file.size()), "stream opened");
+        ok &= check(reads_back(whole, file.data(), file.size()), "whole file read back");
+
+        // A sound out of a bank, starting and ending mid-block
+        SDStream slice(FILE_NAME, 1000, 5000);
+        ok &= check(reads_back(slice, file.data() + 1000, 5000), "file slice read back");
+    }
+    {
+        // A read cut short part way through a block ends the stream there,
+        // instead of the next block landing past the end of the buffer
+        host_sd_short_read_once(700);
+        SDStream cut(FILE_NAME, 0, 8000);
+        ok &= check(reads_back(cut, file.data(), 700) && cut.size() == 700, "stream ends at a short read");
+    }
+
+    TX tx;
+    run_report_t legacy = play<LegacyCassette>(tx, 1, false);
+    run_report_t paced = play<StreamedCassette>(tx, STREAMS, true);
+
+    printf("%.1f s of %u Hz audio, %u byte blocks\n", file_seconds, unsigned(FILE_SAMPLERATE),
+           unsigned(XASAUDIO_SD_BLOCK_SIZE));
+    printf("                  SD calls/s  block reads/s  underruns  us per frame\n");
+    auto print = [](const char *name, const run_report_t &report) {
+        printf("%-16s %11.0f %14.1f %10.0f %13.2f\n", name, report.sd_calls / report.audio_seconds,
+               report.block_reads / report.audio_seconds, report.underruns, report.frame_us);
+    };
+    print("Per sample", legacy);
+    print("Streams, paced", paced);
+    printf("Every SD call takes s_sd_mutex once\n");
+
+    ok &= check(paced.underruns == 0, "paced streams never underrun");
+    ok &= check(paced.sd_calls * 100 < legacy.sd_calls * STREAMS, "SD calls cut by 100x");
+
+    unlink(file_path.c_str());
+    rmdir(root);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+// source_stress.cpp
+//
+// Starts, stops and deletes sources from several tasks at once, while
+// the TX is mixing them, and fails if a source is processed after its
+// destructor started. Also deletes sources on the processing task, and
+// on a TX that was never started, which must not block.
+#include "xasin/audio/AudioTX.h"
+
+#include <stdio.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Xasin::Audio;
+
+namespace {
+
+const uint32_t ALIVE = 0xA11FE;
+const uint32_t DEAD = 0xDEAD;
+
+std::atomic<uint32_t> errors(0);
+std::atomic<int32_t> live_sources(0);
+std::atomic<uint32_t> frames_mixed(0);
+
+// Plays a quiet tone, forever or for a number of frames, and checks that
+// it is never processed once its destructor started
+class CheckedSource : public Source {
+private:
+    std::array<int16_t, XASAUDIO_TX_FRAME_SAMPLE_NO> samples;
+    volatile uint32_t magic;
+    int32_t frames_left;
+
+protected:
+    bool process_frame() override {
+        if (magic != ALIVE) {
+            errors++;
+            return false;
+        }
+
+        add_mono_frame_to_handler(samples.data(), 16);
+        frames_mixed++;
+
+        if (frames_left > 0) {
+            frames_left--;
+        }
+        return true;
+    }
+
+public:
+    // frames < 0 plays until deleted
+    CheckedSource(TX &handler, int32_t frames = -1)
+        : Source(handler), samples(), magic(ALIVE), frames_left(frames) {
+        samples.fill(1000);
+        live_sources++;
+    }
+
+    ~CheckedSource() {
+        detach();
+
+        // Held open for a bit, so that a processing task still using
+        // the source would run into it
+        magic = DEAD;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        samples.fill(0);
+
+        live_sources--;
+    }
+
+    bool is_finished() override {
+        return frames_left == 0;
+    }
+};
+
+// Takes frames as fast as the TX hands them out, with a short pause so
+// the other tasks get to run
+class NullSink : public OutputSink {
+public:
+    void init() override {}
+    void write_frame(const int16_t *) override {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    void start() override {}
+    void stop() override {}
+};
+
+TX tx;
+NullSink sink;
+
+// Also owns a source of its own, replaced every few frames
+void processing_task(void *) {
+    CheckedSource *own = nullptr;
+    uint32_t frame = 0;
+
+    while (true) {
+        xTaskNotifyWait(0, 0, nullptr, portMAX_DELAY);
+        tx.largestack_process();
+
+        if (++frame % 8 != 0) {
+            continue;
+        }
+
+        delete own;
+        own = new CheckedSource(tx);
+        own->start(false);
+    }
+}
+
+void churn(uint32_t seed, std::chrono::steady_clock::time_point end) {
+    std::mt19937 random(seed);
+
+    while (std::chrono::steady_clock::now() < end) {
+        switch (random() % 3) {
+        // Deleted by its owner while it plays
+        case 0: {
+            auto source = new CheckedSource(tx);
+            source->start(false);
+            std::this_thread::sleep_for(std::chrono::microseconds(random() % 2000));
+            delete source;
+        }
+        break;
+
+        // Plays out, and is deleted by the reclaim task
+        case 1:
+            (new CheckedSource(tx, 1 + random() % 4))->start(true);
+            break;
+
+        // Stopped and handed over
+        default: {
+            auto source = new CheckedSource(tx);
+            source->start(false);
+            std::this_thread::sleep_for(std::chrono::microseconds(random() % 500));
+            source->stop();
+            source->release();
+        }
+        break;
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    // A TX without tasks must not wait for them
+    {
+        TX idle;
+        auto source = new CheckedSource(idle);
+        source->start(false);
+        delete source;
+        printf("Deleted a source on a TX that was never started\n");
+    }
+
+    TaskHandle_t processing = nullptr;
+    xTaskCreate(processing_task, "Processing", 8192, nullptr, 10, &processing);
+    tx.init(processing, &sink);
+
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < 4; i++) {
+        threads.emplace_back(churn, i + 1, end);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // Whatever was left to play out, other than the processing task's own
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (live_sources > 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    printf("%u frames mixed, %u voices stolen, %u rejected, %d sources left, %u used after delete\n",
+           unsigned(frames_mixed), unsigned(tx.get_stolen_voice_count()),
+           unsigned(tx.get_rejected_voice_count()), int(live_sources), unsigned(errors));
+
+    if (errors != 0 || live_sources > 1 || frames_mixed == 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+// i2s.h
+//
+// What the I2S DAC sink uses. The driver calls do nothing on the host,
+// tests pass their own OutputSink.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef enum {
+    I2S_NUM_0,
+    I2S_NUM_1,
+} i2s_port_t;
+
+typedef enum {
+    I2S_MODE_MASTER = 1,
+    I2S_MODE_SLAVE = 2,
+    I2S_MODE_TX = 4,
+    I2S_MODE_RX = 8,
+    I2S_MODE_DAC_BUILT_IN = 16,
+} i2s_mode_t;
+
+typedef enum {
+    I2S_BITS_PER_SAMPLE_16BIT = 16,
+} i2s_bits_per_sample_t;
+
+typedef enum {
+    I2S_CHANNEL_FMT_RIGHT_LEFT,
+    I2S_CHANNEL_FMT_ALL_RIGHT,
+    I2S_CHANNEL_FMT_ALL_LEFT,
+    I2S_CHANNEL_FMT_ONLY_RIGHT,
+    I2S_CHANNEL_FMT_ONLY_LEFT,
+} i2s_channel_fmt_t;
+
+typedef enum {
+    I2S_COMM_FORMAT_STAND_I2S = 1,
+    I2S_COMM_FORMAT_STAND_MSB = 3,
+} i2s_comm_format_t;
+
+typedef enum {
+    I2S_DAC_CHANNEL_DISABLE,
+    I2S_DAC_CHANNEL_RIGHT_EN,
+    I2S_DAC_CHANNEL_LEFT_EN,
+    I2S_DAC_CHANNEL_BOTH_EN,
+} i2s_dac_mode_t;
+
+typedef struct {
+    i2s_mode_t mode;
+    uint32_t sample_rate;
+    i2s_bits_per_sample_t bits_per_sample;
+    i2s_channel_fmt_t channel_format;
+    i2s_comm_format_t communication_format;
+    int intr_alloc_flags;
+    int dma_buf_count;
+    int dma_buf_len;
+    bool use_apll;
+    bool tx_desc_auto_clear;
+} i2s_config_t;
+
+typedef struct i2s_pin_config i2s_pin_config_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t i2s_driver_install(i2s_port_t port, const i2s_config_t *config, int queue_size, void *queue);
+esp_err_t i2s_set_pin(i2s_port_t port, const i2s_pin_config_t *pins);
+esp_err_t i2s_set_dac_mode(i2s_dac_mode_t mode);
+esp_err_t i2s_zero_dma_buffer(i2s_port_t port);
+esp_err_t i2s_start(i2s_port_t port);
+esp_err_t i2s_stop(i2s_port_t port);
+esp_err_t i2s_write(i2s_port_t port, const void *data, size_t size, size_t *bytes_written, TickType_t ticks);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,18 @@
+// rmt.h
+//
+// Only the item layout, for the XIRR encoder and decoder
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    union {
+        struct {
+            uint32_t duration0 : 15;
+            uint32_t level0 : 1;
+            uint32_t duration1 : 15;
+            uint32_t level1 : 1;
+        };
+        uint32_t val;
+    };
+} rmt_item32_t;
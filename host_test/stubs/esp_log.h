@@ -0,0 +1,41 @@
+// esp_log.h
+//
+// Logs to stderr. Info and below only with HOST_LOG_LEVEL raised, so the
+// benchmark output stays readable.
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+#ifndef HOST_LOG_LEVEL
+#define HOST_LOG_LEVEL ESP_LOG_WARN
+#endif
+
+#define HOST_LOG(level, letter, tag, format, ...) do {                     \
+        if ((level) <= HOST_LOG_LEVEL) {                                   \
+            fprintf(stderr, letter " (%s) " format "\n", tag, ##__VA_ARGS__); \
+        }                                                                  \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) HOST_LOG(ESP_LOG_ERROR, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG(ESP_LOG_WARN, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HOST_LOG(ESP_LOG_INFO, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) HOST_LOG(ESP_LOG_DEBUG, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) HOST_LOG(ESP_LOG_VERBOSE, "V", tag, format, ##__VA_ARGS__)
+
+#define ESP_LOG_BUFFER_HEX(tag, buffer, length) ((void)(buffer))
+#define ESP_LOG_BUFFER_HEXDUMP(tag, buffer, length, level) ((void)(buffer))
+
+static inline void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    (void)tag;
+    (void)level;
+}
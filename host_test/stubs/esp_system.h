@@ -0,0 +1,7 @@
+// esp_system.h
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_random.h"
@@ -0,0 +1,15 @@
+// esp_timer.h
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Microseconds since the program started, steady clock
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
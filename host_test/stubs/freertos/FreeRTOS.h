@@ -0,0 +1,60 @@
+// FreeRTOS.h
+//
+// Host build of the parts of FreeRTOS the components use, on top of
+// std::thread. Ticks run at CONFIG_FREERTOS_HZ, like on the ESP32.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+// Pulled in through the port layer on the ESP32
+#include "esp_system.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+
+typedef struct QueueDefinition *QueueHandle_t;
+typedef QueueHandle_t SemaphoreHandle_t;
+typedef struct tskTaskControlBlock *TaskHandle_t;
+
+#define configTICK_RATE_HZ CONFIG_FREERTOS_HZ
+#define configMAX_PRIORITIES 25
+#define tskIDLE_PRIORITY 0
+
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((TickType_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define errQUEUE_FULL 0
+
+#define IRAM_ATTR
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Critical sections share one recursive lock on the host
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+void host_enter_critical(void);
+void host_exit_critical(void);
+
+#define portENTER_CRITICAL(mux) host_enter_critical()
+#define portEXIT_CRITICAL(mux) host_exit_critical()
+#define portENTER_CRITICAL_ISR(mux) host_enter_critical()
+#define portEXIT_CRITICAL_ISR(mux) host_exit_critical()
+#define portYIELD_FROM_ISR()
+
+#ifdef __cplusplus
+}
+#endif
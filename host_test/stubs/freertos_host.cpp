@@ -0,0 +1,461 @@
+// freertos_host.cpp
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_err.h"
+#include "esp_timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using host_clock = std::chrono::steady_clock;
+
+const host_clock::time_point start_time = host_clock::now();
+
+std::recursive_mutex critical_lock;
+
+// Thrown by vTaskDelete(nullptr), ends the task's thread
+struct task_exit {};
+
+// Waits on cv until ready() or the ticks run out
+template<typename Lock, typename Ready>
+bool wait_ticks(std::condition_variable &cv, Lock &lock, TickType_t ticks, Ready ready) {
+    if (ticks == portMAX_DELAY) {
+        cv.wait(lock, ready);
+        return true;
+    }
+
+    auto timeout = std::chrono::microseconds(uint64_t(ticks) * 1000000 / configTICK_RATE_HZ);
+    return cv.wait_for(lock, timeout, ready);
+}
+
+} // namespace
+
+enum queue_kind_t {
+    QUEUE,
+    SEMAPHORE,
+    MUTEX,
+    RECURSIVE_MUTEX,
+};
+
+struct QueueDefinition {
+    queue_kind_t kind;
+
+    std::mutex lock;
+    std::condition_variable changed;
+
+    UBaseType_t length;
+    UBaseType_t item_size;
+    std::deque<std::vector<uint8_t>> items;
+
+    // Semaphores and mutexes
+    UBaseType_t count;
+    std::thread::id owner;
+    UBaseType_t depth;
+};
+
+struct tskTaskControlBlock {
+    std::string name;
+
+    std::mutex lock;
+    std::condition_variable notified;
+    uint32_t notify_value;
+    bool notify_pending;
+};
+
+namespace {
+
+thread_local tskTaskControlBlock *current_task = nullptr;
+
+QueueHandle_t create(queue_kind_t kind, UBaseType_t length, UBaseType_t item_size, UBaseType_t count) {
+    QueueHandle_t queue = new QueueDefinition();
+    queue->kind = kind;
+    queue->length = length;
+    queue->item_size = item_size;
+    queue->count = count;
+    queue->depth = 0;
+
+    return queue;
+}
+
+} // namespace
+
+extern "C" {
+
+void host_enter_critical(void) {
+    critical_lock.lock();
+}
+
+void host_exit_critical(void) {
+    critical_lock.unlock();
+}
+
+int64_t esp_timer_get_time(void) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(host_clock::now() - start_time).count();
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+// Queues
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    return create(QUEUE, length, item_size, 0);
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(queue->lock);
+
+    if (!wait_ticks(queue->changed, lock, ticks, [queue]() { return queue->items.size() < queue->length; })) {
+        return errQUEUE_FULL;
+    }
+
+    auto data = static_cast<const uint8_t *>(item);
+    queue->items.emplace_back(data, data + queue->item_size);
+    queue->changed.notify_all();
+
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    return xQueueSend(queue, item, ticks);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(queue->lock);
+
+    if (!wait_ticks(queue->changed, lock, ticks, [queue]() { return !queue->items.empty(); })) {
+        return pdFALSE;
+    }
+
+    memcpy(item, queue->items.front().data(), queue->item_size);
+    queue->items.pop_front();
+    queue->changed.notify_all();
+
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(queue->lock);
+    return queue->kind == QUEUE ? queue->items.size() : queue->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(queue->lock);
+    return queue->length - queue->items.size();
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(queue->lock);
+    queue->items.clear();
+    queue->changed.notify_all();
+
+    return pdPASS;
+}
+
+// Semaphores and mutexes
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return create(MUTEX, 1, 0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) {
+    return create(RECURSIVE_MUTEX, 1, 0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return create(SEMAPHORE, 1, 0, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+    return create(SEMAPHORE, max_count, 0, initial_count);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(semaphore->lock);
+
+    if (!wait_ticks(semaphore->changed, lock, ticks, [semaphore]() { return semaphore->count > 0; })) {
+        return pdFALSE;
+    }
+
+    semaphore->count--;
+    semaphore->owner = std::this_thread::get_id();
+
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    std::lock_guard<std::mutex> lock(semaphore->lock);
+
+    if (semaphore->kind == MUTEX && (semaphore->count > 0 || semaphore->owner != std::this_thread::get_id())) {
+        fprintf(stderr, "Mutex given by a task that does not hold it\n");
+        abort();
+    }
+
+    if (semaphore->count >= semaphore->length) {
+        return pdFALSE;
+    }
+
+    semaphore->count++;
+    semaphore->owner = std::thread::id();
+    semaphore->changed.notify_all();
+
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t *woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xSemaphoreGive(semaphore);
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(semaphore->lock);
+
+    auto self = std::this_thread::get_id();
+    if (semaphore->depth > 0 && semaphore->owner == self) {
+        semaphore->depth++;
+        return pdTRUE;
+    }
+
+    if (!wait_ticks(semaphore->changed, lock, ticks, [semaphore]() { return semaphore->depth == 0; })) {
+        return pdFALSE;
+    }
+
+    semaphore->owner = self;
+    semaphore->depth = 1;
+
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore) {
+    std::lock_guard<std::mutex> lock(semaphore->lock);
+
+    if (semaphore->depth == 0 || semaphore->owner != std::this_thread::get_id()) {
+        return pdFALSE;
+    }
+
+    if (--semaphore->depth == 0) {
+        semaphore->owner = std::thread::id();
+        semaphore->changed.notify_all();
+    }
+
+    return pdTRUE;
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t semaphore) {
+    std::lock_guard<std::mutex> lock(semaphore->lock);
+    return semaphore->count;
+}
+
+// Tasks
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t,
+                       void *args, UBaseType_t, TaskHandle_t *handle) {
+    TaskHandle_t task = new tskTaskControlBlock();
+    task->name = name ? name : "";
+    task->notify_value = 0;
+    task->notify_pending = false;
+
+    if (handle) {
+        *handle = task;
+    }
+
+    // The control block stays around, as others may still notify the
+    // handle after the task ended
+    std::thread([function, args, task]() {
+        current_task = task;
+        try {
+            function(args);
+        } catch (task_exit &) {
+        }
+    }).detach();
+
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth,
+                                   void *args, UBaseType_t priority, TaskHandle_t *handle, BaseType_t) {
+    return xTaskCreate(function, name, stack_depth, args, priority, handle);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task != nullptr && task != xTaskGetCurrentTaskHandle()) {
+        fprintf(stderr, "vTaskDelete of another task (%s) is not supported on the host\n", task->name.c_str());
+        abort();
+    }
+
+    throw task_exit();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    // The main thread, or any thread not started by xTaskCreate
+    if (current_task == nullptr) {
+        current_task = new tskTaskControlBlock();
+        current_task->name = "main";
+        current_task->notify_value = 0;
+        current_task->notify_pending = false;
+    }
+
+    return current_task;
+}
+
+const char *pcTaskGetName(TaskHandle_t task) {
+    if (task == nullptr) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    return task->name.c_str();
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return esp_timer_get_time() * configTICK_RATE_HZ / 1000000;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::microseconds(uint64_t(ticks) * 1000000 / configTICK_RATE_HZ));
+}
+
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment) {
+    *previous_wake += increment;
+
+    TickType_t now = xTaskGetTickCount();
+    if (TickType_t(*previous_wake - now) < portMAX_DELAY / 2) {
+        vTaskDelay(*previous_wake - now);
+    }
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    std::lock_guard<std::mutex> lock(task->lock);
+
+    switch (action) {
+    case eNoAction:
+        break;
+    case eSetBits:
+        task->notify_value |= value;
+        break;
+    case eIncrement:
+        task->notify_value++;
+        break;
+    case eSetValueWithOverwrite:
+        task->notify_value = value;
+        break;
+    case eSetValueWithoutOverwrite:
+        if (task->notify_pending) {
+            return pdFAIL;
+        }
+        task->notify_value = value;
+        break;
+    }
+
+    task->notify_pending = true;
+    task->notified.notify_all();
+
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t *woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xTaskNotify(task, value, action);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    return xTaskNotify(task, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) {
+    if (task == nullptr) {
+        fprintf(stderr, "Notification for a task that does not exist\n");
+        abort();
+    }
+    xTaskNotifyFromISR(task, 0, eIncrement, woken);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(task->lock);
+
+    wait_ticks(task->notified, lock, ticks, [task]() { return task->notify_value != 0; });
+
+    uint32_t value = task->notify_value;
+    if (value != 0) {
+        task->notify_value = clear_on_exit ? 0 : value - 1;
+    }
+    task->notify_pending = false;
+
+    return value;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t ticks) {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(task->lock);
+
+    if (!task->notify_pending) {
+        task->notify_value &= ~clear_on_entry;
+    }
+
+    bool received = wait_ticks(task->notified, lock, ticks, [task]() { return task->notify_pending; });
+
+    if (value) {
+        *value = task->notify_value;
+    }
+    if (received) {
+        task->notify_value &= ~clear_on_exit;
+    }
+    task->notify_pending = false;
+
+    return received ? pdTRUE : pdFALSE;
+}
+
+} // extern "C"
@@ -0,0 +1,88 @@
+// host_heap.cpp
+#include "host_heap.h"
+
+#include <cstddef>
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> allocations(0);
+std::atomic<int64_t> heap_used(0);
+
+// Keeps the size in front of each block, aligned for anything
+constexpr size_t HEADER = alignof(std::max_align_t);
+
+void *allocate(size_t size) {
+    auto block = static_cast<uint8_t *>(malloc(size + HEADER));
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    *reinterpret_cast<size_t *>(block) = size;
+    allocations++;
+    heap_used += size;
+
+    return block + HEADER;
+}
+
+void release(void *pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+
+    auto block = static_cast<uint8_t *>(pointer) - HEADER;
+    heap_used -= *reinterpret_cast<size_t *>(block);
+    free(block);
+}
+
+} // namespace
+
+uint64_t host_allocations() {
+    return allocations;
+}
+
+int64_t host_heap_used() {
+    return heap_used;
+}
+
+void *operator new(size_t size) {
+    return allocate(size);
+}
+
+void *operator new[](size_t size) {
+    return allocate(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return allocate(size);
+    } catch (std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return allocate(size);
+    } catch (std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void operator delete(void *pointer) noexcept {
+    release(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+    release(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+    release(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept {
+    release(pointer);
+}
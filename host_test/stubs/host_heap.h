@@ -0,0 +1,12 @@
+// host_heap.h
+//
+// Counts the allocations made through operator new, for the benchmarks
+// that report allocations or heap use per node.
+#pragma once
+
+#include <stdint.h>
+
+// Allocations made since the program started
+uint64_t host_allocations();
+// Bytes currently allocated through operator new
+int64_t host_heap_used();
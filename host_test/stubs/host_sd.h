@@ -0,0 +1,26 @@
+// host_sd.h
+//
+// The SD card is a directory on the host
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Directory that stands in for the card's mount point, the current
+// directory by default
+void host_sd_set_root(const char *path);
+
+// Calls into sd_raw_access since the start. On the target every one of
+// them takes s_sd_mutex exactly once.
+struct host_sd_stats_t {
+    uint64_t calls;
+    uint64_t reads;
+    uint64_t seeks;
+    uint64_t bytes_read;
+};
+
+host_sd_stats_t host_sd_get_stats();
+
+// Makes the next sd_raw_fread() return at most max_bytes, as a read that
+// ran into a card error part way would
+void host_sd_short_read_once(size_t max_bytes);
@@ -0,0 +1,118 @@
+// sd_raw_access_host.cpp
+//
+// sd_raw_access on top of stdio, relative to the host_sd_set_root()
+// directory.
+#include "sd_raw_access.h"
+#include "host_sd.h"
+
+#include <stdint.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <string>
+
+namespace {
+
+std::string root = ".";
+
+std::atomic<uint64_t> calls(0);
+std::atomic<uint64_t> reads(0);
+std::atomic<uint64_t> seeks(0);
+std::atomic<uint64_t> bytes_read(0);
+
+// SIZE_MAX for no limit
+std::atomic<size_t> short_read_bytes(SIZE_MAX);
+
+std::string full_path(const char *path_suffix) {
+    return root + "/" + path_suffix;
+}
+
+} // namespace
+
+void host_sd_set_root(const char *path) {
+    root = path;
+}
+
+void host_sd_short_read_once(size_t max_bytes) {
+    short_read_bytes = max_bytes;
+}
+
+host_sd_stats_t host_sd_get_stats() {
+    return { calls.load(), reads.load(), seeks.load(), bytes_read.load() };
+}
+
+extern "C" {
+
+FILE *sd_raw_fopen(const char *path_suffix, const char *mode) {
+    calls++;
+    if (path_suffix == nullptr || mode == nullptr) {
+        return nullptr;
+    }
+    return fopen(full_path(path_suffix).c_str(), mode);
+}
+
+size_t sd_raw_fread(void *ptr, size_t size, size_t count, FILE *stream) {
+    calls++;
+    if (ptr == nullptr || stream == nullptr) {
+        return 0;
+    }
+    size_t limit = short_read_bytes.exchange(SIZE_MAX);
+    if (size != 0 && limit / size < count) {
+        count = limit / size;
+    }
+
+    size_t read = fread(ptr, size, count, stream);
+    reads++;
+    bytes_read += read * size;
+    return read;
+}
+
+size_t sd_raw_fwrite(const void *ptr, size_t size, size_t count, FILE *stream) {
+    calls++;
+    if (ptr == nullptr || stream == nullptr) {
+        return 0;
+    }
+    return fwrite(ptr, size, count, stream);
+}
+
+int sd_raw_fseek(FILE *stream, long offset, int whence) {
+    calls++;
+    seeks++;
+    return stream ? fseek(stream, offset, whence) : -1;
+}
+
+long sd_raw_ftell(FILE *stream) {
+    calls++;
+    return stream ? ftell(stream) : -1L;
+}
+
+int sd_raw_fclose(FILE *stream) {
+    calls++;
+    return stream ? fclose(stream) : EOF;
+}
+
+int sd_raw_remove(const char *path_suffix) {
+    calls++;
+    return remove(full_path(path_suffix).c_str());
+}
+
+int sd_raw_rename(const char *old_path_suffix, const char *new_path_suffix) {
+    calls++;
+    return rename(full_path(old_path_suffix).c_str(), full_path(new_path_suffix).c_str());
+}
+
+bool sd_raw_file_exists(const char *path_suffix) {
+    calls++;
+    struct stat st;
+    return stat(full_path(path_suffix).c_str(), &st) == 0;
+}
+
+long sd_raw_get_file_size(const char *path_suffix) {
+    calls++;
+    struct stat st;
+    if (stat(full_path(path_suffix).c_str(), &st) != 0) {
+        return -1L;
+    }
+    return st.st_size;
+}
+
+} // extern "C"
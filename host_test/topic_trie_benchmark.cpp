@@ -0,0 +1,255 @@
+// topic_trie_benchmark.cpp
+//
+// Matches topics against 500 subscriptions, the way the menu visibility
+// items and the player's wildcards subscribe, with the TopicTrie and with
+// a linear scan over all filters. Fails if the two disagree on any topic,
+// or if the broker subscription QoS does not follow the subscriptions of
+// a filter. Reports the time per match for both.
+#include "xasin/mqtt/TopicTrie.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Xasin::MQTT;
+
+namespace {
+
+struct test_subscription_t {
+    std::string topic;
+    int qos;
+};
+
+using test_match_t = basic_topic_match_t<test_subscription_t>;
+
+bool check(bool ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "FAILED: %s\n", what);
+    }
+    return ok;
+}
+
+// MQTT filter matching one level at a time. Sets rest to the part of the
+// topic from the filter's first wildcard level onwards.
+bool filter_matches(std::string_view filter, std::string_view topic, std::string_view &rest) {
+    rest = std::string_view();
+    bool wildcard_seen = false;
+
+    size_t f = 0;
+    size_t t = 0;
+    while (true) {
+        size_t f_end = filter.find('/', f);
+        std::string_view level = filter.substr(f, f_end - f);
+
+        if (level == "#") {
+            if (f == 0 && !topic.empty() && topic[0] == '$') {
+                return false;
+            }
+            if (!wildcard_seen) {
+                rest = t == std::string_view::npos ? std::string_view() : topic.substr(t);
+            }
+            return true;
+        }
+
+        if (t == std::string_view::npos) {
+            return false;
+        }
+
+        size_t t_end = topic.find('/', t);
+        if (level == "+") {
+            if (f == 0 && !topic.empty() && topic[0] == '$') {
+                return false;
+            }
+            if (!wildcard_seen) {
+                rest = topic.substr(t);
+                wildcard_seen = true;
+            }
+        } else if (level != topic.substr(t, t_end - t)) {
+            return false;
+        }
+
+        t = t_end == std::string_view::npos ? std::string_view::npos : t_end + 1;
+        if (f_end == std::string_view::npos) {
+            if (t != std::string_view::npos) {
+                return false;
+            }
+            if (!wildcard_seen) {
+                rest = std::string_view();
+            }
+            return true;
+        }
+        f = f_end + 1;
+    }
+}
+
+void linear_match(const std::list<test_subscription_t> &subscriptions, std::string_view topic,
+                  std::vector<test_match_t> &out) {
+    for (auto &subscription : subscriptions) {
+        std::string_view rest;
+        if (filter_matches(subscription.topic, topic, rest)) {
+            out.push_back({ const_cast<test_subscription_t *>(&subscription), rest });
+        }
+    }
+}
+
+bool same_matches(std::vector<test_match_t> a, std::vector<test_match_t> b) {
+    auto order = [](const test_match_t &x, const test_match_t &y) { return x.subscription < y.subscription; };
+    std::sort(a.begin(), a.end(), order);
+    std::sort(b.begin(), b.end(), order);
+
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].subscription != b[i].subscription || a[i].topic_rest != b[i].topic_rest) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The broker QoS of a filter follows the highest QoS of its subscriptions
+bool qos_counting() {
+    BasicTopicTrie<test_subscription_t> trie;
+    test_subscription_t low{ "a/b", 0 };
+    test_subscription_t high{ "a/b", 2 };
+    test_subscription_t middle{ "a/b", 1 };
+
+    bool ok = check(trie.insert(&low), "first subscription of a filter subscribes");
+    ok &= check(trie.insert(&high), "higher QoS subscribes again");
+    ok &= check(!trie.insert(&middle), "lower QoS does not");
+    ok &= check(trie.size() == 1, "one filter for three subscriptions");
+
+    int qos = -2;
+    ok &= check(trie.remove(&high, &qos) && qos == 1, "removing the highest QoS lowers the filter's QoS");
+    ok &= check(!trie.remove(&low, &qos), "removing a lower QoS changes nothing");
+    ok &= check(trie.remove(&middle, &qos) && qos == -1, "removing the last one unsubscribes");
+    ok &= check(trie.size() == 0, "no filters left");
+
+    int reported = -1;
+    trie.insert(&low);
+    trie.insert(&high);
+    trie.remove(&high);
+    trie.for_each_filter([&](const std::string &, int filter_qos) { reported = filter_qos; });
+    return ok && check(reported == 0, "resubscribed with the lowered QoS after a reconnect");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int rounds = 200;
+    if (argc > 1 && strcmp(argv[1], "--quick") == 0) {
+        rounds = 20;
+    }
+
+    bool ok = qos_counting();
+
+    // One exact filter per menu item, a few duplicates of them, and the
+    // wildcards of the player and the game state
+    std::list<test_subscription_t> subscriptions;
+    const int items = 470;
+    char topic[96];
+    for (int i = 0; i < items; i++) {
+        snprintf(topic, sizeof(topic), "/esp32/lzrtag/game/menu/item%03d/state", i);
+        subscriptions.push_back({ topic, i % 2 });
+    }
+    for (int i = 0; i < 10; i++) {
+        snprintf(topic, sizeof(topic), "/esp32/lzrtag/game/menu/item%03d/state", i * 7);
+        subscriptions.push_back({ topic, 1 });
+    }
+    for (int i = 0; i < 10; i++) {
+        snprintf(topic, sizeof(topic), "/esp32/lzrtag/+/player/%d/hit", i);
+        subscriptions.push_back({ topic, 1 });
+    }
+    subscriptions.push_back({ "/esp32/lzrtag/24:0a:c4:00:00:01/event/#", 1 });
+    subscriptions.push_back({ "/esp32/lzrtag/24:0a:c4:00:00:01/get/#", 1 });
+    subscriptions.push_back({ "/esp32/lzrtag/+/get/_ping", 0 });
+    subscriptions.push_back({ "/esp32/lzrtag/game/#", 1 });
+    subscriptions.push_back({ "/esp32/lzrtag/game/+/item001/+", 0 });
+    subscriptions.push_back({ "/esp32/+/game/menu/#", 0 });
+    subscriptions.push_back({ "#", 0 });
+    subscriptions.push_back({ "+/+", 0 });
+    subscriptions.push_back({ "$SYS/broker/load", 0 });
+    subscriptions.push_back({ "/esp32/lzrtag/game/menu", 0 });
+
+    BasicTopicTrie<test_subscription_t> trie;
+    for (auto &subscription : subscriptions) {
+        trie.insert(&subscription);
+    }
+
+    // Topics as they arrive: menu states, events, pings, and unrelated ones
+    std::vector<std::string> topics;
+    std::mt19937 rng(1);
+    for (int i = 0; i < 200; i++) {
+        switch (rng() % 6) {
+        case 0:
+        case 1:
+            snprintf(topic, sizeof(topic), "/esp32/lzrtag/game/menu/item%03d/state", int(rng() % (items + 20)));
+            break;
+        case 2:
+            snprintf(topic, sizeof(topic), "/esp32/lzrtag/24:0a:c4:00:00:01/event/%s",
+                     rng() % 2 ? "ir_hit" : "ir_beacon");
+            break;
+        case 3:
+            snprintf(topic, sizeof(topic), "/esp32/lzrtag/24:0a:c4:00:00:%02x/get/_ping", unsigned(rng() % 4));
+            break;
+        case 4:
+            snprintf(topic, sizeof(topic), "/esp32/lzrtag/game/player/%d/hit", int(rng() % 12));
+            break;
+        default:
+            snprintf(topic, sizeof(topic), "%s", rng() % 2 ? "$SYS/broker/load" : "lzrtag/unrelated");
+            break;
+        }
+        topics.push_back(topic);
+    }
+    topics.push_back("/esp32/lzrtag/game/menu");
+    topics.push_back("/esp32/lzrtag/game/menu/");
+    topics.push_back("a/b");
+
+    std::vector<test_match_t> trie_matches;
+    std::vector<test_match_t> linear_matches;
+    size_t total_matches = 0;
+    for (auto &t : topics) {
+        trie_matches.clear();
+        linear_matches.clear();
+        trie.match(t, trie_matches);
+        linear_match(subscriptions, t, linear_matches);
+
+        total_matches += trie_matches.size();
+        if (!same_matches(trie_matches, linear_matches)) {
+            fprintf(stderr, "FAILED: trie and linear scan differ for '%s' (%u vs %u matches)\n",
+                    t.c_str(), unsigned(trie_matches.size()), unsigned(linear_matches.size()));
+            ok = false;
+        }
+    }
+
+    auto time_matches = [&](auto match) {
+        volatile size_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++) {
+            for (auto &t : topics) {
+                trie_matches.clear();
+                match(t);
+                sink = sink + trie_matches.size();
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::micro>(end - start).count() / (rounds * topics.size());
+    };
+
+    double trie_us = time_matches([&](const std::string &t) { trie.match(t, trie_matches); });
+    double linear_us = time_matches([&](const std::string &t) { linear_match(subscriptions, t, trie_matches); });
+
+    printf("%u subscriptions, %u filters, %u topics, %.1f matches per topic\n",
+           unsigned(subscriptions.size()), unsigned(trie.size()), unsigned(topics.size()),
+           double(total_matches) / topics.size());
+    printf("Trie: %.2f us per match, linear scan: %.2f us per match (%.0fx)\n",
+           trie_us, linear_us, linear_us / trie_us);
+
+    return ok ? 0 : 1;
+}
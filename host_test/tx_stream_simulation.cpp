@@ -0,0 +1,164 @@
+// tx_stream_simulation.cpp
+//
+// Replays jittery packet traces into the TX stream, and fails if a
+// steady link loses anything, or a busy one falls silent for long.
+// Also plays the stream on a real TX with every voice taken by shots,
+// and fails if the stream loses its voice to them.
+#include "TXStreamSimulation.h"
+#include "xasin/audio/AudioTX.h"
+
+#include <stdio.h>
+#include <array>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace Xasin::Audio;
+
+namespace {
+
+// A shot, playing a quiet tone for a number of frames
+class ToneSource : public Source {
+private:
+    std::array<int16_t, XASAUDIO_TX_FRAME_SAMPLE_NO> samples;
+    volatile int32_t frames_left;
+
+protected:
+    bool process_frame() override {
+        add_mono_frame_to_handler(samples.data(), 16);
+        if (frames_left > 0) {
+            frames_left--;
+        }
+        return frames_left > 0;
+    }
+
+public:
+    ToneSource(TX &handler, int32_t frames) : Source(handler), samples(), frames_left(frames) {
+        samples.fill(1000);
+    }
+    ~ToneSource() {
+        detach();
+    }
+
+    bool is_finished() override {
+        return frames_left == 0;
+    }
+};
+
+// Takes frames at the pace of the DAC
+class PacedSink : public OutputSink {
+public:
+    void init() override {}
+    void write_frame(const int16_t *) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(CONFIG_XASAUDIO_TX_FRAMELENGTH));
+    }
+    void start() override {}
+    void stop() override {}
+};
+
+TX tx;
+PacedSink sink;
+
+void processing_task(void *) {
+    while (true) {
+        xTaskNotifyWait(0, 0, nullptr, portMAX_DELAY);
+        tx.largestack_process();
+    }
+}
+
+void play_shots(int count) {
+    for (int i = 0; i < count; i++) {
+        auto shot = new ToneSource(tx, 1000);
+        shot->priority = PRIORITY_SFX;
+        shot->start(true);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5 * CONFIG_XASAUDIO_TX_FRAMELENGTH));
+}
+
+// Plays the stream as setup_voice_stream() does, while shots take every
+// voice, first with the stream silent and then while it plays
+bool stream_keeps_voice() {
+    TaskHandle_t processing = nullptr;
+    xTaskCreate(processing_task, "Processing", 8192, nullptr, 10, &processing);
+    tx.init(processing, &sink);
+
+    TXStream stream(tx);
+    stream.priority = PRIORITY_UI;
+    stream.start(false);
+
+    play_shots(CONFIG_XASAUDIO_TX_MAX_VOICES + 2);
+    bool ok = stream.is_active();
+
+    const uint8_t batch_packets = 3;
+    std::vector<uint8_t> message(3 + batch_packets * XASAUDIO_TX_STREAM_MAX_PACKETSIZE, 0);
+    for (uint8_t i = 0; i < batch_packets; i++) {
+        message[3 + i * XASAUDIO_TX_STREAM_MAX_PACKETSIZE + 1] = 0x04;
+    }
+    message[2] = batch_packets;
+
+    for (uint16_t sequence = 0; sequence < 30; sequence += batch_packets) {
+        message[0] = sequence & 0xFF;
+        message[1] = sequence >> 8;
+        stream.feed_message(message.data(), message.size());
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (!stream.has_audio() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ok &= stream.has_audio();
+
+    uint32_t stolen = tx.get_stolen_voice_count();
+    play_shots(CONFIG_XASAUDIO_TX_MAX_VOICES);
+
+    // Still drained frame by frame, i.e. still mixed
+    uint16_t depth = stream.get_stats().depth;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5 * CONFIG_XASAUDIO_TX_FRAMELENGTH));
+    ok &= stream.is_active() && stream.get_stats().depth < depth;
+
+    printf("Voices full: %u shots stolen while the stream played, stream %s\n",
+           unsigned(tx.get_stolen_voice_count() - stolen), stream.is_active() ? "kept its voice" : "stopped");
+
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    bool ok = true;
+
+    printf("Steady link\n");
+    tx_stream_simulation_config_t steady;
+    steady.jitter_us = 2000;
+    steady.spike_probability = 0;
+    steady.loss_probability = 0;
+
+    tx_stream_simulation_report_t report = TXStreamSimulation(steady).run();
+    TXStreamSimulation::print_report(report);
+
+    if (report.stream.packets_late != 0 || report.stream.packets_lost != 0
+            || report.stream.underruns != 0 || report.frames_silent != 0) {
+        fprintf(stderr, "Steady link: packets lost or playback interrupted\n");
+        ok = false;
+    }
+
+    printf("Busy mesh\n");
+    tx_stream_simulation_config_t busy;
+    report = TXStreamSimulation(busy).run();
+    TXStreamSimulation::print_report(report);
+
+    // Anything but lost batches and the longest stalls is caught by the
+    // buffer, and gaps are mostly concealed
+    uint32_t packets = report.batches_sent * busy.batch_packets;
+    if (report.stream.packets_late > packets / 100 || report.frames_silent > report.frames_requested / 100) {
+        fprintf(stderr, "Busy mesh: too many late packets or silent frames\n");
+        ok = false;
+    }
+
+    if (!stream_keeps_voice()) {
+        fprintf(stderr, "Voices full: stream lost its voice to shots\n");
+        ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+// wire_format_benchmark.cpp
+//
+// Round-trips every game message through the binary wire format, checks
+// the JSON scalars and the get/wire_format payloads the server may send,
+// and times encoding as JSON and as binary, and decoding the binary form.
+#include "lzrtag/wire_format.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+using namespace LZR::Wire;
+
+namespace {
+
+bool check(bool ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "FAILED: %s\n", what);
+    }
+    return ok;
+}
+
+ir_hit_t make_hit() {
+    ir_hit_t hit = {};
+    hit.shooter_id = 7;
+    hit.arb_code = 3;
+    const uint8_t mac[6] = { 0x24, 0x0a, 0xc4, 0x01, 0x02, 0x03 };
+    memcpy(hit.target_mac, mac, sizeof(mac));
+    hit.mesh_time_us = 1234567890123LL;
+    hit.repeats = 4;
+    hit.last_mesh_time_us = 1234567950123LL;
+    hit.mesh_timebase = 23;
+    return hit;
+}
+
+player_state_t make_state() {
+    player_state_t state = {};
+    state.ammo = { 12, 30, -1 };
+    state.heat = 200;
+    state.weapon = 2;
+    state.dead = true;
+    state.mesh_time_us = 987654321LL;
+    state.mesh_timebase = 23;
+    return state;
+}
+
+bool round_trips() {
+    char buffer[128];
+    bool ok = true;
+
+    ir_hit_t hit = make_hit();
+    ir_hit_t hit_out = {};
+    size_t length = encode(hit, buffer, sizeof(buffer), BINARY);
+    ok &= check(length > 0 && decode(buffer, length, hit_out), "hit encodes and decodes");
+    ok &= check(hit_out.shooter_id == hit.shooter_id && hit_out.arb_code == hit.arb_code
+                && memcmp(hit_out.target_mac, hit.target_mac, 6) == 0
+                && hit_out.mesh_time_us == hit.mesh_time_us && hit_out.repeats == hit.repeats
+                && hit_out.last_mesh_time_us == hit.last_mesh_time_us
+                && hit_out.mesh_timebase == hit.mesh_timebase, "hit round trip");
+
+    ammo_t ammo = { 5, 30, 90 };
+    ammo_t ammo_out = {};
+    length = encode(ammo, buffer, sizeof(buffer), BINARY);
+    ok &= check(length > 0 && decode(buffer, length, ammo_out) && ammo_out == ammo, "ammo round trip");
+
+    ping_reply_t ping = { 3900, 87, true, 123456, 45000 };
+    ping_reply_t ping_out = {};
+    length = encode(ping, buffer, sizeof(buffer), BINARY);
+    ok &= check(length > 0 && decode(buffer, length, ping_out), "ping reply encodes and decodes");
+    ok &= check(ping_out.battery_mv == ping.battery_mv && ping_out.battery_percentage == ping.battery_percentage
+                && ping_out.has_ping_ticks && ping_out.ping_ticks == ping.ping_ticks && ping_out.heap == ping.heap,
+                "ping reply round trip");
+
+    player_state_t state = make_state();
+    player_state_t state_out = {};
+    length = encode(state, buffer, sizeof(buffer), BINARY);
+    ok &= check(length > 0 && decode(buffer, length, state_out), "player state encodes and decodes");
+    ok &= check(state_out.ammo == state.ammo && state_out.heat == state.heat && state_out.weapon == state.weapon
+                && state_out.dead == state.dead && state_out.mesh_time_us == state.mesh_time_us
+                && state_out.mesh_timebase == state.mesh_timebase, "player state round trip");
+
+    // Version 3 had no timebase, which then decodes as not synced
+    length = encode(hit, buffer, sizeof(buffer), BINARY);
+    buffer[1] = 3;
+    buffer[3] = 26;
+    ok &= check(decode(buffer, length - 1, hit_out) && hit_out.mesh_timebase == 0
+                && hit_out.last_mesh_time_us == hit.last_mesh_time_us, "version 3 hit decodes unsynced");
+
+    config_value_t value = {};
+    value.kind = config_value_t::VALUE_NUMBER;
+    value.number = -42;
+    config_value_t value_out = {};
+    length = encode(value, buffer, sizeof(buffer), BINARY);
+    ok &= check(length > 0 && decode(buffer, length, value_out)
+                && value_out.kind == value.kind && value_out.number == value.number, "config value round trip");
+
+    // Too small a buffer is refused, not overrun
+    ok &= check(encode(hit, buffer, 8, BINARY) == 0 && encode(hit, buffer, 8, JSON) == 0, "short buffers refused");
+
+    // A message of another type does not decode
+    length = encode(ammo, buffer, sizeof(buffer), BINARY);
+    ok &= check(!decode(buffer, length, hit_out), "other message types refused");
+
+    return ok;
+}
+
+bool decodes_json(const char *text, config_value_t::kind_t kind, int32_t number = 0) {
+    config_value_t value;
+    return decode(text, strlen(text), value) && value.kind == kind && value.number == number;
+}
+
+bool scalars() {
+    bool ok = check(decodes_json("", config_value_t::VALUE_NONE), "empty payload");
+    ok &= check(decodes_json("null", config_value_t::VALUE_NONE), "null");
+    ok &= check(decodes_json(" true\n", config_value_t::VALUE_TRUE), "true");
+    ok &= check(decodes_json("false", config_value_t::VALUE_FALSE), "false");
+    ok &= check(decodes_json("12", config_value_t::VALUE_NUMBER, 12), "number");
+    ok &= check(decodes_json("\"Xasin\"", config_value_t::VALUE_STRING), "string");
+
+    config_value_t value;
+    ok &= check(!decode("binary", 6, value), "bare words are not JSON");
+
+    // get/wire_format, as servers publish it
+    ok &= check(decode_format("binary", 6) == BINARY, "bare binary format");
+    ok &= check(decode_format("\"binary\"", 8) == BINARY, "quoted binary format");
+    ok &= check(decode_format(" binary\n", 8) == BINARY, "binary format with whitespace");
+    ok &= check(decode_format("json", 4) == JSON, "bare json format");
+    ok &= check(decode_format("\"json\"", 6) == JSON, "quoted json format");
+    ok &= check(decode_format("", 0) == JSON, "cleared format");
+    ok &= check(decode_format("binaryx", 7) == JSON, "unknown format");
+
+    return ok;
+}
+
+template<typename func_t>
+double time_ns(int iterations, func_t func) {
+    volatile size_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        sink = sink + func(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+template<typename msg_t>
+void time_message(const char *name, msg_t msg, int iterations) {
+    char buffer[160];
+
+    double json_ns = time_ns(iterations, [&](int) { return encode(msg, buffer, sizeof(buffer), JSON); });
+    size_t json_length = encode(msg, buffer, sizeof(buffer), JSON);
+
+    double binary_ns = time_ns(iterations, [&](int) { return encode(msg, buffer, sizeof(buffer), BINARY); });
+    size_t binary_length = encode(msg, buffer, sizeof(buffer), BINARY);
+
+    msg_t out;
+    double decode_ns = time_ns(iterations, [&](int) { return size_t(decode(buffer, binary_length, out)); });
+
+    printf("%-14s %4u B %8.1f ns  %4u B %8.1f ns  %8.1f ns\n", name,
+           unsigned(json_length), json_ns, unsigned(binary_length), binary_ns, decode_ns);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int iterations = 200000;
+    if (argc > 1 && strcmp(argv[1], "--quick") == 0) {
+        iterations = 10000;
+    }
+
+    bool ok = round_trips();
+    ok &= scalars();
+
+    printf("message          JSON encode       binary encode   binary decode\n");
+    time_message("event/ir_hit", make_hit(), iterations);
+    time_message("get/ammo", ammo_t{ 12, 30, 120 }, iterations);
+    time_message("get/_ping", ping_reply_t{ 3900, 87, true, 123456, 45000 }, iterations);
+    time_message("get/state", make_state(), iterations);
+
+    return ok ? 0 : 1;
+}
@@ -4,25 +4,18 @@
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "driver/dac.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/**
- * @brief Initialize the audio player
- * 
- * @param dac_channel DAC channel to use (DAC_CHANNEL_1 or DAC_CHANNEL_2)
- * @return ESP_OK on success, ESP_FAIL otherwise
- */
-esp_err_t audio_player_init(dac_channel_t dac_channel);
-
 /**
  * @brief Play an 8-bit raw PCM audio file from the SD card
  * 
- * This function starts a task that reads the audio file in chunks and outputs 
- * it to the DAC. It returns immediately, while playback continues in the background.
+ * The file is played as a UI-priority voice of the global Xasin::Audio::TX,
+ * mixed together with any game sounds. Only one file is played at a time;
+ * starting a new one stops the previous. Returns immediately, while playback
+ * continues in the background.
  * 
  * @param file_path Path to the audio file (relative to SD card mount point)
  * @param sample_rate Sample rate of the audio file in Hz (e.g., 8000, 16000, 22050, 44100)
@@ -4,6 +4,8 @@
 #include "esp_log.h"
 #include "mcp23008_wrapper.h"
 #include "xasin/audio.h"
+#include "xasin/audio/SoundBank.h"
+#include "xasin/audio/TXStream.h"
 #include "lzrtag/player.h"
 #include "lzrtag/weapon/handler.h"
 #include "lzrtag/weapon/shot_weapon.h"
@@ -15,6 +17,7 @@
 #include "xasin/mqtt/Handler.h" // For MQTT handler
 #include "lzrtag/mcp_access.h"
 #include "lzrtag/PatternModeHandler.h"
+#include <cstdio>
 #include <cstring>
 #include <vector> 
 
@@ -22,7 +25,7 @@
 #include "driver/ledc.h"
 #include "lzrtag/vibrationHandler.h" // If needed, ensure it's available
 
-#include "cJSON.h"
+#include "lzrtag/wire_format.h"
 #include "persistent_state.h"
 
 
@@ -50,6 +53,7 @@ namespace LaserTagGame {
     TaskHandle_t initPlayerTask = nullptr;
     TaskHandle_t housekeepingTask = nullptr;
     LZR::Animator* animator = nullptr; // Added
+    LZR::TriggerInput* triggerInput = nullptr;
 
     // Added from setup.h/cpp
     LZRTag_CORE_WEAPON_STATUS main_weapon_status = LZRTag_WPN_STAT_INITIALIZING;
@@ -59,6 +63,7 @@ namespace LaserTagGame {
     // Forward declare internal helper for ping
     static void send_ping_req_internal();
     PatternModeHandler* patternModeHandler = nullptr;
+    Xasin::Audio::TXStream* voiceStream = nullptr;
 }
 
 
@@ -76,9 +81,74 @@ void gun_mux_switch_init(void) {
     }
 }
 
+// Shot to IR start latency, published whenever shots were fired since the last time
+static void send_ir_tx_stats() {
+    static uint32_t lastFramesSent = 0;
+
+    if (!LaserTagGame::weaponHandler || !g_mesh_handler.isConnected()) return;
+
+    Xasin::XIRR::tx_stats_t stats = LaserTagGame::weaponHandler->get_ir_tx_stats();
+    if (stats.frames_sent == lastFramesSent) return;
+    lastFramesSent = stats.frames_sent;
+
+    char buffer[160];
+    int length = snprintf(buffer, sizeof(buffer),
+                          "{\"framesSent\":%u,\"framesDropped\":%u,\"lastLatencyUs\":%u,"
+                          "\"avgLatencyUs\":%u,\"maxLatencyUs\":%u}",
+                          unsigned(stats.frames_sent), unsigned(stats.frames_dropped),
+                          unsigned(stats.last_latency_us), unsigned(stats.average_latency_us),
+                          unsigned(stats.max_latency_us));
+    g_mesh_handler.publish("telemetry/ir_tx", buffer, length, false, 0);
+}
+
+// Received hit frames, and how many of them were merged away
+static void send_ir_hit_stats() {
+    static uint32_t lastFrames = 0;
+
+    if (!LaserTagGame::weaponHandler || !g_mesh_handler.isConnected()) return;
+
+    LZR::hit_filter_stats_t stats = LaserTagGame::weaponHandler->get_ir_hit_stats();
+    if (stats.frames == lastFrames) return;
+    lastFrames = stats.frames;
+
+    char buffer[128];
+    int length = snprintf(buffer, sizeof(buffer),
+                          "{\"frames\":%u,\"hits\":%u,\"framesSuppressed\":%u,\"evictions\":%u}",
+                          unsigned(stats.frames), unsigned(stats.hits),
+                          unsigned(stats.frames_suppressed), unsigned(stats.evictions));
+    g_mesh_handler.publish("telemetry/ir_hits", buffer, length, false, 0);
+}
+
+// Trigger edge to shot latency, and how the trigger is read
+static void send_trigger_stats() {
+    static uint32_t lastPresses = 0;
+
+    if (!LaserTagGame::weaponHandler || !LaserTagGame::triggerInput || !g_mesh_handler.isConnected()) return;
+
+    LZRTag::Weapon::trigger_stats_t stats = LaserTagGame::weaponHandler->get_trigger_stats();
+    if (stats.presses == lastPresses) return;
+    lastPresses = stats.presses;
+
+    LZR::trigger_input_stats_t input = LaserTagGame::triggerInput->get_stats();
+
+    char buffer[256];
+    int length = snprintf(buffer, sizeof(buffer),
+                          "{\"interrupt\":%s,\"presses\":%u,\"lastLatencyUs\":%u,\"avgLatencyUs\":%u,"
+                          "\"maxLatencyUs\":%u,\"interrupts\":%u,\"polls\":%u,\"missedEdges\":%u,"
+                          "\"readErrors\":%u}",
+                          LaserTagGame::triggerInput->uses_interrupt() ? "true" : "false",
+                          unsigned(stats.presses), unsigned(stats.last_latency_us),
+                          unsigned(stats.average_latency_us), unsigned(stats.max_latency_us),
+                          unsigned(input.interrupts), unsigned(input.polls),
+                          unsigned(input.missed_edges), unsigned(input.read_errors));
+    g_mesh_handler.publish("telemetry/trigger", buffer, length, false, 0);
+}
+
 static void housekeeping_thread(void* args) {
     TickType_t nextHWTick = xTaskGetTickCount();
     const TickType_t pingIntervalTicks = 1800; // From setup.cpp (approx 1.8 seconds if Tick is 1ms)
+    TickType_t nextStatsTick = xTaskGetTickCount();
+    const TickType_t statsIntervalTicks = pdMS_TO_TICKS(30000);
 
     while (true) {
         if (xTaskGetTickCount() >= nextHWTick) {
@@ -86,6 +156,12 @@ static void housekeeping_thread(void* args) {
             LaserTagGame::send_ping_req_internal();
             nextHWTick += pingIntervalTicks;
         }
+        if (xTaskGetTickCount() >= nextStatsTick) {
+            send_ir_tx_stats();
+            send_ir_hit_stats();
+            send_trigger_stats();
+            nextStatsTick += statsIntervalTicks;
+        }
         
         // Original delay + any other game logic
         vTaskDelay(pdMS_TO_TICKS(100)); // Reduced delay to allow more frequent checks if needed, adjust as necessary
@@ -152,30 +228,25 @@ void LaserTagGame::setup_ping_handling() {
             // Access topic and payload from the message object
             // const std::string& topic = message.topic; // Assuming message.topic is std::string, if needed
             
-            // Correctly handle message.payload as std::vector<uint8_t>
-            const std::vector<uint8_t>& payload_vec = message.payload;
-            const void* payload_data = payload_vec.data();
-            size_t payload_size = payload_vec.size();
-
-            auto system_info = cJSON_CreateObject();
-            auto battery_json = cJSON_AddObjectToObject(system_info, "battery");
+            const void* payload_data = message.payload.data();
+            size_t payload_size = message.payload.size();
 
-            cJSON_AddNumberToObject(battery_json, "mv", LaserTagGame::battery.current_mv());
-            cJSON_AddNumberToObject(battery_json, "percentage", LaserTagGame::battery.current_capacity());
+            LZR::Wire::ping_reply_t reply = {};
+            reply.battery_mv = LaserTagGame::battery.current_mv();
+            reply.battery_percentage = LaserTagGame::battery.current_capacity();
 
             if (payload_size >= sizeof(uint32_t)) {
                  uint32_t sent_ticks = 0;
                  memcpy(&sent_ticks, payload_data, sizeof(uint32_t)); 
-                 cJSON_AddNumberToObject(system_info, "ping_ticks", xTaskGetTickCount() - sent_ticks);
+                 reply.has_ping_ticks = true;
+                 reply.ping_ticks = xTaskGetTickCount() - sent_ticks;
             }
-            cJSON_AddNumberToObject(system_info, "heap", esp_get_free_heap_size());
-
-            char * json_print = cJSON_PrintUnformatted(system_info); 
-            cJSON_Delete(system_info);
+            reply.heap = esp_get_free_heap_size();
 
-            if (json_print) {
-                g_mesh_handler.publish("get/_ping", json_print, strlen(json_print), false, 1);
-                cJSON_free(json_print);
+            char reply_buffer[96];
+            size_t reply_length = LZR::Wire::encode(reply, reply_buffer, sizeof(reply_buffer));
+            if (reply_length > 0) {
+                g_mesh_handler.publish("get/_ping", reply_buffer, reply_length, false, 1);
             }
         });
         ESP_LOGI(TAG_LASER, "Ping handling (subscription via g_mesh_handler) initialized.");
@@ -191,6 +262,47 @@ void LaserTagGame::shutdown_ping_handling() {
     }
 }
 
+void LaserTagGame::setup_voice_stream() {
+    // Live voice and announcements from the game server. Each message is
+    // a batch of ADPCM packets, see Xasin::Audio::TXStream::feed_message().
+    voiceStream = new Xasin::Audio::TXStream(audioManager);
+    // Kept for good, so the TX never steals its voice, and only counts
+    // it against the voice budget while it has audio
+    voiceStream->priority = Xasin::Audio::PRIORITY_UI;
+    voiceStream->start(false);
+
+    bool subscribed = g_mesh_handler.subscribe("voice_stream",
+        [](const Xasin::Communication::CommReceivedData &message) {
+            if (LaserTagGame::voiceStream == nullptr)
+                return;
+            if (!LaserTagGame::voiceStream->feed_message(message.payload.data(), message.payload.size())) {
+                ESP_LOGW(TAG_LASER, "Dropped malformed voice stream batch of %u bytes", message.payload.size());
+            }
+        });
+
+    if (subscribed) {
+        ESP_LOGI(TAG_LASER, "Voice stream initialized.");
+    } else {
+        ESP_LOGE(TAG_LASER, "Failed to subscribe to the voice stream.");
+    }
+}
+
+void LaserTagGame::shutdown_voice_stream() {
+    // Messages are dispatched under the same lock unsubscribe takes, so no
+    // callback is feeding the stream anymore once this returns
+    g_mesh_handler.unsubscribe("voice_stream");
+
+    Xasin::Audio::TXStream *stream = voiceStream;
+    voiceStream = nullptr;
+
+    if (stream) {
+        // The processing task may be halfway through a frame of it, the
+        // TX deletes it on its reclaim task once it let go
+        stream->stop();
+        stream->release();
+    }
+}
+
 // --- LZRTag mode entry point ---
 bool laser_tag_mode_enter(void) {
     // Load player info from SD (or create default if missing)
@@ -213,6 +325,11 @@ bool laser_tag_mode_enter(void) {
     gun_mux_switch_init(); // This was already here, but ensure it's before lzrtag_set_mcp23008_instance
     lzrtag_set_mcp23008_instance(&gun_gpio_extender);
 
+    // All weapon and game sounds are looked up by ID in this bank
+    if (!Xasin::Audio::SoundBank::is_loaded()) {
+        Xasin::Audio::SoundBank::load("DEI/lzrtag-sfx.bank", LZR::SFX::BANK_ID);
+    }
+
     // --- Game logic setup ---
     LaserTagGame::init(); // Sets up LaserTagGame::mqtt (g_mesh_handler) and player init task
 
@@ -220,6 +337,7 @@ bool laser_tag_mode_enter(void) {
     // LaserTagGame::setup_audio_system(); // Audio system is now initialized in main.cpp
     LaserTagGame::setup_effects_system(); // Includes RGB and animator
     LaserTagGame::setup_ping_handling(); // Setup MQTT for pings
+    LaserTagGame::setup_voice_stream();
 
     // Construct Weapon Handler with Audio, CommHandler (g_mesh_handler), and Player instance
     if (!LaserTagGame::player) {
@@ -240,6 +358,10 @@ bool laser_tag_mode_enter(void) {
 
     LaserTagGame::weaponHandler->start_thread();
 
+    LaserTagGame::triggerInput = new LZR::TriggerInput(*LaserTagGame::weaponHandler, gun_gpio_extender,
+                                                       (gpio_num_t)CONFIG_LZR_TRIGGER_INT_GPIO);
+    LaserTagGame::triggerInput->start();
+
     LaserTagGame::weapons.push_back(new LZRTag::Weapon::ShotWeapon(*LaserTagGame::weaponHandler, colibri_config));
     LaserTagGame::weapons.push_back(new LZRTag::Weapon::ShotWeapon(*LaserTagGame::weaponHandler, whip_config));
     LaserTagGame::weapons.push_back(new LZRTag::Weapon::ShotWeapon(*LaserTagGame::weaponHandler, steelfinger_config));
@@ -279,6 +401,7 @@ void laser_tag_mode_exit(void) {
     }
     // Orderly shutdown of systems
     LaserTagGame::shutdown_ping_handling();
+    LaserTagGame::shutdown_voice_stream();
     if (LaserTagGame::weaponHandler) {
         LaserTagGame::weaponHandler->shutdown_ir_system(); // Call new shutdown method
     }
@@ -286,6 +409,8 @@ void laser_tag_mode_exit(void) {
     // LaserTagGame::shutdown_audio_system(); // Audio system is managed in main.cpp
 
     // Original cleanup
+    // Before the weapon handler, which its task updates
+    delete LaserTagGame::triggerInput; LaserTagGame::triggerInput = nullptr;
     delete LaserTagGame::player; LaserTagGame::player = nullptr;
     delete LaserTagGame::weaponHandler; LaserTagGame::weaponHandler = nullptr;
     for (auto* w : LaserTagGame::weapons) delete w;
@@ -11,6 +11,7 @@
 #include "lzrtag/weapon/handler.h"
 #include "lzrtag/animatorThread.h"
 #include "lzrtag/player.h"
+#include "lzrtag/trigger_input.h"
 #include "lzrtag/core_defs.h" // Added
 #include <string>
 
@@ -43,6 +44,7 @@ namespace LaserTagGame {
     extern std::vector<LZRTag::Weapon::BaseWeapon*> weapons;
     extern TaskHandle_t housekeepingTask;
     extern LZR::Animator* animator; // Added
+    extern LZR::TriggerInput* triggerInput;
 
     // Added from setup.h/cpp
     extern LZRTag_CORE_WEAPON_STATUS main_weapon_status; // Changed to use new enum
@@ -60,6 +62,8 @@ namespace LaserTagGame {
     void shutdown_effects_system();
     void setup_ping_handling();
     void shutdown_ping_handling();
+    void setup_voice_stream();
+    void shutdown_voice_stream();
     extern PatternModeHandler* patternModeHandler;
 
     void tick(); // Call this from your animation loop or main tick
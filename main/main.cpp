@@ -15,6 +15,7 @@
 #include "EspMeshHandler.h"
 #include "xasin/audio/AudioTX.h"
 #include "xasin/audio/ByteCassette.h" // For Xasin::Audio::TX
+#include "xasin/audio/I2SDACSink.h"
 #include "xasin/BatteryManager.h"
 
 // C Standard Library
@@ -139,9 +140,10 @@ static void initTask(void *pvParameter) {
 
     menu_log_add(TAG_MAIN, "[InitTask] Initializing Audio System.");
     TaskHandle_t audioProcessingTaskHandle = nullptr; // Local handle for init
-    // xTaskCreate(audio_core_processing_task, "AudioLargeStack", 32768, nullptr, 5, &audioProcessingTaskHandle);
-    // audioManager.init(audioProcessingTaskHandle); 
-    // audioManager.volume_mod = 160; 
+    xTaskCreate(audio_core_processing_task, "AudioLargeStack", 32768, nullptr, 5, &audioProcessingTaskHandle);
+    // Game and menu sounds share one mix, output on both DAC pins (GPIO25 and GPIO26)
+    audioManager.init(audioProcessingTaskHandle, new Xasin::Audio::I2SDACSink(I2S_DAC_CHANNEL_BOTH_EN));
+    audioManager.volume_mod = 160; 
     menu_log_add(TAG_MAIN, "[InitTask] Audio system initialized.");
 
     // Schedule SD card and UI init as LVGL tasks
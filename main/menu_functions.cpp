@@ -35,6 +35,7 @@ void register_menu_functions(void) {
     G_PredefinedFunctions["ENTER_LASER_TAG_MODE"] = enter_laser_tag_mode_from_menu;
     G_PredefinedFunctions["BATTERY_STATUS"] = show_battery_status_from_menu;
     G_PredefinedFunctions["SHOW_RECENT_MESSAGES"] = show_recent_messages_from_menu;
+    G_PredefinedFunctions["MESH_DIAGNOSTICS"] = show_mesh_diagnostics_from_menu;
 }
 
 
@@ -436,6 +437,43 @@ void show_battery_status_from_menu(void) {
     lv_group_focus_obj(dialog.btn1);
 }
 
+void show_mesh_diagnostics_from_menu(void) {
+    static lv_task_t* refresh_task = nullptr;
+
+    // Reopened while the last dialog's label was not deleted yet
+    if (refresh_task) {
+        lv_task_del(refresh_task);
+        refresh_task = nullptr;
+    }
+
+    ModalDialogParts dialog = create_modal_dialog(
+        "Mesh Diagnostics",
+        "",
+        "CLOSE", ok_button_cb
+    );
+
+    // Refreshed once a second, which is how often the queues are sampled
+    refresh_task = lv_task_create([](lv_task_t *task) {
+        char text[256];
+        if (Xasin::Communication::MeshTelemetry::format(g_mesh_handler.get_mesh_telemetry(), text, sizeof(text)) > 0) {
+            lv_label_set_text(static_cast<lv_obj_t*>(task->user_data), text);
+        }
+    }, 1000, LV_TASK_PRIO_LOW, dialog.msg);
+    lv_task_ready(refresh_task);
+
+    // However the dialog goes away, the task must not outlive its label
+    lv_obj_set_event_cb(dialog.msg, [](lv_obj_t *obj, lv_event_t event) {
+        if (event == LV_EVENT_DELETE && refresh_task && refresh_task->user_data == obj) {
+            lv_task_del(refresh_task);
+            refresh_task = nullptr;
+        }
+    });
+
+    lv_group_t* joy_group = lvgl_joystick_get_group();
+    if (dialog.btn1) lv_group_add_obj(joy_group, dialog.btn1);
+    lv_group_focus_obj(dialog.btn1);
+}
+
 void show_recent_messages_from_menu(void) {
     menu_log_add(TAG_MENU_FUNC, "Displaying recent messages from menu");
 
@@ -76,4 +76,9 @@ void show_battery_status_from_menu(void);
 
 void show_recent_messages_from_menu(void);
 
+/**
+ * @brief Show mesh layer, parent, RSSI and queue depths, refreshed every second
+ */
+void show_mesh_diagnostics_from_menu(void);
+
 #endif
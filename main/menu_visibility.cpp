@@ -109,7 +109,7 @@ void setup_mqtt_visibility_handlers() {
     // 2. Modify EspMeshHandler to add a new subscribe method that accepts Xasin::MQTT::mqtt_callback.
 
     // Option 1: Adapt lambda in menu_visibility.cpp if CommReceivedData is enough.
-    // CommReceivedData contains: topic, payload (vector<uint8_t>), source_id.
+    // CommReceivedData contains: topic, sub_topic, payload and source_id, all as views.
     // The current lambda uses packet.data (string) and packet.full_topic (string).
     // packet.data can be constructed from CommReceivedData.payload.
     // packet.full_topic is not directly in CommReceivedData, but CommReceivedData.topic is the filter.
@@ -129,13 +129,13 @@ void setup_mqtt_visibility_handlers() {
                 bool subscribed = g_mesh_handler.subscribe(
                     topic_to_subscribe,
                     [topic_to_subscribe](const Xasin::Communication::CommReceivedData& data) { // Lambda now takes CommReceivedData
-                        // data.topic is the filter, data.payload is vector<uint8_t>
+                        // data.topic is the filter, data.payload a view of the payload bytes
                         // The original lambda used packet.full_topic and packet.data (std::string)
                         // We need to convert payload to string for set_mqtt_state_variable
                         std::string payload_str(data.payload.begin(), data.payload.end());
                         
-                        ESP_LOGI(TAG_VISIBILITY, "MQTT callback (via g_mesh_handler.subscribe) for visibility: Topic Filter: %s, Payload: %s", 
-                                 data.topic.c_str(), payload_str.c_str());
+                        ESP_LOGI(TAG_VISIBILITY, "MQTT callback (via g_mesh_handler.subscribe) for visibility: Topic Filter: %.*s, Payload: %s", 
+                                 static_cast<int>(data.topic.size()), data.topic.data(), payload_str.c_str());
                         
                         // set_mqtt_state_variable expects the exact topic that was matched,
                         // which is `topic_to_subscribe` (the filter we used).
@@ -24,7 +24,7 @@
 extern TaskHandle_t g_wifi_init_task_handle; // Defined in main.cpp
 
 extern Xasin::Communication::EspMeshHandler g_mesh_handler; // Defined in main.cpp
-// extern Xasin::Audio::TX audioManager; // Defined in laser_tag.cpp or main.cpp
+extern Xasin::Audio::TX audioManager; // Defined in main.cpp
 extern Housekeeping::BatteryManager g_battery_manager; // Defined in main.cpp
 
 // --- MQTT Configuration ---
@@ -31,7 +31,7 @@ TelescopeController::~TelescopeController() {
 }
 
 static void response_callback(const Xasin::Communication::CommReceivedData& data) {
-    ESP_LOGI(TAG, "Received response on topic: %s", data.topic.c_str());
+    ESP_LOGI(TAG, "Received response on topic: %.*s", static_cast<int>(data.topic.size()), data.topic.data());
     ESP_LOGI(TAG, "Response payload: %.*s", static_cast<int>(data.payload.size()), data.payload.data());
     // Process the response as needed, e.g., store it in a buffer or trigger an event.
 }
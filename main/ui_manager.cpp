@@ -111,8 +111,6 @@ void ui_init(lv_task_t *current_init_task) {
 
     ui_styles_init();
 
-    audio_player_init(DAC_CHANNEL_2);
-
     register_menu_functions(); // Register predefined functions for menu items
 
     if (parse_menu_definition_file("S:/DEI/menu.txt")) { 